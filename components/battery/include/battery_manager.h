@@ -6,6 +6,7 @@
 #include "esp_log.h"
 #include "device.h"
 #include "event_system.h"
+#include "timer_service.h"
 
 namespace esp_framework {
 
@@ -199,11 +200,6 @@ public:
      */
     void set_critical_battery_threshold(int percentage);
     
-    /**
-     * @brief 处理电池监控，必须定期调用
-     */
-    void loop();
-    
     /**
      * @brief 事件处理函数
      * @param event 事件数据
@@ -230,6 +226,9 @@ private:
     // 状态计算辅助函数
     void update_battery_state();
     
+    // 定时器到期：采样电池状态并安排下一次
+    void on_timer();
+    
     // 计算电池电量百分比
     int calculate_percentage(float voltage) const;
     
@@ -248,6 +247,8 @@ private:
     
     bool temp_warning_active_;          // 温度警告状态
     
+    timer_id timer_;                    // 定时器服务中的"battery"定时器
+    
     mutable std::mutex mutex_;          // 保护共享数据的互斥锁
 };
 
@@ -240,7 +240,8 @@ battery_manager::battery_manager()
       last_voltage_(0.0f),
       last_current_(0.0f),
       last_temperature_(25.0f),
-      temp_warning_active_(false) {
+      temp_warning_active_(false),
+      timer_(TIMER_INVALID) {
     
     ESP_LOGI(TAG, "电池管理器已创建");
 }
@@ -263,8 +264,14 @@ bool battery_manager::init(std::shared_ptr<battery_device> device) {
     event_bus::get_instance().subscribe(event_type::network_disconnected, listener_ptr);
     event_bus::get_instance().subscribe(event_type::enter_deep_sleep, listener_ptr);
     
-    // 初始化状态
+    // 初始化状态，之后按BATTERY_CHECK_INTERVAL_MS由定时器采样
     update_battery_state();
+    if (timer_ == TIMER_INVALID) {
+        timer_ = timer_service::get_instance().add("battery", [this] { on_timer(); });
+    }
+    if (!timer_service::get_instance().schedule_in(timer_, BATTERY_CHECK_INTERVAL_MS)) {
+        ESP_LOGE(TAG, "无法注册定时器，电池状态不会定期更新");
+    }
     
     ESP_LOGI(TAG, "电池管理器初始化完成");
     return true;
@@ -352,15 +359,9 @@ void battery_manager::set_critical_battery_threshold(int percentage) {
     ESP_LOGI(TAG, "已设置严重低电量阈值为: %d%%", percentage);
 }
 
-void battery_manager::loop() {
-    static uint32_t last_check_time = 0;
-    uint32_t current_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
-    
-    // 定期检查电池状态
-    if (current_time - last_check_time >= BATTERY_CHECK_INTERVAL_MS) {
-        last_check_time = current_time;
-        update_battery_state();
-    }
+void battery_manager::on_timer() {
+    update_battery_state();
+    timer_service::get_instance().schedule_in(timer_, BATTERY_CHECK_INTERVAL_MS);
 }
 
 void battery_manager::on_event(const event_data& event) {
@@ -435,7 +436,7 @@ void battery_manager::update_battery_state() {
         // 发布温度过高事件
         if (!temp_warning_active_) {
             event_data event(event_type::battery_temp_high);
-            event_bus::get_instance().publish(event);
+            event_bus::get_instance().post(event);
             temp_warning_active_ = true;
         }
     } else if (temperature < BATTERY_TEMP_WARNING && temp_warning_active_) {
@@ -445,7 +446,7 @@ void battery_manager::update_battery_state() {
         
         // 发布温度正常事件
         event_data event(event_type::battery_temp_normal);
-        event_bus::get_instance().publish(event);
+        event_bus::get_instance().post(event);
         temp_warning_active_ = false;
     }
     
@@ -500,7 +501,7 @@ void battery_manager::update_battery_state() {
         }
         
         event_data event(evt_type);
-        event_bus::get_instance().publish(event);
+        event_bus::get_instance().post(event);
     }
     
     // 仅在调试日志级别输出详细信息
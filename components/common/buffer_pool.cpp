@@ -0,0 +1,200 @@
+#include "include/buffer_pool.h"
+#include <cstdlib>
+#include <new>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+static const char* TAG = "BufferPool";
+
+// 各规格的块大小和数量
+#define BUFFER_POOL_BLOCK_SIZES { 64, 256, 1024, 4096 }
+#define BUFFER_POOL_BLOCK_COUNTS { CONFIG_BUFFER_POOL_64_COUNT, CONFIG_BUFFER_POOL_256_COUNT, \
+                                   CONFIG_BUFFER_POOL_1024_COUNT, CONFIG_BUFFER_POOL_4096_COUNT }
+
+// 缓冲池所在内存
+#if CONFIG_BUFFER_POOL_USE_PSRAM
+#define BUFFER_POOL_CAPS (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#define BUFFER_POOL_MEMORY "PSRAM"
+#else
+#define BUFFER_POOL_CAPS (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#define BUFFER_POOL_MEMORY "内部RAM"
+#endif
+
+// 堆回退块的规格编号
+#define BUFFER_POOL_FALLBACK_CLASS BUFFER_POOL_CLASS_COUNT
+
+namespace esp_framework {
+
+// 数据区按块头对齐
+static constexpr size_t block_stride(uint32_t block_size) {
+    return (sizeof(buffer_block) + block_size + alignof(buffer_block) - 1) & ~(alignof(buffer_block) - 1);
+}
+
+// 初始化块头
+static buffer_block* init_block(void* mem, uint32_t capacity, uint8_t size_class) {
+    buffer_block* block = new (mem) buffer_block();
+    block->refs.store(1, std::memory_order_relaxed);
+    block->next_free = nullptr;
+    block->capacity = capacity;
+    block->size = 0;
+    block->size_class = size_class;
+    return block;
+}
+
+void pool_buffer::reset() {
+    if (block_ == nullptr) {
+        return;
+    }
+
+    if (block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        buffer_pool::get_instance().release(block_);
+    }
+    block_ = nullptr;
+}
+
+buffer_pool& buffer_pool::get_instance() {
+    static buffer_pool instance;
+    return instance;
+}
+
+buffer_pool::buffer_pool()
+    : classes_(),
+      initialized_(false),
+      acquired_(0),
+      fallback_allocs_(0),
+      failures_(0) {
+    portMUX_INITIALIZE(&lock_);
+}
+
+bool buffer_pool::init() {
+    if (initialized_) {
+        ESP_LOGW(TAG, "缓冲池已经初始化");
+        return true;
+    }
+
+    const uint32_t sizes[BUFFER_POOL_CLASS_COUNT] = BUFFER_POOL_BLOCK_SIZES;
+    const uint32_t counts[BUFFER_POOL_CLASS_COUNT] = BUFFER_POOL_BLOCK_COUNTS;
+
+    size_t total = 0;
+    for (size_t i = 0; i < BUFFER_POOL_CLASS_COUNT; i++) {
+        size_class& cls = classes_[i];
+        cls.block_size = sizes[i];
+        cls.block_count = counts[i];
+        cls.free_list = nullptr;
+        cls.free_count = 0;
+        cls.min_free_count = 0;
+        cls.slab = nullptr;
+
+        if (cls.block_count == 0) {
+            continue;
+        }
+
+        size_t stride = block_stride(cls.block_size);
+        cls.slab = static_cast<uint8_t*>(heap_caps_malloc(stride * cls.block_count, BUFFER_POOL_CAPS));
+        if (cls.slab == nullptr) {
+            ESP_LOGE(TAG, "缓冲池预分配失败: %lu x %lu字节",
+                     (unsigned long)cls.block_count, (unsigned long)cls.block_size);
+            // 释放已分配的大小等级，重试init()时从头开始
+            for (size_t j = 0; j < i; j++) {
+                if (classes_[j].slab != nullptr) {
+                    heap_caps_free(classes_[j].slab);
+                    classes_[j].slab = nullptr;
+                }
+                classes_[j].free_list = nullptr;
+                classes_[j].free_count = 0;
+                classes_[j].min_free_count = 0;
+            }
+            return false;
+        }
+
+        // 构建空闲链表
+        for (uint32_t n = 0; n < cls.block_count; n++) {
+            buffer_block* block = init_block(cls.slab + n * stride, cls.block_size, static_cast<uint8_t>(i));
+            block->refs.store(0, std::memory_order_relaxed);
+            block->next_free = cls.free_list;
+            cls.free_list = block;
+        }
+        cls.free_count = cls.block_count;
+        cls.min_free_count = cls.block_count;
+        total += stride * cls.block_count;
+    }
+
+    initialized_ = true;
+    ESP_LOGI(TAG, "缓冲池初始化完成: 64x%lu, 256x%lu, 1024x%lu, 4096x%lu, 共%lu字节(%s)",
+             (unsigned long)counts[0], (unsigned long)counts[1],
+             (unsigned long)counts[2], (unsigned long)counts[3],
+             (unsigned long)total, BUFFER_POOL_MEMORY);
+    return true;
+}
+
+pool_buffer buffer_pool::acquire(size_t size) {
+    if (initialized_) {
+        for (size_t i = 0; i < BUFFER_POOL_CLASS_COUNT; i++) {
+            size_class& cls = classes_[i];
+            if (cls.block_size < size) {
+                continue;
+            }
+
+            taskENTER_CRITICAL(&lock_);
+            buffer_block* block = cls.free_list;
+            if (block != nullptr) {
+                cls.free_list = block->next_free;
+                cls.free_count--;
+                if (cls.free_count < cls.min_free_count) {
+                    cls.min_free_count = cls.free_count;
+                }
+            }
+            taskEXIT_CRITICAL(&lock_);
+
+            if (block != nullptr) {
+                block->next_free = nullptr;
+                block->size = 0;
+                block->refs.store(1, std::memory_order_relaxed);
+                acquired_.fetch_add(1, std::memory_order_relaxed);
+                return pool_buffer(block);
+            }
+        }
+    }
+
+    // 池耗尽（或未初始化），回退到堆分配
+    void* mem = malloc(sizeof(buffer_block) + size);
+    if (mem == nullptr) {
+        failures_.fetch_add(1, std::memory_order_relaxed);
+        ESP_LOGE(TAG, "缓冲区分配失败: %lu字节", (unsigned long)size);
+        return pool_buffer();
+    }
+
+    fallback_allocs_.fetch_add(1, std::memory_order_relaxed);
+    ESP_LOGD(TAG, "缓冲池耗尽，回退到堆分配: %lu字节", (unsigned long)size);
+    return pool_buffer(init_block(mem, static_cast<uint32_t>(size), BUFFER_POOL_FALLBACK_CLASS));
+}
+
+void buffer_pool::release(buffer_block* block) {
+    if (block->size_class == BUFFER_POOL_FALLBACK_CLASS) {
+        block->~buffer_block();
+        free(block);
+        return;
+    }
+
+    size_class& cls = classes_[block->size_class];
+    taskENTER_CRITICAL(&lock_);
+    block->next_free = cls.free_list;
+    cls.free_list = block;
+    cls.free_count++;
+    taskEXIT_CRITICAL(&lock_);
+}
+
+buffer_pool_stats buffer_pool::get_stats() const {
+    buffer_pool_stats stats = {};
+    stats.acquired = acquired_.load(std::memory_order_relaxed);
+    stats.fallback_allocs = fallback_allocs_.load(std::memory_order_relaxed);
+    stats.failures = failures_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < BUFFER_POOL_CLASS_COUNT; i++) {
+        stats.free_blocks[i] = classes_[i].free_count;
+        stats.min_free_blocks[i] = classes_[i].min_free_count;
+    }
+    return stats;
+}
+
+} // namespace esp_framework
@@ -1,17 +1,115 @@
 #include "include/event_system.h"
 #include "esp_log.h"
+#include "sdkconfig.h"
 #include <algorithm>
 
 static const char* TAG = "EventBus";
 
+// 异步分发配置
+#define EVENT_BUS_QUEUE_LENGTH CONFIG_EVENT_BUS_QUEUE_LENGTH
+#define EVENT_BUS_TASK_STACK_SIZE CONFIG_EVENT_BUS_TASK_STACK_SIZE
+#define EVENT_BUS_TASK_PRIORITY CONFIG_EVENT_BUS_TASK_PRIORITY
+#define EVENT_BUS_TASK_CORE CONFIG_EVENT_BUS_TASK_CORE
+
 namespace esp_framework {
 
+// 当前任务正在执行的publish()层数，监听器中取消注册时不等待（自身就是进行中的发布者）
+static thread_local uint32_t s_publish_depth = 0;
+
 // 获取事件管理器实例
 event_bus& event_bus::get_instance() {
     static event_bus instance;
     return instance;
 }
 
+// 事件数据分配统计
+static std::atomic<uint32_t> s_inline_payloads(0);
+static std::atomic<uint32_t> s_buffer_payloads(0);
+static std::atomic<uint32_t> s_buffer_bytes(0);
+
+// 复制数据构造事件，小数据内联存储
+event_data::event_data(event_type t, event_data_type dt, const void* src, size_t size)
+    : type(t), data_type(dt), buffer(), data_size(0) {
+    if (src == nullptr || size == 0) {
+        return;
+    }
+    
+    if (size <= INLINE_CAPACITY) {
+        memcpy(inline_data, src, size);
+        data_size = size;
+        s_inline_payloads.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    
+    buffer = buffer_pool::get_instance().acquire(size);
+    if (!buffer) {
+        ESP_LOGE(TAG, "内存不足，无法复制事件数据: %d字节", static_cast<int>(size));
+        return;
+    }
+    memcpy(buffer.data(), src, size);
+    buffer.set_size(size);
+    data_size = size;
+    s_buffer_payloads.fetch_add(1, std::memory_order_relaxed);
+    s_buffer_bytes.fetch_add(static_cast<uint32_t>(size), std::memory_order_relaxed);
+}
+
+event_alloc_stats event_data::get_alloc_stats() {
+    event_alloc_stats stats;
+    stats.inline_payloads = s_inline_payloads.load(std::memory_order_relaxed);
+    stats.buffer_payloads = s_buffer_payloads.load(std::memory_order_relaxed);
+    stats.buffer_bytes = s_buffer_bytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// 构造函数，创建异步事件队列和分发任务
+event_bus::event_bus()
+    : subscribers_(),
+      stale_mask_(0),
+      epoch_(0),
+      active_publishers_(),
+      has_retired_(false),
+      slots_(EVENT_BUS_QUEUE_LENGTH, event_data(event_type::max_event_type)),
+      free_slots_(nullptr),
+      queue_(nullptr),
+      dispatcher_handle_(nullptr),
+      dropped_count_(0) {
+    free_slots_ = xQueueCreate(EVENT_BUS_QUEUE_LENGTH, sizeof(uint32_t));
+    queue_ = xQueueCreate(EVENT_BUS_QUEUE_LENGTH, sizeof(uint32_t));
+    if (free_slots_ == nullptr || queue_ == nullptr) {
+        ESP_LOGE(TAG, "事件队列创建失败，post()不可用");
+        if (free_slots_ != nullptr) {
+            vQueueDelete(free_slots_);
+            free_slots_ = nullptr;
+        }
+        if (queue_ != nullptr) {
+            vQueueDelete(queue_);
+            queue_ = nullptr;
+        }
+        return;
+    }
+    
+    for (uint32_t slot = 0; slot < EVENT_BUS_QUEUE_LENGTH; slot++) {
+        xQueueSend(free_slots_, &slot, 0);
+    }
+    
+    BaseType_t core = EVENT_BUS_TASK_CORE < 0 ? tskNO_AFFINITY : EVENT_BUS_TASK_CORE;
+    BaseType_t ret = xTaskCreatePinnedToCore(dispatcher_task, "event_dispatch",
+                                             EVENT_BUS_TASK_STACK_SIZE, this,
+                                             EVENT_BUS_TASK_PRIORITY,
+                                             &dispatcher_handle_, core);
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "事件分发任务创建失败: %d", ret);
+        vQueueDelete(free_slots_);
+        vQueueDelete(queue_);
+        free_slots_ = nullptr;
+        queue_ = nullptr;
+        return;
+    }
+    
+    ESP_LOGI(TAG, "事件分发任务已启动: 队列长度=%d, 优先级=%d, 核心=%d",
+             EVENT_BUS_QUEUE_LENGTH, EVENT_BUS_TASK_PRIORITY, EVENT_BUS_TASK_CORE);
+}
+
 // 注册事件监听器
 void event_bus::subscribe(event_type type, std::shared_ptr<event_listener> listener) {
     if (!listener) {
@@ -19,32 +117,44 @@ void event_bus::subscribe(event_type type, std::shared_ptr<event_listener> liste
         return;
     }
     
-    // 检查是否已注册
-    auto& listeners = listeners_[type];
+    size_t index = static_cast<size_t>(type);
+    if (index >= EVENT_TYPE_COUNT) {
+        ESP_LOGE(TAG, "无效的事件类型: %d", static_cast<int>(type));
+        return;
+    }
     
-    // 清理过期的weak_ptr
-    listeners.erase(
-        std::remove_if(listeners.begin(), listeners.end(),
-                      [](const std::weak_ptr<event_listener>& wp) {
-                          return wp.expired();
-                      }),
-        listeners.end()
-    );
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    const subscriber_list* current = subscribers_[index].load();
     
     // 检查是否已存在
-    auto it = std::find_if(listeners.begin(), listeners.end(),
-                          [&listener](const std::weak_ptr<event_listener>& wp) {
-                              auto sp = wp.lock();
-                              return sp && sp == listener;
-                          });
-    
-    if (it != listeners.end()) {
-        ESP_LOGW(TAG, "监听器已存在，跳过注册");
+    if (current != nullptr) {
+        auto it = std::find_if(current->begin(), current->end(),
+                               [&listener](const subscriber& sub) {
+                                   return sub.listener == listener.get() && !sub.ref.expired();
+                               });
+        if (it != current->end()) {
+            ESP_LOGW(TAG, "监听器已存在，跳过注册");
+            return;
+        }
+    }
+    
+    // 复制当前快照（顺便清理过期的监听器），追加新监听器后整体替换
+    subscriber_list* list = new subscriber_list();
+    if (list == nullptr) {
+        ESP_LOGE(TAG, "内存不足，无法注册事件监听器: %d", static_cast<int>(type));
         return;
     }
+    if (current != nullptr) {
+        list->reserve(current->size() + 1);
+        for (const subscriber& sub : *current) {
+            if (!sub.ref.expired()) {
+                list->push_back(sub);
+            }
+        }
+    }
+    list->push_back(subscriber{listener.get(), listener});
     
-    // 添加监听器
-    listeners.push_back(listener);
+    replace_subscribers(index, list);
     ESP_LOGI(TAG, "已注册事件监听器: %d", static_cast<int>(type));
 }
 
@@ -55,54 +165,225 @@ void event_bus::unsubscribe(event_type type, std::shared_ptr<event_listener> lis
         return;
     }
     
-    auto it = listeners_.find(type);
-    if (it == listeners_.end()) {
-        ESP_LOGW(TAG, "事件类型 %d 无监听器", static_cast<int>(type));
+    size_t index = static_cast<size_t>(type);
+    if (index >= EVENT_TYPE_COUNT) {
+        ESP_LOGE(TAG, "无效的事件类型: %d", static_cast<int>(type));
         return;
     }
     
-    auto& listeners = it->second;
-    
-    // 移除指定监听器
-    listeners.erase(
-        std::remove_if(listeners.begin(), listeners.end(),
-                      [&listener](const std::weak_ptr<event_listener>& wp) {
-                          auto sp = wp.lock();
-                          return !sp || sp == listener;
-                      }),
-        listeners.end()
-    );
+    uint32_t replaced_epoch = 0;
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        const subscriber_list* current = subscribers_[index].load();
+        if (current == nullptr) {
+            ESP_LOGW(TAG, "事件类型 %d 无监听器", static_cast<int>(type));
+        } else {
+            // 复制除指定监听器和过期监听器以外的条目
+            subscriber_list* list = new subscriber_list();
+            if (list == nullptr) {
+                ESP_LOGE(TAG, "内存不足，无法取消注册事件监听器: %d", static_cast<int>(type));
+                return;
+            }
+            list->reserve(current->size());
+            for (const subscriber& sub : *current) {
+                if (sub.listener != listener.get() && !sub.ref.expired()) {
+                    list->push_back(sub);
+                }
+            }
+            replace_subscribers(index, list);
+        }
+        replaced_epoch = epoch_.load();
+    }
     
+    // 等待可能仍在调用该监听器的发布者退出，返回后即可销毁监听器。
+    // 监听器已不在快照中时（例如已在on_event()中取消注册）同样需要等待：发布者可能仍持有旧快照
+    if (s_publish_depth == 0) {
+        wait_for_publishers(replaced_epoch);
+    }
     ESP_LOGI(TAG, "已取消注册事件监听器: %d", static_cast<int>(type));
 }
 
+// 等待纪元推进两次，此前登记的发布者均已退出
+void event_bus::wait_for_publishers(uint32_t epoch) {
+    while (1) {
+        {
+            std::lock_guard<std::mutex> lock(writer_mutex_);
+            collect_retired();
+            if (epoch_.load() - epoch >= 2) {
+                return;
+            }
+        }
+        vTaskDelay(1);
+    }
+}
+
 // 发布事件
 void event_bus::publish(const event_data& event) {
-    auto it = listeners_.find(event.type);
-    if (it == listeners_.end()) {
-        ESP_LOGD(TAG, "事件类型 %d 无监听器，跳过发布", static_cast<int>(event.type));
+    size_t index = static_cast<size_t>(event.type);
+    if (index >= EVENT_TYPE_COUNT) {
+        ESP_LOGE(TAG, "无效的事件类型: %d", static_cast<int>(event.type));
         return;
     }
     
-    auto& listeners = it->second;
+    // 先登记到当前纪元再读取快照，回收方据此判断快照是否仍可能被引用
+    uint32_t slot = epoch_.load() & 1;
+    active_publishers_[slot].fetch_add(1);
+    s_publish_depth++;
     
-    // 清理过期的weak_ptr
-    listeners.erase(
-        std::remove_if(listeners.begin(), listeners.end(),
-                      [](const std::weak_ptr<event_listener>& wp) {
-                          return wp.expired();
-                      }),
-        listeners.end()
-    );
+    const subscriber_list* list = subscribers_[index].load();
+    if (list == nullptr) {
+        ESP_LOGD(TAG, "事件类型 %d 无监听器，跳过发布", static_cast<int>(event.type));
+    } else {
+        ESP_LOGD(TAG, "发布事件: %d, 监听器数: %d", 
+                 static_cast<int>(event.type), static_cast<int>(list->size()));
+        
+        for (const subscriber& sub : *list) {
+            // 调用期间持有强引用：监听器可能未取消注册就在其他任务中被销毁，
+            // 先检查expired()再调用原始指针会有释放后使用。过期条目留给reap_expired()清理
+            std::shared_ptr<event_listener> listener = sub.ref.lock();
+            if (!listener) {
+                stale_mask_.fetch_or(1u << index, std::memory_order_relaxed);
+                continue;
+            }
+            listener->on_event(event);
+        }
+    }
     
-    ESP_LOGI(TAG, "发布事件: %d, 监听器数: %d", 
-             static_cast<int>(event.type), listeners.size());
+    s_publish_depth--;
+    active_publishers_[slot].fetch_sub(1);
+}
+
+// 清理已销毁的监听器
+void event_bus::reap_expired() {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    reap_expired_locked();
+}
+
+size_t event_bus::get_retired_count() {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    return retired_.size();
+}
+
+void event_bus::reap_expired_locked() {
+    uint32_t mask = stale_mask_.exchange(0);
+    
+    for (size_t index = 0; mask != 0 && index < EVENT_TYPE_COUNT; index++) {
+        if ((mask & (1u << index)) == 0) {
+            continue;
+        }
+        mask &= ~(1u << index);
+        
+        const subscriber_list* current = subscribers_[index].load();
+        if (current == nullptr) {
+            continue;
+        }
+        
+        subscriber_list* list = new subscriber_list();
+        if (list == nullptr) {
+            stale_mask_.fetch_or(1u << index); // 下次再试
+            continue;
+        }
+        for (const subscriber& sub : *current) {
+            if (!sub.ref.expired()) {
+                list->push_back(sub);
+            }
+        }
+        replace_subscribers(index, list);
+        ESP_LOGD(TAG, "已清理事件类型 %d 的过期监听器", static_cast<int>(index));
+    }
+    
+    collect_retired();
+}
+
+// 替换订阅者快照
+void event_bus::replace_subscribers(size_t index, const subscriber_list* list) {
+    if (list != nullptr && list->empty()) {
+        delete list;
+        list = nullptr;
+    }
     
-    // 通知所有监听器
-    for (auto& wp : listeners) {
-        auto sp = wp.lock();
-        if (sp) {
-            sp->on_event(event);
+    const subscriber_list* old = subscribers_[index].exchange(list);
+    
+    // 旧快照可能正被其他任务（或本任务外层的on_event）遍历，记录替换时的纪元后延迟释放
+    if (old != nullptr) {
+        retired_.push_back(retired_list{old, epoch_.load()});
+        has_retired_.store(true);
+    }
+    collect_retired();
+}
+
+// 回收旧快照
+void event_bus::collect_retired() {
+    // 上一纪元（与下一纪元同奇偶）的发布者全部退出后才能推进纪元。
+    // 在纪元E被替换的快照，只可能被登记在E或更早纪元的发布者持有，
+    // 纪元推进到E+2时这些发布者均已退出。最多推进两次，空闲时可立即回收。
+    for (int i = 0; i < 2; i++) {
+        uint32_t epoch = epoch_.load();
+        if (active_publishers_[(epoch + 1) & 1].load() != 0) {
+            break;
+        }
+        epoch_.store(epoch + 1);
+    }
+    
+    uint32_t epoch = epoch_.load();
+    auto it = std::remove_if(retired_.begin(), retired_.end(),
+                             [epoch](const retired_list& r) {
+                                 if (epoch - r.epoch < 2) {
+                                     return false;
+                                 }
+                                 delete r.list;
+                                 return true;
+                             });
+    retired_.erase(it, retired_.end());
+    has_retired_.store(!retired_.empty());
+}
+
+// 投递事件
+bool event_bus::post(const event_data& event) {
+    if (queue_ == nullptr) {
+        ESP_LOGE(TAG, "事件队列未初始化，无法投递事件: %d", static_cast<int>(event.type));
+        return false;
+    }
+    
+    // 不等待，没有空闲槽位时直接丢弃，避免阻塞发布者
+    uint32_t slot = 0;
+    if (xQueueReceive(free_slots_, &slot, 0) != pdTRUE) {
+        dropped_count_.fetch_add(1, std::memory_order_relaxed);
+        ESP_LOGW(TAG, "事件队列已满，丢弃事件: %d", static_cast<int>(event.type));
+        return false;
+    }
+    
+    // 复制内联数据或缓冲区的引用，不分配内存
+    slots_[slot] = event;
+    
+    // 槽位数与队列长度相同，取得槽位后入队不会失败
+    xQueueSend(queue_, &slot, 0);
+    return true;
+}
+
+uint32_t event_bus::get_dropped_count() const {
+    return dropped_count_.load(std::memory_order_relaxed);
+}
+
+// 事件分发任务
+void event_bus::dispatcher_task(void* arg) {
+    event_bus* bus = static_cast<event_bus*>(arg);
+    uint32_t slot = 0;
+    
+    while (1) {
+        if (xQueueReceive(bus->queue_, &slot, portMAX_DELAY) == pdTRUE) {
+            event_data& event = bus->slots_[slot];
+            bus->publish(event);
+            
+            // 尽早归还缓冲区，再归还槽位
+            event.buffer.reset();
+            event.data_size = 0;
+            xQueueSend(bus->free_slots_, &slot, 0);
+        }
+        
+        // 在发布路径之外清理已销毁的监听器和待回收快照
+        if (bus->stale_mask_.load(std::memory_order_relaxed) != 0 || bus->has_retired_.load()) {
+            bus->reap_expired();
         }
     }
 }
@@ -0,0 +1,41 @@
+#include "include/heap_monitor.h"
+#include <atomic>
+#include <cstddef>
+#include "sdkconfig.h"
+
+namespace esp_framework {
+
+static std::atomic<uint32_t> s_allocs(0);
+static std::atomic<uint32_t> s_frees(0);
+
+bool heap_monitor::enabled() {
+#if CONFIG_HEAP_CALL_COUNTER
+    return true;
+#else
+    return false;
+#endif
+}
+
+heap_call_stats heap_monitor::get_stats() {
+    heap_call_stats stats;
+    stats.allocs = s_allocs.load(std::memory_order_relaxed);
+    stats.frees = s_frees.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace esp_framework
+
+#if CONFIG_HEAP_CALL_COUNTER
+// ESP-IDF堆钩子（CONFIG_HEAP_USE_HOOKS），在每次分配和释放后调用
+extern "C" void esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t caps) {
+    (void)ptr;
+    (void)size;
+    (void)caps;
+    esp_framework::s_allocs.fetch_add(1, std::memory_order_relaxed);
+}
+
+extern "C" void esp_heap_trace_free_hook(void* ptr) {
+    (void)ptr;
+    esp_framework::s_frees.fetch_add(1, std::memory_order_relaxed);
+}
+#endif
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "freertos/FreeRTOS.h"
+
+namespace esp_framework {
+
+/**
+ * @brief 缓冲池规格数量（64/256/1024/4096字节）
+ */
+constexpr size_t BUFFER_POOL_CLASS_COUNT = 4;
+
+/**
+ * @brief 缓冲池统计信息
+ */
+struct buffer_pool_stats {
+    uint32_t acquired;                              // 从池中成功分配的次数
+    uint32_t fallback_allocs;                       // 池耗尽后回退到堆分配的次数
+    uint32_t failures;                              // 分配失败次数
+    uint32_t free_blocks[BUFFER_POOL_CLASS_COUNT];  // 各规格当前空闲块数
+    uint32_t min_free_blocks[BUFFER_POOL_CLASS_COUNT]; // 各规格历史最少空闲块数
+};
+
+/**
+ * @brief 缓冲块头部，紧邻数据区之前
+ */
+struct buffer_block {
+    std::atomic<uint32_t> refs;   // 引用计数
+    buffer_block* next_free;      // 空闲链表指针
+    uint32_t capacity;            // 数据区容量
+    uint32_t size;                // 有效数据长度
+    uint8_t size_class;           // 所属规格，堆回退块为BUFFER_POOL_CLASS_COUNT
+};
+
+/**
+ * @brief 引用计数的缓冲区句柄
+ *
+ * 复制句柄只增加引用计数，最后一个句柄销毁时缓冲块归还缓冲池。
+ */
+class pool_buffer {
+public:
+    pool_buffer() : block_(nullptr) {}
+
+    ~pool_buffer() { reset(); }
+
+    pool_buffer(const pool_buffer& other) : block_(other.block_) {
+        if (block_ != nullptr) {
+            block_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    pool_buffer& operator=(const pool_buffer& other) {
+        if (block_ != other.block_) {
+            pool_buffer tmp(other);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    pool_buffer(pool_buffer&& other) noexcept : block_(other.block_) {
+        other.block_ = nullptr;
+    }
+
+    pool_buffer& operator=(pool_buffer&& other) noexcept {
+        if (this != &other) {
+            reset();
+            block_ = other.block_;
+            other.block_ = nullptr;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief 释放对缓冲块的引用
+     */
+    void reset();
+
+    /**
+     * @brief 交换两个句柄
+     */
+    void swap(pool_buffer& other) {
+        buffer_block* tmp = block_;
+        block_ = other.block_;
+        other.block_ = tmp;
+    }
+
+    /**
+     * @brief 获取数据区指针
+     * @return 数据区指针，空句柄返回nullptr
+     */
+    uint8_t* data() const {
+        return block_ != nullptr ? reinterpret_cast<uint8_t*>(block_ + 1) : nullptr;
+    }
+
+    /**
+     * @brief 获取有效数据长度
+     */
+    size_t size() const { return block_ != nullptr ? block_->size : 0; }
+
+    /**
+     * @brief 获取数据区容量
+     */
+    size_t capacity() const { return block_ != nullptr ? block_->capacity : 0; }
+
+    /**
+     * @brief 设置有效数据长度（不超过容量）
+     * @param size 数据长度
+     */
+    void set_size(size_t size) {
+        if (block_ != nullptr) {
+            block_->size = static_cast<uint32_t>(size < block_->capacity ? size : block_->capacity);
+        }
+    }
+
+    /**
+     * @brief 是否持有缓冲块
+     */
+    explicit operator bool() const { return block_ != nullptr; }
+
+    /**
+     * @brief 交出缓冲块所有权，用于通过FreeRTOS队列传递句柄
+     * @return 缓冲块原始指针，需由adopt()接管
+     */
+    buffer_block* detach() {
+        buffer_block* block = block_;
+        block_ = nullptr;
+        return block;
+    }
+
+    /**
+     * @brief 接管detach()交出的缓冲块
+     * @param block 缓冲块原始指针
+     * @return 缓冲区句柄
+     */
+    static pool_buffer adopt(buffer_block* block) {
+        pool_buffer buf;
+        buf.block_ = block;
+        return buf;
+    }
+
+private:
+    friend class buffer_pool;
+
+    explicit pool_buffer(buffer_block* block) : block_(block) {}
+
+    buffer_block* block_;
+};
+
+/**
+ * @brief 固定块缓冲池（单例模式）
+ *
+ * 启动时按规格预分配所有缓冲块（可选放在PSRAM中），数据路径上分配和释放
+ * 只操作空闲链表，不调用malloc。池耗尽时回退到堆分配并计数。
+ */
+class buffer_pool {
+public:
+    /**
+     * @brief 获取缓冲池实例
+     * @return 缓冲池引用
+     */
+    static buffer_pool& get_instance();
+
+    /**
+     * @brief 预分配所有缓冲块，应在启动时调用一次
+     * @return 成功返回true，失败返回false
+     */
+    bool init();
+
+    /**
+     * @brief 分配至少size字节的缓冲区
+     *
+     * 优先使用能容纳size的最小规格，该规格耗尽时尝试更大的规格，
+     * 全部耗尽时回退到堆分配。
+     * @param size 需要的容量
+     * @return 缓冲区句柄，有效数据长度为0；分配失败返回空句柄
+     */
+    pool_buffer acquire(size_t size);
+
+    /**
+     * @brief 获取统计信息
+     * @return 统计信息
+     */
+    buffer_pool_stats get_stats() const;
+
+private:
+    friend class pool_buffer;
+
+    buffer_pool();
+    ~buffer_pool() = default;
+
+    // 禁止复制和移动
+    buffer_pool(const buffer_pool&) = delete;
+    buffer_pool& operator=(const buffer_pool&) = delete;
+    buffer_pool(buffer_pool&&) = delete;
+    buffer_pool& operator=(buffer_pool&&) = delete;
+
+    // 归还缓冲块
+    void release(buffer_block* block);
+
+    /**
+     * @brief 单一规格的空闲链表
+     */
+    struct size_class {
+        uint32_t block_size;      // 数据区容量
+        uint32_t block_count;     // 块数量
+        uint8_t* slab;            // 预分配的连续内存
+        buffer_block* free_list;  // 空闲链表
+        uint32_t free_count;      // 空闲块数
+        uint32_t min_free_count;  // 历史最少空闲块数
+    };
+
+    size_class classes_[BUFFER_POOL_CLASS_COUNT];
+    bool initialized_;
+    portMUX_TYPE lock_;                     // 保护空闲链表
+    std::atomic<uint32_t> acquired_;
+    std::atomic<uint32_t> fallback_allocs_;
+    std::atomic<uint32_t> failures_;
+};
+
+} // namespace esp_framework
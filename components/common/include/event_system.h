@@ -1,10 +1,17 @@
 #pragma once
 
+#include <atomic>
+#include <cstring>
 #include <functional>
-#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include "buffer_pool.h"
 
 namespace esp_framework {
 
@@ -23,7 +30,12 @@ enum class event_type {
     battery_temp_high,     // 电池温度过高
     battery_temp_normal,   // 电池温度正常
     device_error,          // 设备错误
-    enter_deep_sleep       // 进入深度睡眠
+    enter_deep_sleep,      // 进入深度睡眠
+    uplink_high_watermark, // 上行队列越过高水位线（数据为队列字节数）
+    uplink_low_watermark,  // 上行队列回落到低水位线（数据为队列字节数）
+    tcp_state_changed,     // TCP连接状态变化（数据为connection_state）
+    
+    max_event_type         // 事件类型数量（必须位于最后）
 };
 
 /**
@@ -38,31 +50,149 @@ enum class event_data_type {
     binary          // 二进制数据
 };
 
+/**
+ * @brief 事件数据分配统计
+ */
+struct event_alloc_stats {
+    uint32_t inline_payloads;   // 内联存储的数据次数
+    uint32_t buffer_payloads;   // 复制到缓冲池缓冲区的次数
+    uint32_t buffer_bytes;      // 复制到缓冲池缓冲区的总字节数
+};
+
 /**
  * @brief 事件数据结构
+ * 
+ * 不超过EVENT_INLINE_PAYLOAD_SIZE字节的数据直接存放在结构体内部，
+ * 更大的数据使用引用计数的缓冲池缓冲区。整数、浮点数和布尔值总是内联存储。
  */
 struct event_data {
+    static constexpr size_t INLINE_CAPACITY = CONFIG_EVENT_INLINE_PAYLOAD_SIZE;
+    static_assert(INLINE_CAPACITY >= sizeof(int32_t), "内联缓冲区至少需要容纳一个整数");
+    
     event_type type;         // 事件类型
     event_data_type data_type; // 数据类型
-    std::shared_ptr<uint8_t[]> data; // 数据指针，使用shared_ptr管理内存
-    size_t data_size;        // 数据大小（仅对string和binary有效）
+    pool_buffer buffer;      // 大数据的共享缓冲区，数据内联存储时为空
+    size_t data_size;        // 数据大小
+    alignas(4) uint8_t inline_data[INLINE_CAPACITY]; // 小数据的内联存储
     
-    // 构造函数
-    event_data(event_type t, event_data_type dt = event_data_type::none, 
-               std::shared_ptr<uint8_t[]> d = nullptr, size_t ds = 0) 
-        : type(t), data_type(dt), data(d), data_size(ds) {}
+    // 构造函数，不携带数据
+    explicit event_data(event_type t, event_data_type dt = event_data_type::none) 
+        : type(t), data_type(dt), buffer(), data_size(0) {}
+    
+    /**
+     * @brief 构造函数，引用已有的缓冲区（不复制数据）
+     * @param t 事件类型
+     * @param dt 数据类型
+     * @param buf 缓冲区句柄，数据大小取buf.size()
+     */
+    event_data(event_type t, event_data_type dt, pool_buffer buf) 
+        : type(t), data_type(dt), buffer(std::move(buf)), data_size(buffer.size()) {}
+    
+    /**
+     * @brief 构造函数，复制数据：小数据内联存储，超过内联容量时从缓冲池分配
+     * @param t 事件类型
+     * @param dt 数据类型
+     * @param src 数据源
+     * @param size 数据大小
+     */
+    event_data(event_type t, event_data_type dt, const void* src, size_t size);
     
-    // 析构函数 - 现在可以使用默认析构函数，shared_ptr会自动管理内存
+    /**
+     * @brief 创建携带整数的事件
+     */
+    static event_data from_integer(event_type t, int32_t value) {
+        return event_data(t, event_data_type::integer, &value, sizeof(value));
+    }
+    
+    /**
+     * @brief 创建携带浮点数的事件
+     */
+    static event_data from_float(event_type t, float value) {
+        return event_data(t, event_data_type::floating, &value, sizeof(value));
+    }
+    
+    /**
+     * @brief 创建携带布尔值的事件
+     */
+    static event_data from_bool(event_type t, bool value) {
+        return event_data(t, event_data_type::boolean, &value, sizeof(value));
+    }
+    
+    /**
+     * @brief 获取数据指针
+     * @return 数据指针，无数据时返回nullptr
+     */
+    const uint8_t* payload() const {
+        if (buffer) {
+            return buffer.data();
+        }
+        return data_size > 0 ? inline_data : nullptr;
+    }
+    
+    /**
+     * @brief 读取整数数据
+     * @return 整数值，数据类型不匹配时返回0
+     */
+    int32_t as_integer() const {
+        int32_t value = 0;
+        if (data_type == event_data_type::integer && data_size == sizeof(value)) {
+            memcpy(&value, payload(), sizeof(value));
+        }
+        return value;
+    }
+    
+    /**
+     * @brief 读取浮点数数据
+     * @return 浮点数值，数据类型不匹配时返回0
+     */
+    float as_float() const {
+        float value = 0.0f;
+        if (data_type == event_data_type::floating && data_size == sizeof(value)) {
+            memcpy(&value, payload(), sizeof(value));
+        }
+        return value;
+    }
+    
+    /**
+     * @brief 读取布尔数据
+     * @return 布尔值，数据类型不匹配时返回false
+     */
+    bool as_bool() const {
+        return data_type == event_data_type::boolean && data_size > 0 && payload()[0] != 0;
+    }
+    
+    /**
+     * @brief 获取事件数据分配统计
+     * @return 分配统计
+     */
+    static event_alloc_stats get_alloc_stats();
+    
+    // 析构函数 - 缓冲区句柄会自动归还缓冲池
     ~event_data() = default;
     
-    // 复制构造和赋值操作禁用
-    event_data(const event_data&) = delete;
-    event_data& operator=(const event_data&) = delete;
+    // 复制构造和赋值：内联数据被复制，共享缓冲区只增加引用计数
+    event_data(const event_data& other)
+        : type(other.type), data_type(other.data_type), 
+          buffer(other.buffer), data_size(other.data_size) {
+        copy_inline(other);
+    }
+    
+    event_data& operator=(const event_data& other) {
+        if (this != &other) {
+            type = other.type;
+            data_type = other.data_type;
+            buffer = other.buffer;
+            data_size = other.data_size;
+            copy_inline(other);
+        }
+        return *this;
+    }
     
     // 移动构造和赋值
     event_data(event_data&& other) noexcept
         : type(other.type), data_type(other.data_type), 
-          data(std::move(other.data)), data_size(other.data_size) {
+          buffer(std::move(other.buffer)), data_size(other.data_size) {
+        copy_inline(other);
         other.data_size = 0;
     }
     
@@ -70,12 +200,21 @@ struct event_data {
         if (this != &other) {
             type = other.type;
             data_type = other.data_type;
-            data = std::move(other.data);
+            buffer = std::move(other.buffer);
             data_size = other.data_size;
+            copy_inline(other);
             other.data_size = 0;
         }
         return *this;
     }
+    
+private:
+    // 仅复制实际使用的内联字节
+    void copy_inline(const event_data& other) {
+        if (!buffer && data_size > 0) {
+            memcpy(inline_data, other.inline_data, data_size);
+        }
+    }
 };
 
 /**
@@ -97,6 +236,9 @@ public:
 
 /**
  * @brief 事件管理器（单例模式）
+ * 
+ * 支持多任务并发发布与订阅。发布路径不加锁：读取订阅者快照前登记到当前纪元，
+ * 订阅变更在写锁内替换快照，旧快照在所有可能引用它的发布者退出后才释放（基于纪元的回收）。
  */
 class event_bus {
 public:
@@ -108,6 +250,9 @@ public:
     
     /**
      * @brief 注册事件监听器
+     * 
+     * 事件总线只持有监听器的弱引用，发布时在调用期间持有强引用。监听器未取消注册就销毁时
+     * 不再被调用，过期条目由reap_expired()清理；仍应在不再需要时取消注册。
      * @param type 事件类型
      * @param listener 监听器智能指针
      */
@@ -115,22 +260,66 @@ public:
     
     /**
      * @brief 取消监听器注册
+     * 
+     * 等待可能仍在调用该监听器的发布者退出后返回，返回后即可销毁监听器。
+     * 在监听器的on_event()中调用时不等待，监听器须在本次发布返回后再销毁。
      * @param type 事件类型
      * @param listener 监听器智能指针
      */
     void unsubscribe(event_type type, std::shared_ptr<event_listener> listener);
     
     /**
-     * @brief 发布事件
+     * @brief 发布事件（同步，在调用者任务中依次执行所有监听器）
      * @param event 事件数据
      */
     void publish(const event_data& event);
     
+    /**
+     * @brief 投递事件（异步，由分发任务执行监听器）
+     * 
+     * 事件数据被复制到预分配的有界队列中（不分配内存），发布者不会被监听器阻塞。
+     * 队列已满时事件被丢弃。
+     * @param event 事件数据
+     * @return 成功入队返回true，队列已满或未初始化返回false
+     */
+    bool post(const event_data& event);
+    
+    /**
+     * @brief 获取因队列已满而丢弃的事件数
+     * @return 丢弃的事件数
+     */
+    uint32_t get_dropped_count() const;
+    
+    /**
+     * @brief 清理已销毁的监听器，不在发布路径上执行
+     */
+    void reap_expired();
+    
+    /**
+     * @brief 获取等待回收的旧快照数
+     * @return 旧快照数，没有进行中的发布时回收后应为0
+     */
+    size_t get_retired_count();
+    
 private:
     /**
-     * @brief 构造函数（私有）
+     * @brief 订阅者条目
+     */
+    struct subscriber {
+        event_listener* listener;             // 原始指针，仅在订阅变更时用于比较，发布时不使用
+        std::weak_ptr<event_listener> ref;    // 弱引用，发布时提升为强引用后调用
+    };
+    
+    // 订阅者快照，发布后不可修改，订阅变更时整体替换（写时复制）
+    typedef std::vector<subscriber> subscriber_list;
+    
+    static constexpr size_t EVENT_TYPE_COUNT = static_cast<size_t>(event_type::max_event_type);
+    static_assert(EVENT_TYPE_COUNT <= 32, "stale_mask_ 最多支持32种事件类型");
+
+    /**
+     * @brief 构造函数（私有），创建事件队列和分发任务
      */
-    event_bus() = default;
+    event_bus();
     
     /**
      * @brief 析构函数（私有）
@@ -143,8 +332,47 @@ private:
     event_bus(event_bus&&) = delete;
     event_bus& operator=(event_bus&&) = delete;
     
-    // 事件监听器映射表
-    std::map<event_type, std::vector<std::weak_ptr<event_listener>>> listeners_;
+    // 事件分发任务
+    static void dispatcher_task(void* arg);
+    
+    /**
+     * @brief 等待回收的旧快照
+     */
+    struct retired_list {
+        const subscriber_list* list;   // 旧快照
+        uint32_t epoch;                // 被替换时的纪元
+    };
+    
+    // 替换指定事件类型的订阅者快照，旧快照延迟回收（需持有writer_mutex_）
+    void replace_subscribers(size_t index, const subscriber_list* list);
+    
+    // 推进纪元并回收不再被发布者引用的旧快照（需持有writer_mutex_）
+    void collect_retired();
+    
+    // 等待纪元从epoch推进两次，即此前登记的发布者全部退出（不能持有writer_mutex_）
+    void wait_for_publishers(uint32_t epoch);
+    
+    // 清理已销毁的监听器（需持有writer_mutex_）
+    void reap_expired_locked();
+    
+    // 按事件类型索引的订阅者快照表，无订阅者时为nullptr
+    std::atomic<const subscriber_list*> subscribers_[EVENT_TYPE_COUNT];
+    std::atomic<uint32_t> stale_mask_;            // 含已销毁监听器的事件类型位图
+    
+    // 纪元回收：发布者按纪元奇偶登记，快照替换两个纪元后即无发布者引用
+    std::atomic<uint32_t> epoch_;                 // 当前纪元
+    std::atomic<uint32_t> active_publishers_[2];  // 按纪元奇偶统计的进行中发布数
+    std::atomic<bool> has_retired_;               // 是否存在待回收快照
+    
+    std::mutex writer_mutex_;                     // 串行化订阅变更与回收，发布路径不使用
+    std::vector<retired_list> retired_;           // 等待回收的旧快照
+    
+    // 异步分发：事件复制到预分配的槽位中，队列只传递槽位索引，投递时不分配内存
+    std::vector<event_data> slots_;    // 预分配的事件槽位
+    QueueHandle_t free_slots_;         // 空闲槽位索引队列
+    QueueHandle_t queue_;              // 待分发槽位索引队列
+    TaskHandle_t dispatcher_handle_;   // 分发任务句柄
+    std::atomic<uint32_t> dropped_count_; // 丢弃的事件数
 };
 
 } // namespace esp_framework 
\ No newline at end of file
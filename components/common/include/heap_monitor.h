@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esp_framework {
+
+/**
+ * @brief 堆调用统计
+ */
+struct heap_call_stats {
+    uint32_t allocs;    // 分配调用次数
+    uint32_t frees;     // 释放调用次数
+};
+
+/**
+ * @brief 堆调用计数器
+ *
+ * 启用CONFIG_HEAP_CALL_COUNTER后通过ESP-IDF堆钩子统计所有malloc/free调用，
+ * 用于验证数据路径在稳态下不访问堆；未启用时计数恒为0。
+ */
+class heap_monitor {
+public:
+    /**
+     * @brief 是否启用了堆调用计数
+     */
+    static bool enabled();
+
+    /**
+     * @brief 获取累计堆调用次数
+     * @return 堆调用统计
+     */
+    static heap_call_stats get_stats();
+};
+
+} // namespace esp_framework
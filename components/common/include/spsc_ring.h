@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace esp_framework {
+
+/**
+ * @brief 单生产者/单消费者无锁环形队列
+ *
+ * 只允许一个任务调用push()，一个任务调用pop()，双方无需加锁。
+ * 元素类型需可平凡复制（例如缓冲块指针），容量向上取整为2的幂。
+ */
+template <typename T>
+class spsc_ring {
+public:
+    spsc_ring() : slots_(nullptr), mask_(0), head_(0), tail_(0) {}
+
+    ~spsc_ring() { delete[] slots_; }
+
+    // 禁止复制和移动
+    spsc_ring(const spsc_ring&) = delete;
+    spsc_ring& operator=(const spsc_ring&) = delete;
+
+    /**
+     * @brief 分配存储空间，必须在生产者和消费者开始工作前调用
+     * @param capacity 期望容量
+     * @return 成功返回true，失败返回false
+     */
+    bool init(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        slots_ = new (std::nothrow) T[size];
+        if (slots_ == nullptr) {
+            return false;
+        }
+        mask_ = size - 1;
+        return true;
+    }
+
+    /**
+     * @brief 入队（仅生产者调用）
+     * @param item 元素
+     * @return 成功返回true，队列已满返回false
+     */
+    bool push(const T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) > mask_) {
+            return false;
+        }
+        slots_[head & mask_] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 出队（仅消费者调用）
+     * @param item 输出元素
+     * @return 成功返回true，队列为空返回false
+     */
+    bool pop(T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = slots_[tail & mask_];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 当前元素数（近似值，双方均可调用）
+     */
+    size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief 队列容量
+     */
+    size_t capacity() const { return slots_ != nullptr ? mask_ + 1 : 0; }
+
+private:
+    T* slots_;
+    size_t mask_;
+    std::atomic<size_t> head_;   // 下一个写入位置，仅生产者修改
+    std::atomic<size_t> tail_;   // 下一个读取位置，仅消费者修改
+};
+
+} // namespace esp_framework
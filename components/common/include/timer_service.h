@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+namespace esp_framework {
+
+/**
+ * @brief 定时器数量上限
+ */
+constexpr size_t TIMER_SERVICE_MAX = 8;
+
+/**
+ * @brief 定时器编号，add()失败时为TIMER_INVALID
+ */
+typedef int timer_id;
+constexpr timer_id TIMER_INVALID = -1;
+
+/**
+ * @brief 单个定时器的统计
+ */
+struct timer_info {
+    const char* name;           // 名称
+    int64_t deadline_us;        // 到期时间（esp_timer微秒），-1表示未安排
+    uint32_t fires;             // 触发次数
+    uint32_t max_late_us;       // 触发时间晚于到期时间的最大值
+};
+
+/**
+ * @brief 定时器服务统计
+ */
+struct timer_service_stats {
+    uint32_t wakeups;           // 服务任务被唤醒的次数（到期或提前安排）
+    uint32_t fires;             // 所有定时器的触发次数
+    int64_t uptime_us;          // 服务任务启动后的时间
+};
+
+/**
+ * @brief 一次性定时器服务（单例模式）
+ *
+ * 各模块注册定时器并安排到期时间，服务任务阻塞到最早的到期时间，到期后在服务任务中调用回调，
+ * 没有定时器到期时不唤醒。回调中可以重新安排任何定时器（周期性定时器在回调中安排下一次）。
+ * 回调不应长时间阻塞，否则推迟其他定时器。
+ *
+ * 定时器在到期时间之后的第一个系统节拍触发，精度为一个节拍。
+ */
+class timer_service {
+public:
+    /**
+     * @brief 获取定时器服务实例
+     * @return 定时器服务引用
+     */
+    static timer_service& get_instance();
+
+    /**
+     * @brief 创建服务任务，重复调用无效果
+     * @return 成功返回true
+     */
+    bool init();
+
+    /**
+     * @brief 注册定时器，注册后未安排
+     * @param name 名称（静态字符串）
+     * @param callback 到期时在服务任务中调用
+     * @return 定时器编号，数量超过TIMER_SERVICE_MAX时返回TIMER_INVALID
+     */
+    timer_id add(const char* name, std::function<void()> callback);
+
+    /**
+     * @brief 安排定时器的到期时间，替换之前的安排
+     * @param id 定时器编号
+     * @param deadline_us esp_timer时间（微秒），已过去时尽快触发
+     * @return 编号无效时返回false
+     */
+    bool schedule_at(timer_id id, int64_t deadline_us);
+
+    /**
+     * @brief 安排定时器在delay_ms毫秒后到期，替换之前的安排
+     */
+    bool schedule_in(timer_id id, uint32_t delay_ms);
+
+    /**
+     * @brief 只在新的到期时间更早（或未安排）时安排定时器，用于频繁调用的路径
+     */
+    bool expedite(timer_id id, int64_t deadline_us);
+
+    /**
+     * @brief 取消定时器的安排
+     */
+    bool cancel(timer_id id);
+
+    /**
+     * @brief 获取服务统计
+     */
+    timer_service_stats get_stats() const;
+
+    /**
+     * @brief 获取所有定时器的统计
+     * @param out 输出数组
+     * @param max 数组容量
+     * @return 写入的数量
+     */
+    size_t snapshot(timer_info* out, size_t max) const;
+
+    /**
+     * @brief 打印服务任务唤醒次数（及每小时折算）和各定时器的下次到期时间、触发次数
+     * @param tag 日志标签
+     */
+    void dump(const char* tag) const;
+
+private:
+    timer_service();
+    ~timer_service() = default;
+
+    // 禁止复制和移动
+    timer_service(const timer_service&) = delete;
+    timer_service& operator=(const timer_service&) = delete;
+
+    struct entry {
+        const char* name;               // nullptr表示未使用
+        std::function<void()> callback; // add()中设置后不再修改，服务任务在锁外直接调用
+        int64_t deadline_us;            // -1表示未安排
+        uint32_t fires;
+        uint32_t max_late_us;
+    };
+
+    static void task_entry(void* arg);
+    void run();
+
+    // 安排到期时间，早于服务任务当前等待的时间时唤醒服务任务（调用者持有锁）
+    void schedule_locked(entry& item, int64_t deadline_us);
+
+    entry entries_[TIMER_SERVICE_MAX];
+    size_t count_;
+    TaskHandle_t task_;
+    int64_t waiting_until_us_;          // 服务任务当前等待到的时间，-1表示无限等待
+    int64_t start_us_;
+    uint32_t wakeups_;
+    uint32_t fires_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace esp_framework
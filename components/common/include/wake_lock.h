@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+namespace esp_framework {
+
+/**
+ * @brief 唤醒锁数量上限（不同名称的个数）
+ */
+constexpr size_t WAKE_LOCK_MAX = 8;
+
+/**
+ * @brief 单个唤醒锁的统计
+ */
+struct wake_lock_info {
+    const char* name;           // 名称
+    uint32_t count;             // 当前持有次数，0表示未持有
+    uint32_t acquisitions;      // 从未持有变为持有的次数
+    uint32_t held_ms;           // 本次已持有的时间，未持有时为0
+    uint32_t total_ms;          // 累计持有时间（含本次）
+};
+
+/**
+ * @brief 命名的引用计数唤醒锁（单例模式）
+ *
+ * 各模块以名称获取和释放唤醒锁，同一名称可被多次获取，释放相同次数后才解除；
+ * 任一唤醒锁被持有时电源管理器不会进入低功耗模式。名称必须是静态字符串（如字面量），
+ * 只保存指针。
+ */
+class wake_locks {
+public:
+    /**
+     * @brief 获取唤醒锁管理器实例
+     * @return 唤醒锁管理器引用
+     */
+    static wake_locks& get_instance();
+
+    /**
+     * @brief 获取唤醒锁
+     * @param name 名称（静态字符串）
+     * @return 成功返回true，名称数量超过WAKE_LOCK_MAX时返回false
+     */
+    bool acquire(const char* name);
+
+    /**
+     * @brief 释放唤醒锁
+     * @param name 名称
+     * @return 成功返回true，未持有该锁时返回false
+     */
+    bool release(const char* name);
+
+    /**
+     * @brief 是否有唤醒锁被持有
+     */
+    bool held() const;
+
+    /**
+     * @brief 最后一个唤醒锁被释放的时间
+     * @return esp_timer时间（微秒），从未释放过时为0
+     */
+    int64_t last_release_us() const;
+
+    /**
+     * @brief 设置held()变化时的通知，在获取或释放唤醒锁的任务中调用（不持有内部锁）
+     * @param observer 通知函数，为空时取消
+     */
+    void set_observer(std::function<void()> observer);
+    
+    /**
+     * @brief 获取所有唤醒锁的统计
+     * @param out 输出数组
+     * @param max 数组容量
+     * @return 写入的数量
+     */
+    size_t snapshot(wake_lock_info* out, size_t max) const;
+
+    /**
+     * @brief 打印持有中的唤醒锁和各自持有的时间
+     * @param tag 日志标签
+     */
+    void dump(const char* tag) const;
+
+private:
+    wake_locks();
+    ~wake_locks() = default;
+
+    // 禁止复制和移动
+    wake_locks(const wake_locks&) = delete;
+    wake_locks& operator=(const wake_locks&) = delete;
+
+    struct entry {
+        const char* name;       // nullptr表示未使用
+        uint32_t count;
+        uint32_t acquisitions;
+        int64_t since_us;       // 本次开始持有的时间
+        int64_t total_us;       // 之前各次持有的累计时间
+    };
+
+    // 按名称查找（调用者持有锁）
+    entry* find(const char* name);
+
+    entry entries_[WAKE_LOCK_MAX];
+    std::atomic<uint32_t> held_count_;      // 持有中的锁的个数
+    std::atomic<int64_t> last_release_us_;
+    std::function<void()> observer_;        // held()变化时的通知
+    mutable std::mutex mutex_;
+};
+
+} // namespace esp_framework
@@ -0,0 +1,223 @@
+#include "include/timer_service.h"
+#include <climits>
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char* TAG = "TimerService";
+
+// 回调中会打印日志（含浮点数）和挂起设备，栈比FreeRTOS定时器任务的默认值大
+#define TIMER_SERVICE_STACK_SIZE 4096
+#define TIMER_SERVICE_PRIORITY 5
+
+namespace esp_framework {
+
+// 服务任务正在处理到期的定时器，不需要唤醒
+static constexpr int64_t TIMER_SERVICE_RUNNING = INT64_MIN;
+
+timer_service& timer_service::get_instance() {
+    static timer_service instance;
+    return instance;
+}
+
+timer_service::timer_service()
+    : count_(0),
+      task_(nullptr),
+      waiting_until_us_(TIMER_SERVICE_RUNNING),
+      start_us_(0),
+      wakeups_(0),
+      fires_(0) {
+    for (auto& item : entries_) {
+        item.name = nullptr;
+        item.deadline_us = -1;
+        item.fires = 0;
+        item.max_late_us = 0;
+    }
+}
+
+bool timer_service::init() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (task_ != nullptr) {
+        return true;
+    }
+    start_us_ = esp_timer_get_time();
+    if (xTaskCreate(task_entry, "timer_svc", TIMER_SERVICE_STACK_SIZE, this, TIMER_SERVICE_PRIORITY, &task_) != pdPASS) {
+        ESP_LOGE(TAG, "定时器服务任务创建失败");
+        task_ = nullptr;
+        return false;
+    }
+    ESP_LOGI(TAG, "定时器服务已启动");
+    return true;
+}
+
+timer_id timer_service::add(const char* name, std::function<void()> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (count_ >= TIMER_SERVICE_MAX) {
+        ESP_LOGE(TAG, "定时器数量超过上限%u，无法注册: %s", (unsigned)TIMER_SERVICE_MAX, name);
+        return TIMER_INVALID;
+    }
+    entry& item = entries_[count_];
+    item.name = name;
+    item.callback = std::move(callback);
+    item.deadline_us = -1;
+    return static_cast<timer_id>(count_++);
+}
+
+void timer_service::schedule_locked(entry& item, int64_t deadline_us) {
+    item.deadline_us = deadline_us;
+    if (deadline_us < waiting_until_us_ && task_ != nullptr) {
+        // 新的到期时间早于服务任务等待的时间，唤醒它重新计算
+        waiting_until_us_ = TIMER_SERVICE_RUNNING;
+        xTaskNotifyGive(task_);
+    }
+}
+
+bool timer_service::schedule_at(timer_id id, int64_t deadline_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (id < 0 || static_cast<size_t>(id) >= count_) {
+        return false;
+    }
+    schedule_locked(entries_[id], deadline_us < 0 ? 0 : deadline_us);
+    return true;
+}
+
+bool timer_service::schedule_in(timer_id id, uint32_t delay_ms) {
+    return schedule_at(id, esp_timer_get_time() + static_cast<int64_t>(delay_ms) * 1000);
+}
+
+bool timer_service::expedite(timer_id id, int64_t deadline_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (id < 0 || static_cast<size_t>(id) >= count_) {
+        return false;
+    }
+    entry& item = entries_[id];
+    if (item.deadline_us >= 0 && item.deadline_us <= deadline_us) {
+        return true;
+    }
+    schedule_locked(item, deadline_us < 0 ? 0 : deadline_us);
+    return true;
+}
+
+bool timer_service::cancel(timer_id id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (id < 0 || static_cast<size_t>(id) >= count_) {
+        return false;
+    }
+    // 服务任务等待到原来的时间后发现没有到期的定时器，重新计算等待时间
+    entries_[id].deadline_us = -1;
+    return true;
+}
+
+void timer_service::task_entry(void* arg) {
+    static_cast<timer_service*>(arg)->run();
+}
+
+void timer_service::run() {
+    const int64_t tick_us = static_cast<int64_t>(portTICK_PERIOD_MS) * 1000;
+    size_t due[TIMER_SERVICE_MAX];
+
+    while (true) {
+        TickType_t wait = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            int64_t now = esp_timer_get_time();
+            int64_t earliest = INT64_MAX;
+            for (size_t i = 0; i < count_; i++) {
+                if (entries_[i].deadline_us >= 0 && entries_[i].deadline_us < earliest) {
+                    earliest = entries_[i].deadline_us;
+                }
+            }
+            if (earliest == INT64_MAX) {
+                wait = portMAX_DELAY;
+            } else if (earliest > now) {
+                // 向上取整到节拍，保证醒来时已经到期
+                int64_t ticks = (earliest - now + tick_us - 1) / tick_us;
+                wait = static_cast<TickType_t>(ticks < static_cast<int64_t>(portMAX_DELAY) ? ticks : portMAX_DELAY - 1);
+            }
+            waiting_until_us_ = wait == 0 ? TIMER_SERVICE_RUNNING : earliest;
+        }
+
+        if (wait != 0) {
+            ulTaskNotifyTake(pdTRUE, wait);
+        }
+
+        size_t due_count = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (wait != 0) {
+                wakeups_++;
+            }
+            waiting_until_us_ = TIMER_SERVICE_RUNNING;
+            int64_t now = esp_timer_get_time();
+            for (size_t i = 0; i < count_; i++) {
+                entry& item = entries_[i];
+                if (item.deadline_us < 0 || item.deadline_us > now) {
+                    continue;
+                }
+                uint32_t late = static_cast<uint32_t>(now - item.deadline_us);
+                if (late > item.max_late_us) {
+                    item.max_late_us = late;
+                }
+                item.deadline_us = -1;
+                item.fires++;
+                fires_++;
+                due[due_count++] = i;
+            }
+        }
+
+        // 在锁外调用回调，回调中可以重新安排定时器。已注册条目的回调不再修改，
+        // 直接通过条目调用，不复制std::function（复制可能分配堆内存）
+        for (size_t i = 0; i < due_count; i++) {
+            const std::function<void()>& callback = entries_[due[i]].callback;
+            if (callback) {
+                callback();
+            }
+        }
+    }
+}
+
+timer_service_stats timer_service::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timer_service_stats stats;
+    stats.wakeups = wakeups_;
+    stats.fires = fires_;
+    stats.uptime_us = task_ != nullptr ? esp_timer_get_time() - start_us_ : 0;
+    return stats;
+}
+
+size_t timer_service::snapshot(timer_info* out, size_t max) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (size_t i = 0; i < count_ && count < max; i++) {
+        const entry& item = entries_[i];
+        timer_info& info = out[count++];
+        info.name = item.name;
+        info.deadline_us = item.deadline_us;
+        info.fires = item.fires;
+        info.max_late_us = item.max_late_us;
+    }
+    return count;
+}
+
+void timer_service::dump(const char* tag) const {
+    timer_service_stats stats = get_stats();
+    timer_info infos[TIMER_SERVICE_MAX];
+    size_t count = snapshot(infos, TIMER_SERVICE_MAX);
+    int64_t now = esp_timer_get_time();
+    double hours = stats.uptime_us / 3.6e9;
+    ESP_LOGI(tag, "定时器服务: 唤醒%lu次(每小时%.0f次), 触发%lu次",
+             (unsigned long)stats.wakeups, hours > 0 ? stats.wakeups / hours : 0.0, (unsigned long)stats.fires);
+    for (size_t i = 0; i < count; i++) {
+        const timer_info& info = infos[i];
+        if (info.deadline_us >= 0) {
+            ESP_LOGI(tag, "  定时器 %s: %lldms后到期, 触发%lu次(每小时%.0f次), 最多延迟%luus",
+                     info.name, static_cast<long long>(info.deadline_us > now ? (info.deadline_us - now) / 1000 : 0),
+                     (unsigned long)info.fires, hours > 0 ? info.fires / hours : 0.0, (unsigned long)info.max_late_us);
+        } else {
+            ESP_LOGI(tag, "  定时器 %s: 未安排, 触发%lu次(每小时%.0f次), 最多延迟%luus",
+                     info.name, (unsigned long)info.fires, hours > 0 ? info.fires / hours : 0.0,
+                     (unsigned long)info.max_late_us);
+        }
+    }
+}
+
+} // namespace esp_framework
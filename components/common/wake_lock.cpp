@@ -0,0 +1,149 @@
+#include "include/wake_lock.h"
+#include <cstring>
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char* TAG = "WakeLock";
+
+namespace esp_framework {
+
+wake_locks& wake_locks::get_instance() {
+    static wake_locks instance;
+    return instance;
+}
+
+wake_locks::wake_locks()
+    : held_count_(0),
+      last_release_us_(0) {
+    memset(entries_, 0, sizeof(entries_));
+}
+
+wake_locks::entry* wake_locks::find(const char* name) {
+    for (auto& item : entries_) {
+        if (item.name != nullptr && (item.name == name || strcmp(item.name, name) == 0)) {
+            return &item;
+        }
+    }
+    return nullptr;
+}
+
+bool wake_locks::acquire(const char* name) {
+    if (name == nullptr) {
+        return false;
+    }
+    std::function<void()> observer;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entry* item = find(name);
+        if (item == nullptr) {
+            for (auto& slot : entries_) {
+                if (slot.name == nullptr) {
+                    item = &slot;
+                    item->name = name;
+                    break;
+                }
+            }
+            if (item == nullptr) {
+                ESP_LOGE(TAG, "唤醒锁数量超过上限%u，无法获取: %s", (unsigned)WAKE_LOCK_MAX, name);
+                return false;
+            }
+        }
+        if (item->count++ == 0) {
+            item->since_us = esp_timer_get_time();
+            item->acquisitions++;
+            if (held_count_.fetch_add(1, std::memory_order_relaxed) == 0) {
+                observer = observer_;
+            }
+            ESP_LOGD(TAG, "获取唤醒锁: %s", name);
+        }
+    }
+    // 在锁外通知，通知函数中可以查询唤醒锁
+    if (observer) {
+        observer();
+    }
+    return true;
+}
+
+bool wake_locks::release(const char* name) {
+    if (name == nullptr) {
+        return false;
+    }
+    std::function<void()> observer;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entry* item = find(name);
+        if (item == nullptr || item->count == 0) {
+            ESP_LOGW(TAG, "释放未持有的唤醒锁: %s", name);
+            return false;
+        }
+        if (--item->count == 0) {
+            int64_t now = esp_timer_get_time();
+            item->total_us += now - item->since_us;
+            // 先记录时间再减少计数，held()为false时last_release_us()已更新
+            last_release_us_.store(now, std::memory_order_relaxed);
+            if (held_count_.fetch_sub(1, std::memory_order_release) == 1) {
+                observer = observer_;
+            }
+            ESP_LOGD(TAG, "释放唤醒锁: %s，持有%lldms", name, (long long)((now - item->since_us) / 1000));
+        }
+    }
+    if (observer) {
+        observer();
+    }
+    return true;
+}
+
+void wake_locks::set_observer(std::function<void()> observer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    observer_ = std::move(observer);
+}
+
+bool wake_locks::held() const {
+    return held_count_.load(std::memory_order_acquire) > 0;
+}
+
+int64_t wake_locks::last_release_us() const {
+    return last_release_us_.load(std::memory_order_relaxed);
+}
+
+size_t wake_locks::snapshot(wake_lock_info* out, size_t max) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t now = esp_timer_get_time();
+    size_t count = 0;
+    for (const auto& item : entries_) {
+        if (item.name == nullptr || count >= max) {
+            continue;
+        }
+        int64_t held_us = item.count > 0 ? now - item.since_us : 0;
+        wake_lock_info& info = out[count++];
+        info.name = item.name;
+        info.count = item.count;
+        info.acquisitions = item.acquisitions;
+        info.held_ms = static_cast<uint32_t>(held_us / 1000);
+        info.total_ms = static_cast<uint32_t>((item.total_us + held_us) / 1000);
+    }
+    return count;
+}
+
+void wake_locks::dump(const char* tag) const {
+    wake_lock_info infos[WAKE_LOCK_MAX];
+    size_t count = snapshot(infos, WAKE_LOCK_MAX);
+    bool any = false;
+    for (size_t i = 0; i < count; i++) {
+        const wake_lock_info& info = infos[i];
+        if (info.count > 0) {
+            ESP_LOGI(tag, "  唤醒锁 %s: 持有%lu次, 已持有%lums(累计%lums, 获取%lu次)",
+                     info.name, (unsigned long)info.count, (unsigned long)info.held_ms,
+                     (unsigned long)info.total_ms, (unsigned long)info.acquisitions);
+            any = true;
+        } else {
+            ESP_LOGD(tag, "  唤醒锁 %s: 未持有(累计%lums, 获取%lu次)",
+                     info.name, (unsigned long)info.total_ms, (unsigned long)info.acquisitions);
+        }
+    }
+    if (!any) {
+        ESP_LOGI(tag, "  没有持有中的唤醒锁");
+    }
+}
+
+} // namespace esp_framework
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/uio.h>
+
+namespace esp_framework {
+
+/**
+ * 流式LZ77压缩格式，由若干序列组成，每个序列字节对齐：
+ *
+ *   标记 | [字面量长度扩展] | 字面量 | [距离(2字节小端) | [匹配长度扩展]]
+ *
+ * 标记高4位为字面量字节数L，低4位M：0表示本序列没有匹配，否则匹配长度为M+2（3~17）。
+ * L或M为15时后跟扩展字节，逐个累加，字节为255时继续读取下一个。
+ * 距离为1~窗口大小，匹配可与输出重叠（距离小于长度时按字节复制）。
+ *
+ * 历史窗口跨越多次compress()保留，每次compress()的输出以完整序列结束，
+ * 接收方收到一次输出即可全部解出。连接重置时双方都须从空窗口重新开始。
+ */
+constexpr uint8_t LZ_MIN_WINDOW_BITS = 9;
+constexpr uint8_t LZ_MAX_WINDOW_BITS = 12;
+
+/**
+ * @brief 压缩器统计
+ */
+struct lz_encoder_stats {
+    uint32_t input_bytes;       // 累计输入字节数
+    uint32_t output_bytes;      // 累计输出字节数
+    uint32_t calls;             // compress()次数（刷新次数）
+    uint32_t matches;           // 输出的匹配数
+};
+
+/**
+ * @brief 流式压缩器
+ *
+ * 内存占用为2倍窗口的历史缓冲区加半个窗口项的哈希表（窗口2KB时共6KB），
+ * 在init()中一次分配。每个位置只查找哈希表中最近的一个候选，不搜索哈希链。
+ * 不加锁，调用者须保证同一时刻只有一个任务使用。
+ */
+class lz_encoder {
+public:
+    lz_encoder();
+    ~lz_encoder();
+
+    /**
+     * @brief 分配历史缓冲区和哈希表
+     * @param window_bits 窗口大小的对数，LZ_MIN_WINDOW_BITS~LZ_MAX_WINDOW_BITS
+     * @return 成功返回true
+     */
+    bool init(uint8_t window_bits);
+
+    /**
+     * @brief 清空历史窗口，之后的输出不再引用之前的数据
+     */
+    void reset();
+
+    /**
+     * @brief 压缩一组数据段并刷新
+     * @param segments 输入数据段，按顺序视为连续数据
+     * @param count 段数
+     * @param out 输出缓冲区，至少max_compressed_size(输入总字节数)字节
+     * @return 输出字节数
+     */
+    size_t compress(const struct iovec* segments, size_t count, uint8_t* out);
+
+    /**
+     * @brief size字节输入的最大输出字节数
+     */
+    static constexpr size_t max_compressed_size(size_t size) {
+        return size + size / 64 + 16;
+    }
+
+    lz_encoder_stats get_stats() const { return stats_; }
+
+private:
+    // 编码pos_到limit之间的数据，输出剩余字面量
+    uint8_t* encode(uint8_t* out, size_t limit);
+
+    // 历史缓冲区满时保留最近一个窗口的数据
+    void slide();
+
+    // 输出一个序列
+    static uint8_t* emit(uint8_t* out, const uint8_t* literals, size_t literal_count,
+                         size_t distance, size_t match_length);
+
+    uint32_t hash(size_t pos) const;
+
+    uint8_t* buffer_;           // 历史和待编码数据，2倍窗口
+    uint16_t* table_;           // 三字节哈希 -> 最近位置
+    size_t window_;
+    uint8_t hash_bits_;
+    size_t end_;                // 缓冲区中的数据量
+    size_t pos_;                // 下一个待编码的位置
+    lz_encoder_stats stats_;
+};
+
+/**
+ * @brief 流式解压器
+ *
+ * 输入须由完整的compress()输出组成（一次发送或一帧负载），不支持序列被拆开。
+ */
+class lz_decoder {
+public:
+    lz_decoder();
+    ~lz_decoder();
+
+    /**
+     * @brief 分配历史窗口
+     * @param window_bits 与压缩器相同的窗口大小对数
+     * @return 成功返回true
+     */
+    bool init(uint8_t window_bits);
+
+    /**
+     * @brief 清空历史窗口
+     */
+    void reset();
+
+    /**
+     * @brief 解压一段输入
+     * @param data 输入数据
+     * @param size 输入字节数
+     * @param out 输出缓冲区
+     * @param capacity 输出缓冲区大小
+     * @return 输出字节数，格式错误或输出空间不足时返回-1
+     */
+    int decompress(const uint8_t* data, size_t size, uint8_t* out, size_t capacity);
+
+private:
+    uint8_t* history_;          // 最近一个窗口的输出（环形）
+    size_t window_;
+    size_t head_;               // 下一个写入位置
+    size_t filled_;             // 历史中的有效字节数
+};
+
+} // namespace esp_framework
@@ -0,0 +1,261 @@
+#include "lz_codec.h"
+#include <cstring>
+#include <new>
+#include "esp_log.h"
+
+static const char* TAG = "LzCodec";
+
+namespace esp_framework {
+
+static constexpr size_t MIN_MATCH = 3;
+static constexpr uint16_t EMPTY_SLOT = 0xFFFF;
+
+// 写入扩展长度（value已减去15）
+static uint8_t* put_extension(uint8_t* out, size_t value) {
+    while (value >= 255) {
+        *out++ = 255;
+        value -= 255;
+    }
+    *out++ = static_cast<uint8_t>(value);
+    return out;
+}
+
+lz_encoder::lz_encoder()
+    : buffer_(nullptr),
+      table_(nullptr),
+      window_(0),
+      hash_bits_(0),
+      end_(0),
+      pos_(0),
+      stats_() {
+}
+
+lz_encoder::~lz_encoder() {
+    delete[] buffer_;
+    delete[] table_;
+}
+
+bool lz_encoder::init(uint8_t window_bits) {
+    if (window_bits < LZ_MIN_WINDOW_BITS || window_bits > LZ_MAX_WINDOW_BITS) {
+        ESP_LOGE(TAG, "窗口大小无效: 2^%u", window_bits);
+        return false;
+    }
+    window_ = static_cast<size_t>(1) << window_bits;
+    hash_bits_ = window_bits - 1;
+    buffer_ = new (std::nothrow) uint8_t[window_ * 2];
+    table_ = new (std::nothrow) uint16_t[static_cast<size_t>(1) << hash_bits_];
+    if (buffer_ == nullptr || table_ == nullptr) {
+        ESP_LOGE(TAG, "压缩器内存分配失败");
+        return false;
+    }
+    reset();
+    return true;
+}
+
+void lz_encoder::reset() {
+    end_ = 0;
+    pos_ = 0;
+    for (size_t i = 0; i < (static_cast<size_t>(1) << hash_bits_); i++) {
+        table_[i] = EMPTY_SLOT;
+    }
+}
+
+uint32_t lz_encoder::hash(size_t pos) const {
+    uint32_t v = buffer_[pos] | (buffer_[pos + 1] << 8) | (buffer_[pos + 2] << 16);
+    return (v * 2654435761u) >> (32 - hash_bits_);
+}
+
+uint8_t* lz_encoder::emit(uint8_t* out, const uint8_t* literals, size_t literal_count,
+                          size_t distance, size_t match_length) {
+    size_t m = match_length > 0 ? match_length - 2 : 0;
+    uint8_t* token = out++;
+    *token = static_cast<uint8_t>((literal_count < 15 ? literal_count : 15) << 4 | (m < 15 ? m : 15));
+    if (literal_count >= 15) {
+        out = put_extension(out, literal_count - 15);
+    }
+    memcpy(out, literals, literal_count);
+    out += literal_count;
+    if (match_length > 0) {
+        *out++ = static_cast<uint8_t>(distance);
+        *out++ = static_cast<uint8_t>(distance >> 8);
+        if (m >= 15) {
+            out = put_extension(out, m - 15);
+        }
+    }
+    return out;
+}
+
+uint8_t* lz_encoder::encode(uint8_t* out, size_t limit) {
+    size_t pos = pos_;
+    size_t literal_start = pos;
+
+    while (pos + MIN_MATCH <= limit) {
+        uint32_t h = hash(pos);
+        size_t candidate = table_[h];
+        table_[h] = static_cast<uint16_t>(pos);
+        if (candidate == EMPTY_SLOT || pos - candidate > window_ ||
+            memcmp(buffer_ + candidate, buffer_ + pos, MIN_MATCH) != 0) {
+            pos++;
+            continue;
+        }
+
+        // 匹配可延伸到当前数据末尾，与待编码数据重叠时相当于重复
+        size_t length = MIN_MATCH;
+        while (pos + length < limit && buffer_[candidate + length] == buffer_[pos + length]) {
+            length++;
+        }
+        out = emit(out, buffer_ + literal_start, pos - literal_start, pos - candidate, length);
+        stats_.matches++;
+
+        // 匹配内部的位置也加入哈希表，重复的遥测数据常从记录中间开始匹配
+        for (size_t p = pos + 1; p < pos + length && p + MIN_MATCH <= limit; p++) {
+            table_[hash(p)] = static_cast<uint16_t>(p);
+        }
+        pos += length;
+        literal_start = pos;
+    }
+
+    // 刷新：末尾不足一个匹配的数据作为字面量输出
+    if (literal_start < limit) {
+        out = emit(out, buffer_ + literal_start, limit - literal_start, 0, 0);
+    }
+    pos_ = limit;
+    return out;
+}
+
+void lz_encoder::slide() {
+    size_t shift = end_ - window_;
+    memmove(buffer_, buffer_ + shift, window_);
+    end_ = window_;
+    pos_ -= shift;
+    for (size_t i = 0; i < (static_cast<size_t>(1) << hash_bits_); i++) {
+        table_[i] = (table_[i] != EMPTY_SLOT && table_[i] >= shift)
+            ? static_cast<uint16_t>(table_[i] - shift) : EMPTY_SLOT;
+    }
+}
+
+size_t lz_encoder::compress(const struct iovec* segments, size_t count, uint8_t* out) {
+    uint8_t* start = out;
+    size_t input = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* data = static_cast<const uint8_t*>(segments[i].iov_base);
+        size_t size = segments[i].iov_len;
+        input += size;
+        while (size > 0) {
+            if (end_ == window_ * 2) {
+                out = encode(out, end_);
+                slide();
+            }
+            size_t n = window_ * 2 - end_;
+            if (n > size) {
+                n = size;
+            }
+            memcpy(buffer_ + end_, data, n);
+            end_ += n;
+            data += n;
+            size -= n;
+        }
+    }
+    out = encode(out, end_);
+
+    stats_.input_bytes += static_cast<uint32_t>(input);
+    stats_.output_bytes += static_cast<uint32_t>(out - start);
+    stats_.calls++;
+    return static_cast<size_t>(out - start);
+}
+
+lz_decoder::lz_decoder()
+    : history_(nullptr),
+      window_(0),
+      head_(0),
+      filled_(0) {
+}
+
+lz_decoder::~lz_decoder() {
+    delete[] history_;
+}
+
+bool lz_decoder::init(uint8_t window_bits) {
+    if (window_bits < LZ_MIN_WINDOW_BITS || window_bits > LZ_MAX_WINDOW_BITS) {
+        ESP_LOGE(TAG, "窗口大小无效: 2^%u", window_bits);
+        return false;
+    }
+    window_ = static_cast<size_t>(1) << window_bits;
+    history_ = new (std::nothrow) uint8_t[window_];
+    if (history_ == nullptr) {
+        ESP_LOGE(TAG, "解压器内存分配失败");
+        return false;
+    }
+    reset();
+    return true;
+}
+
+void lz_decoder::reset() {
+    head_ = 0;
+    filled_ = 0;
+}
+
+// 读取扩展长度，输入不足时返回false
+static bool get_extension(const uint8_t*& data, const uint8_t* end, size_t& value) {
+    uint8_t byte;
+    do {
+        if (data == end) {
+            return false;
+        }
+        byte = *data++;
+        value += byte;
+    } while (byte == 255);
+    return true;
+}
+
+int lz_decoder::decompress(const uint8_t* data, size_t size, uint8_t* out, size_t capacity) {
+    const uint8_t* end = data + size;
+    size_t produced = 0;
+
+    auto put = [&](uint8_t byte) {
+        out[produced++] = byte;
+        history_[head_] = byte;
+        head_ = (head_ + 1) & (window_ - 1);
+        if (filled_ < window_) {
+            filled_++;
+        }
+    };
+
+    while (data < end) {
+        uint8_t token = *data++;
+        size_t literals = token >> 4;
+        size_t m = token & 0x0F;
+        if (literals == 15 && !get_extension(data, end, literals)) {
+            return -1;
+        }
+        if (static_cast<size_t>(end - data) < literals || capacity - produced < literals) {
+            return -1;
+        }
+        for (size_t i = 0; i < literals; i++) {
+            put(*data++);
+        }
+        if (m == 0) {
+            continue;
+        }
+
+        if (end - data < 2) {
+            return -1;
+        }
+        size_t distance = data[0] | (data[1] << 8);
+        data += 2;
+        if (m == 15 && !get_extension(data, end, m)) {
+            return -1;
+        }
+        size_t length = m + 2;
+        if (distance == 0 || distance > filled_ || capacity - produced < length) {
+            return -1;
+        }
+        for (size_t i = 0; i < length; i++) {
+            put(history_[(head_ - distance) & (window_ - 1)]);
+        }
+    }
+    return static_cast<int>(produced);
+}
+
+} // namespace esp_framework
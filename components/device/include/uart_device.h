@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <memory>
 #include <vector>
@@ -8,9 +9,21 @@
 #include "freertos/queue.h"
 #include "driver/uart.h"
 #include "device.h"
+#include "buffer_pool.h"
 
 namespace esp_framework {
 
+/**
+ * @brief UART到TCP转发统计
+ */
+struct uart_forward_stats {
+    uint32_t rx_bytes;         // 从UART接收的字节数
+    uint32_t forwarded_bytes;  // 成功交给上行链路的字节数
+    uint32_t copied_bytes;     // 转发路径上应用层复制的字节数（不含协议栈内部复制）
+    uint32_t tx_bytes;         // 从发送队列写入UART的下行字节数
+    uint32_t tx_dropped_bytes; // 发送队列满而丢弃的下行字节数
+};
+
 /**
  * @brief UART设备类
  * 
@@ -55,6 +68,8 @@ public:
     
     /**
      * @brief 挂起设备（低功耗模式）
+     * 
+     * 只暂停UART发送任务。接收任务保持运行，挂起期间的UART数据照常转发并作为活动唤醒pmu。
      * @return 成功返回0，失败返回负值
      */
     int suspend() override;
@@ -74,7 +89,31 @@ public:
 
 
     int send_data(const std::string& data);
-
+    
+    /**
+     * @brief 发送缓冲池缓冲区中的数据到UART
+     * @param buffer 缓冲区句柄
+     * @return 成功发送的字节数，失败返回负值
+     */
+    int send_data(const pool_buffer& buffer);
+    
+    /**
+     * @brief 将缓冲区放入UART发送队列，由UART发送任务异步写出
+     * 
+     * 队列持有缓冲区引用，不复制数据。
+     * @param buffer 缓冲区句柄
+     * @param wait 队列满时的最长等待时间
+     * @return 成功入队返回true，超时返回false（数据被丢弃）
+     */
+    bool enqueue_tx(const pool_buffer& buffer, TickType_t wait);
+    
+    /**
+     * @brief 获取转发统计
+     * 
+     * copied_bytes / forwarded_bytes 即转发路径上每字节的复制次数
+     * @return 转发统计
+     */
+    uart_forward_stats get_forward_stats() const;
     
 private:
     // UART相关配置
@@ -84,10 +123,28 @@ private:
     int rx_pin_;
     QueueHandle_t uart_queue_;
     TaskHandle_t uart_task_handle_;
+    QueueHandle_t tx_queue_;          // 下行发送队列，元素为缓冲块指针
+    TaskHandle_t tx_task_handle_;     // UART发送任务句柄
     bool is_initialized_;
     
+    // 转发统计
+    std::atomic<uint32_t> rx_bytes_;
+    std::atomic<uint32_t> forwarded_bytes_;
+    std::atomic<uint32_t> copied_bytes_;
+    std::atomic<uint32_t> tx_bytes_;
+    std::atomic<uint32_t> tx_dropped_bytes_;
+    
     // UART接收任务
     static void uart_rx_task(void* arg);
+    
+    // UART发送任务，批量写出发送队列中的数据
+    static void uart_tx_task(void* arg);
+    
+    // 释放发送队列中剩余的缓冲块
+    void drain_tx_queue();
+    
+    // 发送一段连续数据
+    int send_bytes(const uint8_t* data, size_t size);
 };
 
 } // namespace esp_framework 
\ No newline at end of file
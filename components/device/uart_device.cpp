@@ -1,13 +1,20 @@
 #include "uart_device.h"
 #include "esp_log.h"
+#include "esp_sleep.h"
 #include "network_module.h"
+#include "store_forward.h"
 #include <cstring>
 #include "event_system.h"
+#include "sdkconfig.h"
 
 // 定义一些常量
 #define UART_BUF_SIZE (1024)
 #define UART_TASK_STACK_SIZE (4096)
 #define UART_TASK_PRIORITY (10)
+#define UART_TX_TASK_STACK_SIZE (3072)
+#define UART_TX_TASK_PRIORITY (9)
+#define UART_TX_QUEUE_LENGTH CONFIG_UART_TX_QUEUE_LENGTH
+#define UART_TX_ENQUEUE_TIMEOUT_MS (1000)
 
 static const char* TAG = "UART_DEVICE";
 
@@ -15,7 +22,9 @@ namespace esp_framework {
 
 uart_device::uart_device(uart_port_t uart_num, int baud_rate, int tx_pin, int rx_pin)
     : uart_num_(uart_num), baud_rate_(baud_rate), tx_pin_(tx_pin), rx_pin_(rx_pin),
-      uart_queue_(nullptr), uart_task_handle_(nullptr), is_initialized_(false) {
+      uart_queue_(nullptr), uart_task_handle_(nullptr), tx_queue_(nullptr), tx_task_handle_(nullptr),
+      is_initialized_(false), rx_bytes_(0), forwarded_bytes_(0), copied_bytes_(0),
+      tx_bytes_(0), tx_dropped_bytes_(0) {
     ESP_LOGI(TAG, "创建UART设备: 端口=%d, 波特率=%d, TX=%d, RX=%d", 
              uart_num, baud_rate, tx_pin, rx_pin);
 }
@@ -65,14 +74,51 @@ int uart_device::init() {
         return -1;
     }
     
+#if CONFIG_POWER_LIGHT_SLEEP
+    // 自动轻度睡眠期间由RX上升沿唤醒。触发唤醒的边沿所在的字节不会被接收，
+    // 唤醒后由pmu保持CPU唤醒，同一批数据的后续字节不再丢失。
+    // 接收任务在pmu挂起设备时也保持运行，唤醒后收到的数据照常转发并使pmu恢复
+    if (uart_set_wakeup_threshold(uart_num_, CONFIG_POWER_UART_WAKEUP_THRESHOLD) != ESP_OK ||
+        esp_sleep_enable_uart_wakeup(uart_num_) != ESP_OK) {
+        ESP_LOGW(TAG, "UART唤醒配置失败，轻度睡眠期间收到的数据将丢失");
+    }
+#endif
+    
+    // 创建下行发送队列和UART发送任务
+    tx_queue_ = xQueueCreate(UART_TX_QUEUE_LENGTH, sizeof(buffer_block*));
+    if (tx_queue_ == nullptr) {
+        ESP_LOGE(TAG, "UART发送队列创建失败");
+        uart_driver_delete(uart_num_);
+        return -1;
+    }
+    
+    ret = xTaskCreate(uart_tx_task, "uart_tx_task", UART_TX_TASK_STACK_SIZE, this, UART_TX_TASK_PRIORITY, &tx_task_handle_);
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "UART发送任务创建失败: %d", ret);
+        vQueueDelete(tx_queue_);
+        tx_queue_ = nullptr;
+        uart_driver_delete(uart_num_);
+        return -1;
+    }
+    
     // 创建UART接收任务
     ret = xTaskCreate(uart_rx_task, "uart_rx_task", UART_TASK_STACK_SIZE, this, UART_TASK_PRIORITY, &uart_task_handle_);
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "UART接收任务创建失败: %d", ret);
+        vTaskDelete(tx_task_handle_);
+        tx_task_handle_ = nullptr;
+        vQueueDelete(tx_queue_);
+        tx_queue_ = nullptr;
         uart_driver_delete(uart_num_);
         return -1;
     }
     
+    // TCP下行数据进入UART发送队列；队列满时最多阻塞TCP接收UART_TX_ENQUEUE_TIMEOUT_MS，
+    // 期间由TCP窗口对服务器施加背压，超时后丢弃并计入tx_dropped_bytes
+    network_module::get_instance().set_data_callback([this](const pool_buffer& buffer) {
+        enqueue_tx(buffer, pdMS_TO_TICKS(UART_TX_ENQUEUE_TIMEOUT_MS));
+    });
+    
     is_initialized_ = true;
     ESP_LOGI(TAG, "UART设备初始化成功");
     return 0;
@@ -83,12 +129,25 @@ int uart_device::deinit() {
         return 0;
     }
     
+    network_module::get_instance().set_data_callback(nullptr);
+    
     // 删除UART接收任务
     if (uart_task_handle_ != nullptr) {
         vTaskDelete(uart_task_handle_);
         uart_task_handle_ = nullptr;
     }
     
+    // 删除UART发送任务并释放未发送的缓冲区
+    if (tx_task_handle_ != nullptr) {
+        vTaskDelete(tx_task_handle_);
+        tx_task_handle_ = nullptr;
+    }
+    if (tx_queue_ != nullptr) {
+        drain_tx_queue();
+        vQueueDelete(tx_queue_);
+        tx_queue_ = nullptr;
+    }
+    
     // 删除UART驱动
     int ret = uart_driver_delete(uart_num_);
     if (ret != ESP_OK) {
@@ -109,9 +168,11 @@ int uart_device::suspend() {
     
     ESP_LOGI(TAG, "挂起UART设备");
     
-    // 暂停UART接收任务
-    if (uart_task_handle_ != nullptr) {
-        vTaskSuspend(uart_task_handle_);
+    // 接收任务保持运行：它阻塞在UART驱动事件队列上不占用CPU，挂起期间收到的数据
+    // 仍发布data_received，由pmu据此恢复系统。只暂停发送任务，下行数据留在发送队列中，
+    // 其data_received事件同样使pmu恢复
+    if (tx_task_handle_ != nullptr) {
+        vTaskSuspend(tx_task_handle_);
     }
     
     return 0;
@@ -124,47 +185,118 @@ int uart_device::resume() {
     
     ESP_LOGI(TAG, "恢复UART设备");
     
-    // 恢复UART接收任务
-    if (uart_task_handle_ != nullptr) {
-        vTaskResume(uart_task_handle_);
+    // 恢复UART发送任务，写出挂起期间入队的下行数据
+    if (tx_task_handle_ != nullptr) {
+        vTaskResume(tx_task_handle_);
     }
     
     return 0;
 }
 
 int uart_device::send_data(const std::vector<uint8_t>& data) {
-    if (!is_initialized_ || data.empty()) {
+    return send_bytes(data.data(), data.size());
+}
+
+int uart_device::send_data(const pool_buffer& buffer) {
+    return send_bytes(buffer.data(), buffer.size());
+}
+
+int uart_device::send_bytes(const uint8_t* data, size_t size) {
+    if (!is_initialized_ || data == nullptr || size == 0) {
         return -1;
     }
     
     // 发送数据到UART
-    int written = uart_write_bytes(uart_num_, data.data(), data.size());
+    int written = uart_write_bytes(uart_num_, data, size);
     if (written < 0) {
         ESP_LOGE(TAG, "UART发送数据失败: %d", written);
     } else {
-        ESP_LOGI(TAG, "UART发送数据成功: %d字节", written);
+        ESP_LOGD(TAG, "UART发送数据成功: %d字节", written);
     }
     
     return written;
 }
 
 int uart_device::send_data(const std::string& data) {
-    return send_data(std::vector<uint8_t>(data.begin(), data.end()));
+    return send_bytes(reinterpret_cast<const uint8_t*>(data.data()), data.size());
 }
 
+uart_forward_stats uart_device::get_forward_stats() const {
+    uart_forward_stats stats;
+    stats.rx_bytes = rx_bytes_.load(std::memory_order_relaxed);
+    stats.forwarded_bytes = forwarded_bytes_.load(std::memory_order_relaxed);
+    stats.copied_bytes = copied_bytes_.load(std::memory_order_relaxed);
+    stats.tx_bytes = tx_bytes_.load(std::memory_order_relaxed);
+    stats.tx_dropped_bytes = tx_dropped_bytes_.load(std::memory_order_relaxed);
+    return stats;
+}
 
-void uart_device::uart_rx_task(void* arg) {
-    uart_device* device = static_cast<uart_device*>(arg);
-    uart_event_t event;
-    uint8_t* data = new uint8_t[UART_BUF_SIZE];
+bool uart_device::enqueue_tx(const pool_buffer& buffer, TickType_t wait) {
+    size_t size = buffer.size();
+    if (size == 0) {
+        return true;
+    }
+    
+    if (tx_queue_ == nullptr) {
+        tx_dropped_bytes_.fetch_add(size, std::memory_order_relaxed);
+        return false;
+    }
+    
+    // 队列持有一个引用，由发送任务写出后释放
+    pool_buffer ref(buffer);
+    buffer_block* block = ref.detach();
+    if (xQueueSend(tx_queue_, &block, wait) != pdTRUE) {
+        pool_buffer::adopt(block).reset();
+        tx_dropped_bytes_.fetch_add(size, std::memory_order_relaxed);
+        ESP_LOGW(TAG, "UART发送队列已满，丢弃 %zu 字节", size);
+        return false;
+    }
     
-    if (!data) {
-        ESP_LOGE(TAG, "无法分配UART接收缓冲区");
-        vTaskDelete(NULL);
-        return;
+    return true;
+}
+
+void uart_device::drain_tx_queue() {
+    buffer_block* block = nullptr;
+    while (xQueueReceive(tx_queue_, &block, 0) == pdTRUE) {
+        pool_buffer::adopt(block).reset();
     }
+}
+
+void uart_device::uart_tx_task(void* arg) {
+    uart_device* device = static_cast<uart_device*>(arg);
+    buffer_block* block = nullptr;
+    
+    ESP_LOGI(TAG, "UART发送任务已启动");
     
-    auto& network = network_module::get_instance();
+    while (1) {
+        if (xQueueReceive(device->tx_queue_, &block, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        
+        // 一次唤醒写出队列中所有待发送数据，UART驱动发送缓冲区满时在此阻塞
+        size_t batch_bytes = 0;
+        do {
+            pool_buffer buffer = pool_buffer::adopt(block);
+            int written = uart_write_bytes(device->uart_num_, buffer.data(), buffer.size());
+            if (written < 0) {
+                ESP_LOGE(TAG, "UART发送数据失败: %d", written);
+                device->tx_dropped_bytes_.fetch_add(buffer.size(), std::memory_order_relaxed);
+            } else {
+                device->tx_bytes_.fetch_add(written, std::memory_order_relaxed);
+                batch_bytes += written;
+            }
+        } while (xQueueReceive(device->tx_queue_, &block, 0) == pdTRUE);
+        
+        ESP_LOGD(TAG, "UART下行批量写出: %zu字节", batch_bytes);
+    }
+}
+
+
+void uart_device::uart_rx_task(void* arg) {
+    uart_device* device = static_cast<uart_device*>(arg);
+    uart_event_t event;
+    auto& pool = buffer_pool::get_instance();
+    auto& uplink = store_forward::get_instance();
     
     ESP_LOGI(TAG, "UART接收任务已启动");
     
@@ -173,38 +305,41 @@ void uart_device::uart_rx_task(void* arg) {
         if (xQueueReceive(device->uart_queue_, &event, portMAX_DELAY)) {
             switch (event.type) {
                 case UART_DATA: {
-                    // 读取UART数据
-                    int len = uart_read_bytes(device->uart_num_, data, event.size, portMAX_DELAY);
+                    // UART驱动直接读入缓冲池缓冲区，这是转发路径上唯一的一次复制
+                    pool_buffer buffer = pool.acquire(event.size);
+                    if (!buffer) {
+                        ESP_LOGE(TAG, "内存不足，无法处理UART数据");
+                        uart_flush_input(device->uart_num_);
+                        break;
+                    }
+                    
+                    int len = uart_read_bytes(device->uart_num_, buffer.data(), event.size, portMAX_DELAY);
                     if (len > 0) {
-                        ESP_LOGI(TAG, "接收到UART数据: %d字节", len);
+                        ESP_LOGD(TAG, "接收到UART数据: %d字节", len);
+                        buffer.set_size(len);
+                        device->rx_bytes_.fetch_add(len, std::memory_order_relaxed);
                         
-                        // 创建数据副本用于事件系统和网络发送
-                        std::shared_ptr<uint8_t[]> data_copy(new uint8_t[len], std::default_delete<uint8_t[]>());
-                        if (data_copy) {
-                            // 复制数据
-                            memcpy(data_copy.get(), data, len);
-                            
-                            // 使用data_copy创建临时vector用于网络发送
-                            if (network.is_tcp_connected()) {
-                                // 使用shared_ptr中的数据创建临时vector
-                                std::vector<uint8_t> temp_vec(data_copy.get(), data_copy.get() + len);
-                                if (network.send_data(temp_vec)) {
-                                    ESP_LOGI(TAG, "数据已转发到TCP服务器");
-                                } else {
-                                    ESP_LOGE(TAG, "数据转发到TCP服务器失败");
-                                }
-                            } else {
-                                ESP_LOGW(TAG, "TCP未连接，无法转发数据");
-                            }
-                            
-                            // 发布事件，通知其他组件
-                            event_data event_data(event_type::data_received, 
-                                                  event_data_type::binary, 
-                                                  data_copy, len);
-                            event_bus::get_instance().publish(event_data);
-                        } else {
-                            ESP_LOGE(TAG, "内存不足，无法处理UART数据");
+                        // TCP已连接时同一缓冲区放入上行队列，由TCP发送任务发送，UART接收不被网络阻塞；
+                        // 断开期间复制到存储转发缓存，重新连接后重放
+                        switch (uplink.submit(buffer)) {
+                            case submit_result::live:
+                                device->forwarded_bytes_.fetch_add(len, std::memory_order_relaxed);
+                                device->copied_bytes_.fetch_add(len, std::memory_order_relaxed);
+                                break;
+                            case submit_result::stored:
+                                device->forwarded_bytes_.fetch_add(len, std::memory_order_relaxed);
+                                device->copied_bytes_.fetch_add(2 * len, std::memory_order_relaxed);
+                                break;
+                            default:
+                                ESP_LOGW(TAG, "上行队列或缓存已满，UART数据被丢弃");
+                                break;
                         }
+                        
+                        // 以引用方式发布事件，通知其他组件
+                        event_data event_data(event_type::data_received, 
+                                              event_data_type::binary, 
+                                              std::move(buffer));
+                        event_bus::get_instance().post(event_data);
                     }
                     break;
                 }
@@ -234,7 +369,6 @@ void uart_device::uart_rx_task(void* arg) {
         }
     }
     
-    delete[] data;
     vTaskDelete(NULL);
 }
 
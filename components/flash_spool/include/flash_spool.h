@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "esp_partition.h"
+
+namespace esp_framework {
+
+/**
+ * @brief 闪存缓存统计
+ */
+struct flash_spool_stats {
+    uint32_t segments;          // 段数
+    uint32_t segment_size;      // 段大小（字节）
+    uint32_t used_segments;     // 含未读记录的段数
+    uint32_t pending_bytes;     // 未读数据占用的闪存字节数（含记录头）
+    uint32_t appended_bytes;    // 本次启动以来追加的数据字节数
+    uint32_t consumed_bytes;    // 本次启动以来读出的数据字节数
+    uint32_t dropped_bytes;     // 缓存满时丢弃的数据字节数
+    uint32_t corrupt_records;   // 校验失败而跳过的记录数
+    uint32_t min_erase_count;   // 启动时各段最少擦除次数
+    uint32_t max_erase_count;   // 各段最多擦除次数
+    uint32_t recovery_ms;       // 启动恢复耗时
+};
+
+/**
+ * @brief 日志结构的闪存缓存
+ *
+ * 分区按段（扇区整数倍）划分，记录按顺序追加到当前段，段满后轮换到下一段，
+ * 各段按环形顺序依次擦除，擦除次数均衡。每段开头是带CRC的段头（魔数、序号、擦除次数），
+ * 每条记录带长度和覆盖长度与数据的CRC32，掉电造成的残缺记录在读取或恢复时被识别并跳过。
+ *
+ * 启动时只读取各段的段头和当前写入段，无需扫描全部数据。读取位置（序号, 偏移）
+ * 定期保存到NVS，重启或深度睡眠后从上次保存的位置继续读取（可能重复少量记录，不会丢失）。
+ *
+ * 不加锁，调用者负责串行访问。
+ */
+class flash_spool {
+public:
+    /**
+     * @brief 构造函数
+     * @param partition_label 分区名称
+     */
+    explicit flash_spool(const char* partition_label);
+
+    /**
+     * @brief 查找分区并恢复写入位置和读取位置
+     * @return 成功返回true，分区不存在或太小返回false
+     */
+    bool init();
+
+    /**
+     * @brief 追加一条记录
+     * @param data 数据
+     * @param size 数据长度，不超过max_record_size()
+     * @param drop_oldest 缓存满时丢弃最早的一段数据腾出空间；为false时拒绝新数据
+     * @return 成功返回true
+     */
+    bool append(const uint8_t* data, size_t size, bool drop_oldest);
+
+    /**
+     * @brief 最早一条未读记录的数据长度，没有未读记录时返回0
+     */
+    size_t front_size();
+
+    /**
+     * @brief 读取最早一条未读记录
+     * @param dest 目标缓冲区，至少front_size()字节
+     * @return 成功返回true；记录校验失败时跳过所在段的剩余记录并返回false
+     */
+    bool read_front(uint8_t* dest);
+
+    /**
+     * @brief 移除最早一条未读记录
+     * @return 被移除记录的数据长度
+     */
+    size_t pop();
+
+    /**
+     * @brief 是否没有未读记录
+     */
+    bool empty();
+
+    /**
+     * @brief 把读取位置保存到NVS
+     */
+    void commit_cursor();
+
+    /**
+     * @brief 丢弃全部未读数据（只移动读取位置，不额外擦除）
+     * @return 成功返回true
+     */
+    bool format();
+
+    /**
+     * @brief 单条记录的最大数据长度
+     */
+    size_t max_record_size() const;
+
+    /**
+     * @brief 获取统计信息
+     * @return 统计信息
+     */
+    flash_spool_stats get_stats() const;
+
+private:
+    // 段头
+    struct segment_header {
+        uint32_t magic;
+        uint32_t seq;           // 段序号，每打开一段加1
+        uint32_t erase_count;   // 该段累计擦除次数
+        uint32_t crc;           // 前三个字段的CRC32
+    };
+
+    // 记录头，数据紧随其后，记录按4字节对齐
+    struct record_header {
+        uint16_t magic;
+        uint16_t size;          // 数据长度
+        uint32_t crc;           // 长度和数据的CRC32
+    };
+
+    static constexpr uint32_t SEGMENT_MAGIC = 0x314C5053;   // "SPL1"
+    static constexpr uint16_t RECORD_MAGIC = 0xA55A;
+
+    // 段序号对应的段编号
+    uint32_t segment_index(uint32_t seq) const;
+    uint32_t segment_offset(uint32_t seq) const;
+
+    // 读取并校验段头
+    bool read_segment_header(uint32_t index, segment_header& header) const;
+
+    // 扫描当前写入段，找到第一个空闲位置
+    void recover_write_offset();
+
+    // 从NVS恢复读取位置
+    void restore_cursor();
+
+    // 打开下一段作为写入段
+    bool open_next_segment(bool drop_oldest);
+
+    // 读取当前位置的记录头，跳过已写满的段；没有未读记录返回false
+    bool locate_front(record_header& header);
+
+    // 计算从读取位置到所在段末尾的未读数据字节数
+    uint32_t remaining_in_cursor_segment();
+
+    static uint32_t record_crc(uint16_t size, const uint8_t* data);
+    static size_t record_bytes(size_t size) { return (sizeof(record_header) + size + 3) & ~static_cast<size_t>(3); }
+
+    const char* label_;
+    const esp_partition_t* partition_;
+    uint32_t segment_size_;
+    uint32_t segment_count_;
+
+    uint32_t write_seq_;        // 当前写入段序号，0表示尚未写入
+    uint32_t write_offset_;     // 当前写入段中的写入位置
+    uint32_t read_seq_;         // 读取位置所在段序号
+    uint32_t read_offset_;      // 读取位置
+    uint32_t uncommitted_bytes_; // 上次保存读取位置后读出的字节数
+
+    uint32_t appended_bytes_;
+    uint32_t consumed_bytes_;
+    uint32_t dropped_bytes_;
+    uint32_t corrupt_records_;
+    uint32_t min_erase_count_;
+    uint32_t max_erase_count_;
+    uint32_t recovery_ms_;
+};
+
+} // namespace esp_framework
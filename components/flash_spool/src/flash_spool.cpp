@@ -0,0 +1,440 @@
+#include "flash_spool.h"
+#include <cstring>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "nvs.h"
+#include "sdkconfig.h"
+
+static const char* TAG = "FlashSpool";
+
+// 段大小，必须是扇区大小的整数倍
+#define FLASH_SPOOL_SEGMENT_SIZE CONFIG_FLASH_SPOOL_SEGMENT_SIZE
+#define FLASH_SPOOL_SECTOR_SIZE 4096
+
+// 读出多少字节后保存一次读取位置
+#define FLASH_SPOOL_CURSOR_COMMIT_BYTES CONFIG_FLASH_SPOOL_CURSOR_COMMIT_BYTES
+
+// 保存读取位置的NVS命名空间，键为分区名称
+#define FLASH_SPOOL_NVS_NAMESPACE "spool"
+
+// 校验空闲区域时每次读取的字节数
+#define FLASH_SPOOL_SCAN_CHUNK 256
+
+namespace esp_framework {
+
+// 保存在NVS中的读取位置
+struct spool_cursor {
+    uint32_t seq;
+    uint32_t offset;
+};
+
+flash_spool::flash_spool(const char* partition_label)
+    : label_(partition_label),
+      partition_(nullptr),
+      segment_size_(FLASH_SPOOL_SEGMENT_SIZE),
+      segment_count_(0),
+      write_seq_(0),
+      write_offset_(0),
+      read_seq_(0),
+      read_offset_(0),
+      uncommitted_bytes_(0),
+      appended_bytes_(0),
+      consumed_bytes_(0),
+      dropped_bytes_(0),
+      corrupt_records_(0),
+      min_erase_count_(0),
+      max_erase_count_(0),
+      recovery_ms_(0) {
+}
+
+bool flash_spool::init() {
+    partition_ = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label_);
+    if (partition_ == nullptr) {
+        ESP_LOGE(TAG, "未找到分区: %s", label_);
+        return false;
+    }
+
+    if (segment_size_ % FLASH_SPOOL_SECTOR_SIZE != 0) {
+        ESP_LOGE(TAG, "段大小%lu不是扇区大小的整数倍", (unsigned long)segment_size_);
+        partition_ = nullptr;
+        return false;
+    }
+    segment_count_ = partition_->size / segment_size_;
+    if (segment_count_ < 2) {
+        ESP_LOGE(TAG, "分区%s太小: %lu字节，至少需要两段", label_, (unsigned long)partition_->size);
+        partition_ = nullptr;
+        return false;
+    }
+
+    TickType_t start = xTaskGetTickCount();
+
+    // 只读取段头：序号最大的有效段是当前写入段
+    write_seq_ = 0;
+    min_erase_count_ = UINT32_MAX;
+    max_erase_count_ = 0;
+    for (uint32_t i = 0; i < segment_count_; i++) {
+        segment_header header;
+        uint32_t erase_count = 0;
+        if (read_segment_header(i, header)) {
+            erase_count = header.erase_count;
+            if (segment_index(header.seq) == i && header.seq > write_seq_) {
+                write_seq_ = header.seq;
+            }
+        }
+        if (erase_count < min_erase_count_) {
+            min_erase_count_ = erase_count;
+        }
+        if (erase_count > max_erase_count_) {
+            max_erase_count_ = erase_count;
+        }
+    }
+
+    if (write_seq_ != 0) {
+        recover_write_offset();
+    }
+    restore_cursor();
+
+    recovery_ms_ = (xTaskGetTickCount() - start) * portTICK_PERIOD_MS;
+    flash_spool_stats stats = get_stats();
+    ESP_LOGI(TAG, "闪存缓存就绪: 分区%s %lu段x%lu字节, 未读%lu字节, 擦除次数%lu~%lu, 恢复耗时%lums",
+             label_, (unsigned long)segment_count_, (unsigned long)segment_size_,
+             (unsigned long)stats.pending_bytes, (unsigned long)min_erase_count_,
+             (unsigned long)max_erase_count_, (unsigned long)recovery_ms_);
+    return true;
+}
+
+uint32_t flash_spool::segment_index(uint32_t seq) const {
+    return (seq - 1) % segment_count_;
+}
+
+uint32_t flash_spool::segment_offset(uint32_t seq) const {
+    return segment_index(seq) * segment_size_;
+}
+
+uint32_t flash_spool::record_crc(uint16_t size, const uint8_t* data) {
+    uint32_t crc = esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&size), sizeof(size));
+    return esp_rom_crc32_le(crc, data, size);
+}
+
+bool flash_spool::read_segment_header(uint32_t index, segment_header& header) const {
+    if (esp_partition_read(partition_, index * segment_size_, &header, sizeof(header)) != ESP_OK) {
+        return false;
+    }
+    return header.magic == SEGMENT_MAGIC && header.seq != 0 && header.seq != UINT32_MAX &&
+           header.crc == esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&header),
+                                          offsetof(segment_header, crc));
+}
+
+void flash_spool::recover_write_offset() {
+    uint32_t base = segment_offset(write_seq_);
+    uint32_t offset = sizeof(segment_header);
+    uint8_t chunk[FLASH_SPOOL_SCAN_CHUNK];
+
+    // 逐条校验当前写入段的记录，找到最后一条完整记录之后的位置
+    while (offset + sizeof(record_header) <= segment_size_) {
+        record_header header;
+        esp_partition_read(partition_, base + offset, &header, sizeof(header));
+        if (header.magic != RECORD_MAGIC || offset + record_bytes(header.size) > segment_size_) {
+            break;
+        }
+
+        uint32_t crc = esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&header.size), sizeof(header.size));
+        for (uint32_t done = 0; done < header.size; done += sizeof(chunk)) {
+            uint32_t len = header.size - done < sizeof(chunk) ? header.size - done : sizeof(chunk);
+            esp_partition_read(partition_, base + offset + sizeof(header) + done, chunk, len);
+            crc = esp_rom_crc32_le(crc, chunk, len);
+        }
+        if (crc != header.crc) {
+            break;
+        }
+        offset += record_bytes(header.size);
+    }
+
+    // 之后的区域必须是擦除状态，否则是掉电留下的残缺记录，该段不再写入
+    for (uint32_t pos = offset; pos < segment_size_; pos += sizeof(chunk)) {
+        uint32_t len = segment_size_ - pos < sizeof(chunk) ? segment_size_ - pos : sizeof(chunk);
+        esp_partition_read(partition_, base + pos, chunk, len);
+        for (uint32_t i = 0; i < len; i++) {
+            if (chunk[i] != 0xFF) {
+                ESP_LOGW(TAG, "段%lu在偏移%lu处有残缺记录，换用下一段",
+                         (unsigned long)write_seq_, (unsigned long)offset);
+                write_offset_ = segment_size_;
+                return;
+            }
+        }
+    }
+    write_offset_ = offset;
+}
+
+void flash_spool::restore_cursor() {
+    if (write_seq_ == 0) {
+        read_seq_ = 0;
+        read_offset_ = 0;
+        return;
+    }
+
+    // 从写入段向前查找连续有效的最早一段
+    uint32_t oldest = write_seq_;
+    while (oldest > 1 && write_seq_ - oldest + 1 < segment_count_) {
+        segment_header header;
+        if (!read_segment_header(segment_index(oldest - 1), header) || header.seq != oldest - 1) {
+            break;
+        }
+        oldest--;
+    }
+
+    spool_cursor cursor = {0, 0};
+    size_t length = sizeof(cursor);
+    nvs_handle_t handle;
+    bool found = false;
+    if (nvs_open(FLASH_SPOOL_NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        found = nvs_get_blob(handle, label_, &cursor, &length) == ESP_OK && length == sizeof(cursor);
+        nvs_close(handle);
+    }
+
+    if (found && cursor.seq >= oldest && cursor.seq <= write_seq_) {
+        read_seq_ = cursor.seq;
+        read_offset_ = cursor.offset < sizeof(segment_header) ? sizeof(segment_header) : cursor.offset;
+        if (read_seq_ == write_seq_ && read_offset_ > write_offset_) {
+            read_offset_ = write_offset_;
+        }
+    } else {
+        // 没有保存的读取位置或该位置已被覆盖，从最早的数据开始
+        read_seq_ = oldest;
+        read_offset_ = sizeof(segment_header);
+    }
+}
+
+bool flash_spool::open_next_segment(bool drop_oldest) {
+    uint32_t seq = write_seq_ + 1;
+    uint32_t index = segment_index(seq);
+    bool was_empty = empty();
+
+    // 下一段仍有未读数据：缓存已满
+    if (write_seq_ != 0 && read_seq_ + segment_count_ <= seq) {
+        if (!drop_oldest) {
+            return false;
+        }
+        uint32_t dropped = remaining_in_cursor_segment();
+        dropped_bytes_ += dropped;
+        ESP_LOGD(TAG, "闪存缓存已满，丢弃最早一段中的%lu字节", (unsigned long)dropped);
+        read_seq_++;
+        read_offset_ = sizeof(segment_header);
+        commit_cursor();
+    }
+
+    segment_header old_header;
+    uint32_t erase_count = read_segment_header(index, old_header) ? old_header.erase_count + 1 : 1;
+
+    if (esp_partition_erase_range(partition_, index * segment_size_, segment_size_) != ESP_OK) {
+        ESP_LOGE(TAG, "擦除段%lu失败", (unsigned long)index);
+        return false;
+    }
+
+    segment_header header;
+    header.magic = SEGMENT_MAGIC;
+    header.seq = seq;
+    header.erase_count = erase_count;
+    header.crc = esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&header), offsetof(segment_header, crc));
+    if (esp_partition_write(partition_, index * segment_size_, &header, sizeof(header)) != ESP_OK) {
+        ESP_LOGE(TAG, "写入段头%lu失败", (unsigned long)index);
+        return false;
+    }
+    if (erase_count > max_erase_count_) {
+        max_erase_count_ = erase_count;
+    }
+
+    write_seq_ = seq;
+    write_offset_ = sizeof(segment_header);
+    if (was_empty) {
+        read_seq_ = seq;
+        read_offset_ = sizeof(segment_header);
+    }
+    return true;
+}
+
+bool flash_spool::append(const uint8_t* data, size_t size, bool drop_oldest) {
+    if (partition_ == nullptr || size == 0 || size > max_record_size()) {
+        dropped_bytes_ += size;
+        return false;
+    }
+
+    size_t need = record_bytes(size);
+    if (write_seq_ == 0 || write_offset_ + need > segment_size_) {
+        if (!open_next_segment(drop_oldest)) {
+            dropped_bytes_ += size;
+            return false;
+        }
+    }
+
+    record_header header;
+    header.magic = RECORD_MAGIC;
+    header.size = static_cast<uint16_t>(size);
+    header.crc = record_crc(header.size, data);
+
+    // 先写数据后写记录头，记录头写入后记录才有效
+    uint32_t base = segment_offset(write_seq_) + write_offset_;
+    if (esp_partition_write(partition_, base + sizeof(header), data, size) != ESP_OK ||
+        esp_partition_write(partition_, base, &header, sizeof(header)) != ESP_OK) {
+        ESP_LOGE(TAG, "写入记录失败，换用下一段");
+        write_offset_ = segment_size_;
+        dropped_bytes_ += size;
+        return false;
+    }
+
+    write_offset_ += need;
+    appended_bytes_ += size;
+    return true;
+}
+
+bool flash_spool::locate_front(record_header& header) {
+    if (partition_ == nullptr || write_seq_ == 0) {
+        return false;
+    }
+
+    while (1) {
+        if (read_seq_ == write_seq_ && read_offset_ >= write_offset_) {
+            return false;
+        }
+
+        if (read_offset_ + sizeof(header) <= segment_size_) {
+            esp_partition_read(partition_, segment_offset(read_seq_) + read_offset_, &header, sizeof(header));
+            if (header.magic == RECORD_MAGIC && read_offset_ + record_bytes(header.size) <= segment_size_) {
+                return true;
+            }
+            if (header.magic != 0xFFFF) {
+                corrupt_records_++;
+            }
+        }
+
+        if (read_seq_ == write_seq_) {
+            read_offset_ = write_offset_;
+            return false;
+        }
+
+        // 该段没有更多记录，进入下一段并保存读取位置，之后该段可以被擦除
+        read_seq_++;
+        read_offset_ = sizeof(segment_header);
+        commit_cursor();
+    }
+}
+
+size_t flash_spool::front_size() {
+    record_header header;
+    return locate_front(header) ? header.size : 0;
+}
+
+bool flash_spool::read_front(uint8_t* dest) {
+    record_header header;
+    if (!locate_front(header)) {
+        return false;
+    }
+
+    esp_partition_read(partition_, segment_offset(read_seq_) + read_offset_ + sizeof(header), dest, header.size);
+    if (record_crc(header.size, dest) == header.crc) {
+        return true;
+    }
+
+    // 记录损坏时长度也不可信，跳过所在段的剩余记录
+    ESP_LOGW(TAG, "段%lu偏移%lu处的记录校验失败，跳过该段剩余数据",
+             (unsigned long)read_seq_, (unsigned long)read_offset_);
+    corrupt_records_++;
+    read_offset_ = segment_size_;
+    if (read_seq_ == write_seq_) {
+        read_offset_ = write_offset_;
+    }
+    return false;
+}
+
+size_t flash_spool::pop() {
+    record_header header;
+    if (!locate_front(header)) {
+        return 0;
+    }
+
+    read_offset_ += record_bytes(header.size);
+    consumed_bytes_ += header.size;
+    uncommitted_bytes_ += header.size;
+    if (uncommitted_bytes_ >= FLASH_SPOOL_CURSOR_COMMIT_BYTES ||
+        (read_seq_ == write_seq_ && read_offset_ >= write_offset_)) {
+        commit_cursor();
+    }
+    return header.size;
+}
+
+bool flash_spool::empty() {
+    record_header header;
+    return !locate_front(header);
+}
+
+uint32_t flash_spool::remaining_in_cursor_segment() {
+    uint32_t base = segment_offset(read_seq_);
+    uint32_t offset = read_offset_;
+    uint32_t bytes = 0;
+    while (offset + sizeof(record_header) <= segment_size_) {
+        record_header header;
+        esp_partition_read(partition_, base + offset, &header, sizeof(header));
+        if (header.magic != RECORD_MAGIC || offset + record_bytes(header.size) > segment_size_) {
+            break;
+        }
+        bytes += header.size;
+        offset += record_bytes(header.size);
+    }
+    return bytes;
+}
+
+void flash_spool::commit_cursor() {
+    if (partition_ == nullptr) {
+        return;
+    }
+    uncommitted_bytes_ = 0;
+
+    nvs_handle_t handle;
+    if (nvs_open(FLASH_SPOOL_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        ESP_LOGW(TAG, "无法打开NVS，读取位置未保存");
+        return;
+    }
+    spool_cursor cursor = {read_seq_, read_offset_};
+    if (nvs_set_blob(handle, label_, &cursor, sizeof(cursor)) != ESP_OK || nvs_commit(handle) != ESP_OK) {
+        ESP_LOGW(TAG, "保存读取位置失败");
+    }
+    nvs_close(handle);
+}
+
+bool flash_spool::format() {
+    if (partition_ == nullptr) {
+        return false;
+    }
+
+    // 丢弃全部数据只需把读取位置移到写入位置，不额外擦除
+    read_seq_ = write_seq_;
+    read_offset_ = write_offset_;
+    commit_cursor();
+    return true;
+}
+
+size_t flash_spool::max_record_size() const {
+    size_t size = segment_size_ - sizeof(segment_header) - sizeof(record_header);
+    return size < 0xFFFF ? size : 0xFFFE;
+}
+
+flash_spool_stats flash_spool::get_stats() const {
+    flash_spool_stats stats;
+    stats.segments = segment_count_;
+    stats.segment_size = segment_size_;
+    bool empty = write_seq_ == 0 || (read_seq_ == write_seq_ && read_offset_ >= write_offset_);
+    stats.used_segments = empty ? 0 : write_seq_ - read_seq_ + 1;
+    stats.pending_bytes = empty ? 0 : (write_seq_ - read_seq_) * segment_size_ + write_offset_ - read_offset_;
+    stats.appended_bytes = appended_bytes_;
+    stats.consumed_bytes = consumed_bytes_;
+    stats.dropped_bytes = dropped_bytes_;
+    stats.corrupt_records = corrupt_records_;
+    stats.min_erase_count = min_erase_count_;
+    stats.max_erase_count = max_erase_count_;
+    stats.recovery_ms = recovery_ms_;
+    return stats;
+}
+
+} // namespace esp_framework
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+namespace esp_framework {
+
+/**
+ * @brief 缓存的主机名数量
+ */
+constexpr size_t DNS_CACHE_MAX_ENTRIES = 4;
+
+/**
+ * @brief 主机名最大长度（含结尾的NUL）
+ */
+constexpr size_t DNS_CACHE_HOST_LEN = 64;
+
+/**
+ * @brief 地址的来源
+ */
+enum class dns_source {
+    literal,    // 主机名本身是IP地址
+    fresh,      // 未过期的缓存
+    stale,      // 已过期的缓存，同时在后台重新解析
+    lookup      // 没有缓存，同步解析
+};
+
+/**
+ * @brief DNS缓存统计
+ */
+struct dns_cache_stats {
+    uint32_t fresh_hits;        // 使用未过期缓存的次数
+    uint32_t stale_hits;        // 使用过期缓存的次数
+    uint32_t lookups;           // 同步解析次数（没有缓存）
+    uint32_t refreshes;         // 后台重新解析次数
+    uint32_t failures;          // 解析失败次数
+    uint32_t last_lookup_ms;    // 最近一次解析耗时
+    uint32_t max_lookup_ms;     // 最长解析耗时
+};
+
+/**
+ * @brief 带持久化的DNS缓存
+ *
+ * 解析结果保存在内存和NVS中，有效期为DNS_CACHE_TTL_S。时间取自系统时钟，
+ * 深度睡眠期间继续计时，因此唤醒后在有效期内重连无需DNS查询；上电复位后时钟从0开始，
+ * 解析时间晚于当前时间的记录视为过期。
+ * 过期的结果仍然先被使用，同时由后台任务重新解析，连接不等待DNS；
+ * 只有从未解析过的主机名才同步解析。
+ */
+class dns_cache {
+public:
+    /**
+     * @brief 获取DNS缓存实例
+     * @return DNS缓存引用
+     */
+    static dns_cache& get_instance();
+
+    /**
+     * @brief 解析主机名为IPv4地址
+     * @param host 主机名或IPv4地址字符串
+     * @param addr 输出地址（网络字节序）
+     * @param source 输出地址来源，可为nullptr
+     * @return 成功返回true
+     */
+    bool resolve(const std::string& host, uint32_t& addr, dns_source* source = nullptr);
+
+    /**
+     * @brief 使主机名的缓存过期并在后台重新解析
+     *
+     * 连接缓存的地址失败时调用，服务器迁移到新地址后下次重连即可使用新地址。
+     * @param host 主机名
+     */
+    void expire(const std::string& host);
+
+    /**
+     * @brief 获取统计信息
+     * @return 统计信息
+     */
+    dns_cache_stats get_stats() const;
+
+private:
+    dns_cache();
+    ~dns_cache() = default;
+
+    // 禁止复制和移动
+    dns_cache(const dns_cache&) = delete;
+    dns_cache& operator=(const dns_cache&) = delete;
+
+    /**
+     * @brief 缓存项，按此布局保存到NVS
+     */
+    struct entry {
+        char host[DNS_CACHE_HOST_LEN];  // 空字符串表示未使用
+        uint32_t addr;                  // 网络字节序
+        int64_t resolved_at;            // 解析时的系统时间（秒）
+    };
+
+    // 调用getaddrinfo()解析，不持有锁
+    bool lookup(const char* host, uint32_t& addr);
+
+    // 查找缓存项，没有时返回nullptr（调用者持有锁）
+    entry* find(const char* host);
+
+    // 保存解析结果，没有空位时替换最早解析的项（调用者持有锁）
+    void store(const char* host, uint32_t addr);
+
+    // 请求后台重新解析（调用者持有锁）
+    void schedule_refresh(entry& item);
+
+    // 从NVS加载和保存全部缓存项
+    void load();
+    void save();
+
+    // 后台重新解析任务
+    static void refresh_task(void* arg);
+
+    entry entries_[DNS_CACHE_MAX_ENTRIES];
+    bool refresh_pending_[DNS_CACHE_MAX_ENTRIES];
+    TaskHandle_t refresh_task_;
+    dns_cache_stats stats_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace esp_framework
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace esp_framework {
+
+/**
+ * @brief 最多配置的服务器数量
+ */
+constexpr size_t ENDPOINT_MAX = 4;
+
+/**
+ * @brief 每次竞速连接的候选数
+ */
+constexpr size_t ENDPOINT_RACE_COUNT = 2;
+
+/**
+ * @brief 服务器地址
+ */
+struct server_endpoint {
+    std::string host;       // IP地址或主机名
+    uint16_t port;          // 端口
+};
+
+/**
+ * @brief 单个服务器的健康统计
+ */
+struct endpoint_stats {
+    std::string host;
+    uint16_t port;
+    uint8_t score;          // 健康分（0~100），成功时向100靠近，失败时减半
+    bool pinned;            // 是否为当前固定使用的服务器
+    uint32_t attempts;      // 参与连接的次数
+    uint32_t failures;      // 连接失败次数
+    uint32_t wins;          // 连接成功次数
+};
+
+/**
+ * @brief 按优先级排列的服务器列表
+ *
+ * 最近一次连接成功的服务器被固定为第一候选，直到竞速中其他服务器先连接成功；
+ * 第二候选为其余服务器中健康分最高的（同分时按配置顺序）。固定的服务器和健康分
+ * 在连接成功时保存到NVS，重启后从上次成功的服务器开始连接。服务器列表变化时
+ * 之前保存的数据作废。
+ */
+class endpoint_list {
+public:
+    endpoint_list();
+    
+    /**
+     * @brief 设置服务器列表并从NVS加载健康分
+     * @param endpoints 按配置优先级排列，超过ENDPOINT_MAX的部分被忽略
+     */
+    void set(const std::vector<server_endpoint>& endpoints);
+    
+    /**
+     * @brief 解析 "host:port,host:port" 形式的列表，省略端口时使用默认端口
+     * @param text 逗号分隔的列表，可为空
+     * @param default_port 默认端口
+     * @param endpoints 解析结果追加到这里
+     * @return 格式正确返回true
+     */
+    static bool parse(const char* text, uint16_t default_port, std::vector<server_endpoint>& endpoints);
+    
+    /**
+     * @brief 选出本次连接的候选
+     * @param indexes 输出候选在列表中的序号，按优先级排列
+     * @param max 最多的候选数
+     * @return 候选数
+     */
+    size_t candidates(size_t* indexes, size_t max) const;
+    
+    /**
+     * @brief 获取服务器地址
+     */
+    server_endpoint get(size_t index) const;
+    
+    /**
+     * @brief 记录一次连接的结果
+     * @param index 候选序号
+     * @param failed 连接失败；未失败且不是获胜者的候选（竞速中被放弃）不计分
+     * @param won 连接成功
+     * @return 获胜者与之前固定的服务器不同时返回true（发生了切换）
+     */
+    bool report(size_t index, bool failed, bool won);
+    
+    /**
+     * @brief 连接成功后保存固定的服务器和健康分
+     */
+    void save();
+    
+    /**
+     * @brief 服务器数量
+     */
+    size_t size() const;
+    
+    /**
+     * @brief 获取每个服务器的健康统计
+     */
+    std::vector<endpoint_stats> get_stats() const;
+    
+private:
+    /**
+     * @brief 保存到NVS的数据
+     */
+    struct persisted {
+        uint32_t list_hash;             // 服务器列表的哈希，列表变化时作废
+        uint8_t pinned;                 // 固定的服务器序号
+        uint8_t scores[ENDPOINT_MAX];
+    };
+    
+    // 服务器列表的FNV-1a哈希
+    uint32_t list_hash() const;
+    
+    std::vector<server_endpoint> endpoints_;
+    uint8_t scores_[ENDPOINT_MAX];
+    uint32_t attempts_[ENDPOINT_MAX];
+    uint32_t failures_[ENDPOINT_MAX];
+    uint32_t wins_[ENDPOINT_MAX];
+    size_t pinned_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace esp_framework
@@ -1,17 +1,132 @@
 #pragma once
 
+#include <atomic>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <memory>
 #include <functional>
+#include <sys/uio.h>
 #include "esp_log.h"
 #include "esp_event.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "event_system.h"
+#include "buffer_pool.h"
+#include "spsc_ring.h"
+#include "frame_protocol.h"
+#include "lz_codec.h"
+#include "transport.h"
+#include "tcp_transport.h"
+#include "udp_transport.h"
+#include "endpoint_list.h"
+#include "wifi_cache.h"
+#include "esp_netif.h"
 
 namespace esp_framework {
 
+class tls_client;
+
+/**
+ * @brief send_gather()单次sendmsg()调用最多携带的段数
+ */
+constexpr size_t NETWORK_SEND_GATHER_WINDOW = 16;
+
+/**
+ * @brief 上行链路统计
+ */
+struct uplink_stats {
+    uint32_t queued_bytes;      // 当前环形队列中待发送的字节数
+    uint32_t peak_queued_bytes; // 环形队列中待发送字节数的峰值
+    uint32_t sent_bytes;        // 已发送到TCP服务器的字节数
+    uint32_t dropped_bytes;     // 环形队列已满时丢弃的字节数
+    uint32_t unsent_bytes;      // 出队时TCP未连接或发送失败，且未能交还缓存而丢弃的字节数
+    uint32_t requeued_bytes;    // 出队时TCP未连接或发送失败，交还存储转发缓存的字节数
+    uint32_t chunks;            // 出队的UART数据块数
+    uint32_t send_calls;        // 发送系统调用次数（合并后的批次数）
+    uint32_t flush_by_size;     // 因达到字节阈值而发送的批次数
+    uint32_t flush_by_timeout;  // 因超过最大延迟而发送的批次数
+    uint32_t flush_by_delimiter; // 因遇到帧分隔符而发送的批次数
+};
+
+/**
+ * @brief 上行压缩统计
+ */
+struct compress_stats {
+    uint32_t input_bytes;       // 压缩前字节数
+    uint32_t output_bytes;      // 压缩后字节数
+    uint32_t flushes;           // 压缩次数，每次发送的一批数据压缩并刷新一次
+    uint64_t cycles;            // 压缩累计耗费的CPU周期数
+    uint32_t avg_time_us;       // 每次压缩的平均耗时，即增加的发送延迟
+    uint32_t max_time_us;       // 每次压缩的最长耗时
+};
+
+/**
+ * @brief TLS握手统计
+ */
+struct tls_stats {
+    uint32_t full_handshakes;       // 完整握手次数
+    uint32_t resumed_handshakes;    // 以会话票据恢复的次数
+    uint32_t failed_handshakes;     // 握手失败次数
+    bool last_resumed;              // 最近一次握手是否为会话恢复
+    uint32_t last_handshake_ms;     // 最近一次握手耗时
+    uint32_t avg_full_ms;           // 完整握手平均耗时
+    uint32_t avg_resumed_ms;        // 会话恢复平均耗时
+    uint32_t avg_full_compute_ms;   // 完整握手平均本地运算时间（扣除等待服务器的时间）
+    uint32_t avg_resumed_compute_ms; // 会话恢复平均本地运算时间
+    uint32_t avg_full_bytes;        // 完整握手平均收发字节数
+    uint32_t avg_resumed_bytes;     // 会话恢复平均收发字节数
+};
+
+/**
+ * @brief 启动后各阶段的耗时（从启动开始计时，只记录第一次）
+ */
+struct boot_timing {
+    bool cached_ap;             // 按缓存的BSSID和信道连接
+    bool reused_lease;          // 直接使用缓存的IP地址，没有等待DHCP
+    uint32_t fallbacks;         // 按缓存连接失败后退回全信道扫描的次数
+    uint32_t assoc_ms;          // 关联AP
+    uint32_t ip_ms;             // 获得IP地址
+    uint32_t tcp_ms;            // 连接到服务器
+    uint32_t first_byte_ms;     // 第一次向服务器发送数据
+};
+
+/**
+ * @brief 上行合并发送配置
+ *
+ * 类似Nagle算法：小数据块先合并，满足任一条件时一次发送整批数据。
+ */
+struct uplink_coalesce_config {
+    uint32_t max_bytes;         // 批次字节阈值，0表示不合并（每块立即发送）
+    uint32_t max_latency_ms;    // 批次第一个数据块的最大等待时间
+    int32_t delimiter;          // 帧分隔符（0~255），-1表示不按分隔符发送
+};
+
+/**
+ * @brief TCP连接管理状态
+ */
+enum class connection_state : int32_t {
+    idle,           // 未启动连接管理
+    waiting_wifi,   // 等待WiFi连接
+    connecting,     // 正在连接TCP服务器
+    connected,      // 已连接
+    backoff         // 连接失败，等待退避时间后重试
+};
+
+/**
+ * @brief TCP连接管理统计
+ */
+struct connection_stats {
+    connection_state state;     // 当前状态
+    uint32_t attempts;          // TCP连接尝试次数
+    uint32_t failures;          // TCP连接失败次数
+    uint32_t reconnects;        // 断开后重新连接成功的次数
+    uint32_t last_reconnect_ms; // 最近一次从断开到重新连接的时间
+    uint32_t max_reconnect_ms;  // 从断开到重新连接的最长时间
+    uint32_t wifi_retries;      // WiFi重连次数
+    uint32_t failovers;         // 切换到其他服务器的次数
+};
+
 /**
  * @brief 网络模块类
  * 
@@ -27,6 +142,9 @@ public:
     
     /**
      * @brief 连接WiFi网络
+     * 
+     * 有上次连接的记录时直接在记录的信道上连接记录的BSSID，地址未过期时作为静态地址
+     * 使用，跳过扫描和DHCP；按记录连接失败时删除记录，立即改为全信道扫描和DHCP。
      * @param ssid WiFi名称
      * @param password WiFi密码
      * @return 连接成功返回true，失败返回false
@@ -40,6 +158,9 @@ public:
     
     /**
      * @brief 连接TCP服务器
+     * 
+     * 使用set_transport()选择的传输方式（默认由NETWORK_TRANSPORT_UDP决定），TCP之外的
+     * 传输方式也沿用TCP相关的接口名称和事件。
      * @param host 服务器地址
      * @param port 服务器端口
      * @return 连接成功返回true，失败返回false
@@ -51,6 +172,73 @@ public:
      */
     void disconnect_tcp();
     
+    /**
+     * @brief 选择与服务器之间的传输方式，下次连接时生效
+     * 
+     * 已连接且传输方式不同时断开连接，由连接管理任务按新的方式重连。
+     * UDP不能与帧协议、上行压缩和TLS同时使用。
+     * @param type 传输方式
+     * @return 传输方式可用返回true
+     */
+    bool set_transport(transport_type type);
+    
+    /**
+     * @brief 获取当前选择的传输方式
+     */
+    transport_type get_transport() const;
+    
+    /**
+     * @brief 获取启动后各阶段的耗时，尚未到达的阶段为0
+     * @return 启动耗时
+     */
+    boot_timing get_boot_timing() const;
+    
+    /**
+     * @brief 获取UDP传输统计，未使用过UDP时全部为0
+     * @return UDP传输统计
+     */
+    udp_transport_stats get_udp_stats() const;
+    
+    /**
+     * @brief 启动TCP连接管理，立即返回
+     * 
+     * 连接管理任务在WiFi可用时连接服务器，连接断开后立即重试一次，之后按带随机抖动的
+     * 指数退避重试；获取IP地址时跳过退避立即重试。WiFi断开后也由该任务按退避间隔重连。
+     * 状态变化以tcp_state_changed事件发布。
+     * @param host 服务器地址
+     * @param port 服务器端口
+     */
+    void start_connection(const std::string& host, uint16_t port);
+    
+    /**
+     * @brief 启动TCP连接管理，在多个服务器之间故障切换
+     * 
+     * 每次连接向两个候选服务器竞速：上次成功的服务器先发起，ENDPOINT_RACE_STAGGER_MS后
+     * （或第一个立即失败时）再向其余服务器中健康分最高的发起，使用先连接成功的一个，
+     * 之后固定使用它直到断开后竞速中其他服务器胜出。切换服务器与普通重连相同：
+     * 断开时上行队列中未发送的数据和断开期间的上行数据由存储转发缓存（见set_unsent_callback()），
+     * 未确认的帧在新连接上重传。断开瞬间已写入协议栈但服务器未读取的数据（未启用帧协议时）无法恢复。
+     * @param endpoints 按优先级排列的服务器列表（最多ENDPOINT_MAX个）
+     */
+    void start_connection(const std::vector<server_endpoint>& endpoints);
+    
+    /**
+     * @brief 停止TCP连接管理并断开TCP连接
+     */
+    void stop_connection();
+    
+    /**
+     * @brief 获取TCP连接管理统计
+     * @return 连接管理统计
+     */
+    connection_stats get_connection_stats() const;
+    
+    /**
+     * @brief 获取每个服务器的健康统计
+     * @return 按配置顺序排列的统计
+     */
+    std::vector<endpoint_stats> get_endpoint_stats() const;
+    
     /**
      * @brief 发送数据到TCP服务器
      * @param data 要发送的数据
@@ -58,16 +246,93 @@ public:
      */
     bool send_data(const std::vector<uint8_t>& data);
     
+    /**
+     * @brief 发送缓冲池缓冲区中的数据到TCP服务器
+     * @param buffer 缓冲区句柄
+     * @return 发送成功返回true，失败返回false
+     */
+    bool send_data(const pool_buffer& buffer);
+    
+    /**
+     * @brief 聚合发送多个缓冲区段到TCP服务器
+     * 
+     * 用一次sendmsg()发送所有段（超过NETWORK_SEND_GATHER_WINDOW段时分批），部分写入时
+     * 从中断处继续发送，直到全部发送完成或出错。帧头、负载和帧尾可以分别放在不同段中，
+     * 无需拼接复制。多个任务并发调用时，每次调用的数据在TCP流中保持连续。
+     * 启用帧协议时各段被复制到一个缓冲区中作为一帧发送。启用上行压缩时各段压缩后发送，
+     * 每次调用结束时刷新压缩器。
+     * @param segments 缓冲区段数组（不会被修改）
+     * @param count 段数
+     * @return 全部发送成功返回true，失败返回false
+     */
+    bool send_gather(const struct iovec* segments, size_t count);
+    
+    /**
+     * @brief 将数据放入上行环形队列，由TCP发送任务异步发送
+     * 
+     * 只允许一个任务（UART接收任务）调用。队列中待发送字节数越过高/低水位线时
+     * 分别投递uplink_high_watermark/uplink_low_watermark事件，用于流量控制。
+     * @param buffer 缓冲区句柄
+     * @return 成功入队返回true，队列已满返回false（数据被丢弃）
+     */
+    bool enqueue_uplink(const pool_buffer& buffer);
+    
+    /**
+     * @brief 获取上行链路统计
+     * @return 上行链路统计
+     */
+    uplink_stats get_uplink_stats() const;
+    
+    /**
+     * @brief 设置上行合并发送配置，运行时生效
+     * @param config 合并发送配置
+     */
+    void set_coalesce_config(const uplink_coalesce_config& config);
+    
+    /**
+     * @brief 获取上行合并发送配置
+     * @return 合并发送配置
+     */
+    uplink_coalesce_config get_coalesce_config() const;
+    
+    /**
+     * @brief 获取帧协议统计，未启用帧协议时全部为0
+     * @return 帧协议统计
+     */
+    frame_protocol_stats get_protocol_stats() const;
+    
+    /**
+     * @brief 获取上行压缩统计，未启用压缩时全部为0
+     * @return 上行压缩统计
+     */
+    compress_stats get_compress_stats() const;
+    
+    /**
+     * @brief 获取TLS握手统计，未启用TLS时全部为0
+     * @return TLS握手统计
+     */
+    tls_stats get_tls_stats() const;
+    
     /**
      * @brief 设置数据接收回调函数
+     * 
+     * 回调在TCP接收任务中调用，缓冲区可直接保存引用而无需复制；回调阻塞时
+     * TCP接收暂停，由TCP窗口对服务器施加背压。断开连接时等待接收任务退出，
+     * 回调的阻塞时间必须有上限。应在连接TCP之前设置。
      * @param callback 接收到数据时的回调函数
      */
-    void set_data_callback(std::function<void(const std::vector<uint8_t>&)> callback);
+    void set_data_callback(std::function<void(const pool_buffer&)> callback);
     
     /**
-     * @brief 处理网络事件，必须定期调用
+     * @brief 设置未发送上行数据的回调函数
+     * 
+     * TCP断开（包括故障切换）或发送失败时，上行队列中尚未发送的数据按原顺序逐块交给回调
+     * （存储转发缓存），重新连接后重放；未设置回调或回调返回false时计为未发送并丢弃。
+     * 发送失败时整批交还，服务器可能重复收到失败前已写入协议栈的部分。
+     * 回调在TCP发送任务中调用，应在启动连接之前设置。
+     * @param callback 回调函数，成功保存数据时返回true
      */
-    void loop();
+    void set_unsent_callback(std::function<bool(const pool_buffer&)> callback);
     
     /**
      * @brief 事件处理函数
@@ -111,16 +376,165 @@ private:
     // TCP接收任务
     static void tcp_receive_task(void* pvParameters);
     
+    // TCP发送任务，从上行环形队列取数据发送
+    static void tcp_tx_task(void* pvParameters);
+    
+    // 连接管理任务，负责WiFi和TCP的重连
+    static void connection_task(void* pvParameters);
+    
+    // 设置WiFi站点配置，use_cache时锁定记录的BSSID和信道，地址未过期时停止DHCP使用记录的地址
+    void configure_sta(bool use_cache);
+    
+    // 静态地址到期时启动DHCP，返回距到期的等待时间（没有使用静态地址时为portMAX_DELAY）
+    TickType_t check_static_ip();
+    
+    // 记录启动后第一次到达某阶段的时间
+    static void mark_boot_time(std::atomic<int64_t>& slot);
+    
+    // 唤醒连接管理任务重新检查连接
+    void notify_connection_task();
+    
+    // 更新连接状态并发布事件
+    void set_connection_state(connection_state state);
+    
+    // 第attempt次失败后的退避时间（带随机抖动）
+    static TickType_t backoff_delay(uint32_t attempt);
+    
+    // 发送一段连续数据
+    bool send_bytes(const uint8_t* data, size_t size);
+    
+    // 发送一个窗口内的段，处理部分写入
+    bool send_window(struct iovec* iov, size_t count);
+    
+    // 一次系统调用发送一批缓冲区，并更新上行统计
+    void flush_uplink(pool_buffer* batch, size_t count, uint32_t bytes);
+    
+    // 把未能发送的缓冲区交给未发送回调，并更新上行统计
+    void requeue_unsent(const pool_buffer* buffers, size_t count);
+    
+    // 每个缓冲区封装为一帧发送，并保存在发送窗口中直到被确认；
+    // accepted不为空时返回已进入发送窗口（重连后重传）的前几个缓冲区数
+    bool send_frames(const pool_buffer* buffers, size_t count, size_t* accepted = nullptr);
+    
+    // 新连接建立后发送hello帧并重传未确认的帧（调用者持有发送锁）
+    bool resume_frames();
+    
+    // 向一组候选服务器竞速连接，成功时winner为获胜的候选序号，candidates[i].failed标记失败的候选
+    bool connect_candidates(const server_endpoint* endpoints, transport_candidate* candidates,
+                            size_t count, size_t& winner);
+    
+    // 在新建立的TCP连接上进行TLS握手并记录统计
+    bool handshake_tls();
+    
+    // 处理收到的一帧
+    void handle_frame(frame_parser::frame& frame);
+    
+    // 一帧加入发送窗口，段描述凑满一个窗口时先发送（调用者持有发送锁）
+    bool queue_frame(const pool_buffer& payload, uint32_t channel, TickType_t wait,
+                     struct iovec* iov, size_t& segments);
+    
+    // 压缩一组数据段并刷新，分配失败时返回空缓冲区且不改变压缩器状态（调用者持有发送锁）
+    pool_buffer compress_group(const struct iovec* group, size_t count, size_t bytes);
+    
     // 私有成员变量
     std::string ssid_;                // WiFi名称
     std::string password_;            // WiFi密码
-    std::string server_host_;         // 服务器地址
-    uint16_t server_port_;            // 服务器端口
-    int sock_;                        // Socket描述符
-    bool wifi_connected_;             // WiFi连接状态
-    bool tcp_connected_;              // TCP连接状态
+    esp_netif_t* sta_netif_;          // 站点网络接口
+    wifi_cache wifi_cache_;           // 上次连接的AP和地址，只在连接WiFi前和WiFi事件中访问
+    std::atomic<bool> wifi_pinned_;   // 当前配置锁定了记录的BSSID和信道
+    std::atomic<bool> wifi_fast_pending_; // 按记录连接尚未关联到AP
+    std::atomic<bool> static_ip_;     // 正在使用记录的地址，DHCP已停止
+    std::atomic<int64_t> static_ip_expires_; // 记录的地址到期的系统时间（秒）
+    std::string server_host_;         // 当前连接的服务器地址
+    uint16_t server_port_;            // 当前连接的服务器端口
+    endpoint_list endpoints_;         // 连接管理使用的服务器列表
+    tcp_transport tcp_transport_;
+    udp_transport udp_transport_;
+    transport* transport_;            // 当前连接使用的传输，只在未连接时切换
+    std::atomic<int32_t> transport_request_; // set_transport()选择的transport_type
+    std::atomic<bool> wifi_connected_; // WiFi连接状态
+    std::atomic<bool> tcp_connected_;  // TCP连接状态
     TaskHandle_t task_handle_;        // TCP接收任务句柄
-    std::function<void(const std::vector<uint8_t>&)> data_callback_; // 数据接收回调
+    TaskHandle_t tx_task_handle_;     // TCP发送任务句柄
+    TaskHandle_t conn_task_handle_;   // 连接管理任务句柄
+    std::mutex send_mutex_;           // 保证每次发送的数据在TCP流中连续
+    
+    // 上行环形队列（UART接收任务生产，TCP发送任务消费）
+    spsc_ring<buffer_block*> uplink_ring_;
+    std::atomic<uint32_t> uplink_queued_bytes_;   // 队列中待发送字节数
+    std::atomic<uint32_t> uplink_peak_bytes_;     // 待发送字节数峰值
+    std::atomic<uint32_t> uplink_sent_bytes_;     // 已发送字节数
+    std::atomic<uint32_t> uplink_dropped_bytes_;  // 队列满丢弃的字节数
+    std::atomic<uint32_t> uplink_unsent_bytes_;   // 未连接或发送失败丢弃的字节数
+    std::atomic<uint32_t> uplink_requeued_bytes_; // 未连接或发送失败交还缓存的字节数
+    std::atomic<bool> uplink_above_high_;         // 是否处于高水位状态
+    std::atomic<uint32_t> uplink_chunks_;         // 出队数据块数
+    std::atomic<uint32_t> uplink_send_calls_;     // 发送系统调用次数
+    std::atomic<uint32_t> uplink_flush_size_;     // 按字节阈值发送的批次数
+    std::atomic<uint32_t> uplink_flush_timeout_;  // 按最大延迟发送的批次数
+    std::atomic<uint32_t> uplink_flush_delim_;    // 按分隔符发送的批次数
+    
+    // 合并发送配置（发送任务每批读取一次）
+    std::atomic<uint32_t> coalesce_max_bytes_;
+    std::atomic<uint32_t> coalesce_latency_ms_;
+    std::atomic<int32_t> coalesce_delimiter_;
+    std::function<void(const pool_buffer&)> data_callback_; // 数据接收回调
+    std::function<bool(const pool_buffer&)> unsent_callback_; // 未发送上行数据回调
+    
+    // 帧协议（启用时）
+    frame_window frame_window_;       // 未确认的上行帧
+    frame_parser frame_parser_;       // 下行帧解析，只在接收任务中使用
+    uint32_t session_id_;             // 本次启动的会话ID
+    uint32_t rx_expected_seq_;        // 期望的下一个下行帧号，0表示尚未收到
+    std::atomic<uint32_t> rx_seq_gaps_;
+    
+    // 上行压缩（启用时），压缩器只在持有发送锁时使用
+    lz_encoder encoder_;
+    std::atomic<uint32_t> compress_input_bytes_;
+    std::atomic<uint32_t> compress_output_bytes_;
+    std::atomic<uint32_t> compress_flushes_;
+    std::atomic<uint64_t> compress_cycles_;
+    std::atomic<uint32_t> compress_time_us_;
+    std::atomic<uint32_t> compress_max_us_;
+    
+    // TLS（启用时），握手只在连接管理任务中进行
+    tls_client* tls_;
+    std::atomic<uint32_t> tls_full_;
+    std::atomic<uint32_t> tls_resumed_;
+    std::atomic<uint32_t> tls_failed_;
+    std::atomic<bool> tls_last_resumed_;
+    std::atomic<uint32_t> tls_last_ms_;
+    std::atomic<uint32_t> tls_full_ms_;           // 以下为累计值，读取时求平均
+    std::atomic<uint32_t> tls_resumed_ms_;
+    std::atomic<uint32_t> tls_full_compute_ms_;
+    std::atomic<uint32_t> tls_resumed_compute_ms_;
+    std::atomic<uint32_t> tls_full_bytes_;
+    std::atomic<uint32_t> tls_resumed_bytes_;
+    
+    // 连接管理（endpoints_在启用前设置）
+    std::atomic<bool> conn_enabled_;              // 是否启用TCP连接管理
+    std::atomic<bool> wifi_started_;              // WiFi已启动，断开后需要重连
+    std::atomic<bool> wifi_retry_pending_;        // WiFi断开后尚未发起重连
+    std::atomic<bool> fast_retry_;                // 获取IP后跳过退避立即重试
+    std::atomic<int32_t> conn_state_;             // 当前connection_state
+    std::atomic<TickType_t> tcp_lost_tick_;       // TCP连接断开的时间
+    std::atomic<bool> tcp_lost_;                  // 是否正在从断开中恢复
+    std::atomic<uint32_t> conn_attempts_;
+    std::atomic<uint32_t> conn_failures_;
+    std::atomic<uint32_t> conn_reconnects_;
+    std::atomic<uint32_t> conn_last_reconnect_ms_;
+    std::atomic<uint32_t> conn_max_reconnect_ms_;
+    std::atomic<uint32_t> wifi_retries_;
+    std::atomic<uint32_t> conn_failovers_;
+    
+    // 启动耗时（esp_timer微秒，0表示尚未到达）
+    std::atomic<bool> boot_cached_ap_;
+    std::atomic<bool> boot_reused_lease_;
+    std::atomic<uint32_t> wifi_fallbacks_;
+    std::atomic<int64_t> boot_assoc_us_;
+    std::atomic<int64_t> boot_ip_us_;
+    std::atomic<int64_t> boot_tcp_us_;
+    std::atomic<int64_t> boot_first_byte_us_;
 };
 
 } // namespace esp_framework 
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "transport.h"
+
+namespace esp_framework {
+
+/**
+ * @brief TCP传输
+ *
+ * 非阻塞connect()带超时，连接后恢复阻塞模式并关闭Nagle算法（合并由上行发送任务控制）。
+ * open_race()同时等待多个非阻塞connect()，实现错开发起的竞速连接。
+ */
+class tcp_transport : public transport {
+public:
+    tcp_transport();
+    ~tcp_transport() override;
+    
+    transport_type type() const override { return transport_type::tcp; }
+    const char* name() const override { return "TCP"; }
+    bool open(uint32_t addr, uint16_t port, uint32_t timeout_ms) override;
+    bool open_race(transport_candidate* candidates, size_t count, uint32_t stagger_ms,
+                   uint32_t timeout_ms, size_t& winner) override;
+    bool send(struct iovec* segments, size_t count) override;
+    int receive(uint8_t* data, size_t size) override;
+    void shutdown() override;
+    void close() override;
+    int fd() const override { return sock_; }
+    
+    /**
+     * @brief 竞速连接最多的候选数
+     */
+    static constexpr size_t MAX_RACE_CANDIDATES = 4;
+    
+private:
+    // 发起一个非阻塞连接，返回套接字，立即失败时返回-1
+    static int start_connect(const transport_candidate& candidate);
+    
+    int sock_;
+};
+
+} // namespace esp_framework
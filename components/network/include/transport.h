@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/uio.h>
+
+namespace esp_framework {
+
+/**
+ * @brief 传输方式
+ */
+enum class transport_type : int32_t {
+    tcp,        // TCP字节流
+    udp         // UDP数据报，每个数据报带帧号，丢失不重传
+};
+
+/**
+ * @brief 竞速连接的候选地址
+ */
+struct transport_candidate {
+    uint32_t addr;      // IPv4地址（网络字节序）
+    uint16_t port;      // 端口
+    bool failed;        // 输出：连接失败（被放弃的候选为false）
+};
+
+/**
+ * @brief 与服务器之间的传输抽象
+ *
+ * 网络模块通过该接口收发数据，不关心底层是字节流还是数据报。
+ * 发送由调用者串行化；接收只在一个任务中调用，shutdown()可从其他任务唤醒它。
+ */
+class transport {
+public:
+    /**
+     * @brief 获取传输方式
+     */
+    virtual transport_type type() const = 0;
+    
+    /**
+     * @brief 获取传输名称（用于日志）
+     */
+    virtual const char* name() const = 0;
+    
+    /**
+     * @brief 连接服务器，阻塞到连接完成或超时
+     * @param addr 服务器IPv4地址（网络字节序，由dns_cache解析）
+     * @param port 服务器端口
+     * @param timeout_ms 连接超时时间
+     * @return 成功返回true
+     */
+    virtual bool open(uint32_t addr, uint16_t port, uint32_t timeout_ms) = 0;
+    
+    /**
+     * @brief 按顺序向多个候选地址发起连接，使用最先连接成功的一个
+     *
+     * 第i个候选在开始后i×stagger_ms发起，前面的候选全部失败时立即发起下一个，
+     * 其余连接在有候选成功后关闭。默认实现依次调用open()，用于无需建立连接的传输。
+     * @param candidates 候选地址，按优先级排列
+     * @param count 候选数
+     * @param stagger_ms 相邻候选发起连接的间隔
+     * @param timeout_ms 从开始到放弃的总超时时间
+     * @param winner 输出成功的候选序号
+     * @return 有候选连接成功返回true
+     */
+    virtual bool open_race(transport_candidate* candidates, size_t count, uint32_t stagger_ms,
+                           uint32_t timeout_ms, size_t& winner) {
+        for (size_t i = 0; i < count; i++) {
+            candidates[i].failed = !open(candidates[i].addr, candidates[i].port, timeout_ms);
+            if (!candidates[i].failed) {
+                winner = i;
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    /**
+     * @brief 发送一组数据段，全部交给协议栈后返回
+     *
+     * 段描述可能被修改（部分写入时前移），调用者不应再使用。
+     * @return 成功返回true，失败表示连接已不可用
+     */
+    virtual bool send(struct iovec* segments, size_t count) = 0;
+    
+    /**
+     * @brief 阻塞接收数据
+     * @return 接收的字节数，连接被关闭（包括本地调用shutdown()）返回0，出错返回-1
+     */
+    virtual int receive(uint8_t* data, size_t size) = 0;
+    
+    /**
+     * @brief 唤醒阻塞在receive()中的任务，之后的发送和接收都失败
+     */
+    virtual void shutdown() = 0;
+    
+    /**
+     * @brief 释放套接字
+     */
+    virtual void close() = 0;
+    
+    /**
+     * @brief 获取套接字描述符，未连接时返回-1
+     */
+    virtual int fd() const = 0;
+    
+    /**
+     * @brief 虚析构函数
+     */
+    virtual ~transport() = default;
+};
+
+} // namespace esp_framework
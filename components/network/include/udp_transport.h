@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include "transport.h"
+
+namespace esp_framework {
+
+/**
+ * @brief UDP数据报头部大小：4字节帧号（小端）
+ */
+constexpr size_t UDP_DATAGRAM_HEADER_SIZE = 4;
+
+/**
+ * @brief 单个数据报最多包含的数据段数
+ */
+constexpr size_t UDP_DATAGRAM_MAX_SEGMENTS = 16;
+
+/**
+ * @brief UDP传输统计
+ */
+struct udp_transport_stats {
+    uint32_t tx_datagrams;      // 发送的数据报数
+    uint32_t tx_dropped;        // 协议栈缓冲不足而丢弃的数据报数
+    uint32_t rx_datagrams;      // 接收的数据报数
+    uint32_t rx_lost;           // 按帧号推算丢失的下行数据报数
+    uint32_t rx_reordered;      // 乱序或重复到达的下行数据报数
+};
+
+/**
+ * @brief UDP传输
+ *
+ * 每个数据报为4字节帧号加负载。发送时数据段按顺序装入数据报，数据报边界总落在段边界上
+ * （UART一次读取的数据不会被拆到两个数据报中），只有超过最大负载的段才被拆开。
+ * 帧号每个数据报加1，从设备启动时的0开始，重连后继续，接收方据此统计丢失；
+ * 帧号为0的数据报表示设备重新启动。连接后先发送一个只有帧头的数据报，服务器由此得知设备地址。
+ * 丢失的数据不重传，适合宁可丢失也不要队头阻塞的实时数据。
+ */
+class udp_transport : public transport {
+public:
+    /**
+     * @param max_payload 每个数据报的最大负载字节数，应小于路径MTU减去IP和UDP头部
+     */
+    explicit udp_transport(size_t max_payload);
+    ~udp_transport() override;
+    
+    transport_type type() const override { return transport_type::udp; }
+    const char* name() const override { return "UDP"; }
+    bool open(uint32_t addr, uint16_t port, uint32_t timeout_ms) override;
+    bool send(struct iovec* segments, size_t count) override;
+    int receive(uint8_t* data, size_t size) override;
+    void shutdown() override;
+    void close() override;
+    int fd() const override { return sock_; }
+    
+    /**
+     * @brief 获取统计
+     */
+    udp_transport_stats get_stats() const;
+    
+private:
+    // 发送一个数据报，iov[0]留给帧头
+    bool send_datagram(struct iovec* iov, size_t count);
+    
+    // 根据下行帧号更新丢失和乱序统计
+    void track_rx_seq(uint32_t seq);
+    
+    int sock_;
+    size_t max_payload_;
+    std::atomic<bool> open_;
+    uint32_t tx_seq_;
+    bool rx_started_;
+    uint32_t rx_expected_seq_;
+    std::atomic<uint32_t> tx_datagrams_;
+    std::atomic<uint32_t> tx_dropped_;
+    std::atomic<uint32_t> rx_datagrams_;
+    std::atomic<uint32_t> rx_lost_;
+    std::atomic<uint32_t> rx_reordered_;
+};
+
+} // namespace esp_framework
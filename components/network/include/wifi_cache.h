@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace esp_framework {
+
+/**
+ * @brief 上次连接的AP和IP地址
+ */
+struct wifi_cache_record {
+    uint32_t ssid_hash;     // SSID的FNV-1a哈希，SSID变化时记录作废
+    uint8_t bssid[6];       // AP的MAC地址
+    uint8_t channel;        // 主信道，0表示没有AP记录
+    uint8_t authmode;       // wifi_auth_mode_t，作为重连时的最低安全要求
+    uint32_t ip;            // DHCP分配的地址（网络字节序），0表示没有
+    uint32_t netmask;
+    uint32_t gw;
+    uint32_t dns;           // DHCP提供的DNS服务器
+    int64_t lease_at;       // 获得地址时的系统时间（秒）
+};
+
+/**
+ * @brief WiFi快速重连缓存
+ *
+ * 保存上次连接的BSSID、信道、安全模式和DHCP地址。唤醒后直接在已知信道上向该BSSID
+ * 发起连接，不做全信道扫描；地址在WIFI_LEASE_REUSE_S内直接作为静态地址使用，不等待DHCP。
+ * 系统时钟在深度睡眠期间继续计时，上电复位后时钟从0开始，之前的地址视为过期。
+ *
+ * 记录保存在NVS中（上电复位后AP记录仍然可用），只在AP变化或通过DHCP获得地址时写入。
+ */
+class wifi_cache {
+public:
+    wifi_cache();
+    
+    /**
+     * @brief 从NVS加载记录
+     * @param ssid 本次连接的SSID
+     * @return 有该SSID的AP记录返回true
+     */
+    bool load(const std::string& ssid);
+    
+    /**
+     * @brief 获取记录
+     */
+    const wifi_cache_record& record() const { return record_; }
+    
+    /**
+     * @brief 地址是否仍在可直接使用的期限内
+     * @param remaining_s 输出剩余秒数，可为nullptr
+     */
+    bool lease_valid(int64_t* remaining_s = nullptr) const;
+    
+    /**
+     * @brief 记录连接的AP，与保存的不同时写入NVS
+     */
+    void update_ap(const uint8_t* bssid, uint8_t channel, uint8_t authmode);
+    
+    /**
+     * @brief 记录DHCP获得的地址并写入NVS
+     */
+    void update_ip(uint32_t ip, uint32_t netmask, uint32_t gw, uint32_t dns);
+    
+    /**
+     * @brief 删除记录（按记录连接失败时调用）
+     */
+    void invalidate();
+    
+private:
+    void save();
+    
+    wifi_cache_record record_;
+};
+
+} // namespace esp_framework
@@ -0,0 +1,252 @@
+#include "dns_cache.h"
+#include <cstring>
+#include <ctime>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "lwip/netdb.h"
+#include "lwip/sockets.h"
+#include "sdkconfig.h"
+
+static const char* TAG = "DNS";
+
+#define DNS_CACHE_TTL_S CONFIG_DNS_CACHE_TTL_S
+#define DNS_CACHE_NVS_NAMESPACE "dns_cache"
+#define DNS_CACHE_NVS_KEY "entries"
+
+// 后台解析任务，getaddrinfo()在lwIP中需要较大的栈
+#define DNS_REFRESH_TASK_STACK_SIZE 4096
+#define DNS_REFRESH_TASK_PRIORITY 3
+
+namespace esp_framework {
+
+dns_cache& dns_cache::get_instance() {
+    static dns_cache instance;
+    return instance;
+}
+
+dns_cache::dns_cache() : refresh_task_(nullptr), stats_() {
+    memset(entries_, 0, sizeof(entries_));
+    memset(refresh_pending_, 0, sizeof(refresh_pending_));
+    load();
+}
+
+// 系统时间（秒），深度睡眠期间继续计时
+static int64_t now_seconds() {
+    return static_cast<int64_t>(time(nullptr));
+}
+
+bool dns_cache::lookup(const char* host, uint32_t& addr) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    
+    struct addrinfo* result = nullptr;
+    int64_t start = esp_timer_get_time();
+    int err = getaddrinfo(host, nullptr, &hints, &result);
+    uint32_t elapsed_ms = static_cast<uint32_t>((esp_timer_get_time() - start) / 1000);
+    
+    bool ok = err == 0 && result != nullptr;
+    if (ok) {
+        addr = reinterpret_cast<struct sockaddr_in*>(result->ai_addr)->sin_addr.s_addr;
+    }
+    if (result != nullptr) {
+        freeaddrinfo(result);
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.last_lookup_ms = elapsed_ms;
+    if (elapsed_ms > stats_.max_lookup_ms) {
+        stats_.max_lookup_ms = elapsed_ms;
+    }
+    if (!ok) {
+        stats_.failures++;
+        ESP_LOGW(TAG, "解析%s失败: %d (%lums)", host, err, (unsigned long)elapsed_ms);
+        return false;
+    }
+    struct in_addr in;
+    in.s_addr = addr;
+    ESP_LOGI(TAG, "%s -> %s (%lums)", host, inet_ntoa(in), (unsigned long)elapsed_ms);
+    return true;
+}
+
+dns_cache::entry* dns_cache::find(const char* host) {
+    for (auto& item : entries_) {
+        if (item.host[0] != '\0' && strncmp(item.host, host, DNS_CACHE_HOST_LEN) == 0) {
+            return &item;
+        }
+    }
+    return nullptr;
+}
+
+void dns_cache::store(const char* host, uint32_t addr) {
+    entry* item = find(host);
+    if (item == nullptr) {
+        item = &entries_[0];
+        for (auto& candidate : entries_) {
+            if (candidate.host[0] == '\0') {
+                item = &candidate;
+                break;
+            }
+            if (candidate.resolved_at < item->resolved_at) {
+                item = &candidate;
+            }
+        }
+        memset(item, 0, sizeof(*item));
+        strncpy(item->host, host, DNS_CACHE_HOST_LEN - 1);
+    }
+    
+    // 地址不变时只更新内存中的时间，不写NVS；时间只用于判断是否过期，重启后多解析一次无妨
+    bool changed = item->addr != addr || item->resolved_at == 0;
+    item->addr = addr;
+    item->resolved_at = now_seconds();
+    if (changed) {
+        save();
+    }
+}
+
+bool dns_cache::resolve(const std::string& host, uint32_t& addr, dns_source* source) {
+    struct in_addr literal;
+    if (inet_aton(host.c_str(), &literal)) {
+        addr = literal.s_addr;
+        if (source != nullptr) {
+            *source = dns_source::literal;
+        }
+        return true;
+    }
+    if (host.size() >= DNS_CACHE_HOST_LEN) {
+        ESP_LOGE(TAG, "主机名过长: %s", host.c_str());
+        return false;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entry* item = find(host.c_str());
+        if (item != nullptr) {
+            addr = item->addr;
+            int64_t age = now_seconds() - item->resolved_at;
+            bool fresh = item->resolved_at > 0 && age >= 0 && age < DNS_CACHE_TTL_S;
+            if (fresh) {
+                stats_.fresh_hits++;
+            } else {
+                stats_.stale_hits++;
+                schedule_refresh(*item);
+            }
+            if (source != nullptr) {
+                *source = fresh ? dns_source::fresh : dns_source::stale;
+            }
+            return true;
+        }
+        stats_.lookups++;
+    }
+    
+    // 从未解析过，只能等待DNS
+    if (!lookup(host.c_str(), addr)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    store(host.c_str(), addr);
+    if (source != nullptr) {
+        *source = dns_source::lookup;
+    }
+    return true;
+}
+
+void dns_cache::expire(const std::string& host) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entry* item = find(host.c_str());
+    if (item != nullptr) {
+        item->resolved_at = 0;
+        schedule_refresh(*item);
+    }
+}
+
+void dns_cache::schedule_refresh(entry& item) {
+    size_t index = &item - entries_;
+    if (refresh_pending_[index]) {
+        return;
+    }
+    refresh_pending_[index] = true;
+    
+    // 第一次需要时才创建后台任务
+    if (refresh_task_ == nullptr &&
+        xTaskCreate(refresh_task, "dns_refresh", DNS_REFRESH_TASK_STACK_SIZE, this,
+                    DNS_REFRESH_TASK_PRIORITY, &refresh_task_) != pdPASS) {
+        ESP_LOGE(TAG, "DNS后台解析任务创建失败");
+        refresh_task_ = nullptr;
+        refresh_pending_[index] = false;
+        return;
+    }
+    xTaskNotifyGive(refresh_task_);
+}
+
+void dns_cache::refresh_task(void* arg) {
+    dns_cache* cache = static_cast<dns_cache*>(arg);
+    
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        
+        for (size_t i = 0; i < DNS_CACHE_MAX_ENTRIES; i++) {
+            char host[DNS_CACHE_HOST_LEN];
+            {
+                std::lock_guard<std::mutex> lock(cache->mutex_);
+                if (!cache->refresh_pending_[i]) {
+                    continue;
+                }
+                memcpy(host, cache->entries_[i].host, sizeof(host));
+                cache->stats_.refreshes++;
+            }
+            
+            // 解析失败时保留旧地址，下次使用时再重试
+            uint32_t addr;
+            bool ok = cache->lookup(host, addr);
+            
+            std::lock_guard<std::mutex> lock(cache->mutex_);
+            cache->refresh_pending_[i] = false;
+            if (ok) {
+                cache->store(host, addr);
+            }
+        }
+    }
+}
+
+void dns_cache::load() {
+#if CONFIG_DNS_CACHE_PERSIST
+    nvs_handle_t handle;
+    if (nvs_open(DNS_CACHE_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;
+    }
+    size_t length = sizeof(entries_);
+    if (nvs_get_blob(handle, DNS_CACHE_NVS_KEY, entries_, &length) != ESP_OK || length != sizeof(entries_)) {
+        memset(entries_, 0, sizeof(entries_));
+    }
+    nvs_close(handle);
+    
+    for (auto& item : entries_) {
+        item.host[DNS_CACHE_HOST_LEN - 1] = '\0';
+    }
+#endif
+}
+
+void dns_cache::save() {
+#if CONFIG_DNS_CACHE_PERSIST
+    nvs_handle_t handle;
+    if (nvs_open(DNS_CACHE_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        ESP_LOGW(TAG, "无法打开NVS，DNS缓存未保存");
+        return;
+    }
+    if (nvs_set_blob(handle, DNS_CACHE_NVS_KEY, entries_, sizeof(entries_)) != ESP_OK ||
+        nvs_commit(handle) != ESP_OK) {
+        ESP_LOGW(TAG, "保存DNS缓存失败");
+    }
+    nvs_close(handle);
+#endif
+}
+
+dns_cache_stats dns_cache::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace esp_framework
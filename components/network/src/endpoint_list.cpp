@@ -0,0 +1,187 @@
+#include "endpoint_list.h"
+#include <cstdlib>
+#include <cstring>
+#include "esp_log.h"
+#include "nvs.h"
+
+static const char* TAG = "Endpoint";
+
+#define ENDPOINT_NVS_NAMESPACE "endpoints"
+#define ENDPOINT_NVS_KEY "health"
+
+// 新服务器的初始健康分
+#define ENDPOINT_INITIAL_SCORE 50
+
+namespace esp_framework {
+
+endpoint_list::endpoint_list() : pinned_(0) {
+    memset(scores_, 0, sizeof(scores_));
+    memset(attempts_, 0, sizeof(attempts_));
+    memset(failures_, 0, sizeof(failures_));
+    memset(wins_, 0, sizeof(wins_));
+}
+
+void endpoint_list::set(const std::vector<server_endpoint>& endpoints) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    endpoints_.assign(endpoints.begin(), endpoints.begin() + (endpoints.size() < ENDPOINT_MAX ? endpoints.size() : ENDPOINT_MAX));
+    if (endpoints.size() > ENDPOINT_MAX) {
+        ESP_LOGW(TAG, "服务器数量超过%u个，忽略多余的服务器", (unsigned)ENDPOINT_MAX);
+    }
+    pinned_ = 0;
+    memset(scores_, ENDPOINT_INITIAL_SCORE, sizeof(scores_));
+    
+    nvs_handle_t handle;
+    if (nvs_open(ENDPOINT_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;
+    }
+    persisted data;
+    size_t length = sizeof(data);
+    esp_err_t err = nvs_get_blob(handle, ENDPOINT_NVS_KEY, &data, &length);
+    nvs_close(handle);
+    if (err != ESP_OK || length != sizeof(data) || data.list_hash != list_hash() || data.pinned >= endpoints_.size()) {
+        return;
+    }
+    pinned_ = data.pinned;
+    memcpy(scores_, data.scores, sizeof(scores_));
+    ESP_LOGI(TAG, "从上次成功的服务器开始连接: %s:%u", endpoints_[pinned_].host.c_str(), endpoints_[pinned_].port);
+}
+
+bool endpoint_list::parse(const char* text, uint16_t default_port, std::vector<server_endpoint>& endpoints) {
+    const char* p = text;
+    while (*p != '\0') {
+        const char* end = strchr(p, ',');
+        std::string item(p, end != nullptr ? static_cast<size_t>(end - p) : strlen(p));
+        p = end != nullptr ? end + 1 : p + item.size();
+        
+        // 去掉首尾空格
+        size_t first = item.find_first_not_of(' ');
+        size_t last = item.find_last_not_of(' ');
+        if (first == std::string::npos) {
+            continue;
+        }
+        item = item.substr(first, last - first + 1);
+        
+        server_endpoint endpoint = {item, default_port};
+        size_t colon = item.rfind(':');
+        if (colon != std::string::npos) {
+            char* tail = nullptr;
+            long port = strtol(item.c_str() + colon + 1, &tail, 10);
+            if (colon == 0 || *tail != '\0' || port <= 0 || port > 65535) {
+                ESP_LOGE(TAG, "服务器地址格式错误: %s", item.c_str());
+                return false;
+            }
+            endpoint.host = item.substr(0, colon);
+            endpoint.port = static_cast<uint16_t>(port);
+        }
+        endpoints.push_back(endpoint);
+    }
+    return true;
+}
+
+size_t endpoint_list::candidates(size_t* indexes, size_t max) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    if (max == 0 || endpoints_.empty()) {
+        return 0;
+    }
+    indexes[count++] = pinned_;
+    
+    // 其余按健康分从高到低，同分时配置在前的优先
+    bool used[ENDPOINT_MAX] = {};
+    used[pinned_] = true;
+    while (count < max && count < endpoints_.size()) {
+        size_t best = ENDPOINT_MAX;
+        for (size_t i = 0; i < endpoints_.size(); i++) {
+            if (!used[i] && (best == ENDPOINT_MAX || scores_[i] > scores_[best])) {
+                best = i;
+            }
+        }
+        used[best] = true;
+        indexes[count++] = best;
+    }
+    return count;
+}
+
+server_endpoint endpoint_list::get(size_t index) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return endpoints_[index];
+}
+
+bool endpoint_list::report(size_t index, bool failed, bool won) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!failed && !won) {
+        return false;
+    }
+    attempts_[index]++;
+    if (failed) {
+        failures_[index]++;
+        scores_[index] /= 2;
+        return false;
+    }
+    
+    wins_[index]++;
+    scores_[index] += (100 - scores_[index] + 1) / 2;
+    bool switched = index != pinned_;
+    if (switched) {
+        ESP_LOGW(TAG, "切换服务器: %s:%u -> %s:%u",
+                 endpoints_[pinned_].host.c_str(), endpoints_[pinned_].port,
+                 endpoints_[index].host.c_str(), endpoints_[index].port);
+        pinned_ = index;
+    }
+    return switched;
+}
+
+void endpoint_list::save() {
+    persisted data;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        data.list_hash = list_hash();
+        data.pinned = static_cast<uint8_t>(pinned_);
+        memcpy(data.scores, scores_, sizeof(data.scores));
+    }
+    
+    nvs_handle_t handle;
+    if (nvs_open(ENDPOINT_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        ESP_LOGW(TAG, "无法打开NVS，服务器健康分未保存");
+        return;
+    }
+    if (nvs_set_blob(handle, ENDPOINT_NVS_KEY, &data, sizeof(data)) != ESP_OK || nvs_commit(handle) != ESP_OK) {
+        ESP_LOGW(TAG, "保存服务器健康分失败");
+    }
+    nvs_close(handle);
+}
+
+size_t endpoint_list::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return endpoints_.size();
+}
+
+std::vector<endpoint_stats> endpoint_list::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<endpoint_stats> stats;
+    for (size_t i = 0; i < endpoints_.size(); i++) {
+        endpoint_stats item;
+        item.host = endpoints_[i].host;
+        item.port = endpoints_[i].port;
+        item.score = scores_[i];
+        item.pinned = i == pinned_;
+        item.attempts = attempts_[i];
+        item.failures = failures_[i];
+        item.wins = wins_[i];
+        stats.push_back(item);
+    }
+    return stats;
+}
+
+uint32_t endpoint_list::list_hash() const {
+    uint32_t hash = 2166136261u;
+    for (const auto& endpoint : endpoints_) {
+        std::string key = endpoint.host + ":" + std::to_string(endpoint.port) + ",";
+        for (char c : key) {
+            hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+} // namespace esp_framework
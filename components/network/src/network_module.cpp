@@ -1,7 +1,13 @@
+#include <cstring>
+#include <ctime>
+#include <new>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
 #include "esp_system.h"
+#include "esp_random.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_log.h"
@@ -11,7 +17,12 @@
 #include "lwip/sockets.h"
 #include "sdkconfig.h"
 #include "network_module.h"
+#include "dns_cache.h"
+#include "wake_lock.h"
 #include "esp_netif.h"
+#if CONFIG_TLS_ENABLE
+#include "tls_client.h"
+#endif
 
 static const char* TAG = "Network";
 
@@ -19,18 +30,72 @@ static const char* TAG = "Network";
 #define WIFI_CONNECTED_BIT BIT0
 #define WIFI_FAIL_BIT      BIT1
 
-// TCP缓冲区大小
-#define TCP_BUFFER_SIZE 1024
+// TCP接收缓冲区大小
+#define TCP_RX_BUFFER_SIZE CONFIG_TCP_RX_BUFFER_SIZE
 
 // TCP任务栈大小和优先级
 #define TCP_TASK_STACK_SIZE 4096
 #define TCP_TASK_PRIORITY 5
 
+// 上行环形队列配置
+#define UPLINK_RING_SLOTS CONFIG_UPLINK_RING_SLOTS
+#define UPLINK_RING_SIZE CONFIG_UPLINK_RING_SIZE
+#define UPLINK_HIGH_WATERMARK (UPLINK_RING_SIZE * CONFIG_UPLINK_HIGH_WATERMARK / 100)
+#define UPLINK_LOW_WATERMARK (UPLINK_RING_SIZE * CONFIG_UPLINK_LOW_WATERMARK / 100)
+#define TCP_TX_TASK_STACK_SIZE CONFIG_TCP_TX_TASK_STACK_SIZE
+#define TCP_TX_TASK_PRIORITY CONFIG_TCP_TX_TASK_PRIORITY
+
+// 单个合并批次最多包含的数据块数
+#define UPLINK_COALESCE_MAX_SEGMENTS CONFIG_UPLINK_COALESCE_MAX_SEGMENTS
+
+// 帧协议
+#define PROTOCOL_FRAMING CONFIG_PROTOCOL_FRAMING
+#define PROTOCOL_WINDOW_FRAMES CONFIG_PROTOCOL_WINDOW_FRAMES
+#define PROTOCOL_ACK_TIMEOUT_MS CONFIG_PROTOCOL_ACK_TIMEOUT_MS
+#define PROTOCOL_MAX_PAYLOAD CONFIG_PROTOCOL_MAX_PAYLOAD
+#define FRAME_CHANNEL_DATA 0
+#define FRAME_CHANNEL_COMPRESSED 1
+
+// 上行压缩，每组输入的压缩结果不超过缓冲池的最大块（4096字节）
+#define UPLINK_COMPRESS CONFIG_UPLINK_COMPRESS
+#define UPLINK_COMPRESS_WINDOW_BITS CONFIG_UPLINK_COMPRESS_WINDOW_BITS
+#define COMPRESS_MAX_INPUT 4000
+#define COMPRESS_GROUP_SEGMENTS 16
+
+// TLS
+#define TLS_ENABLE CONFIG_TLS_ENABLE
+
+// 传输方式，UDP数据报不重传，不能承载依赖可靠字节流的帧协议、上行压缩和TLS
+#define NETWORK_TRANSPORT_UDP CONFIG_NETWORK_TRANSPORT_UDP
+#define UDP_MAX_PAYLOAD CONFIG_UDP_MAX_PAYLOAD
+#define UDP_TRANSPORT_SUPPORTED !(PROTOCOL_FRAMING || UPLINK_COMPRESS || TLS_ENABLE)
+#if NETWORK_TRANSPORT_UDP && !UDP_TRANSPORT_SUPPORTED
+#error "NETWORK_TRANSPORT_UDP不能与PROTOCOL_FRAMING、UPLINK_COMPRESS或TLS_ENABLE同时启用"
+#endif
+
+// 连接管理任务和重连退避
+#define CONN_TASK_STACK_SIZE 4096
+#define CONN_TASK_PRIORITY 5
+#define TCP_RECONNECT_MIN_MS CONFIG_TCP_RECONNECT_MIN_MS
+#define TCP_RECONNECT_MAX_MS CONFIG_TCP_RECONNECT_MAX_MS
+#define TCP_CONNECT_TIMEOUT_MS CONFIG_TCP_CONNECT_TIMEOUT_MS
+#define ENDPOINT_RACE_STAGGER_MS CONFIG_ENDPOINT_RACE_STAGGER_MS
+
 namespace esp_framework {
 
 // 创建事件组
 static EventGroupHandle_t s_wifi_event_group = NULL;
 
+// 日志中的地址来源
+static const char* dns_source_name(dns_source source) {
+    switch (source) {
+        case dns_source::literal: return "IP地址";
+        case dns_source::fresh: return "DNS缓存";
+        case dns_source::stale: return "过期DNS缓存";
+        default: return "DNS查询";
+    }
+}
+
 // 静态实例
 network_module& network_module::get_instance() {
     static network_module instance;
@@ -41,12 +106,85 @@ network_module& network_module::get_instance() {
 network_module::network_module() 
     : ssid_(),
       password_(),
+      sta_netif_(nullptr),
+      wifi_cache_(),
+      wifi_pinned_(false),
+      wifi_fast_pending_(false),
+      static_ip_(false),
+      static_ip_expires_(0),
       server_host_(),
       server_port_(0),
-      sock_(-1), 
+      tcp_transport_(),
+      udp_transport_(UDP_MAX_PAYLOAD),
+      transport_(&tcp_transport_),
+#if NETWORK_TRANSPORT_UDP
+      transport_request_(static_cast<int32_t>(transport_type::udp)),
+#else
+      transport_request_(static_cast<int32_t>(transport_type::tcp)),
+#endif
       wifi_connected_(false), 
       tcp_connected_(false),
-      task_handle_(nullptr) {
+      task_handle_(nullptr),
+      tx_task_handle_(nullptr),
+      conn_task_handle_(nullptr),
+      uplink_queued_bytes_(0),
+      uplink_peak_bytes_(0),
+      uplink_sent_bytes_(0),
+      uplink_dropped_bytes_(0),
+      uplink_unsent_bytes_(0),
+      uplink_requeued_bytes_(0),
+      uplink_above_high_(false),
+      uplink_chunks_(0),
+      uplink_send_calls_(0),
+      uplink_flush_size_(0),
+      uplink_flush_timeout_(0),
+      uplink_flush_delim_(0),
+      coalesce_max_bytes_(CONFIG_UPLINK_COALESCE_BYTES),
+      coalesce_latency_ms_(CONFIG_UPLINK_COALESCE_LATENCY_MS),
+      coalesce_delimiter_(CONFIG_UPLINK_COALESCE_DELIMITER),
+      frame_parser_(PROTOCOL_MAX_PAYLOAD),
+      session_id_(0),
+      rx_expected_seq_(0),
+      rx_seq_gaps_(0),
+      compress_input_bytes_(0),
+      compress_output_bytes_(0),
+      compress_flushes_(0),
+      compress_cycles_(0),
+      compress_time_us_(0),
+      compress_max_us_(0),
+      tls_(nullptr),
+      tls_full_(0),
+      tls_resumed_(0),
+      tls_failed_(0),
+      tls_last_resumed_(false),
+      tls_last_ms_(0),
+      tls_full_ms_(0),
+      tls_resumed_ms_(0),
+      tls_full_compute_ms_(0),
+      tls_resumed_compute_ms_(0),
+      tls_full_bytes_(0),
+      tls_resumed_bytes_(0),
+      conn_enabled_(false),
+      wifi_started_(false),
+      wifi_retry_pending_(false),
+      fast_retry_(false),
+      conn_state_(static_cast<int32_t>(connection_state::idle)),
+      tcp_lost_tick_(0),
+      tcp_lost_(false),
+      conn_attempts_(0),
+      conn_failures_(0),
+      conn_reconnects_(0),
+      conn_last_reconnect_ms_(0),
+      conn_max_reconnect_ms_(0),
+      wifi_retries_(0),
+      conn_failovers_(0),
+      boot_cached_ap_(false),
+      boot_reused_lease_(false),
+      wifi_fallbacks_(0),
+      boot_assoc_us_(0),
+      boot_ip_us_(0),
+      boot_tcp_us_(0),
+      boot_first_byte_us_(0) {
     
     // 初始化NVS闪存（WiFi库需要）
     esp_err_t ret = nvs_flash_init();
@@ -62,6 +200,43 @@ network_module::network_module()
     // 创建FreeRTOS事件组
     s_wifi_event_group = xEventGroupCreate();
     
+#if PROTOCOL_FRAMING
+    // 帧协议的发送窗口，会话ID区分设备重启和重新连接
+    if (!frame_window_.init(PROTOCOL_WINDOW_FRAMES)) {
+        ESP_LOGE(TAG, "帧协议发送窗口创建失败");
+    }
+    session_id_ = esp_random();
+#endif
+    
+#if UPLINK_COMPRESS
+    if (!encoder_.init(UPLINK_COMPRESS_WINDOW_BITS)) {
+        ESP_LOGE(TAG, "上行压缩器创建失败");
+    }
+#endif
+    
+#if TLS_ENABLE
+    tls_ = new (std::nothrow) tls_client();
+    if (tls_ == nullptr || !tls_->init()) {
+        ESP_LOGE(TAG, "TLS客户端创建失败，无法连接服务器");
+    }
+#endif
+    
+    // 创建上行环形队列和TCP发送任务，UART接收不再被网络发送阻塞
+    if (!uplink_ring_.init(UPLINK_RING_SLOTS)) {
+        ESP_LOGE(TAG, "上行环形队列创建失败");
+    } else if (xTaskCreate(tcp_tx_task, "tcp_tx", TCP_TX_TASK_STACK_SIZE, this,
+                           TCP_TX_TASK_PRIORITY, &tx_task_handle_) != pdPASS) {
+        ESP_LOGE(TAG, "TCP发送任务创建失败");
+        tx_task_handle_ = nullptr;
+    }
+    
+    // 创建连接管理任务，WiFi和TCP断开后由它重连，不阻塞调用者
+    if (xTaskCreate(connection_task, "net_conn", CONN_TASK_STACK_SIZE, this,
+                    CONN_TASK_PRIORITY, &conn_task_handle_) != pdPASS) {
+        ESP_LOGE(TAG, "连接管理任务创建失败");
+        conn_task_handle_ = nullptr;
+    }
+    
     // 注册网络事件监听 - 使用特殊方法订阅，由于是单例，不应该被shared_ptr删除
     auto event_listener_ptr = std::shared_ptr<event_listener>(this, [](event_listener*){});
     event_bus::get_instance().subscribe(event_type::enter_deep_sleep, event_listener_ptr);
@@ -74,6 +249,9 @@ network_module::~network_module() {
     // 确保断开所有连接
     disconnect_tcp();
     disconnect_wifi();
+#if TLS_ENABLE
+    delete tls_;
+#endif
     
     // 删除事件组
     if (s_wifi_event_group) {
@@ -100,7 +278,7 @@ void network_module::wifi_event_handler(void* arg, esp_event_base_t event_base,
             esp_wifi_connect();
         } else if (event_id == WIFI_EVENT_STA_DISCONNECTED) {
             wifi_event_sta_disconnected_t* event = (wifi_event_sta_disconnected_t*) event_data;
-            ESP_LOGW(TAG, "WiFi连接断开，原因: %d，尝试重新连接...", event->reason);
+            ESP_LOGW(TAG, "WiFi连接断开，原因: %d", event->reason);
             
             // 打印断开原因
             switch (event->reason) {
@@ -138,18 +316,39 @@ void network_module::wifi_event_handler(void* arg, esp_event_base_t event_base,
                     ESP_LOGW(TAG, "WiFi断开原因: 其他(%d)", event->reason);
             }
             
+            // 按记录连接只用于唤醒后的第一次连接，之后的重连扫描全部信道（AP可能已更换）
+            if (net.wifi_pinned_) {
+                bool fast_failed = net.wifi_fast_pending_.exchange(false);
+                net.configure_sta(false);
+                if (fast_failed) {
+                    // 记录已失效，立即改为全信道扫描，不经过退避；connect_wifi()继续等待
+                    ESP_LOGW(TAG, "按记录的AP连接失败，改为全信道扫描");
+                    net.wifi_cache_.invalidate();
+                    net.wifi_fallbacks_.fetch_add(1, std::memory_order_relaxed);
+                    net.boot_cached_ap_ = false;
+                    net.boot_reused_lease_ = false;
+                    esp_wifi_connect();
+                    return;
+                }
+            }
+            
+            // 由连接管理任务按退避间隔重连，避免在事件处理中连续调用esp_wifi_connect()
             net.wifi_connected_ = false;
-            esp_wifi_connect();
+            net.wifi_retry_pending_ = true;
+            net.notify_connection_task();
             xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
             xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
             
             // 发布网络断开事件
             esp_framework::event_data disconnect_event(event_type::network_disconnected);
-            event_bus::get_instance().publish(disconnect_event);
+            event_bus::get_instance().post(disconnect_event);
         } else if (event_id == WIFI_EVENT_STA_CONNECTED) {
             wifi_event_sta_connected_t* event = (wifi_event_sta_connected_t*) event_data;
             ESP_LOGI(TAG, "WiFi已连接到AP SSID:%s, channel:%d", 
                      event->ssid, event->channel);
+            net.wifi_fast_pending_ = false;
+            mark_boot_time(net.boot_assoc_us_);
+            net.wifi_cache_.update_ap(event->bssid, event->channel, event->authmode);
         }
     } else if (event_base == IP_EVENT) {
         if (event_id == IP_EVENT_STA_GOT_IP) {
@@ -157,12 +356,26 @@ void network_module::wifi_event_handler(void* arg, esp_event_base_t event_base,
             ESP_LOGI(TAG, "获取IP地址: " IPSTR ", 网关: " IPSTR, 
                      IP2STR(&ip_event->ip_info.ip), 
                      IP2STR(&ip_event->ip_info.gw));
+            mark_boot_time(net.boot_ip_us_);
+            
+            // DHCP获得的地址保存下来，唤醒后直接使用
+            if (!net.static_ip_) {
+                esp_netif_dns_info_t dns = {};
+                esp_netif_get_dns_info(net.sta_netif_, ESP_NETIF_DNS_MAIN, &dns);
+                net.wifi_cache_.update_ip(ip_event->ip_info.ip.addr, ip_event->ip_info.netmask.addr,
+                                          ip_event->ip_info.gw.addr, dns.ip.u_addr.ip4.addr);
+            }
+            
             net.wifi_connected_ = true;
             xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
             
+            // 获取IP后立即重试TCP连接，不等待剩余的退避时间
+            net.fast_retry_ = true;
+            net.notify_connection_task();
+            
             // 发布网络连接事件
             esp_framework::event_data connect_event(event_type::network_connected);
-            event_bus::get_instance().publish(connect_event);
+            event_bus::get_instance().post(connect_event);
         } else if (event_id == IP_EVENT_STA_LOST_IP) {
             ESP_LOGW(TAG, "IP地址丢失");
         }
@@ -183,7 +396,7 @@ bool network_module::connect_wifi(const std::string& ssid, const std::string& pa
     
     // 初始化网络接口
     ESP_ERROR_CHECK(esp_netif_init());
-    esp_netif_create_default_wifi_sta();
+    sta_netif_ = esp_netif_create_default_wifi_sta();
     
     // 初始化WiFi子系统
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
@@ -193,15 +406,21 @@ bool network_module::connect_wifi(const std::string& ssid, const std::string& pa
     ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL));
     ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, NULL));
     
-    // 配置WiFi
-    wifi_config_t wifi_config = {};
-    strlcpy((char*)wifi_config.sta.ssid, ssid.c_str(), sizeof(wifi_config.sta.ssid));
-    strlcpy((char*)wifi_config.sta.password, password.c_str(), sizeof(wifi_config.sta.password));
-    
-    // 配置WiFi模式和启动
+    // 配置WiFi模式，有上次连接的记录时按记录连接
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    bool cached = wifi_cache_.load(ssid);
+    wifi_fast_pending_ = cached;
+    configure_sta(cached);
+    boot_cached_ap_ = cached;
+    boot_reused_lease_ = static_ip_.load();
+    if (cached) {
+        const wifi_cache_record& record = wifi_cache_.record();
+        ESP_LOGI(TAG, "按记录连接: BSSID %02x:%02x:%02x:%02x:%02x:%02x, 信道%u, %s",
+                 record.bssid[0], record.bssid[1], record.bssid[2], record.bssid[3], record.bssid[4],
+                 record.bssid[5], record.channel, static_ip_ ? "使用记录的地址" : "DHCP");
+    }
     
+    wifi_started_ = true;
     ESP_ERROR_CHECK(esp_wifi_start());
     
     // 等待连接或超时
@@ -224,8 +443,93 @@ bool network_module::connect_wifi(const std::string& ssid, const std::string& pa
     }
 }
 
+// 设置WiFi站点配置
+void network_module::configure_sta(bool use_cache) {
+    wifi_config_t wifi_config = {};
+    strlcpy((char*)wifi_config.sta.ssid, ssid_.c_str(), sizeof(wifi_config.sta.ssid));
+    strlcpy((char*)wifi_config.sta.password, password_.c_str(), sizeof(wifi_config.sta.password));
+    
+    const wifi_cache_record& record = wifi_cache_.record();
+    if (use_cache) {
+        // 只在记录的信道上寻找记录的BSSID，安全模式不低于上次
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, record.bssid, sizeof(wifi_config.sta.bssid));
+        wifi_config.sta.channel = record.channel;
+        wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+        wifi_config.sta.threshold.authmode = static_cast<wifi_auth_mode_t>(record.authmode);
+    } else {
+        wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+    }
+    // 轻度睡眠档位（WIFI_PS_MAX_MODEM）下每隔几个DTIM接收一次信标
+    wifi_config.sta.listen_interval = CONFIG_POWER_WIFI_LISTEN_INTERVAL;
+    esp_err_t err = esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "设置WiFi配置失败: %s", esp_err_to_name(err));
+    }
+    wifi_pinned_ = use_cache;
+    
+    int64_t remaining_s = 0;
+    bool use_lease = use_cache && wifi_cache_.lease_valid(&remaining_s);
+    if (use_lease && !static_ip_) {
+        esp_netif_dhcpc_stop(sta_netif_);
+        esp_netif_ip_info_t ip_info = {};
+        ip_info.ip.addr = record.ip;
+        ip_info.netmask.addr = record.netmask;
+        ip_info.gw.addr = record.gw;
+        esp_netif_set_ip_info(sta_netif_, &ip_info);
+        if (record.dns != 0) {
+            esp_netif_dns_info_t dns = {};
+            dns.ip.u_addr.ip4.addr = record.dns;
+            dns.ip.type = ESP_IPADDR_TYPE_V4;
+            esp_netif_set_dns_info(sta_netif_, ESP_NETIF_DNS_MAIN, &dns);
+        }
+        static_ip_expires_ = static_cast<int64_t>(time(nullptr)) + remaining_s;
+        static_ip_ = true;
+    } else if (!use_lease && static_ip_) {
+        esp_netif_dhcpc_start(sta_netif_);
+        static_ip_ = false;
+    }
+}
+
+// 记录的地址到期后启动DHCP续租，地址变化时TCP连接断开并按新地址重连
+TickType_t network_module::check_static_ip() {
+    if (!static_ip_) {
+        return portMAX_DELAY;
+    }
+    int64_t remaining = static_ip_expires_ - static_cast<int64_t>(time(nullptr));
+    if (remaining > 0) {
+        // 分段等待，避免换算为tick时溢出
+        return pdMS_TO_TICKS((remaining < 3600 ? remaining : 3600) * 1000);
+    }
+    ESP_LOGI(TAG, "记录的IP地址已到期，启动DHCP");
+    static_ip_ = false;
+    esp_netif_dhcpc_start(sta_netif_);
+    return portMAX_DELAY;
+}
+
+void network_module::mark_boot_time(std::atomic<int64_t>& slot) {
+    int64_t expected = 0;
+    slot.compare_exchange_strong(expected, esp_timer_get_time());
+}
+
+// 获取启动耗时
+boot_timing network_module::get_boot_timing() const {
+    boot_timing timing;
+    timing.cached_ap = boot_cached_ap_;
+    timing.reused_lease = boot_reused_lease_;
+    timing.fallbacks = wifi_fallbacks_.load(std::memory_order_relaxed);
+    timing.assoc_ms = static_cast<uint32_t>(boot_assoc_us_ / 1000);
+    timing.ip_ms = static_cast<uint32_t>(boot_ip_us_ / 1000);
+    timing.tcp_ms = static_cast<uint32_t>(boot_tcp_us_ / 1000);
+    timing.first_byte_ms = static_cast<uint32_t>(boot_first_byte_us_ / 1000);
+    return timing;
+}
+
 // 断开WiFi
 void network_module::disconnect_wifi() {
+    // 主动断开时不再自动重连
+    wifi_started_ = false;
+    
     if (!wifi_connected_) {
         return;
     }
@@ -249,12 +553,23 @@ void network_module::disconnect_wifi() {
 // TCP接收任务
 void network_module::tcp_receive_task(void* pvParameters) {
     network_module* net = static_cast<network_module*>(pvParameters);
-    int sock = net->sock_;
-    uint8_t* rx_buffer = new uint8_t[TCP_BUFFER_SIZE];
+    auto& pool = buffer_pool::get_instance();
     
     while (net->tcp_connected_) {
+        // 每次接收到新的缓冲池缓冲区，下游直接持有引用，不再复制
+        pool_buffer rx_buffer = pool.acquire(TCP_RX_BUFFER_SIZE);
+        if (!rx_buffer) {
+            ESP_LOGE(TAG, "内存不足，暂停TCP接收");
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+        
         // 接收数据
-        int len = recv(sock, rx_buffer, sizeof(rx_buffer) - 1, 0);
+#if TLS_ENABLE
+        int len = net->tls_->read(rx_buffer.data(), TCP_RX_BUFFER_SIZE);
+#else
+        int len = net->transport_->receive(rx_buffer.data(), TCP_RX_BUFFER_SIZE);
+#endif
         
         if (len < 0) {
             // 连接错误
@@ -268,31 +583,45 @@ void network_module::tcp_receive_task(void* pvParameters) {
             break;
         } else {
             // 收到数据
-            ESP_LOGI(TAG, "收到 %d 字节数据", len);
-            
+            ESP_LOGD(TAG, "收到 %d 字节数据", len);
+            rx_buffer.set_size(len);
             
-            // 发布数据接收事件
-            auto event_data_ptr = std::make_shared<uint8_t[]>(len);
-            if (event_data_ptr) {
-                memcpy(event_data_ptr.get(), rx_buffer, len);
-                esp_framework::event_data data_event(event_type::data_received, 
-                         event_data_type::binary, 
-                         event_data_ptr, 
-                         len);
-                event_bus::get_instance().publish(data_event);
-                // 使用shared_ptr自动管理内存，不需要手动释放
+#if PROTOCOL_FRAMING
+            // 下行数据为帧格式，确认帧在此处理，数据帧的负载交给回调
+            net->frame_parser_.feed(rx_buffer.data(), len,
+                                    [net](frame_parser::frame& frame) { net->handle_frame(frame); });
+#else
+            // 下行数据交给回调（UART发送队列）
+            if (net->data_callback_) {
+                net->data_callback_(rx_buffer);
             }
+            
+            // 以引用方式发布数据接收事件
+            esp_framework::event_data data_event(event_type::data_received, 
+                     event_data_type::binary, 
+                     std::move(rx_buffer));
+            event_bus::get_instance().post(data_event);
+#endif
         }
     }
     
-    delete[] rx_buffer;
-    // 任务完成
+    // 任务完成，通知连接管理任务重连
     net->task_handle_ = nullptr;
+    net->notify_connection_task();
     vTaskDelete(NULL);
 }
 
 // 连接TCP服务器
 bool network_module::connect_tcp(const std::string& host, uint16_t port) {
+    server_endpoint endpoint = {host, port};
+    transport_candidate candidate = {};
+    size_t winner;
+    return connect_candidates(&endpoint, &candidate, 1, winner);
+}
+
+// 向一组候选服务器竞速连接
+bool network_module::connect_candidates(const server_endpoint* endpoints, transport_candidate* candidates,
+                                        size_t count, size_t& winner) {
     if (tcp_connected_) {
         ESP_LOGW(TAG, "TCP已连接，请先断开");
         return true; // 已连接视为成功
@@ -303,79 +632,87 @@ bool network_module::connect_tcp(const std::string& host, uint16_t port) {
         return false;
     }
     
-    server_host_ = host;
-    server_port_ = port;
+    // 按set_transport()的选择切换传输，未连接时接收任务已退出，发送方不会使用旧的传输
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        transport_type type = static_cast<transport_type>(transport_request_.load());
+        transport_ = type == transport_type::udp ? static_cast<transport*>(&udp_transport_) : &tcp_transport_;
+    }
     
-    ESP_LOGI(TAG, "开始连接TCP服务器: %s:%d", host.c_str(), port);
+    // 缓存的地址有效时不等待DNS，过期的地址同样先使用，由后台重新解析；
+    // 解析失败的候选不参与竞速
+    dns_cache& dns = dns_cache::get_instance();
+    transport_candidate racing[tcp_transport::MAX_RACE_CANDIDATES];
+    size_t racing_index[tcp_transport::MAX_RACE_CANDIDATES];
+    dns_source sources[tcp_transport::MAX_RACE_CANDIDATES];
+    size_t racing_count = 0;
+    for (size_t i = 0; i < count && i < tcp_transport::MAX_RACE_CANDIDATES; i++) {
+        const server_endpoint& endpoint = endpoints[i];
+        candidates[i] = {0, endpoint.port, true};
+        int64_t resolve_start = esp_timer_get_time();
+        if (!dns.resolve(endpoint.host, candidates[i].addr, &sources[racing_count])) {
+            ESP_LOGE(TAG, "无法解析服务器地址: %s", endpoint.host.c_str());
+            continue;
+        }
+        
+        struct in_addr in;
+        in.s_addr = candidates[i].addr;
+        ESP_LOGI(TAG, "开始连接服务器(%s): %s:%d (%s, %s, 解析%lldms)", transport_->name(), endpoint.host.c_str(),
+                 endpoint.port, inet_ntoa(in), dns_source_name(sources[racing_count]),
+                 (long long)((esp_timer_get_time() - resolve_start) / 1000));
+        racing[racing_count] = candidates[i];
+        racing_index[racing_count++] = i;
+    }
     
-    // 创建套接字
-    sock_ = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
-    if (sock_ < 0) {
-        ESP_LOGE(TAG, "创建套接字失败: errno %d", errno);
+    size_t won = 0;
+    bool opened = racing_count > 0 &&
+                  transport_->open_race(racing, racing_count, ENDPOINT_RACE_STAGGER_MS, TCP_CONNECT_TIMEOUT_MS, won);
+    for (size_t i = 0; i < racing_count; i++) {
+        candidates[racing_index[i]].failed = racing[i].failed;
+        // 服务器可能已迁移到新地址，下次重连前在后台重新解析
+        if (racing[i].failed && sources[i] != dns_source::literal) {
+            dns.expire(endpoints[racing_index[i]].host);
+        }
+    }
+    if (!opened) {
         return false;
     }
+    winner = racing_index[won];
+    server_host_ = endpoints[winner].host;
+    server_port_ = endpoints[winner].port;
     
-    // 配置服务器地址
-    struct sockaddr_in dest_addr;
-    dest_addr.sin_addr.s_addr = inet_addr(host.c_str());
-    dest_addr.sin_family = AF_INET;
-    dest_addr.sin_port = htons(port);
-    
-    // 设置套接字为非阻塞模式
-    int flags = fcntl(sock_, F_GETFL, 0);
-    fcntl(sock_, F_SETFL, flags | O_NONBLOCK);
-    
-    // 设置超时时间
-    struct timeval tv;
-    tv.tv_sec = 60*10; //设置超时时间(s)
-    tv.tv_usec = 0;
-    setsockopt(sock_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-    
-    // 连接服务器
-    int err = connect(sock_, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
-    if (err != 0 && errno != EINPROGRESS) {
-        ESP_LOGE(TAG, "连接TCP服务器失败: errno %d", errno);
-        close(sock_);
-        sock_ = -1;
+#if TLS_ENABLE
+    if (!handshake_tls()) {
+        transport_->close();
+        candidates[winner].failed = true;
         return false;
     }
+#endif
     
-    // 如果连接正在进行中（非阻塞模式）
-    if (err != 0 && errno == EINPROGRESS) {
-        // 等待连接完成
-        fd_set write_fds;
-        FD_ZERO(&write_fds);
-        FD_SET(sock_, &write_fds);
-        
-        struct timeval timeout;
-        timeout.tv_sec = 5;  // 5秒超时
-        timeout.tv_usec = 0;
-        
-        int ret = select(sock_ + 1, NULL, &write_fds, NULL, &timeout);
-        if (ret <= 0) {
-            ESP_LOGE(TAG, "TCP连接超时或失败: %d", ret);
-            close(sock_);
-            sock_ = -1;
-            return false;
-        }
-        
-        // 检查连接是否成功
-        int error = 0;
-        socklen_t len = sizeof(error);
-        if (getsockopt(sock_, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error != 0) {
-            ESP_LOGE(TAG, "TCP连接建立失败: %d", error);
-            close(sock_);
-            sock_ = -1;
+#if PROTOCOL_FRAMING
+    // 标记为已连接前先重传，未确认的帧总是排在新数据之前。
+    // 重传的压缩帧与原来相同，服务器按会话保留解压窗口，压缩器不重置
+    frame_parser_.reset();
+    rx_expected_seq_ = 0;
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        if (!resume_frames()) {
+            transport_->close();
+            candidates[winner].failed = true;
             return false;
         }
     }
-    
-    // 恢复阻塞模式
-    flags = fcntl(sock_, F_GETFL, 0);
-    fcntl(sock_, F_SETFL, flags & ~O_NONBLOCK);
+#elif UPLINK_COMPRESS
+    // 不使用帧协议时服务器每个连接从空窗口开始解压
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        encoder_.reset();
+    }
+#endif
     
     tcp_connected_ = true;
-    ESP_LOGI(TAG, "成功连接到TCP服务器: %s:%d", host.c_str(), port);
+    mark_boot_time(boot_tcp_us_);
+    ESP_LOGI(TAG, "成功连接到服务器(%s): %s:%d", transport_->name(), server_host_.c_str(), server_port_);
     
     // 创建TCP接收任务
     if (task_handle_ == nullptr) {
@@ -391,54 +728,872 @@ bool network_module::connect_tcp(const std::string& host, uint16_t port) {
     return true;
 }
 
+#if TLS_ENABLE
+// TLS握手，服务器名默认为服务器地址，会话缓存按地址和端口区分
+bool network_module::handshake_tls() {
+    if (tls_ == nullptr) {
+        return false;
+    }
+    
+    const char* server_name = CONFIG_TLS_SERVER_NAME[0] != '\0' ? CONFIG_TLS_SERVER_NAME : server_host_.c_str();
+    std::string cache_key = server_host_ + ":" + std::to_string(server_port_);
+    tls_handshake_result result = {};
+    if (!tls_->handshake(transport_->fd(), server_name, cache_key.c_str(), CONFIG_TLS_HANDSHAKE_TIMEOUT_MS, result)) {
+        tls_failed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    
+    tls_last_resumed_.store(result.resumed, std::memory_order_relaxed);
+    tls_last_ms_.store(result.elapsed_ms, std::memory_order_relaxed);
+    if (result.resumed) {
+        tls_resumed_.fetch_add(1, std::memory_order_relaxed);
+        tls_resumed_ms_.fetch_add(result.elapsed_ms, std::memory_order_relaxed);
+        tls_resumed_compute_ms_.fetch_add(result.compute_ms, std::memory_order_relaxed);
+        tls_resumed_bytes_.fetch_add(result.bytes, std::memory_order_relaxed);
+    } else {
+        tls_full_.fetch_add(1, std::memory_order_relaxed);
+        tls_full_ms_.fetch_add(result.elapsed_ms, std::memory_order_relaxed);
+        tls_full_compute_ms_.fetch_add(result.compute_ms, std::memory_order_relaxed);
+        tls_full_bytes_.fetch_add(result.bytes, std::memory_order_relaxed);
+    }
+    return true;
+}
+#endif
+
 // 断开TCP连接
 void network_module::disconnect_tcp() {
-    if (!tcp_connected_) {
+    // 接收任务和其他任务可能同时断开，只处理一次
+    if (!tcp_connected_.exchange(false)) {
         return;
     }
     
-    // 设置状态为断开，使接收任务退出
-    tcp_connected_ = false;
-    
-    // 关闭socket
-    if (sock_ >= 0) {
-        close(sock_);
-        sock_ = -1;
-        ESP_LOGI(TAG, "TCP连接已关闭");
+    if (conn_enabled_ && !tcp_lost_.exchange(true)) {
+        tcp_lost_tick_ = xTaskGetTickCount();
     }
     
-    // 等待接收任务结束
-    if (task_handle_ != nullptr) {
-        vTaskDelay(pdMS_TO_TICKS(100)); // 给任务一些时间退出
+    // 唤醒阻塞在接收中的任务
+    transport_->shutdown();
+#if TLS_ENABLE
+    tls_->close();
+#endif
+    
+    // 等待接收任务结束后再关闭套接字，重连前不能有旧的接收任务；接收任务自身调用时无需等待。
+    // 接收任务可能阻塞在数据回调中（UART发送队列满时最多1秒），不设超时
+    if (xTaskGetCurrentTaskHandle() != task_handle_) {
+        while (task_handle_ != nullptr) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
     }
+    transport_->close();
+    ESP_LOGI(TAG, "%s连接已关闭", transport_->name());
     
-    // 确保回调不会被调用
-    data_callback_ = nullptr;
+    notify_connection_task();
 }
 
 // 发送数据
 bool network_module::send_data(const std::vector<uint8_t>& data) {
-    if (!tcp_connected_ || sock_ < 0) {
+    return send_bytes(data.data(), data.size());
+}
+
+bool network_module::send_data(const pool_buffer& buffer) {
+#if PROTOCOL_FRAMING
+    return send_frames(&buffer, 1);
+#else
+    return send_bytes(buffer.data(), buffer.size());
+#endif
+}
+
+bool network_module::send_bytes(const uint8_t* data, size_t size) {
+    struct iovec iov;
+    iov.iov_base = const_cast<uint8_t*>(data);
+    iov.iov_len = size;
+    return send_gather(&iov, 1);
+}
+
+#if UPLINK_COMPRESS
+// 数据段的读取位置，用于按字节数分组
+struct segment_cursor {
+    const struct iovec* segments;
+    size_t count;
+    size_t index;
+    size_t offset;
+};
+
+// 取出下一组不超过COMPRESS_MAX_INPUT字节的数据（长段会被拆开），返回段数，没有数据时返回0
+static size_t next_compress_group(segment_cursor& cursor, struct iovec* group, size_t& bytes) {
+    size_t n = 0;
+    bytes = 0;
+    while (cursor.index < cursor.count && n < COMPRESS_GROUP_SEGMENTS && bytes < COMPRESS_MAX_INPUT) {
+        const struct iovec& segment = cursor.segments[cursor.index];
+        size_t take = segment.iov_len - cursor.offset;
+        if (take > COMPRESS_MAX_INPUT - bytes) {
+            take = COMPRESS_MAX_INPUT - bytes;
+        }
+        if (take > 0) {
+            group[n].iov_base = static_cast<uint8_t*>(segment.iov_base) + cursor.offset;
+            group[n].iov_len = take;
+            n++;
+            bytes += take;
+        }
+        cursor.offset += take;
+        if (cursor.offset == segment.iov_len) {
+            cursor.index++;
+            cursor.offset = 0;
+        }
+    }
+    return n;
+}
+#endif
+
+// 聚合发送
+bool network_module::send_gather(const struct iovec* segments, size_t count) {
+    if (!tcp_connected_ || transport_->fd() < 0) {
         ESP_LOGE(TAG, "TCP未连接，无法发送数据");
         return false;
     }
     
-    ESP_LOGI(TAG, "发送 %zu 字节数据", data.size());
+#if PROTOCOL_FRAMING
+    // 帧负载需要保留到被确认，复制到一个缓冲池缓冲区中
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        total += segments[i].iov_len;
+    }
+    pool_buffer frame = buffer_pool::get_instance().acquire(total);
+    if (!frame) {
+        ESP_LOGE(TAG, "内存不足，无法发送%zu字节", total);
+        return false;
+    }
+    size_t offset = 0;
+    for (size_t i = 0; i < count; i++) {
+        memcpy(frame.data() + offset, segments[i].iov_base, segments[i].iov_len);
+        offset += segments[i].iov_len;
+    }
+    frame.set_size(total);
+    return send_frames(&frame, 1);
+#endif
+    
+    std::lock_guard<std::mutex> lock(send_mutex_);
     
-    int err = send(sock_, data.data(), data.size(), 0);
-    if (err < 0) {
-        ESP_LOGE(TAG, "发送数据失败: errno %d", errno);
+#if UPLINK_COMPRESS
+    segment_cursor cursor = {segments, count, 0, 0};
+    struct iovec group[COMPRESS_GROUP_SEGMENTS];
+    size_t bytes;
+    while (size_t n = next_compress_group(cursor, group, bytes)) {
+        pool_buffer out = compress_group(group, n, bytes);
+        if (!out) {
+            return false;
+        }
+        struct iovec iov;
+        iov.iov_base = out.data();
+        iov.iov_len = out.size();
+        if (!send_window(&iov, 1)) {
+            return false;
+        }
+    }
+    return true;
+#endif
+    
+    // 按窗口复制段描述，部分写入时只修改副本
+    struct iovec iov[NETWORK_SEND_GATHER_WINDOW];
+    for (size_t offset = 0; offset < count; offset += NETWORK_SEND_GATHER_WINDOW) {
+        size_t n = count - offset;
+        if (n > NETWORK_SEND_GATHER_WINDOW) {
+            n = NETWORK_SEND_GATHER_WINDOW;
+        }
+        memcpy(iov, segments + offset, n * sizeof(struct iovec));
+        if (!send_window(iov, n)) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+// 发送一个窗口内的所有段
+bool network_module::send_window(struct iovec* iov, size_t count) {
+#if TLS_ENABLE
+    // TLS写入所有段后才返回，部分写入在内部处理
+    bool ok = tls_->write(iov, count);
+#else
+    bool ok = transport_->send(iov, count);
+#endif
+    if (ok && boot_first_byte_us_ == 0) {
+        mark_boot_time(boot_first_byte_us_);
+        boot_timing timing = get_boot_timing();
+        ESP_LOGI(TAG, "启动到首次发送%lums(%s%s): 关联%lums, 获得IP %lums, 连接服务器%lums",
+                 (unsigned long)timing.first_byte_ms, timing.cached_ap ? "按记录连接AP" : "全信道扫描",
+                 timing.reused_lease ? ", 使用记录的地址" : ", DHCP",
+                 (unsigned long)timing.assoc_ms, (unsigned long)timing.ip_ms, (unsigned long)timing.tcp_ms);
+    }
+    return ok;
+}
+
+// 封装为帧发送
+bool network_module::send_frames(const pool_buffer* buffers, size_t count, size_t* accepted) {
+    size_t queued = 0;
+    if (accepted == nullptr) {
+        accepted = &queued;
+    }
+    *accepted = 0;
+    if (!tcp_connected_ || transport_->fd() < 0) {
+        ESP_LOGE(TAG, "TCP未连接，无法发送数据");
         return false;
     }
     
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    
+    // 每帧三段（帧头、负载、CRC），凑满一个窗口发送一次
+    struct iovec iov[NETWORK_SEND_GATHER_WINDOW];
+    size_t segments = 0;
+    TickType_t wait = pdMS_TO_TICKS(PROTOCOL_ACK_TIMEOUT_MS);
+#if UPLINK_COMPRESS
+    // 整批数据压缩后作为一帧（超过COMPRESS_MAX_INPUT时为几帧）发送，批次即刷新点
+    for (size_t base = 0; base < count; base += COMPRESS_GROUP_SEGMENTS) {
+        struct iovec input[COMPRESS_GROUP_SEGMENTS];
+        size_t n = count - base < COMPRESS_GROUP_SEGMENTS ? count - base : COMPRESS_GROUP_SEGMENTS;
+        for (size_t i = 0; i < n; i++) {
+            input[i].iov_base = buffers[base + i].data();
+            input[i].iov_len = buffers[base + i].size();
+        }
+        
+        segment_cursor cursor = {input, n, 0, 0};
+        struct iovec group[COMPRESS_GROUP_SEGMENTS];
+        size_t bytes;
+        while (size_t k = next_compress_group(cursor, group, bytes)) {
+            // 压缩会更新历史窗口，确认能加入发送窗口后才压缩，否则服务器无法解压之后的帧
+            if (!frame_window_.wait_space(wait)) {
+                ESP_LOGW(TAG, "%dms内未收到确认，断开TCP连接", PROTOCOL_ACK_TIMEOUT_MS);
+                disconnect_tcp();
+                return false;
+            }
+            pool_buffer frame = compress_group(group, k, bytes);
+            if (!frame || !queue_frame(frame, FRAME_CHANNEL_COMPRESSED, 0, iov, segments)) {
+                return false;
+            }
+            // 超过COMPRESS_MAX_INPUT被拆开的缓冲区全部进入窗口后才计入
+            *accepted = base + cursor.index;
+        }
+    }
+#else
+    for (size_t i = 0; i < count; i++) {
+        if (buffers[i].size() > 0 && !queue_frame(buffers[i], FRAME_CHANNEL_DATA, wait, iov, segments)) {
+            return false;
+        }
+        *accepted = i + 1;
+    }
+#endif
+    
+    return segments == 0 || send_window(iov, segments);
+}
+
+bool network_module::queue_frame(const pool_buffer& payload, uint32_t channel, TickType_t wait,
+                                 struct iovec* iov, size_t& segments) {
+    if (segments + frame_window::SEGMENTS_PER_FRAME > NETWORK_SEND_GATHER_WINDOW) {
+        if (!send_window(iov, segments)) {
+            return false;
+        }
+        segments = 0;
+    }
+    
+    // 窗口满且长时间收不到确认时认为连接已失效，重连后重传
+    if (!frame_window_.push(payload, channel, wait, iov + segments)) {
+        ESP_LOGW(TAG, "%dms内未收到确认，断开TCP连接", PROTOCOL_ACK_TIMEOUT_MS);
+        disconnect_tcp();
+        return false;
+    }
+    segments += frame_window::SEGMENTS_PER_FRAME;
+    return true;
+}
+
+// 压缩一组数据段
+pool_buffer network_module::compress_group(const struct iovec* group, size_t count, size_t bytes) {
+    pool_buffer out = buffer_pool::get_instance().acquire(lz_encoder::max_compressed_size(bytes));
+    if (!out) {
+        ESP_LOGE(TAG, "内存不足，无法压缩%zu字节", bytes);
+        return out;
+    }
+    
+    int64_t start_us = esp_timer_get_time();
+    esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+    size_t size = encoder_.compress(group, count, out.data());
+    uint32_t cycles = esp_cpu_get_cycle_count() - start;
+    uint32_t elapsed_us = static_cast<uint32_t>(esp_timer_get_time() - start_us);
+    out.set_size(size);
+    
+    compress_input_bytes_.fetch_add(static_cast<uint32_t>(bytes), std::memory_order_relaxed);
+    compress_output_bytes_.fetch_add(static_cast<uint32_t>(size), std::memory_order_relaxed);
+    compress_flushes_.fetch_add(1, std::memory_order_relaxed);
+    compress_cycles_.fetch_add(cycles, std::memory_order_relaxed);
+    compress_time_us_.fetch_add(elapsed_us, std::memory_order_relaxed);
+    if (elapsed_us > compress_max_us_.load(std::memory_order_relaxed)) {
+        compress_max_us_.store(elapsed_us, std::memory_order_relaxed);
+    }
+    
+    // 压缩结果通常远小于输入，换到较小的缓冲块，帧协议窗口中的帧要保存到被确认
+    pool_buffer exact = buffer_pool::get_instance().acquire(size);
+    if (exact && exact.capacity() < out.capacity()) {
+        memcpy(exact.data(), out.data(), size);
+        exact.set_size(size);
+        return exact;
+    }
+    return out;
+}
+
+// 发送hello帧并重传未确认的帧
+bool network_module::resume_frames() {
+    uint8_t hello[FRAME_MAX_HEADER_SIZE + sizeof(session_id_) + FRAME_CRC_SIZE];
+    uint8_t session[sizeof(session_id_)] = {
+        static_cast<uint8_t>(session_id_), static_cast<uint8_t>(session_id_ >> 8),
+        static_cast<uint8_t>(session_id_ >> 16), static_cast<uint8_t>(session_id_ >> 24)
+    };
+    size_t size = frame_encode_header(frame_type::hello, FRAME_CHANNEL_DATA, frame_window_.oldest_seq(),
+                                      sizeof(session), hello);
+    uint32_t crc = frame_crc(hello, size, session, sizeof(session));
+    memcpy(hello + size, session, sizeof(session));
+    size += sizeof(session);
+    for (size_t i = 0; i < FRAME_CRC_SIZE; i++) {
+        hello[size++] = static_cast<uint8_t>(crc >> (8 * i));
+    }
+    
+    struct iovec iov[NETWORK_SEND_GATHER_WINDOW];
+    iov[0].iov_base = hello;
+    iov[0].iov_len = size;
+    if (!send_window(iov, 1)) {
+        return false;
+    }
+    
+    // 接收任务尚未启动，窗口在重传期间不会变化
+    const size_t frames_per_call = NETWORK_SEND_GATHER_WINDOW / frame_window::SEGMENTS_PER_FRAME;
+    size_t index = 0;
+    while (size_t frames = frame_window_.collect(index, iov, frames_per_call)) {
+        if (!send_window(iov, frames * frame_window::SEGMENTS_PER_FRAME)) {
+            return false;
+        }
+        index += frames;
+    }
+    if (index > 0) {
+        frame_window_.add_retransmitted(static_cast<uint32_t>(index));
+        ESP_LOGI(TAG, "重传%zu个未确认的帧", index);
+    }
     return true;
 }
 
+// 处理下行帧
+void network_module::handle_frame(frame_parser::frame& frame) {
+    switch (frame.type) {
+        case frame_type::ack:
+            frame_window_.on_ack(frame.seq);
+            break;
+            
+        case frame_type::data:
+            // 下行不重传，只统计帧号不连续的次数
+            if (rx_expected_seq_ != 0 && frame.seq != rx_expected_seq_) {
+                rx_seq_gaps_.fetch_add(1, std::memory_order_relaxed);
+                ESP_LOGW(TAG, "下行帧号不连续: 期望%lu, 收到%lu",
+                         (unsigned long)rx_expected_seq_, (unsigned long)frame.seq);
+            }
+            rx_expected_seq_ = frame.seq + 1;
+            
+            if (data_callback_) {
+                data_callback_(frame.payload);
+            }
+            {
+                esp_framework::event_data data_event(event_type::data_received,
+                         event_data_type::binary,
+                         std::move(frame.payload));
+                event_bus::get_instance().post(data_event);
+            }
+            break;
+            
+        default:
+            break;
+    }
+}
+
+// 放入上行环形队列
+bool network_module::enqueue_uplink(const pool_buffer& buffer) {
+    size_t size = buffer.size();
+    if (size == 0) {
+        return true;
+    }
+    
+    if (tx_task_handle_ == nullptr) {
+        uplink_dropped_bytes_.fetch_add(size, std::memory_order_relaxed);
+        return false;
+    }
+    
+    // 按字节数和槽位数双重限制
+    uint32_t queued = uplink_queued_bytes_.load(std::memory_order_relaxed);
+    if (queued + size > UPLINK_RING_SIZE) {
+        uplink_dropped_bytes_.fetch_add(size, std::memory_order_relaxed);
+        ESP_LOGW(TAG, "上行队列已满(%lu字节)，丢弃 %zu 字节", (unsigned long)queued, size);
+        return false;
+    }
+    
+    // 队列持有一个引用，由发送任务在发送完成后释放
+    pool_buffer ref(buffer);
+    buffer_block* block = ref.detach();
+    if (!uplink_ring_.push(block)) {
+        pool_buffer::adopt(block).reset();
+        uplink_dropped_bytes_.fetch_add(size, std::memory_order_relaxed);
+        ESP_LOGW(TAG, "上行队列槽位已满，丢弃 %zu 字节", size);
+        return false;
+    }
+    
+    queued = uplink_queued_bytes_.fetch_add(size) + size;
+    if (queued > uplink_peak_bytes_.load(std::memory_order_relaxed)) {
+        uplink_peak_bytes_.store(queued, std::memory_order_relaxed);
+    }
+    xTaskNotifyGive(tx_task_handle_);
+    
+    // 越过高水位线时通知系统施加流量控制
+    if (queued >= UPLINK_HIGH_WATERMARK && !uplink_above_high_.exchange(true)) {
+        ESP_LOGW(TAG, "上行队列越过高水位线: %lu字节", (unsigned long)queued);
+        event_bus::get_instance().post(
+            event_data::from_integer(event_type::uplink_high_watermark, static_cast<int32_t>(queued)));
+    }
+    
+    return true;
+}
+
+// TCP发送任务
+void network_module::tcp_tx_task(void* pvParameters) {
+    network_module* net = static_cast<network_module*>(pvParameters);
+    pool_buffer batch[UPLINK_COALESCE_MAX_SEGMENTS];
+    size_t count = 0;
+    uint32_t bytes = 0;
+    TickType_t batch_start = 0;
+    buffer_block* block = nullptr;
+    
+    ESP_LOGI(TAG, "TCP发送任务已启动");
+    
+    while (1) {
+        uint32_t max_bytes = net->coalesce_max_bytes_.load(std::memory_order_relaxed);
+        TickType_t latency = pdMS_TO_TICKS(net->coalesce_latency_ms_.load(std::memory_order_relaxed));
+        int32_t delimiter = net->coalesce_delimiter_.load(std::memory_order_relaxed);
+        
+        // 没有未发送的批次时一直阻塞到有数据入队，否则最多等待到批次超时
+        TickType_t wait = portMAX_DELAY;
+        if (count > 0) {
+            TickType_t elapsed = xTaskGetTickCount() - batch_start;
+            wait = elapsed < latency ? latency - elapsed : 0;
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+        
+        while (net->uplink_ring_.pop(block)) {
+            pool_buffer& buffer = batch[count++];
+            buffer = pool_buffer::adopt(block);
+            bytes += static_cast<uint32_t>(buffer.size());
+            if (count == 1) {
+                batch_start = xTaskGetTickCount();
+            }
+            
+            // 满足任一条件立即发送整批数据
+            if (bytes >= max_bytes || count == UPLINK_COALESCE_MAX_SEGMENTS) {
+                net->uplink_flush_size_.fetch_add(1, std::memory_order_relaxed);
+            } else if (delimiter >= 0 && memchr(buffer.data(), delimiter, buffer.size()) != nullptr) {
+                net->uplink_flush_delim_.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                continue;
+            }
+            net->flush_uplink(batch, count, bytes);
+            count = 0;
+            bytes = 0;
+        }
+        
+        if (count > 0 && xTaskGetTickCount() - batch_start >= latency) {
+            net->uplink_flush_timeout_.fetch_add(1, std::memory_order_relaxed);
+            net->flush_uplink(batch, count, bytes);
+            count = 0;
+            bytes = 0;
+        }
+    }
+}
+
+// 发送一批上行数据
+void network_module::flush_uplink(pool_buffer* batch, size_t count, uint32_t bytes) {
+    bool sent = false;
+    size_t done = 0;    // 已发送或已进入帧协议发送窗口的缓冲区数
+#if PROTOCOL_FRAMING
+    if (tcp_connected_) {
+        sent = send_frames(batch, count, &done);
+        uplink_send_calls_.fetch_add(1, std::memory_order_relaxed);
+    }
+#else
+    if (tcp_connected_) {
+        struct iovec iov[UPLINK_COALESCE_MAX_SEGMENTS];
+        for (size_t i = 0; i < count; i++) {
+            iov[i].iov_base = batch[i].data();
+            iov[i].iov_len = batch[i].size();
+        }
+        
+        sent = send_gather(iov, count);
+        uplink_send_calls_.fetch_add(1, std::memory_order_relaxed);
+    }
+#endif
+    
+    if (sent) {
+        uplink_sent_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    } else {
+        requeue_unsent(batch + done, count - done);
+    }
+    uplink_chunks_.fetch_add(count, std::memory_order_relaxed);
+    
+    // 归还缓冲块
+    for (size_t i = 0; i < count; i++) {
+        batch[i].reset();
+    }
+    
+    uint32_t queued = uplink_queued_bytes_.fetch_sub(bytes) - bytes;
+    
+    // 回落到低水位线时解除流量控制
+    if (queued <= UPLINK_LOW_WATERMARK && uplink_above_high_.exchange(false)) {
+        ESP_LOGI(TAG, "上行队列回落到低水位线: %lu字节", (unsigned long)queued);
+        event_bus::get_instance().post(
+            event_data::from_integer(event_type::uplink_low_watermark, static_cast<int32_t>(queued)));
+    }
+}
+
+// 未发送的数据按原顺序交还存储转发缓存，重新连接（或切换服务器）后重放
+void network_module::requeue_unsent(const pool_buffer* buffers, size_t count) {
+    uint32_t requeued = 0;
+    uint32_t unsent = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t size = static_cast<uint32_t>(buffers[i].size());
+        if (unsent_callback_ && unsent_callback_(buffers[i])) {
+            requeued += size;
+        } else {
+            unsent += size;
+        }
+    }
+    uplink_requeued_bytes_.fetch_add(requeued, std::memory_order_relaxed);
+    uplink_unsent_bytes_.fetch_add(unsent, std::memory_order_relaxed);
+    ESP_LOGD(TAG, "TCP未连接或发送失败，交还缓存 %lu 字节，丢弃 %lu 字节",
+             (unsigned long)requeued, (unsigned long)unsent);
+}
+
+// 设置上行合并发送配置
+void network_module::set_coalesce_config(const uplink_coalesce_config& config) {
+    coalesce_max_bytes_.store(config.max_bytes, std::memory_order_relaxed);
+    coalesce_latency_ms_.store(config.max_latency_ms, std::memory_order_relaxed);
+    coalesce_delimiter_.store(config.delimiter < 0 ? -1 : (config.delimiter & 0xFF), std::memory_order_relaxed);
+    ESP_LOGI(TAG, "上行合并发送: 阈值%lu字节, 最大延迟%lums, 分隔符%ld",
+             (unsigned long)config.max_bytes, (unsigned long)config.max_latency_ms, (long)config.delimiter);
+    
+    // 唤醒发送任务按新配置处理未发送的批次
+    if (tx_task_handle_ != nullptr) {
+        xTaskNotifyGive(tx_task_handle_);
+    }
+}
+
+// 获取上行合并发送配置
+uplink_coalesce_config network_module::get_coalesce_config() const {
+    uplink_coalesce_config config;
+    config.max_bytes = coalesce_max_bytes_.load(std::memory_order_relaxed);
+    config.max_latency_ms = coalesce_latency_ms_.load(std::memory_order_relaxed);
+    config.delimiter = coalesce_delimiter_.load(std::memory_order_relaxed);
+    return config;
+}
+
+// 获取上行链路统计
+uplink_stats network_module::get_uplink_stats() const {
+    uplink_stats stats;
+    stats.queued_bytes = uplink_queued_bytes_.load(std::memory_order_relaxed);
+    stats.peak_queued_bytes = uplink_peak_bytes_.load(std::memory_order_relaxed);
+    stats.sent_bytes = uplink_sent_bytes_.load(std::memory_order_relaxed);
+    stats.dropped_bytes = uplink_dropped_bytes_.load(std::memory_order_relaxed);
+    stats.unsent_bytes = uplink_unsent_bytes_.load(std::memory_order_relaxed);
+    stats.requeued_bytes = uplink_requeued_bytes_.load(std::memory_order_relaxed);
+    stats.chunks = uplink_chunks_.load(std::memory_order_relaxed);
+    stats.send_calls = uplink_send_calls_.load(std::memory_order_relaxed);
+    stats.flush_by_size = uplink_flush_size_.load(std::memory_order_relaxed);
+    stats.flush_by_timeout = uplink_flush_timeout_.load(std::memory_order_relaxed);
+    stats.flush_by_delimiter = uplink_flush_delim_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// 启动TCP连接管理
+void network_module::start_connection(const std::string& host, uint16_t port) {
+    std::vector<server_endpoint> endpoints;
+    endpoints.push_back({host, port});
+    start_connection(endpoints);
+}
+
+void network_module::start_connection(const std::vector<server_endpoint>& endpoints) {
+    if (conn_task_handle_ == nullptr) {
+        ESP_LOGE(TAG, "连接管理任务未创建，无法启动连接管理");
+        return;
+    }
+    if (endpoints.empty()) {
+        ESP_LOGE(TAG, "没有配置服务器");
+        return;
+    }
+    
+    endpoints_.set(endpoints);
+    conn_enabled_ = true;
+    for (const auto& endpoint : endpoints) {
+        ESP_LOGI(TAG, "启动TCP连接管理: %s:%d", endpoint.host.c_str(), endpoint.port);
+    }
+    notify_connection_task();
+}
+
+// 停止TCP连接管理
+void network_module::stop_connection() {
+    if (!conn_enabled_.exchange(false)) {
+        return;
+    }
+    
+    ESP_LOGI(TAG, "停止TCP连接管理");
+    tcp_lost_ = false;
+    disconnect_tcp();
+    notify_connection_task();
+}
+
+// 唤醒连接管理任务
+void network_module::notify_connection_task() {
+    if (conn_task_handle_ != nullptr) {
+        xTaskNotifyGive(conn_task_handle_);
+    }
+}
+
+// 更新连接状态，状态变化时发布事件
+void network_module::set_connection_state(connection_state state) {
+    int32_t value = static_cast<int32_t>(state);
+    if (conn_state_.exchange(value) != value) {
+        event_bus::get_instance().post(
+            event_data::from_integer(event_type::tcp_state_changed, value));
+    }
+}
+
+// 指数退避时间，随机抖动范围为[delay/2, delay]，避免多台设备同时重连
+TickType_t network_module::backoff_delay(uint32_t attempt) {
+    uint32_t delay_ms = TCP_RECONNECT_MIN_MS;
+    while (attempt-- > 0 && delay_ms < TCP_RECONNECT_MAX_MS) {
+        delay_ms *= 2;
+    }
+    if (delay_ms > TCP_RECONNECT_MAX_MS) {
+        delay_ms = TCP_RECONNECT_MAX_MS;
+    }
+    delay_ms = delay_ms / 2 + esp_random() % (delay_ms / 2 + 1);
+    return pdMS_TO_TICKS(delay_ms);
+}
+
+// 连接管理任务
+void network_module::connection_task(void* pvParameters) {
+    network_module* net = static_cast<network_module*>(pvParameters);
+    uint32_t tcp_attempt = 0;   // 连续失败次数，决定退避时间
+    uint32_t wifi_attempt = 0;
+    
+    while (1) {
+        if (!net->wifi_connected_) {
+            // WiFi断开时TCP连接已不可用
+            net->disconnect_tcp();
+            if (!net->wifi_started_) {
+                net->set_connection_state(net->conn_enabled_ ? connection_state::waiting_wifi
+                                                            : connection_state::idle);
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                continue;
+            }
+            net->set_connection_state(connection_state::waiting_wifi);
+            
+            if (net->wifi_retry_pending_) {
+                // 等待退避时间，期间重新获取到IP则不再重连
+                TickType_t delay = backoff_delay(wifi_attempt++);
+                ESP_LOGI(TAG, "%lums后重连WiFi", (unsigned long)(delay * portTICK_PERIOD_MS));
+                TickType_t start = xTaskGetTickCount();
+                while (!net->wifi_connected_ && net->wifi_started_ && xTaskGetTickCount() - start < delay) {
+                    ulTaskNotifyTake(pdTRUE, delay - (xTaskGetTickCount() - start));
+                }
+                if (!net->wifi_connected_ && net->wifi_started_) {
+                    net->wifi_retry_pending_ = false;
+                    net->wifi_retries_.fetch_add(1, std::memory_order_relaxed);
+                    esp_wifi_connect();
+                }
+                continue;
+            }
+            
+            // 等待获取IP或再次断开
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        wifi_attempt = 0;
+        
+        if (!net->conn_enabled_) {
+            net->disconnect_tcp();
+            net->set_connection_state(connection_state::idle);
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        
+        if (net->tcp_connected_) {
+            // 已连接，等待断开通知；使用记录的地址时到期后启动DHCP
+            net->set_connection_state(connection_state::connected);
+            ulTaskNotifyTake(pdTRUE, net->check_static_ip());
+            continue;
+        }
+        
+        if (net->fast_retry_.exchange(false)) {
+            tcp_attempt = 0;
+        }
+        
+        net->set_connection_state(connection_state::connecting);
+        net->conn_attempts_.fetch_add(1, std::memory_order_relaxed);
+        
+        // 上次成功的服务器和健康分最高的另一个服务器竞速
+        size_t indexes[ENDPOINT_RACE_COUNT];
+        server_endpoint endpoints[ENDPOINT_RACE_COUNT];
+        transport_candidate candidates[ENDPOINT_RACE_COUNT] = {};
+        size_t count = net->endpoints_.candidates(indexes, ENDPOINT_RACE_COUNT);
+        for (size_t i = 0; i < count; i++) {
+            endpoints[i] = net->endpoints_.get(indexes[i]);
+        }
+        size_t winner = ENDPOINT_RACE_COUNT;
+        // 连接和握手期间保持系统活跃
+        wake_locks::get_instance().acquire("network");
+        bool connected = net->connect_candidates(endpoints, candidates, count, winner);
+        wake_locks::get_instance().release("network");
+        bool switched = false;
+        for (size_t i = 0; i < count; i++) {
+            switched |= net->endpoints_.report(indexes[i], candidates[i].failed, connected && i == winner);
+        }
+        if (connected) {
+            // 只在连接成功时写NVS，长时间断网期间的反复失败不写闪存
+            net->endpoints_.save();
+            if (switched) {
+                net->conn_failovers_.fetch_add(1, std::memory_order_relaxed);
+            }
+            tcp_attempt = 0;
+            if (net->tcp_lost_.exchange(false)) {
+                uint32_t elapsed = (xTaskGetTickCount() - net->tcp_lost_tick_) * portTICK_PERIOD_MS;
+                net->conn_last_reconnect_ms_.store(elapsed, std::memory_order_relaxed);
+                if (elapsed > net->conn_max_reconnect_ms_.load(std::memory_order_relaxed)) {
+                    net->conn_max_reconnect_ms_.store(elapsed, std::memory_order_relaxed);
+                }
+                net->conn_reconnects_.fetch_add(1, std::memory_order_relaxed);
+                ESP_LOGI(TAG, "TCP重新连接成功，断开时长%lums", (unsigned long)elapsed);
+            }
+            net->set_connection_state(connection_state::connected);
+            continue;
+        }
+        
+        // 连接失败，退避后重试；期间获取IP或被停止时提前结束等待
+        net->conn_failures_.fetch_add(1, std::memory_order_relaxed);
+        TickType_t delay = backoff_delay(tcp_attempt++);
+        if (tcp_attempt == 1) {
+            ESP_LOGW(TAG, "TCP连接失败，%lums后重试", (unsigned long)(delay * portTICK_PERIOD_MS));
+        } else {
+            ESP_LOGD(TAG, "TCP连接失败，%lums后重试", (unsigned long)(delay * portTICK_PERIOD_MS));
+        }
+        net->set_connection_state(connection_state::backoff);
+        TickType_t start = xTaskGetTickCount();
+        while (net->conn_enabled_ && net->wifi_connected_ && !net->fast_retry_ &&
+               xTaskGetTickCount() - start < delay) {
+            ulTaskNotifyTake(pdTRUE, delay - (xTaskGetTickCount() - start));
+        }
+    }
+}
+
+// 获取TCP连接管理统计
+connection_stats network_module::get_connection_stats() const {
+    connection_stats stats;
+    stats.state = static_cast<connection_state>(conn_state_.load(std::memory_order_relaxed));
+    stats.attempts = conn_attempts_.load(std::memory_order_relaxed);
+    stats.failures = conn_failures_.load(std::memory_order_relaxed);
+    stats.reconnects = conn_reconnects_.load(std::memory_order_relaxed);
+    stats.last_reconnect_ms = conn_last_reconnect_ms_.load(std::memory_order_relaxed);
+    stats.max_reconnect_ms = conn_max_reconnect_ms_.load(std::memory_order_relaxed);
+    stats.wifi_retries = wifi_retries_.load(std::memory_order_relaxed);
+    stats.failovers = conn_failovers_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// 获取每个服务器的健康统计
+std::vector<endpoint_stats> network_module::get_endpoint_stats() const {
+    return endpoints_.get_stats();
+}
+
+// 获取帧协议统计
+frame_protocol_stats network_module::get_protocol_stats() const {
+    frame_protocol_stats stats = {};
+#if PROTOCOL_FRAMING
+    stats = frame_window_.get_stats();
+    stats.rx_frames = frame_parser_.frames();
+    stats.rx_crc_errors = frame_parser_.crc_errors();
+    stats.rx_sync_errors = frame_parser_.sync_errors();
+    stats.rx_seq_gaps = rx_seq_gaps_.load(std::memory_order_relaxed);
+#endif
+    return stats;
+}
+
+// 获取上行压缩统计
+compress_stats network_module::get_compress_stats() const {
+    compress_stats stats = {};
+    stats.input_bytes = compress_input_bytes_.load(std::memory_order_relaxed);
+    stats.output_bytes = compress_output_bytes_.load(std::memory_order_relaxed);
+    stats.flushes = compress_flushes_.load(std::memory_order_relaxed);
+    stats.cycles = compress_cycles_.load(std::memory_order_relaxed);
+    stats.avg_time_us = stats.flushes > 0 ? compress_time_us_.load(std::memory_order_relaxed) / stats.flushes : 0;
+    stats.max_time_us = compress_max_us_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// 获取TLS握手统计
+tls_stats network_module::get_tls_stats() const {
+    tls_stats stats = {};
+    stats.full_handshakes = tls_full_.load(std::memory_order_relaxed);
+    stats.resumed_handshakes = tls_resumed_.load(std::memory_order_relaxed);
+    stats.failed_handshakes = tls_failed_.load(std::memory_order_relaxed);
+    stats.last_resumed = tls_last_resumed_.load(std::memory_order_relaxed);
+    stats.last_handshake_ms = tls_last_ms_.load(std::memory_order_relaxed);
+    if (stats.full_handshakes > 0) {
+        stats.avg_full_ms = tls_full_ms_.load(std::memory_order_relaxed) / stats.full_handshakes;
+        stats.avg_full_compute_ms = tls_full_compute_ms_.load(std::memory_order_relaxed) / stats.full_handshakes;
+        stats.avg_full_bytes = tls_full_bytes_.load(std::memory_order_relaxed) / stats.full_handshakes;
+    }
+    if (stats.resumed_handshakes > 0) {
+        stats.avg_resumed_ms = tls_resumed_ms_.load(std::memory_order_relaxed) / stats.resumed_handshakes;
+        stats.avg_resumed_compute_ms = tls_resumed_compute_ms_.load(std::memory_order_relaxed) / stats.resumed_handshakes;
+        stats.avg_resumed_bytes = tls_resumed_bytes_.load(std::memory_order_relaxed) / stats.resumed_handshakes;
+    }
+    return stats;
+}
+
+// 选择传输方式
+bool network_module::set_transport(transport_type type) {
+#if !UDP_TRANSPORT_SUPPORTED
+    if (type == transport_type::udp) {
+        ESP_LOGE(TAG, "UDP不能与帧协议、上行压缩或TLS同时使用");
+        return false;
+    }
+#endif
+    
+    transport_request_.store(static_cast<int32_t>(type));
+    if (tcp_connected_ && transport_->type() != type) {
+        ESP_LOGI(TAG, "切换传输方式，重新连接");
+        disconnect_tcp();
+    }
+    return true;
+}
+
+transport_type network_module::get_transport() const {
+    return static_cast<transport_type>(transport_request_.load());
+}
+
+// 获取UDP传输统计
+udp_transport_stats network_module::get_udp_stats() const {
+    return udp_transport_.get_stats();
+}
+
 // 设置数据接收回调
-void network_module::set_data_callback(std::function<void(const std::vector<uint8_t>&)> callback) {
+void network_module::set_data_callback(std::function<void(const pool_buffer&)> callback) {
     data_callback_ = callback;
 }
 
+// 设置未发送上行数据回调
+void network_module::set_unsent_callback(std::function<bool(const pool_buffer&)> callback) {
+    unsent_callback_ = callback;
+}
+
 // 检查是否连接到WiFi
 bool network_module::is_wifi_connected() const {
     return wifi_connected_;
@@ -449,17 +1604,13 @@ bool network_module::is_tcp_connected() const {
     return tcp_connected_;
 }
 
-// 处理事件循环
-void network_module::loop() {
-    // 目前不需要特殊处理，只需定期调用以响应事件
-}
-
 // 事件处理
 void network_module::on_event(const event_data& event) {
     switch (event.type) {
         case event_type::enter_deep_sleep:
             // 进入深度睡眠前，断开所有连接
             ESP_LOGI(TAG, "准备进入深度睡眠，断开所有网络连接");
+            stop_connection();
             disconnect_tcp();
             disconnect_wifi();
             break;
@@ -0,0 +1,234 @@
+#include "tcp_transport.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+
+static const char* TAG = "Transport";
+
+namespace esp_framework {
+
+tcp_transport::tcp_transport() : sock_(-1) {
+}
+
+tcp_transport::~tcp_transport() {
+    close();
+}
+
+bool tcp_transport::open(uint32_t addr, uint16_t port, uint32_t timeout_ms) {
+    transport_candidate candidate = {addr, port, false};
+    size_t winner;
+    return open_race(&candidate, 1, 0, timeout_ms, winner);
+}
+
+int tcp_transport::start_connect(const transport_candidate& candidate) {
+    // 创建套接字
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "创建套接字失败: errno %d", errno);
+        return -1;
+    }
+    
+    // 配置服务器地址
+    struct sockaddr_in dest_addr;
+    dest_addr.sin_addr.s_addr = candidate.addr;
+    dest_addr.sin_family = AF_INET;
+    dest_addr.sin_port = htons(candidate.port);
+    
+    // 设置套接字为非阻塞模式
+    int flags = fcntl(sock, F_GETFL, 0);
+    fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+    
+    // 连接服务器，非阻塞模式下通常返回EINPROGRESS，由select()等待完成
+    int err = connect(sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
+    if (err != 0 && errno != EINPROGRESS) {
+        ESP_LOGE(TAG, "连接TCP服务器失败: errno %d", errno);
+        ::close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+bool tcp_transport::open_race(transport_candidate* candidates, size_t count, uint32_t stagger_ms,
+                              uint32_t timeout_ms, size_t& winner) {
+    if (count > MAX_RACE_CANDIDATES) {
+        count = MAX_RACE_CANDIDATES;
+    }
+    int socks[MAX_RACE_CANDIDATES];
+    for (size_t i = 0; i < count; i++) {
+        socks[i] = -1;
+        candidates[i].failed = false;
+    }
+    
+    int64_t start = esp_timer_get_time();
+    int64_t deadline = start + static_cast<int64_t>(timeout_ms) * 1000;
+    size_t started = 0;
+    int found = -1;
+    
+    while (found < 0) {
+        int64_t now = esp_timer_get_time();
+        
+        // 到了错开时间，或已发起的候选全部失败时，发起下一个候选
+        size_t pending = 0;
+        for (size_t i = 0; i < started; i++) {
+            pending += socks[i] >= 0 ? 1 : 0;
+        }
+        while (started < count &&
+               (pending == 0 || now >= start + static_cast<int64_t>(started) * stagger_ms * 1000)) {
+            socks[started] = start_connect(candidates[started]);
+            if (socks[started] < 0) {
+                candidates[started].failed = true;
+            } else {
+                pending++;
+            }
+            started++;
+        }
+        if (pending == 0 || now >= deadline) {
+            if (pending > 0) {
+                ESP_LOGE(TAG, "TCP连接超时");
+            }
+            break;
+        }
+        
+        // 等待连接完成，最多等到下一个候选的发起时间
+        int64_t wake = deadline;
+        if (started < count) {
+            int64_t next = start + static_cast<int64_t>(started) * stagger_ms * 1000;
+            wake = next < wake ? next : wake;
+        }
+        int64_t wait_us = wake > now ? wake - now : 0;
+        
+        fd_set write_fds;
+        FD_ZERO(&write_fds);
+        int max_fd = -1;
+        for (size_t i = 0; i < started; i++) {
+            if (socks[i] >= 0) {
+                FD_SET(socks[i], &write_fds);
+                max_fd = socks[i] > max_fd ? socks[i] : max_fd;
+            }
+        }
+        struct timeval timeout;
+        timeout.tv_sec = wait_us / 1000000;
+        timeout.tv_usec = wait_us % 1000000;
+        int ret = select(max_fd + 1, NULL, &write_fds, NULL, &timeout);
+        if (ret < 0 && errno != EINTR) {
+            ESP_LOGE(TAG, "TCP连接等待失败: errno %d", errno);
+            break;
+        }
+        if (ret <= 0) {
+            continue;
+        }
+        
+        // 检查连接是否成功，优先级高的候选同时成功时优先
+        for (size_t i = 0; i < started && found < 0; i++) {
+            if (socks[i] < 0 || !FD_ISSET(socks[i], &write_fds)) {
+                continue;
+            }
+            int error = 0;
+            socklen_t len = sizeof(error);
+            if (getsockopt(socks[i], SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error != 0) {
+                if (count > 1) {
+                    ESP_LOGW(TAG, "候选%u连接失败: %d", (unsigned)i, error);
+                } else {
+                    ESP_LOGE(TAG, "TCP连接建立失败: %d", error);
+                }
+                ::close(socks[i]);
+                socks[i] = -1;
+                candidates[i].failed = true;
+            } else {
+                found = static_cast<int>(i);
+            }
+        }
+    }
+    
+    // 关闭落选的连接
+    for (size_t i = 0; i < started; i++) {
+        if (socks[i] >= 0 && static_cast<int>(i) != found) {
+            ::close(socks[i]);
+        }
+    }
+    if (found < 0) {
+        return false;
+    }
+    
+    winner = static_cast<size_t>(found);
+    sock_ = socks[found];
+    
+    // 恢复阻塞模式
+    int flags = fcntl(sock_, F_GETFL, 0);
+    fcntl(sock_, F_SETFL, flags & ~O_NONBLOCK);
+    
+    // 设置超时时间
+    struct timeval tv;
+    tv.tv_sec = 60*10; //设置超时时间(s)
+    tv.tv_usec = 0;
+    setsockopt(sock_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    
+    // 关闭Nagle算法，上行合并由发送任务按配置控制
+    int nodelay = 1;
+    setsockopt(sock_, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    return true;
+}
+
+// 发送所有段，部分写入时从中断处继续
+bool tcp_transport::send(struct iovec* iov, size_t count) {
+    size_t index = 0;
+    
+    while (index < count) {
+        // 跳过已发送完的段和空段
+        if (iov[index].iov_len == 0) {
+            index++;
+            continue;
+        }
+        
+        struct msghdr msg = {};
+        msg.msg_iov = iov + index;
+        msg.msg_iovlen = count - index;
+        
+        int ret = sendmsg(sock_, &msg, 0);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ESP_LOGE(TAG, "发送数据失败: errno %d", errno);
+            return false;
+        }
+        if (ret == 0) {
+            ESP_LOGE(TAG, "发送数据失败: 连接已关闭");
+            return false;
+        }
+        
+        // 前进到第一个未发送完的段
+        size_t sent = static_cast<size_t>(ret);
+        while (index < count && sent >= iov[index].iov_len) {
+            sent -= iov[index].iov_len;
+            index++;
+        }
+        if (index < count && sent > 0) {
+            ESP_LOGD(TAG, "部分写入，剩余 %zu 字节继续发送", iov[index].iov_len - sent);
+            iov[index].iov_base = static_cast<uint8_t*>(iov[index].iov_base) + sent;
+            iov[index].iov_len -= sent;
+        }
+    }
+    
+    return true;
+}
+
+int tcp_transport::receive(uint8_t* data, size_t size) {
+    return recv(sock_, data, size, 0);
+}
+
+void tcp_transport::shutdown() {
+    // shutdown()唤醒阻塞在recv()中的接收任务
+    if (sock_ >= 0) {
+        ::shutdown(sock_, SHUT_RDWR);
+    }
+}
+
+void tcp_transport::close() {
+    if (sock_ >= 0) {
+        ::close(sock_);
+        sock_ = -1;
+    }
+}
+
+} // namespace esp_framework
@@ -0,0 +1,237 @@
+#include "udp_transport.h"
+#include "esp_log.h"
+#include "lwip/sockets.h"
+
+static const char* TAG = "Transport";
+
+// 等待下行数据时的select()超时，超时后检查是否已shutdown()（lwIP不支持对UDP套接字shutdown()）
+#define UDP_RECEIVE_POLL_MS 200
+
+namespace esp_framework {
+
+udp_transport::udp_transport(size_t max_payload)
+    : sock_(-1),
+      max_payload_(max_payload),
+      open_(false),
+      tx_seq_(0),
+      rx_started_(false),
+      rx_expected_seq_(0),
+      tx_datagrams_(0),
+      tx_dropped_(0),
+      rx_datagrams_(0),
+      rx_lost_(0),
+      rx_reordered_(0) {
+}
+
+udp_transport::~udp_transport() {
+    close();
+}
+
+bool udp_transport::open(uint32_t addr, uint16_t port, uint32_t timeout_ms) {
+    sock_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock_ < 0) {
+        ESP_LOGE(TAG, "创建套接字失败: errno %d", errno);
+        return false;
+    }
+    
+    // 已连接的UDP套接字只接收服务器的数据报，服务器端口不可达时收发返回ECONNREFUSED
+    struct sockaddr_in dest_addr;
+    dest_addr.sin_addr.s_addr = addr;
+    dest_addr.sin_family = AF_INET;
+    dest_addr.sin_port = htons(port);
+    if (connect(sock_, (struct sockaddr *)&dest_addr, sizeof(dest_addr)) != 0) {
+        ESP_LOGE(TAG, "UDP连接失败: errno %d", errno);
+        close();
+        return false;
+    }
+    
+    // 只有帧头的数据报，服务器由此得知设备地址
+    open_ = true;
+    struct iovec hello[1];
+    if (!send_datagram(hello, 1)) {
+        open_ = false;
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool udp_transport::send_datagram(struct iovec* iov, size_t count) {
+    uint8_t header[UDP_DATAGRAM_HEADER_SIZE];
+    for (size_t i = 0; i < UDP_DATAGRAM_HEADER_SIZE; i++) {
+        header[i] = static_cast<uint8_t>(tx_seq_ >> (8 * i));
+    }
+    iov[0].iov_base = header;
+    iov[0].iov_len = sizeof(header);
+    
+    struct msghdr msg = {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    
+    // 帧号总是前进，协议栈丢弃的数据报在接收方统计为丢失
+    tx_seq_++;
+    while (sendmsg(sock_, &msg, 0) < 0) {
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == ENOMEM || errno == ENOBUFS || errno == EAGAIN) {
+            tx_dropped_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        ESP_LOGE(TAG, "发送数据报失败: errno %d", errno);
+        return false;
+    }
+    tx_datagrams_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool udp_transport::send(struct iovec* segments, size_t count) {
+    if (!open_) {
+        return false;
+    }
+    
+    // iov[0]为帧头，之后是本数据报的负载段
+    struct iovec iov[UDP_DATAGRAM_MAX_SEGMENTS + 1];
+    size_t n = 1;
+    size_t payload = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t* data = static_cast<uint8_t*>(segments[i].iov_base);
+        size_t size = segments[i].iov_len;
+        if (size == 0) {
+            continue;
+        }
+        
+        // 放不下整段时先发送已装入的段，数据报边界落在段边界上
+        if (payload > 0 && (payload + size > max_payload_ || n > UDP_DATAGRAM_MAX_SEGMENTS)) {
+            if (!send_datagram(iov, n)) {
+                return false;
+            }
+            n = 1;
+            payload = 0;
+        }
+        
+        // 超过最大负载的段拆成多个数据报
+        while (size > 0) {
+            size_t take = size < max_payload_ - payload ? size : max_payload_ - payload;
+            iov[n].iov_base = data;
+            iov[n].iov_len = take;
+            n++;
+            payload += take;
+            data += take;
+            size -= take;
+            if (size > 0) {
+                if (!send_datagram(iov, n)) {
+                    return false;
+                }
+                n = 1;
+                payload = 0;
+            }
+        }
+    }
+    
+    return payload == 0 || send_datagram(iov, n);
+}
+
+void udp_transport::track_rx_seq(uint32_t seq) {
+    rx_datagrams_.fetch_add(1, std::memory_order_relaxed);
+    
+    // 帧号0表示服务器重新开始计数
+    if (!rx_started_ || seq == 0) {
+        rx_started_ = true;
+        rx_expected_seq_ = seq + 1;
+        return;
+    }
+    
+    int32_t gap = static_cast<int32_t>(seq - rx_expected_seq_);
+    if (gap < 0) {
+        rx_reordered_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (gap > 0) {
+        rx_lost_.fetch_add(static_cast<uint32_t>(gap), std::memory_order_relaxed);
+    }
+    rx_expected_seq_ = seq + 1;
+}
+
+int udp_transport::receive(uint8_t* data, size_t size) {
+    while (open_) {
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(sock_, &readable);
+        struct timeval tv;
+        tv.tv_sec = 0;
+        tv.tv_usec = UDP_RECEIVE_POLL_MS * 1000;
+        int ret = select(sock_ + 1, &readable, nullptr, nullptr, &tv);
+        if (ret < 0 && errno != EINTR) {
+            return -1;
+        }
+        if (ret <= 0) {
+            continue;
+        }
+        
+        // 帧头和负载分别接收到两个缓冲区，负载直接进入调用者的缓冲区
+        uint8_t header[UDP_DATAGRAM_HEADER_SIZE];
+        struct iovec iov[2];
+        iov[0].iov_base = header;
+        iov[0].iov_len = sizeof(header);
+        iov[1].iov_base = data;
+        iov[1].iov_len = size;
+        struct msghdr msg = {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = 2;
+        
+        ret = recvmsg(sock_, &msg, 0);
+        if (ret < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+                continue;
+            }
+            if (errno == ECONNREFUSED) {
+                ESP_LOGW(TAG, "UDP服务器端口不可达");
+            }
+            return -1;
+        }
+        if (ret < static_cast<int>(UDP_DATAGRAM_HEADER_SIZE)) {
+            ESP_LOGW(TAG, "忽略%d字节的无效数据报", ret);
+            continue;
+        }
+        if (msg.msg_flags & MSG_TRUNC) {
+            ESP_LOGW(TAG, "下行数据报超过%zu字节，已截断", size);
+        }
+        
+        uint32_t seq = 0;
+        for (size_t i = 0; i < UDP_DATAGRAM_HEADER_SIZE; i++) {
+            seq |= static_cast<uint32_t>(header[i]) << (8 * i);
+        }
+        track_rx_seq(seq);
+        
+        // 只有帧头的数据报为保活，不交给调用者
+        if (ret > static_cast<int>(UDP_DATAGRAM_HEADER_SIZE)) {
+            return ret - static_cast<int>(UDP_DATAGRAM_HEADER_SIZE);
+        }
+    }
+    return 0;
+}
+
+void udp_transport::shutdown() {
+    open_ = false;
+}
+
+void udp_transport::close() {
+    open_ = false;
+    if (sock_ >= 0) {
+        ::close(sock_);
+        sock_ = -1;
+    }
+}
+
+udp_transport_stats udp_transport::get_stats() const {
+    udp_transport_stats stats;
+    stats.tx_datagrams = tx_datagrams_.load(std::memory_order_relaxed);
+    stats.tx_dropped = tx_dropped_.load(std::memory_order_relaxed);
+    stats.rx_datagrams = rx_datagrams_.load(std::memory_order_relaxed);
+    stats.rx_lost = rx_lost_.load(std::memory_order_relaxed);
+    stats.rx_reordered = rx_reordered_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace esp_framework
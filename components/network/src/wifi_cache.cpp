@@ -0,0 +1,112 @@
+#include "wifi_cache.h"
+#include <cstring>
+#include <ctime>
+#include "esp_log.h"
+#include "nvs.h"
+#include "sdkconfig.h"
+
+static const char* TAG = "WiFiCache";
+
+#define WIFI_CACHE_NVS_NAMESPACE "wifi_cache"
+#define WIFI_CACHE_NVS_KEY "record"
+#define WIFI_LEASE_REUSE_S CONFIG_WIFI_LEASE_REUSE_S
+
+namespace esp_framework {
+
+static uint32_t ssid_hash(const std::string& ssid) {
+    uint32_t hash = 2166136261u;
+    for (char c : ssid) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+wifi_cache::wifi_cache() {
+    memset(&record_, 0, sizeof(record_));
+}
+
+bool wifi_cache::load(const std::string& ssid) {
+    memset(&record_, 0, sizeof(record_));
+    record_.ssid_hash = ssid_hash(ssid);
+    
+    nvs_handle_t handle;
+    if (nvs_open(WIFI_CACHE_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+    wifi_cache_record stored;
+    size_t length = sizeof(stored);
+    esp_err_t err = nvs_get_blob(handle, WIFI_CACHE_NVS_KEY, &stored, &length);
+    nvs_close(handle);
+    if (err != ESP_OK || length != sizeof(stored) || stored.ssid_hash != record_.ssid_hash || stored.channel == 0) {
+        return false;
+    }
+    record_ = stored;
+    return true;
+}
+
+bool wifi_cache::lease_valid(int64_t* remaining_s) const {
+    if (record_.ip == 0) {
+        return false;
+    }
+    int64_t age = static_cast<int64_t>(time(nullptr)) - record_.lease_at;
+    if (age < 0 || age >= WIFI_LEASE_REUSE_S) {
+        return false;
+    }
+    if (remaining_s != nullptr) {
+        *remaining_s = WIFI_LEASE_REUSE_S - age;
+    }
+    return true;
+}
+
+void wifi_cache::update_ap(const uint8_t* bssid, uint8_t channel, uint8_t authmode) {
+    if (memcmp(record_.bssid, bssid, sizeof(record_.bssid)) == 0 &&
+        record_.channel == channel && record_.authmode == authmode) {
+        return;
+    }
+    memcpy(record_.bssid, bssid, sizeof(record_.bssid));
+    record_.channel = channel;
+    record_.authmode = authmode;
+    save();
+}
+
+void wifi_cache::update_ip(uint32_t ip, uint32_t netmask, uint32_t gw, uint32_t dns) {
+    record_.ip = ip;
+    record_.netmask = netmask;
+    record_.gw = gw;
+    record_.dns = dns;
+    record_.lease_at = static_cast<int64_t>(time(nullptr));
+    save();
+}
+
+void wifi_cache::invalidate() {
+    uint32_t hash = record_.ssid_hash;
+    memset(&record_, 0, sizeof(record_));
+    record_.ssid_hash = hash;
+    
+    nvs_handle_t handle;
+    if (nvs_open(WIFI_CACHE_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    nvs_erase_key(handle, WIFI_CACHE_NVS_KEY);
+    nvs_commit(handle);
+    nvs_close(handle);
+}
+
+void wifi_cache::save() {
+    // 还没有AP记录时不保存
+    if (record_.channel == 0) {
+        return;
+    }
+    nvs_handle_t handle;
+    if (nvs_open(WIFI_CACHE_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        ESP_LOGW(TAG, "无法打开NVS，WiFi连接记录未保存");
+        return;
+    }
+    if (nvs_set_blob(handle, WIFI_CACHE_NVS_KEY, &record_, sizeof(record_)) != ESP_OK ||
+        nvs_commit(handle) != ESP_OK) {
+        ESP_LOGW(TAG, "保存WiFi连接记录失败");
+    }
+    nvs_close(handle);
+}
+
+} // namespace esp_framework
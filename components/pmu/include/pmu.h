@@ -1,27 +1,42 @@
 #pragma once
 
 #include <atomic>
-#include <chrono>
+#include <memory>
+#include <mutex>
 #include "esp_log.h"
 #include "esp_sleep.h"
+#include "esp_pm.h"
 #include "device_manager.h"
 #include "event_system.h"
+#include "wake_lock.h"
+#include "timer_service.h"
+#include "sleep_policy.h"
 
 namespace esp_framework {
 
 /**
  * @brief 电源管理器类
  * 
- * 负责设备低功耗控制和深度睡眠管理
+ * 负责设备低功耗控制和深度睡眠管理。满足以下全部条件时挂起所有设备：
+ * - 没有唤醒锁被持有（见wake_locks），且最后一个唤醒锁释放已超过空闲超时时间
+ * - 最近一次数据或网络事件已超过活动宽限时间
+ * 挂起后收到数据或网络事件、其他模块获取唤醒锁时立即恢复。
+ *
+ * 不需要周期性调用：在timer_service中注册名为"pmu"的定时器，只在可以挂起、档位可能变化或
+ * 保持唤醒结束的时间触发，唤醒锁和活动改变这些时间时重新安排。
+ *
+ * 未挂起时按数据到达间隔选择保持TCP连接的省电档位（见sleep_policy）：全速、WiFi调制解调器
+ * 睡眠或自动轻度睡眠。轻度睡眠档位下由UART唤醒，每次收到数据后保持唤醒一段时间。
  */
 class pmu {
 public:
     /**
      * @brief 构造函数
      * @param dev_mgr 设备管理器引用
-     * @param idle_timeout_seconds 空闲超时时间(秒)
+     * @param idle_timeout_seconds 空闲超时时间(秒)，0表示使用CONFIG_POWER_SAVE_TIMEOUT
+     * @param activity_grace_seconds 活动宽限时间(秒)，0表示使用CONFIG_POWER_ACTIVITY_GRACE_S
      */
-    pmu(device_manager& dev_mgr, int idle_timeout_seconds = 10);
+    pmu(device_manager& dev_mgr, int idle_timeout_seconds = 10, int activity_grace_seconds = 0);
     
     /**
      * @brief 析构函数
@@ -29,31 +44,34 @@ public:
     ~pmu();
     
     /**
-     * @brief 获取锁，保持系统活跃
+     * @brief 获取名为"pmu"的唤醒锁，保持系统活跃
      */
     void lock();
     
     /**
-     * @brief 释放锁，允许系统进入低功耗模式
+     * @brief 释放lock()获取的唤醒锁，允许系统进入低功耗模式
      */
     void unlock();
     
     /**
-     * @brief 检查是否被锁定
+     * @brief 检查是否有唤醒锁被持有（任何模块）
      * @return 被锁定返回true，否则返回false
      */
     bool is_locked() const;
     
     /**
-     * @brief 进入深度睡眠
-     * @param sleep_time_ms 睡眠时间(毫秒)，0表示无限期睡眠
+     * @brief 记录一次活动，重置空闲计时，已挂起时立即恢复
+     * 
+     * 数据和网络事件自动调用，其他模块也可直接调用。
+     * @param type 活动对应的事件类型
      */
-    void enter_deep_sleep(uint32_t sleep_time_ms = 0);
+    void notify_activity(event_type type);
     
     /**
-     * @brief 必须定期调用以检查空闲状态
+     * @brief 进入深度睡眠
+     * @param sleep_time_ms 睡眠时间(毫秒)，0表示无限期睡眠
      */
-    void loop();
+    void enter_deep_sleep(uint32_t sleep_time_ms = 0);
     
     /**
      * @brief 设置空闲超时时间
@@ -67,12 +85,83 @@ public:
      */
     int get_idle_timeout() const;
     
+    /**
+     * @brief 设置活动宽限时间
+     * @param seconds 最近一次活动后保持活跃的时间(秒)
+     */
+    void set_activity_grace(int seconds);
+    
+    /**
+     * @brief 获取活动宽限时间
+     * @return 宽限时间(秒)
+     */
+    int get_activity_grace() const;
+    
+    /**
+     * @brief 获取当前省电档位
+     */
+    power_tier get_tier() const;
+    
+    /**
+     * @brief 获取各省电档位的时间、占空比和事件统计
+     * @param out 输出数组，POWER_TIER_COUNT项
+     */
+    void get_tier_stats(power_tier_stats* out) const;
+    
+    /**
+     * @brief 打印电源状态：是否挂起、持有中的唤醒锁、最近的活动、距离挂起的时间，
+     *        以及各省电档位的占空比和电流估算
+     */
+    void dump() const;
+    
 private:
+    /**
+     * @brief 把数据和网络事件转为活动通知
+     */
+    class activity_listener : public event_listener {
+    public:
+        explicit activity_listener(pmu& owner) : owner_(owner) {}
+        void on_event(const event_data& event) override { owner_.notify_activity(event.type); }
+    private:
+        pmu& owner_;
+    };
+    
+    // 计算可以挂起的时间（esp_timer微秒）
+    int64_t idle_deadline_us() const;
+    
+    // 定时器到期：更新档位和保持唤醒，空闲超时时挂起，然后安排下一次
+    void on_timer();
+    
+    // 下一次需要检查的时间，没有时为INT64_MAX（调用者持有state_mutex_）
+    int64_t next_deadline_locked(int64_t now_us) const;
+    
+    // 按next_deadline_locked()安排定时器，替换之前的安排（调用者持有state_mutex_）
+    void reschedule_locked(int64_t now_us);
+    
+    // 恢复所有设备（调用者持有state_mutex_）
+    void resume_locked(const char* reason);
+    
+    // 按当前档位配置CPU调频、自动轻度睡眠和WiFi省电模式（调用者持有state_mutex_）
+    void apply_tier_locked();
+    
+    // 轻度睡眠档位下收到数据后阻止轻度睡眠，保持时间结束后解除（调用者持有state_mutex_）
+    void update_sleep_hold_locked(int64_t now_us);
+    
     device_manager& dev_mgr_;                             // 设备管理器引用
-    std::atomic<bool> is_locked_;                         // 是否已锁定
-    std::chrono::steady_clock::time_point last_unlock_time_; // 上次解锁时间
-    std::chrono::seconds idle_timeout_;                   // 空闲超时时间
-    bool is_suspended_;                                  // 是否已挂起
+    std::shared_ptr<activity_listener> listener_;         // 事件监听器
+    std::atomic<int64_t> idle_timeout_us_;                // 空闲超时时间
+    std::atomic<int64_t> activity_grace_us_;              // 活动宽限时间
+    std::atomic<int64_t> start_us_;                       // 创建时间，之前没有释放和活动时从此计时
+    std::atomic<int64_t> last_activity_us_;               // 最近一次活动的时间
+    std::atomic<int> last_activity_type_;                 // 最近一次活动的事件类型
+    std::atomic<uint32_t> activity_count_;                // 活动次数
+    std::atomic<uint32_t> suspend_count_;                 // 挂起次数
+    std::atomic<bool> is_suspended_;                      // 是否已挂起
+    sleep_policy policy_;                                 // 省电档位选择
+    esp_pm_lock_handle_t no_sleep_lock_;                  // 收到数据后阻止轻度睡眠
+    bool sleep_held_;                                     // 是否持有no_sleep_lock_
+    timer_id timer_;                                      // 定时器服务中的"pmu"定时器
+    mutable std::mutex state_mutex_;                      // 保护挂起状态和档位，事件分发任务和主任务都会修改
 };
 
 } // namespace esp_framework 
\ No newline at end of file
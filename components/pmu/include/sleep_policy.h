@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esp_framework {
+
+/**
+ * @brief 保持TCP连接的省电档位，从高功耗到低功耗排列
+ */
+enum class power_tier : uint8_t {
+    active,         // CPU全速，WiFi不省电（WIFI_PS_NONE）
+    modem_sleep,    // CPU动态调频，WiFi在DTIM间隔之间关闭射频（WIFI_PS_MIN_MODEM）
+    light_sleep     // 自动轻度睡眠，WiFi按监听间隔接收信标（WIFI_PS_MAX_MODEM），UART唤醒
+};
+
+constexpr size_t POWER_TIER_COUNT = 3;
+
+/**
+ * @brief 档位名称
+ */
+const char* power_tier_name(power_tier tier);
+
+/**
+ * @brief 档位选择参数
+ */
+struct sleep_policy_config {
+    uint32_t active_gap_ms;     // 数据到达间隔低于此值时保持全速
+    uint32_t light_gap_ms;      // 到达间隔或静默时间超过此值时进入轻度睡眠
+    uint32_t dwell_ms;          // 进入轻度睡眠前须持续满足条件的时间，其余切换不等待
+    uint32_t hold_ms;           // 轻度睡眠档位下收到数据后保持唤醒的时间
+    uint32_t listen_interval;   // 轻度睡眠档位的监听间隔（DTIM个数）
+};
+
+/**
+ * @brief 每个档位的累计统计
+ */
+struct power_tier_stats {
+    uint64_t time_us;           // 处于该档位的时间
+    uint64_t awake_us;          // 其中CPU或射频唤醒的时间（按模型估算，含信标接收）
+    uint32_t entries;           // 进入该档位的次数
+    uint32_t events;            // 该档位下的数据事件数
+    uint32_t wakeups;           // 从睡眠中被数据唤醒的次数（轻度睡眠下即UART唤醒）
+};
+
+/**
+ * @brief 按数据到达间隔选择省电档位，并按电流模型估算各档位的占空比和平均电流
+ *
+ * 记录最近SLEEP_POLICY_GAPS个到达间隔，取平均值与当前静默时间的较大者作为到达间隔：
+ * 小于active_gap_ms为全速，小于light_gap_ms为调制解调器睡眠，否则为轻度睡眠。
+ * 用平均值而不是中位数，一帧数据分几块到达时按帧间隔而不是块间隔计算。
+ * 轻度睡眠会丢失唤醒字节，进入前须持续满足条件dwell_ms，等待期间先使用调制解调器睡眠；
+ * 其余切换立即进行。
+ *
+ * 唤醒时间模型：全速档位始终唤醒；调制解调器睡眠档位每个DTIM（102.4ms）接收一次信标，
+ * 每次数据后射频保持工作MODEM_TAIL_MS；轻度睡眠档位每listen_interval个DTIM接收一次信标，
+ * 每次数据后CPU和射频保持唤醒hold_ms。唤醒期间电流为awake_ma()，其余时间为该档位的
+ * 睡眠电流，数值取自ESP32-S3数据手册的典型值，只用于比较不同档位和策略参数。
+ *
+ * 不依赖ESP-IDF，设备上由pmu调用，宿主机上由sleep_sim按流量记录回放。不加锁。
+ */
+class sleep_policy {
+public:
+    static constexpr size_t SLEEP_POLICY_GAPS = 16;
+    static constexpr uint32_t DTIM_US = 102400;
+    static constexpr uint32_t BEACON_US = 3000;         // 每次接收信标的唤醒时间
+    static constexpr uint32_t MODEM_TAIL_MS = 50;       // 调制解调器睡眠档位下每次数据后射频工作的时间
+
+    explicit sleep_policy(const sleep_policy_config& config);
+
+    /**
+     * @brief 清空统计和到达间隔，从全速档位开始
+     * @param now_us 当前时间（微秒）
+     */
+    void reset(int64_t now_us);
+
+    /**
+     * @brief 记录一次数据事件
+     * @param now_us 当前时间（微秒），不得早于上一次调用
+     * @return 档位变化时返回true
+     */
+    bool on_event(int64_t now_us);
+
+    /**
+     * @brief 按静默时间更新档位，应周期性调用
+     * @param now_us 当前时间（微秒）
+     * @return 档位变化时返回true
+     */
+    bool update(int64_t now_us);
+
+    /**
+     * @brief 下一次update()可能改变档位或保持状态的时间
+     *
+     * 静默时间越过阈值、进入轻度睡眠的等待结束或保持唤醒结束中最早的一个，
+     * 在此之前没有新事件时调用update()不会有变化。
+     * @param now_us 当前时间（微秒）
+     * @return 晚于now_us的时间（微秒），没有时为INT64_MAX
+     */
+    int64_t next_update_us(int64_t now_us) const;
+    
+    /**
+     * @brief 当前档位
+     */
+    power_tier tier() const { return tier_; }
+
+    /**
+     * @brief 轻度睡眠档位下是否仍在数据后的保持唤醒时间内
+     */
+    bool holding(int64_t now_us) const;
+
+    /**
+     * @brief 最近到达间隔的平均值（毫秒），不足两次事件时为0
+     */
+    uint32_t mean_gap_ms() const;
+
+    /**
+     * @brief 获取各档位统计，当前档位计入到now_us为止
+     * @param now_us 当前时间（微秒）
+     * @param out 输出数组，POWER_TIER_COUNT项
+     */
+    void get_stats(int64_t now_us, power_tier_stats* out) const;
+
+    /**
+     * @brief 唤醒期间的电流（mA）
+     */
+    static float awake_ma();
+
+    /**
+     * @brief 档位睡眠期间的电流（mA）
+     */
+    static float sleep_ma(power_tier tier);
+
+    /**
+     * @brief 按统计估算平均电流（mA）
+     */
+    static float estimate_ma(power_tier tier, const power_tier_stats& stats);
+
+    /**
+     * @brief 唤醒时间占比
+     */
+    static float duty_cycle(const power_tier_stats& stats);
+
+private:
+    // 按到达间隔和静默时间计算目标档位
+    power_tier desired(int64_t now_us) const;
+
+    // 按目标档位切换，进入轻度睡眠须持续dwell_ms
+    bool apply(power_tier target, int64_t now_us);
+
+    // 信标间隔（微秒），全速档位为0
+    uint64_t beacon_interval_us(power_tier tier) const;
+
+    // 每次数据后保持唤醒的时间（微秒）
+    int64_t tail_us(power_tier tier) const;
+
+    sleep_policy_config config_;
+    uint32_t gaps_ms_[SLEEP_POLICY_GAPS];   // 最近的到达间隔，环形缓冲区
+    size_t gap_count_;
+    size_t gap_next_;
+    int64_t start_us_;                      // reset()的时间
+    int64_t last_event_us_;                 // 0表示还没有事件
+    power_tier tier_;
+    int64_t tier_since_us_;
+    int64_t light_since_us_;                // 开始满足轻度睡眠条件的时间，-1表示不满足
+    int64_t awake_until_us_;                // 当前唤醒窗口的结束时间
+    power_tier_stats stats_[POWER_TIER_COUNT];
+};
+
+} // namespace esp_framework
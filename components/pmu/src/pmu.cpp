@@ -1,64 +1,222 @@
 #include "pmu.h"
+#include <algorithm>
 #include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
 
 static const char* TAG = "PMU";
 
 // 配置参数
 #define PMU_DEFAULT_IDLE_TIMEOUT CONFIG_POWER_SAVE_TIMEOUT
+#define PMU_DEFAULT_ACTIVITY_GRACE CONFIG_POWER_ACTIVITY_GRACE_S
+
+// lock()/unlock()使用的唤醒锁名称
+static const char* PMU_WAKE_LOCK = "pmu";
 
 namespace esp_framework {
 
-pmu::pmu(device_manager& dev_mgr, int idle_timeout_seconds)
+// 视为活动的事件：数据收发和网络状态变化
+static const event_type ACTIVITY_EVENTS[] = {
+    event_type::data_received,
+    event_type::network_connected,
+    event_type::network_disconnected,
+    event_type::tcp_state_changed,
+    event_type::uplink_high_watermark,
+};
+
+static sleep_policy_config default_policy_config() {
+    sleep_policy_config config;
+    config.active_gap_ms = CONFIG_POWER_ACTIVE_GAP_MS;
+    config.light_gap_ms = CONFIG_POWER_LIGHT_GAP_MS;
+    config.dwell_ms = CONFIG_POWER_TIER_DWELL_MS;
+    config.hold_ms = CONFIG_POWER_LIGHT_SLEEP_HOLD_MS;
+    config.listen_interval = CONFIG_POWER_WIFI_LISTEN_INTERVAL;
+    return config;
+}
+
+static const char* activity_name(int type) {
+    switch (static_cast<event_type>(type)) {
+        case event_type::data_received:          return "数据";
+        case event_type::network_connected:      return "网络连接";
+        case event_type::network_disconnected:   return "网络断开";
+        case event_type::tcp_state_changed:      return "TCP状态";
+        case event_type::uplink_high_watermark:  return "上行积压";
+        default:                                 return "其他";
+    }
+}
+
+pmu::pmu(device_manager& dev_mgr, int idle_timeout_seconds, int activity_grace_seconds)
     : dev_mgr_(dev_mgr),
-      is_locked_(false),
-      idle_timeout_(std::chrono::seconds(idle_timeout_seconds == 0 ? 
-                                       PMU_DEFAULT_IDLE_TIMEOUT : 
-                                       idle_timeout_seconds)),
-      is_suspended_(false) {
+      listener_(),
+      idle_timeout_us_(static_cast<int64_t>(idle_timeout_seconds == 0 ? 
+                                            PMU_DEFAULT_IDLE_TIMEOUT : 
+                                            idle_timeout_seconds) * 1000000),
+      activity_grace_us_(static_cast<int64_t>(activity_grace_seconds == 0 ?
+                                              PMU_DEFAULT_ACTIVITY_GRACE :
+                                              activity_grace_seconds) * 1000000),
+      start_us_(esp_timer_get_time()),
+      last_activity_us_(0),
+      last_activity_type_(static_cast<int>(event_type::max_event_type)),
+      activity_count_(0),
+      suspend_count_(0),
+      is_suspended_(false),
+      policy_(default_policy_config()),
+      no_sleep_lock_(nullptr),
+      sleep_held_(false),
+      timer_(TIMER_INVALID) {
+    
+#if CONFIG_POWER_LIGHT_SLEEP
+    if (esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "pmu_rx", &no_sleep_lock_) != ESP_OK) {
+        ESP_LOGW(TAG, "无法创建电源管理锁，轻度睡眠档位下UART数据可能丢失");
+        no_sleep_lock_ = nullptr;
+    }
+#endif
+    timer_ = timer_service::get_instance().add("pmu", [this] { on_timer(); });
+    if (timer_ == TIMER_INVALID) {
+        ESP_LOGE(TAG, "无法注册定时器，不会自动进入低功耗模式");
+    }
+    {
+        std::lock_guard<std::mutex> guard(state_mutex_);
+        int64_t now = esp_timer_get_time();
+        policy_.reset(now);
+        apply_tier_locked();
+        reschedule_locked(now);
+    }
     
-    // 记录初始解锁时间
-    last_unlock_time_ = std::chrono::steady_clock::now();
+    // 唤醒锁全部释放后从释放时间重新计算空闲超时，获取时立即恢复
+    wake_locks::get_instance().set_observer([this] { timer_service::get_instance().schedule_in(timer_, 0); });
     
-    ESP_LOGI(TAG, "电源管理器初始化完成，空闲超时时间: %d秒", 
-            static_cast<int>(idle_timeout_.count()));
+    // 订阅数据和网络事件，流量即活动
+    listener_ = std::make_shared<activity_listener>(*this);
+    for (event_type type : ACTIVITY_EVENTS) {
+        event_bus::get_instance().subscribe(type, listener_);
+    }
+    
+    ESP_LOGI(TAG, "电源管理器初始化完成，空闲超时时间: %d秒，活动宽限时间: %d秒", 
+            get_idle_timeout(), get_activity_grace());
 }
 
 pmu::~pmu() {
+    for (event_type type : ACTIVITY_EVENTS) {
+        event_bus::get_instance().unsubscribe(type, listener_);
+    }
+    wake_locks::get_instance().set_observer(nullptr);
+    timer_service::get_instance().cancel(timer_);
+    
     // 确保系统不会处于挂起状态
+    std::lock_guard<std::mutex> guard(state_mutex_);
     if (is_suspended_) {
         dev_mgr_.resume_all();
+        is_suspended_ = false;
+    }
+    if (no_sleep_lock_ != nullptr) {
+        if (sleep_held_) {
+            esp_pm_lock_release(no_sleep_lock_);
+        }
+        esp_pm_lock_delete(no_sleep_lock_);
     }
     
     ESP_LOGI(TAG, "电源管理器已销毁");
 }
 
 void pmu::lock() {
-    if (!is_locked_) {
-        is_locked_ = true;
-        
-        // 如果系统已挂起，则恢复
-        if (is_suspended_) {
-            dev_mgr_.resume_all();
-            is_suspended_ = false;
-            ESP_LOGI(TAG, "系统已恢复（从低功耗模式）");
+    wake_locks::get_instance().acquire(PMU_WAKE_LOCK);
+    
+    // 如果系统已挂起，则恢复（其他模块的唤醒锁由定时器中恢复）
+    std::lock_guard<std::mutex> guard(state_mutex_);
+    resume_locked("获取唤醒锁");
+}
+
+void pmu::unlock() {
+    wake_locks::get_instance().release(PMU_WAKE_LOCK);
+}
+
+bool pmu::is_locked() const {
+    return wake_locks::get_instance().held();
+}
+
+void pmu::notify_activity(event_type type) {
+    int64_t now = esp_timer_get_time();
+    last_activity_us_.store(now, std::memory_order_relaxed);
+    last_activity_type_.store(static_cast<int>(type), std::memory_order_relaxed);
+    activity_count_.fetch_add(1, std::memory_order_relaxed);
+    
+    std::lock_guard<std::mutex> guard(state_mutex_);
+    if (type == event_type::data_received) {
+        // 只有数据事件计入到达间隔，网络状态变化不代表流量
+        if (policy_.on_event(now)) {
+            apply_tier_locked();
         }
-        
-        ESP_LOGI(TAG, "电源管理器已锁定，系统将保持活跃");
+        update_sleep_hold_locked(now);
+    }
+    resume_locked(activity_name(static_cast<int>(type)));
+    // 活动只会推迟空闲超时，数据事件可能带来更早的档位或保持唤醒检查
+    int64_t next = next_deadline_locked(now);
+    if (next != INT64_MAX) {
+        timer_service::get_instance().expedite(timer_, next);
     }
 }
 
-void pmu::unlock() {
-    if (is_locked_) {
-        is_locked_ = false;
-        last_unlock_time_ = std::chrono::steady_clock::now();
-        ESP_LOGI(TAG, "电源管理器已解锁，系统可能进入低功耗模式");
+void pmu::resume_locked(const char* reason) {
+    if (is_suspended_) {
+        dev_mgr_.resume_all();
+        is_suspended_ = false;
+        ESP_LOGI(TAG, "系统已恢复（从低功耗模式，原因: %s）", reason);
     }
 }
 
-bool pmu::is_locked() const {
-    return is_locked_;
+void pmu::apply_tier_locked() {
+    power_tier tier = policy_.tier();
+#if CONFIG_POWER_LIGHT_SLEEP
+    // 全速档位固定最高频率；其他档位空闲时降到晶振频率，轻度睡眠档位允许自动轻度睡眠
+    esp_pm_config_t config = {};
+    config.max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    config.min_freq_mhz = tier == power_tier::active ? CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ : CONFIG_XTAL_FREQ;
+    config.light_sleep_enable = tier == power_tier::light_sleep;
+    esp_err_t err = esp_pm_configure(&config);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "电源管理配置失败: %s", esp_err_to_name(err));
+    }
+#endif
+    wifi_ps_type_t ps = WIFI_PS_NONE;
+    if (tier == power_tier::modem_sleep) {
+        ps = WIFI_PS_MIN_MODEM;
+    } else if (tier == power_tier::light_sleep) {
+        ps = WIFI_PS_MAX_MODEM;
+    }
+    esp_err_t ps_err = esp_wifi_set_ps(ps);
+    if (ps_err != ESP_OK) {
+        ESP_LOGW(TAG, "WiFi省电模式设置失败: %s", esp_err_to_name(ps_err));
+    }
+    ESP_LOGI(TAG, "省电档位: %s（平均到达间隔%lums）", power_tier_name(tier),
+             (unsigned long)policy_.mean_gap_ms());
+}
+
+void pmu::update_sleep_hold_locked(int64_t now_us) {
+    bool hold = policy_.holding(now_us);
+    if (hold == sleep_held_ || no_sleep_lock_ == nullptr) {
+        return;
+    }
+    if (hold) {
+        esp_pm_lock_acquire(no_sleep_lock_);
+    } else {
+        esp_pm_lock_release(no_sleep_lock_);
+    }
+    sleep_held_ = hold;
+}
+
+int64_t pmu::idle_deadline_us() const {
+    int64_t release = wake_locks::get_instance().last_release_us();
+    int64_t start = start_us_.load(std::memory_order_relaxed);
+    int64_t idle_deadline = (release > start ? release : start) + idle_timeout_us_.load(std::memory_order_relaxed);
+    int64_t activity = last_activity_us_.load(std::memory_order_relaxed);
+    int64_t activity_deadline = activity + activity_grace_us_.load(std::memory_order_relaxed);
+    if (activity == 0 || activity_deadline < idle_deadline) {
+        return idle_deadline;
+    }
+    return activity_deadline;
 }
 
 void pmu::enter_deep_sleep(uint32_t sleep_time_ms) {
@@ -84,39 +242,141 @@ void pmu::enter_deep_sleep(uint32_t sleep_time_ms) {
     // 此行不会执行，因为深度睡眠会重启系统
 }
 
-void pmu::loop() {
-    if (is_locked_ || is_suspended_) {
-        return;  // 被锁定或已挂起，无需处理
+int64_t pmu::next_deadline_locked(int64_t now_us) const {
+    int64_t next = policy_.next_update_us(now_us);
+    if (!is_suspended_ && !wake_locks::get_instance().held()) {
+        next = std::min(next, idle_deadline_us());
     }
+    return next;
+}
+
+void pmu::on_timer() {
+    std::lock_guard<std::mutex> guard(state_mutex_);
+    int64_t now = esp_timer_get_time();
     
-    // 检查是否超时
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - last_unlock_time_);
+    // 流量停止后按静默时间降低档位
+    if (policy_.update(now)) {
+        apply_tier_locked();
+    }
+    update_sleep_hold_locked(now);
     
-    if (elapsed >= idle_timeout_) {
+    if (wake_locks::get_instance().held()) {
+        // 其他模块获取唤醒锁时恢复
+        resume_locked("唤醒锁");
+    } else if (!is_suspended_ && now >= idle_deadline_us()) {
         // 超时，进入低功耗模式
-        if (!is_suspended_) {
-            ESP_LOGI(TAG, "空闲超时(%lld秒)，进入低功耗模式", 
-                    static_cast<long long>(elapsed.count()));
-            dev_mgr_.suspend_all();
-            is_suspended_ = true;
+        int64_t activity = last_activity_us_.load(std::memory_order_relaxed);
+        if (activity == 0) {
+            ESP_LOGI(TAG, "空闲超时，进入低功耗模式");
+        } else {
+            ESP_LOGI(TAG, "空闲超时(最近活动%lld秒前)，进入低功耗模式", 
+                    static_cast<long long>((now - activity) / 1000000));
         }
+        dev_mgr_.suspend_all();
+        is_suspended_ = true;
+        suspend_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    reschedule_locked(now);
+}
+
+void pmu::reschedule_locked(int64_t now_us) {
+    int64_t next = next_deadline_locked(now_us);
+    if (next == INT64_MAX) {
+        timer_service::get_instance().cancel(timer_);
+    } else {
+        timer_service::get_instance().schedule_at(timer_, next);
     }
 }
 
 void pmu::set_idle_timeout(int seconds) {
     if (seconds <= 0) {
         ESP_LOGW(TAG, "无效的空闲超时时间: %d秒，使用默认值", seconds);
-        idle_timeout_ = std::chrono::seconds(PMU_DEFAULT_IDLE_TIMEOUT);
-    } else {
-        idle_timeout_ = std::chrono::seconds(seconds);
+        seconds = PMU_DEFAULT_IDLE_TIMEOUT;
     }
+    idle_timeout_us_.store(static_cast<int64_t>(seconds) * 1000000, std::memory_order_relaxed);
+    timer_service::get_instance().schedule_in(timer_, 0);
     
-    ESP_LOGI(TAG, "空闲超时时间设置为: %d秒", static_cast<int>(idle_timeout_.count()));
+    ESP_LOGI(TAG, "空闲超时时间设置为: %d秒", seconds);
 }
 
 int pmu::get_idle_timeout() const {
-    return static_cast<int>(idle_timeout_.count());
+    return static_cast<int>(idle_timeout_us_.load(std::memory_order_relaxed) / 1000000);
+}
+
+void pmu::set_activity_grace(int seconds) {
+    if (seconds <= 0) {
+        ESP_LOGW(TAG, "无效的活动宽限时间: %d秒，使用默认值", seconds);
+        seconds = PMU_DEFAULT_ACTIVITY_GRACE;
+    }
+    activity_grace_us_.store(static_cast<int64_t>(seconds) * 1000000, std::memory_order_relaxed);
+    timer_service::get_instance().schedule_in(timer_, 0);
+    
+    ESP_LOGI(TAG, "活动宽限时间设置为: %d秒", seconds);
+}
+
+int pmu::get_activity_grace() const {
+    return static_cast<int>(activity_grace_us_.load(std::memory_order_relaxed) / 1000000);
+}
+
+power_tier pmu::get_tier() const {
+    std::lock_guard<std::mutex> guard(state_mutex_);
+    return policy_.tier();
+}
+
+void pmu::get_tier_stats(power_tier_stats* out) const {
+    std::lock_guard<std::mutex> guard(state_mutex_);
+    policy_.get_stats(esp_timer_get_time(), out);
+}
+
+void pmu::dump() const {
+    int64_t now = esp_timer_get_time();
+    bool suspended;
+    power_tier tier;
+    uint32_t mean_gap_ms;
+    power_tier_stats stats[POWER_TIER_COUNT];
+    {
+        std::lock_guard<std::mutex> guard(state_mutex_);
+        suspended = is_suspended_;
+        tier = policy_.tier();
+        mean_gap_ms = policy_.mean_gap_ms();
+        policy_.get_stats(now, stats);
+    }
+    int64_t activity = last_activity_us_.load(std::memory_order_relaxed);
+    if (activity == 0) {
+        ESP_LOGI(TAG, "电源状态: %s, 挂起%lu次, 还没有活动",
+                 suspended ? "已挂起" : "活跃", (unsigned long)suspend_count_.load(std::memory_order_relaxed));
+    } else {
+        ESP_LOGI(TAG, "电源状态: %s, 挂起%lu次, 活动%lu次, 最近活动: %s %lldms前",
+                 suspended ? "已挂起" : "活跃", (unsigned long)suspend_count_.load(std::memory_order_relaxed),
+                 (unsigned long)activity_count_.load(std::memory_order_relaxed),
+                 activity_name(last_activity_type_.load(std::memory_order_relaxed)),
+                 static_cast<long long>((now - activity) / 1000));
+    }
+    wake_locks::get_instance().dump(TAG);
+    if (!suspended && !wake_locks::get_instance().held()) {
+        int64_t remaining = idle_deadline_us() - now;
+        ESP_LOGI(TAG, "  %lldms后进入低功耗模式", static_cast<long long>(remaining > 0 ? remaining / 1000 : 0));
+    }
+    
+    // 各档位的占空比和电流估算，总平均按时间加权
+    double total_s = 0.0;
+    double charge = 0.0;
+    for (size_t i = 0; i < POWER_TIER_COUNT; i++) {
+        if (stats[i].time_us == 0) {
+            continue;
+        }
+        power_tier t = static_cast<power_tier>(i);
+        double seconds = stats[i].time_us / 1e6;
+        float ma = sleep_policy::estimate_ma(t, stats[i]);
+        total_s += seconds;
+        charge += ma * seconds;
+        ESP_LOGI(TAG, "  档位%s: %.1f秒, 占空比%.1f%%, 估算%.2fmA, 数据%lu次(唤醒%lu次), 进入%lu次",
+                 power_tier_name(t), seconds, 100.0f * sleep_policy::duty_cycle(stats[i]), ma,
+                 (unsigned long)stats[i].events, (unsigned long)stats[i].wakeups, (unsigned long)stats[i].entries);
+    }
+    ESP_LOGI(TAG, "  当前档位%s, 平均到达间隔%lums, 平均电流估算%.2fmA",
+             power_tier_name(tier), (unsigned long)mean_gap_ms, total_s > 0 ? charge / total_s : 0.0);
 }
 
-} // namespace esp_framework 
\ No newline at end of file
+} // namespace esp_framework
@@ -0,0 +1,194 @@
+#include "sleep_policy.h"
+#include <algorithm>
+#include <cstring>
+
+namespace esp_framework {
+
+// ESP32-S3数据手册典型值：射频接收且CPU工作时约90mA，计入偶尔的发射取100mA；
+// 调制解调器睡眠下CPU以80MHz空闲约20mA；轻度睡眠约0.24mA，计入外设取0.3mA
+static constexpr float AWAKE_MA = 100.0f;
+static constexpr float SLEEP_MA[POWER_TIER_COUNT] = {100.0f, 20.0f, 0.3f};
+
+const char* power_tier_name(power_tier tier) {
+    switch (tier) {
+        case power_tier::active:        return "全速";
+        case power_tier::modem_sleep:   return "调制解调器睡眠";
+        case power_tier::light_sleep:   return "轻度睡眠";
+        default:                        return "未知";
+    }
+}
+
+sleep_policy::sleep_policy(const sleep_policy_config& config)
+    : config_(config) {
+    reset(0);
+}
+
+void sleep_policy::reset(int64_t now_us) {
+    memset(gaps_ms_, 0, sizeof(gaps_ms_));
+    gap_count_ = 0;
+    gap_next_ = 0;
+    start_us_ = now_us;
+    last_event_us_ = 0;
+    tier_ = power_tier::active;
+    tier_since_us_ = now_us;
+    light_since_us_ = -1;
+    awake_until_us_ = now_us;
+    memset(stats_, 0, sizeof(stats_));
+    stats_[static_cast<size_t>(tier_)].entries = 1;
+}
+
+bool sleep_policy::on_event(int64_t now_us) {
+    if (last_event_us_ != 0) {
+        int64_t gap_ms = (now_us - last_event_us_) / 1000;
+        gaps_ms_[gap_next_] = static_cast<uint32_t>(std::min<int64_t>(std::max<int64_t>(gap_ms, 0), UINT32_MAX));
+        gap_next_ = (gap_next_ + 1) % SLEEP_POLICY_GAPS;
+        gap_count_ = std::min(gap_count_ + 1, SLEEP_POLICY_GAPS);
+    }
+    last_event_us_ = now_us;
+
+    // 按事件到达时的档位计入唤醒时间，唤醒窗口重叠的部分只计一次
+    power_tier_stats& stats = stats_[static_cast<size_t>(tier_)];
+    stats.events++;
+    if (tier_ != power_tier::active) {
+        int64_t end = now_us + tail_us(tier_);
+        if (now_us >= awake_until_us_) {
+            stats.wakeups++;
+            stats.awake_us += end - now_us;
+        } else if (end > awake_until_us_) {
+            stats.awake_us += end - awake_until_us_;
+        }
+        awake_until_us_ = std::max(awake_until_us_, end);
+    }
+
+    return apply(desired(now_us), now_us);
+}
+
+bool sleep_policy::update(int64_t now_us) {
+    return apply(desired(now_us), now_us);
+}
+
+int64_t sleep_policy::next_update_us(int64_t now_us) const {
+    int64_t next = INT64_MAX;
+    auto consider = [&next, now_us](int64_t t) {
+        if (t > now_us && t < next) {
+            next = t;
+        }
+    };
+    int64_t since = last_event_us_ != 0 ? last_event_us_ : start_us_;
+    consider(since + static_cast<int64_t>(config_.active_gap_ms) * 1000);
+    consider(since + static_cast<int64_t>(config_.light_gap_ms) * 1000);
+    if (light_since_us_ >= 0) {
+        consider(light_since_us_ + static_cast<int64_t>(config_.dwell_ms) * 1000);
+    }
+    consider(awake_until_us_);
+    return next;
+}
+
+bool sleep_policy::holding(int64_t now_us) const {
+    return tier_ == power_tier::light_sleep && now_us < awake_until_us_;
+}
+
+uint32_t sleep_policy::mean_gap_ms() const {
+    if (gap_count_ == 0) {
+        return 0;
+    }
+    uint64_t sum = 0;
+    for (size_t i = 0; i < gap_count_; i++) {
+        sum += gaps_ms_[i];
+    }
+    return static_cast<uint32_t>(sum / gap_count_);
+}
+
+power_tier sleep_policy::desired(int64_t now_us) const {
+    // 没有事件时只看静默时间；流量停止后静默时间超过平均值，按静默时间判断
+    int64_t silence_ms = (now_us - (last_event_us_ != 0 ? last_event_us_ : start_us_)) / 1000;
+    int64_t gap_ms = std::max<int64_t>(mean_gap_ms(), silence_ms);
+    if (gap_count_ == 0 && last_event_us_ != 0) {
+        // 只有一次事件，还不知道到达间隔
+        gap_ms = silence_ms;
+    }
+    if (gap_ms < config_.active_gap_ms) {
+        return power_tier::active;
+    }
+    if (gap_ms < config_.light_gap_ms) {
+        return power_tier::modem_sleep;
+    }
+    return power_tier::light_sleep;
+}
+
+bool sleep_policy::apply(power_tier target, int64_t now_us) {
+    if (target != power_tier::light_sleep) {
+        light_since_us_ = -1;
+    } else if (tier_ != power_tier::light_sleep) {
+        // 进入轻度睡眠须持续满足dwell_ms，等待期间先降到调制解调器睡眠
+        if (light_since_us_ < 0) {
+            light_since_us_ = now_us;
+        }
+        if (now_us - light_since_us_ < static_cast<int64_t>(config_.dwell_ms) * 1000) {
+            target = power_tier::modem_sleep;
+        }
+    }
+    if (target == tier_) {
+        return false;
+    }
+
+    stats_[static_cast<size_t>(tier_)].time_us += now_us - tier_since_us_;
+    tier_ = target;
+    tier_since_us_ = now_us;
+    stats_[static_cast<size_t>(tier_)].entries++;
+    // 切换后的唤醒窗口按新档位重新计算
+    awake_until_us_ = std::min(awake_until_us_, now_us);
+    return true;
+}
+
+uint64_t sleep_policy::beacon_interval_us(power_tier tier) const {
+    switch (tier) {
+        case power_tier::modem_sleep:
+            return DTIM_US;
+        case power_tier::light_sleep:
+            return static_cast<uint64_t>(DTIM_US) * std::max<uint32_t>(config_.listen_interval, 1);
+        default:
+            return 0;
+    }
+}
+
+int64_t sleep_policy::tail_us(power_tier tier) const {
+    if (tier == power_tier::light_sleep) {
+        return static_cast<int64_t>(config_.hold_ms) * 1000;
+    }
+    return static_cast<int64_t>(MODEM_TAIL_MS) * 1000;
+}
+
+void sleep_policy::get_stats(int64_t now_us, power_tier_stats* out) const {
+    memcpy(out, stats_, sizeof(stats_));
+    out[static_cast<size_t>(tier_)].time_us += now_us - tier_since_us_;
+    for (size_t i = 0; i < POWER_TIER_COUNT; i++) {
+        power_tier tier = static_cast<power_tier>(i);
+        uint64_t interval = beacon_interval_us(tier);
+        if (interval == 0) {
+            out[i].awake_us = out[i].time_us;
+            continue;
+        }
+        out[i].awake_us += out[i].time_us / interval * BEACON_US;
+        out[i].awake_us = std::min(out[i].awake_us, out[i].time_us);
+    }
+}
+
+float sleep_policy::awake_ma() {
+    return AWAKE_MA;
+}
+
+float sleep_policy::sleep_ma(power_tier tier) {
+    return SLEEP_MA[static_cast<size_t>(tier)];
+}
+
+float sleep_policy::duty_cycle(const power_tier_stats& stats) {
+    return stats.time_us > 0 ? static_cast<float>(stats.awake_us) / stats.time_us : 0.0f;
+}
+
+float sleep_policy::estimate_ma(power_tier tier, const power_tier_stats& stats) {
+    float duty = duty_cycle(stats);
+    return duty * AWAKE_MA + (1.0f - duty) * sleep_ma(tier);
+}
+
+} // namespace esp_framework
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <sys/uio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "buffer_pool.h"
+
+namespace esp_framework {
+
+/**
+ * 帧格式（变长整数为无符号LEB128，CRC32为小端）：
+ *
+ *   同步字节 0xA5 | 类型 | 负载长度(varint) | 通道(varint) | 帧号(varint) | 负载 | CRC32
+ *
+ * CRC32覆盖类型到负载末尾（不含同步字节），与zlib.crc32()相同。
+ *   data  数据帧，帧号为发送方的帧序号，从1开始连续递增
+ *   ack   累计确认（服务器→设备），帧号为期望的下一帧号，之前的帧均已收到，无负载
+ *   hello 每次连接后设备首先发送，帧号为最早未确认的帧号，负载为4字节会话ID；
+ *         会话ID在每次启动时随机生成，服务器据此区分重连（继续去重）和重启（重新计数）
+ */
+enum class frame_type : uint8_t {
+    data = 0,
+    ack = 1,
+    hello = 2
+};
+
+constexpr uint8_t FRAME_SYNC = 0xA5;
+constexpr size_t FRAME_MAX_HEADER_SIZE = 2 + 3 * 5;     // 同步字节、类型和三个最长5字节的varint
+constexpr size_t FRAME_CRC_SIZE = 4;
+
+/**
+ * @brief 编码无符号LEB128变长整数
+ * @param value 数值
+ * @param out 输出缓冲区，至少5字节
+ * @return 编码后的字节数
+ */
+size_t varint_encode(uint32_t value, uint8_t* out);
+
+/**
+ * @brief 编码帧头
+ * @param out 输出缓冲区，至少FRAME_MAX_HEADER_SIZE字节
+ * @return 帧头字节数
+ */
+size_t frame_encode_header(frame_type type, uint32_t channel, uint32_t seq, size_t length, uint8_t* out);
+
+/**
+ * @brief 计算帧校验值
+ * @param header 帧头（含同步字节）
+ * @param header_size 帧头字节数
+ * @param payload 负载
+ * @param size 负载字节数
+ */
+uint32_t frame_crc(const uint8_t* header, size_t header_size, const uint8_t* payload, size_t size);
+
+/**
+ * @brief 帧协议统计
+ */
+struct frame_protocol_stats {
+    uint32_t next_seq;              // 下一个分配的帧号
+    uint32_t acked_seq;             // 已确认到的帧号（不含）
+    uint32_t in_flight_frames;      // 已发送未确认的帧数
+    uint32_t in_flight_bytes;       // 已发送未确认的负载字节数
+    uint32_t sent_frames;           // 累计发送的数据帧数（不含重传）
+    uint32_t retransmitted_frames;  // 重连后重传的帧数
+    uint32_t acked_frames;          // 累计被确认的帧数
+    uint32_t ack_latency_avg_ms;    // 发送到确认的平均时间
+    uint32_t ack_latency_max_ms;    // 发送到确认的最长时间
+    uint32_t window_full_waits;     // 发送窗口满而等待确认的次数
+    uint32_t rx_frames;             // 收到的有效帧数
+    uint32_t rx_crc_errors;         // 校验失败的帧数
+    uint32_t rx_sync_errors;        // 寻找同步字节时跳过的字节数
+    uint32_t rx_seq_gaps;           // 下行数据帧号不连续的次数
+};
+
+/**
+ * @brief 发送窗口
+ *
+ * 保存已发送未确认的帧（持有负载缓冲区的引用，不复制），收到累计确认后释放。
+ * 帧只在重新连接后重传，TCP连接存续期间由TCP保证可靠传输。
+ *
+ * push()只允许一个任务同时调用（由调用者的发送锁保证），on_ack()可在接收任务中并发调用。
+ */
+class frame_window {
+public:
+    frame_window();
+    ~frame_window();
+
+    /**
+     * @brief 分配窗口
+     * @param slots 最多未确认的帧数
+     * @return 成功返回true
+     */
+    bool init(size_t slots);
+
+    /**
+     * @brief 为负载分配帧号并加入窗口，窗口满时等待确认
+     * @param payload 负载，窗口持有其引用直到被确认
+     * @param channel 通道号
+     * @param wait 最长等待时间
+     * @param iov 输出帧头、负载、CRC三段，帧头和CRC位于窗口中，在下次push()前有效
+     * @return 成功返回true，等待超时返回false
+     */
+    bool push(const pool_buffer& payload, uint32_t channel, TickType_t wait, struct iovec* iov);
+
+    /**
+     * @brief 等待窗口中有空位，之后的一次push()不会再等待
+     *
+     * 用于生成负载有副作用（如更新压缩器的历史窗口）、须先确认能加入窗口的情况。
+     * @param wait 最长等待时间
+     * @return 有空位返回true，等待超时返回false
+     */
+    bool wait_space(TickType_t wait);
+
+    /**
+     * @brief 处理累计确认
+     * @param next_seq 对方期望的下一帧号
+     */
+    void on_ack(uint32_t next_seq);
+
+    /**
+     * @brief 取出从第index个未确认帧开始的帧，用于重连后重传
+     *
+     * 只能在没有并发on_ack()时调用（接收任务尚未启动）。
+     * @param index 起始位置（0为最早的未确认帧）
+     * @param iov 输出，每帧三段
+     * @param max_frames 最多取出的帧数
+     * @return 取出的帧数
+     */
+    size_t collect(size_t index, struct iovec* iov, size_t max_frames);
+
+    /**
+     * @brief 最早未确认的帧号，窗口为空时为下一个分配的帧号
+     */
+    uint32_t oldest_seq() const;
+
+    /**
+     * @brief 记录一次重传的帧数
+     */
+    void add_retransmitted(uint32_t frames);
+
+    /**
+     * @brief 获取窗口统计（接收相关字段为0）
+     */
+    frame_protocol_stats get_stats() const;
+
+    static constexpr size_t SEGMENTS_PER_FRAME = 3;
+
+private:
+    struct entry {
+        uint32_t seq;
+        pool_buffer payload;
+        TickType_t sent_tick;
+        uint8_t header[FRAME_MAX_HEADER_SIZE];
+        uint8_t header_size;
+        uint8_t crc[FRAME_CRC_SIZE];
+    };
+
+    static void fill_iov(entry& e, struct iovec* iov);
+
+    // 持有锁时等待空位
+    bool wait_space(std::unique_lock<std::mutex>& lock, TickType_t wait);
+
+    mutable std::mutex mutex_;
+    SemaphoreHandle_t space_;   // 确认释放空间时给出
+    entry* entries_;
+    size_t slots_;
+    size_t head_;               // 最早未确认帧的位置
+    size_t count_;
+    uint32_t next_seq_;
+    uint32_t in_flight_bytes_;
+
+    uint32_t sent_frames_;
+    uint32_t retransmitted_frames_;
+    uint32_t acked_frames_;
+    uint64_t ack_latency_sum_ms_;
+    uint32_t ack_latency_max_ms_;
+    uint32_t window_full_waits_;
+};
+
+/**
+ * @brief 增量帧解析器
+ *
+ * 按字节流输入，跨越多次输入的帧也能正确解析。长度超限或校验失败时丢弃当前帧，
+ * 从之后的下一个同步字节重新开始。不加锁，只能在一个任务中使用。
+ */
+class frame_parser {
+public:
+    /**
+     * @brief 解析出的帧，负载位于缓冲池缓冲区中，接收者可直接保存引用
+     */
+    struct frame {
+        frame_type type;
+        uint32_t channel;
+        uint32_t seq;
+        pool_buffer payload;
+    };
+
+    /**
+     * @brief 构造函数
+     * @param max_payload 接受的最大负载长度，超过时视为错误帧
+     */
+    explicit frame_parser(size_t max_payload);
+
+    /**
+     * @brief 输入数据，每解析出一个完整帧调用一次回调
+     */
+    void feed(const uint8_t* data, size_t size, const std::function<void(frame&)>& on_frame);
+
+    /**
+     * @brief 丢弃未完成的帧，用于新连接
+     */
+    void reset();
+
+    uint32_t frames() const { return frames_; }
+    uint32_t crc_errors() const { return crc_errors_; }
+    uint32_t sync_errors() const { return sync_errors_; }
+
+private:
+    enum class state {
+        sync,
+        type,
+        length,
+        channel,
+        seq,
+        payload,
+        crc
+    };
+
+    // 读取一个varint字节，完成时返回true
+    bool read_varint(uint8_t byte, uint32_t& value);
+
+    // 丢弃当前帧，重新寻找同步字节
+    void drop_frame();
+
+    size_t max_payload_;
+    state state_;
+    frame current_;
+    uint32_t length_;
+    uint32_t varint_value_;
+    uint8_t varint_shift_;
+    uint32_t crc_;              // 从类型字节开始的累计CRC
+    uint32_t received_;         // 已接收的负载或CRC字节数
+    uint8_t crc_bytes_[FRAME_CRC_SIZE];
+
+    uint32_t frames_;
+    uint32_t crc_errors_;
+    uint32_t sync_errors_;
+};
+
+} // namespace esp_framework
@@ -0,0 +1,348 @@
+#include "frame_protocol.h"
+#include <cstring>
+#include <new>
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+
+static const char* TAG = "FrameProtocol";
+
+namespace esp_framework {
+
+size_t varint_encode(uint32_t value, uint8_t* out) {
+    size_t size = 0;
+    while (value >= 0x80) {
+        out[size++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    out[size++] = static_cast<uint8_t>(value);
+    return size;
+}
+
+size_t frame_encode_header(frame_type type, uint32_t channel, uint32_t seq, size_t length, uint8_t* out) {
+    size_t size = 0;
+    out[size++] = FRAME_SYNC;
+    out[size++] = static_cast<uint8_t>(type);
+    size += varint_encode(static_cast<uint32_t>(length), out + size);
+    size += varint_encode(channel, out + size);
+    size += varint_encode(seq, out + size);
+    return size;
+}
+
+uint32_t frame_crc(const uint8_t* header, size_t header_size, const uint8_t* payload, size_t size) {
+    uint32_t crc = esp_rom_crc32_le(0, header + 1, header_size - 1);
+    return esp_rom_crc32_le(crc, payload, size);
+}
+
+static void store_crc(uint32_t crc, uint8_t* out) {
+    out[0] = static_cast<uint8_t>(crc);
+    out[1] = static_cast<uint8_t>(crc >> 8);
+    out[2] = static_cast<uint8_t>(crc >> 16);
+    out[3] = static_cast<uint8_t>(crc >> 24);
+}
+
+frame_window::frame_window()
+    : space_(nullptr),
+      entries_(nullptr),
+      slots_(0),
+      head_(0),
+      count_(0),
+      next_seq_(1),
+      in_flight_bytes_(0),
+      sent_frames_(0),
+      retransmitted_frames_(0),
+      acked_frames_(0),
+      ack_latency_sum_ms_(0),
+      ack_latency_max_ms_(0),
+      window_full_waits_(0) {
+}
+
+frame_window::~frame_window() {
+    delete[] entries_;
+    if (space_ != nullptr) {
+        vSemaphoreDelete(space_);
+    }
+}
+
+bool frame_window::init(size_t slots) {
+    entries_ = new (std::nothrow) entry[slots];
+    space_ = xSemaphoreCreateBinary();
+    if (entries_ == nullptr || space_ == nullptr) {
+        ESP_LOGE(TAG, "发送窗口分配失败: %zu帧", slots);
+        return false;
+    }
+    slots_ = slots;
+    return true;
+}
+
+void frame_window::fill_iov(entry& e, struct iovec* iov) {
+    iov[0].iov_base = e.header;
+    iov[0].iov_len = e.header_size;
+    iov[1].iov_base = e.payload.data();
+    iov[1].iov_len = e.payload.size();
+    iov[2].iov_base = e.crc;
+    iov[2].iov_len = FRAME_CRC_SIZE;
+}
+
+bool frame_window::wait_space(std::unique_lock<std::mutex>& lock, TickType_t wait) {
+    TickType_t start = xTaskGetTickCount();
+
+    // 窗口满时等待累计确认释放空间
+    if (count_ == slots_) {
+        window_full_waits_++;
+    }
+    while (count_ == slots_) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= wait) {
+            return false;
+        }
+        lock.unlock();
+        xSemaphoreTake(space_, wait - elapsed);
+        lock.lock();
+    }
+    return true;
+}
+
+bool frame_window::wait_space(TickType_t wait) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return wait_space(lock, wait);
+}
+
+bool frame_window::push(const pool_buffer& payload, uint32_t channel, TickType_t wait, struct iovec* iov) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!wait_space(lock, wait)) {
+        return false;
+    }
+
+    entry& e = entries_[(head_ + count_) % slots_];
+    e.seq = next_seq_++;
+    e.payload = payload;
+    e.sent_tick = xTaskGetTickCount();
+    e.header_size = static_cast<uint8_t>(frame_encode_header(frame_type::data, channel, e.seq, payload.size(), e.header));
+    store_crc(frame_crc(e.header, e.header_size, payload.data(), payload.size()), e.crc);
+    count_++;
+    in_flight_bytes_ += static_cast<uint32_t>(payload.size());
+    sent_frames_++;
+
+    fill_iov(e, iov);
+    return true;
+}
+
+void frame_window::on_ack(uint32_t next_seq) {
+    bool released = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        TickType_t now = xTaskGetTickCount();
+
+        // 按序列号差值比较，帧号回绕后仍然正确；确认号不会超过已分配的帧号
+        if (static_cast<int32_t>(next_seq - next_seq_) > 0) {
+            ESP_LOGW(TAG, "确认号%lu超过已发送的帧号%lu", (unsigned long)next_seq, (unsigned long)next_seq_);
+            next_seq = next_seq_;
+        }
+        while (count_ > 0 && static_cast<int32_t>(entries_[head_].seq - next_seq) < 0) {
+            entry& e = entries_[head_];
+            uint32_t latency = (now - e.sent_tick) * portTICK_PERIOD_MS;
+            ack_latency_sum_ms_ += latency;
+            if (latency > ack_latency_max_ms_) {
+                ack_latency_max_ms_ = latency;
+            }
+            in_flight_bytes_ -= static_cast<uint32_t>(e.payload.size());
+            e.payload.reset();
+            head_ = (head_ + 1) % slots_;
+            count_--;
+            acked_frames_++;
+            released = true;
+        }
+    }
+
+    if (released) {
+        xSemaphoreGive(space_);
+    }
+}
+
+size_t frame_window::collect(size_t index, struct iovec* iov, size_t max_frames) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TickType_t now = xTaskGetTickCount();
+    size_t frames = 0;
+    while (index + frames < count_ && frames < max_frames) {
+        entry& e = entries_[(head_ + index + frames) % slots_];
+        e.sent_tick = now;
+        fill_iov(e, iov + frames * SEGMENTS_PER_FRAME);
+        frames++;
+    }
+    return frames;
+}
+
+uint32_t frame_window::oldest_seq() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_ > 0 ? entries_[head_].seq : next_seq_;
+}
+
+void frame_window::add_retransmitted(uint32_t frames) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    retransmitted_frames_ += frames;
+}
+
+frame_protocol_stats frame_window::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frame_protocol_stats stats = {};
+    stats.next_seq = next_seq_;
+    stats.acked_seq = count_ > 0 ? entries_[head_].seq : next_seq_;
+    stats.in_flight_frames = static_cast<uint32_t>(count_);
+    stats.in_flight_bytes = in_flight_bytes_;
+    stats.sent_frames = sent_frames_;
+    stats.retransmitted_frames = retransmitted_frames_;
+    stats.acked_frames = acked_frames_;
+    stats.ack_latency_avg_ms = acked_frames_ > 0 ? static_cast<uint32_t>(ack_latency_sum_ms_ / acked_frames_) : 0;
+    stats.ack_latency_max_ms = ack_latency_max_ms_;
+    stats.window_full_waits = window_full_waits_;
+    return stats;
+}
+
+frame_parser::frame_parser(size_t max_payload)
+    : max_payload_(max_payload),
+      state_(state::sync),
+      current_(),
+      length_(0),
+      varint_value_(0),
+      varint_shift_(0),
+      crc_(0),
+      received_(0),
+      crc_bytes_(),
+      frames_(0),
+      crc_errors_(0),
+      sync_errors_(0) {
+}
+
+void frame_parser::reset() {
+    current_.payload.reset();
+    state_ = state::sync;
+}
+
+void frame_parser::drop_frame() {
+    current_.payload.reset();
+    state_ = state::sync;
+}
+
+bool frame_parser::read_varint(uint8_t byte, uint32_t& value) {
+    varint_value_ |= static_cast<uint32_t>(byte & 0x7F) << varint_shift_;
+    varint_shift_ += 7;
+    if (byte & 0x80) {
+        return false;
+    }
+    value = varint_value_;
+    varint_value_ = 0;
+    varint_shift_ = 0;
+    return true;
+}
+
+void frame_parser::feed(const uint8_t* data, size_t size, const std::function<void(frame&)>& on_frame) {
+    size_t pos = 0;
+    while (pos < size) {
+        // 负载整段复制
+        if (state_ == state::payload) {
+            size_t len = size - pos < length_ - received_ ? size - pos : length_ - received_;
+            memcpy(current_.payload.data() + received_, data + pos, len);
+            crc_ = esp_rom_crc32_le(crc_, data + pos, len);
+            received_ += static_cast<uint32_t>(len);
+            pos += len;
+            if (received_ == length_) {
+                received_ = 0;
+                state_ = state::crc;
+            }
+            continue;
+        }
+
+        uint8_t byte = data[pos++];
+        if (state_ != state::sync && state_ != state::crc) {
+            crc_ = esp_rom_crc32_le(crc_, &byte, 1);
+        }
+
+        switch (state_) {
+            case state::sync:
+                if (byte == FRAME_SYNC) {
+                    crc_ = 0;
+                    varint_value_ = 0;
+                    varint_shift_ = 0;
+                    state_ = state::type;
+                } else {
+                    sync_errors_++;
+                }
+                break;
+
+            case state::type:
+                if (byte > static_cast<uint8_t>(frame_type::hello)) {
+                    drop_frame();
+                    break;
+                }
+                current_.type = static_cast<frame_type>(byte);
+                state_ = state::length;
+                break;
+
+            case state::length:
+                if (varint_shift_ > 28) {
+                    drop_frame();
+                } else if (read_varint(byte, length_)) {
+                    if (length_ > max_payload_) {
+                        ESP_LOGW(TAG, "帧负载过长: %lu字节", (unsigned long)length_);
+                        drop_frame();
+                    } else {
+                        state_ = state::channel;
+                    }
+                }
+                break;
+
+            case state::channel:
+                if (varint_shift_ > 28) {
+                    drop_frame();
+                } else if (read_varint(byte, current_.channel)) {
+                    state_ = state::seq;
+                }
+                break;
+
+            case state::seq:
+                if (varint_shift_ > 28) {
+                    drop_frame();
+                } else if (read_varint(byte, current_.seq)) {
+                    received_ = 0;
+                    if (length_ == 0) {
+                        current_.payload.reset();
+                        state_ = state::crc;
+                        break;
+                    }
+                    current_.payload = buffer_pool::get_instance().acquire(length_);
+                    if (!current_.payload) {
+                        ESP_LOGW(TAG, "内存不足，丢弃%lu字节的帧", (unsigned long)length_);
+                        drop_frame();
+                        break;
+                    }
+                    current_.payload.set_size(length_);
+                    state_ = state::payload;
+                }
+                break;
+
+            case state::crc:
+                crc_bytes_[received_++] = byte;
+                if (received_ < FRAME_CRC_SIZE) {
+                    break;
+                }
+                received_ = 0;
+                if ((crc_bytes_[0] | (crc_bytes_[1] << 8) | (crc_bytes_[2] << 16) |
+                     (static_cast<uint32_t>(crc_bytes_[3]) << 24)) != crc_) {
+                    crc_errors_++;
+                    drop_frame();
+                    break;
+                }
+                frames_++;
+                state_ = state::sync;
+                on_frame(current_);
+                current_.payload.reset();
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+} // namespace esp_framework
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "event_system.h"
+#include "buffer_pool.h"
+#include "flash_spool.h"
+
+namespace esp_framework {
+
+/**
+ * @brief 缓存满时的处理策略
+ */
+enum class overflow_policy {
+    drop_oldest,    // 丢弃最早缓存的数据，保留最新数据
+    drop_newest     // 丢弃新到达的数据，保留最早数据
+};
+
+/**
+ * @brief submit()的处理结果
+ */
+enum class submit_result {
+    live,       // TCP已连接，直接放入上行队列
+    stored,     // TCP未连接，已缓存等待重放
+    dropped     // 未能转发也未能缓存
+};
+
+/**
+ * @brief 存储转发统计
+ */
+struct store_forward_stats {
+    uint32_t buffered_bytes;        // 当前缓存的字节数（RAM + PSRAM + 闪存）
+    uint32_t peak_buffered_bytes;   // 缓存字节数峰值
+    uint32_t ram_bytes;             // 当前RAM中缓存的字节数
+    uint32_t psram_bytes;           // 当前PSRAM中缓存的字节数
+    uint32_t flash_bytes;           // 当前闪存中未读记录占用的字节数（含记录头）
+    uint32_t records;               // 当前内存中缓存的数据块数
+    uint32_t stored_bytes;          // 累计缓存的字节数
+    uint32_t replayed_bytes;        // 累计重放的字节数
+    uint32_t dropped_bytes;         // 累计因缓存满丢弃的字节数
+};
+
+/**
+ * @brief 变长记录环形缓冲区
+ *
+ * 每条记录为2字节长度加数据，按先进先出顺序存取，记录可跨越缓冲区末尾。
+ * 不加锁，由store_forward串行访问。
+ */
+class record_ring {
+public:
+    record_ring();
+    ~record_ring();
+
+    /**
+     * @brief 分配存储空间
+     * @param capacity 容量（字节，含记录头）
+     * @param caps heap_caps_malloc()内存属性
+     * @return 成功返回true，失败返回false
+     */
+    bool init(size_t capacity, uint32_t caps);
+
+    /**
+     * @brief 追加一条记录
+     * @return 空间不足返回false
+     */
+    bool push(const uint8_t* data, size_t size);
+
+    /**
+     * @brief 最早一条记录的数据长度，为空时返回0
+     */
+    size_t front_size() const;
+
+    /**
+     * @brief 复制最早一条记录的数据
+     * @param dest 目标缓冲区，至少front_size()字节
+     */
+    void copy_front(uint8_t* dest) const;
+
+    /**
+     * @brief 移除最早一条记录
+     * @return 被移除记录的数据长度
+     */
+    size_t pop();
+
+    /**
+     * @brief 能否容纳size字节的记录
+     */
+    bool fits(size_t size) const { return record_bytes(size) <= capacity_ - used_; }
+
+    bool empty() const { return records_ == 0; }
+    size_t capacity() const { return capacity_; }
+    size_t data_bytes() const { return used_ - records_ * HEADER_SIZE; }
+    size_t records() const { return records_; }
+
+    static constexpr size_t HEADER_SIZE = 2;
+    static constexpr size_t MAX_RECORD = 0xFFFF;
+
+private:
+    static size_t record_bytes(size_t size) { return size + HEADER_SIZE; }
+
+    // 环形读写，处理跨越末尾
+    void write_at(size_t pos, const uint8_t* src, size_t len);
+    void read_at(size_t pos, uint8_t* dest, size_t len) const;
+
+    uint8_t* mem_;
+    size_t capacity_;
+    size_t head_;       // 最早记录的位置
+    size_t used_;       // 已用字节（含记录头）
+    size_t records_;
+};
+
+/**
+ * @brief 上行存储转发（单例模式）
+ *
+ * 位于网络模块之前：TCP已连接时数据直接放入上行队列，断开期间复制到RAM缓存，
+ * 断开时上行队列中尚未发送的数据也交还缓存，
+ * RAM满后溢出到PSRAM（如果配置），内存缓存满后再溢出到闪存缓存（如果配置），
+ * 重新连接后由重放任务按原顺序限速发送。
+ * 重放只在上行队列空闲时进行，实时数据优先，因此重放数据与实时数据在TCP流中可能交错。
+ *
+ * 闪存中有数据时新数据只追加到闪存，保持RAM、PSRAM、闪存依次由旧到新。
+ * 闪存中的数据在重启后保留，连接后继续重放；进入深度睡眠前内存中的数据也会写入闪存。
+ * 使用闪存缓存时，丢弃最早策略以段为单位丢弃闪存中最早的数据。
+ */
+class store_forward : public event_listener {
+public:
+    /**
+     * @brief 获取存储转发实例
+     * @return 存储转发引用
+     */
+    static store_forward& get_instance();
+
+    /**
+     * @brief 分配缓存并创建重放任务，应在启动时调用一次
+     * @return 成功返回true，失败返回false
+     */
+    bool init();
+
+    /**
+     * @brief 提交一块上行数据
+     *
+     * 只允许一个任务（UART接收任务）调用，与network_module::enqueue_uplink()相同。
+     * @param buffer 缓冲区句柄
+     * @return 处理结果
+     */
+    submit_result submit(const pool_buffer& buffer);
+
+    /**
+     * @brief 缓存上行队列中未能发送的数据，重新连接后重放
+     *
+     * 由网络模块在TCP发送任务中调用（network_module::set_unsent_callback()），
+     * 断开前已进入上行队列的数据按原顺序交还，submit()在此期间把新数据排在它们之后。
+     * @param buffer 缓冲区句柄
+     * @return 成功缓存返回true，缓存满且按策略丢弃新数据时返回false
+     */
+    bool requeue(const pool_buffer& buffer);
+
+    /**
+     * @brief 设置缓存满时的处理策略，运行时生效
+     */
+    void set_overflow_policy(overflow_policy policy);
+
+    /**
+     * @brief 设置重放速率上限
+     * @param bytes_per_second 每秒字节数，0表示不限速
+     */
+    void set_replay_rate(uint32_t bytes_per_second);
+
+    /**
+     * @brief 获取统计信息
+     * @return 统计信息
+     */
+    store_forward_stats get_stats() const;
+
+    /**
+     * @brief 事件处理函数
+     * @param event 事件数据
+     */
+    void on_event(const event_data& event) override;
+
+private:
+    store_forward();
+    ~store_forward() = default;
+
+    // 禁止复制和移动
+    store_forward(const store_forward&) = delete;
+    store_forward& operator=(const store_forward&) = delete;
+    store_forward(store_forward&&) = delete;
+    store_forward& operator=(store_forward&&) = delete;
+
+    // 重放任务
+    static void replay_task(void* pvParameters);
+
+    // 缓存一个缓冲区，超过单条记录上限时分段，并唤醒重放任务
+    bool store_buffer(const pool_buffer& buffer);
+
+    // 缓存一块数据，按策略处理溢出
+    bool store(const uint8_t* data, size_t size);
+
+    // 移除最早一条记录（调用者持有锁）
+    size_t pop_oldest();
+
+    // 把PSRAM中最早的记录移入RAM，保持RAM中总是最早的数据（调用者持有锁）
+    void rebalance();
+
+    // 把内存中的数据按顺序写入闪存并保存读取位置，用于深度睡眠前
+    void persist();
+
+    // 读取最早一条记录，返回其序号
+    bool peek(pool_buffer& out, uint32_t& seq);
+
+    // 重放成功后移除记录，期间已被溢出策略丢弃则忽略
+    void consume(uint32_t seq);
+
+    void update_peak();
+
+    mutable std::mutex mutex_;      // 保护两级缓存
+    record_ring ram_;
+    record_ring psram_;
+    flash_spool* spool_;            // 闪存缓存，未配置或初始化失败时为nullptr
+    size_t max_record_;             // 单条记录的最大长度
+    uint32_t head_seq_;             // 最早记录的序号，移除或丢弃最早记录时递增
+    bool initialized_;
+    TaskHandle_t task_handle_;
+    std::shared_ptr<event_listener> listener_ref_;  // 保持事件订阅有效
+
+    std::atomic<overflow_policy> policy_;
+    std::atomic<uint32_t> replay_rate_;
+    std::atomic<uint32_t> peak_bytes_;
+    std::atomic<uint32_t> stored_bytes_;
+    std::atomic<uint32_t> replayed_bytes_;
+    std::atomic<uint32_t> dropped_bytes_;
+};
+
+} // namespace esp_framework
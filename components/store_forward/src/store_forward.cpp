@@ -0,0 +1,522 @@
+#include "store_forward.h"
+#include <cstring>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include "network_module.h"
+
+static const char* TAG = "StoreForward";
+
+// 缓存容量
+#define STORE_FORWARD_RAM_SIZE CONFIG_STORE_FORWARD_RAM_SIZE
+#if CONFIG_SPIRAM && defined(CONFIG_STORE_FORWARD_PSRAM_SIZE)
+#define STORE_FORWARD_PSRAM_SIZE CONFIG_STORE_FORWARD_PSRAM_SIZE
+#else
+#define STORE_FORWARD_PSRAM_SIZE 0
+#endif
+
+// 闪存缓存分区
+#if CONFIG_FLASH_SPOOL_ENABLE
+#define FLASH_SPOOL_PARTITION_LABEL CONFIG_FLASH_SPOOL_PARTITION_LABEL
+#endif
+
+// 重放任务栈大小和优先级（低于TCP发送任务，实时数据优先）
+#define REPLAY_TASK_STACK_SIZE 4096
+#define REPLAY_TASK_PRIORITY 4
+
+// 断开期间有缓存数据时检查连接状态的间隔，连接建立事件被丢弃时最迟在此时间后开始重放
+#define REPLAY_CONNECT_CHECK_MS 1000
+
+// 上行队列积压超过低水位线时暂停重放
+#define REPLAY_LIVE_THRESHOLD (CONFIG_UPLINK_RING_SIZE * CONFIG_UPLINK_LOW_WATERMARK / 100)
+
+// 搬移记录时的临时缓冲区大小
+#define TRANSFER_CHUNK_SIZE 128
+
+namespace esp_framework {
+
+record_ring::record_ring()
+    : mem_(nullptr),
+      capacity_(0),
+      head_(0),
+      used_(0),
+      records_(0) {
+}
+
+record_ring::~record_ring() {
+    if (mem_ != nullptr) {
+        heap_caps_free(mem_);
+    }
+}
+
+bool record_ring::init(size_t capacity, uint32_t caps) {
+    mem_ = static_cast<uint8_t*>(heap_caps_malloc(capacity, caps));
+    if (mem_ == nullptr) {
+        return false;
+    }
+    capacity_ = capacity;
+    head_ = 0;
+    used_ = 0;
+    records_ = 0;
+    return true;
+}
+
+void record_ring::write_at(size_t pos, const uint8_t* src, size_t len) {
+    pos %= capacity_;
+    size_t first = capacity_ - pos < len ? capacity_ - pos : len;
+    memcpy(mem_ + pos, src, first);
+    memcpy(mem_, src + first, len - first);
+}
+
+void record_ring::read_at(size_t pos, uint8_t* dest, size_t len) const {
+    pos %= capacity_;
+    size_t first = capacity_ - pos < len ? capacity_ - pos : len;
+    memcpy(dest, mem_ + pos, first);
+    memcpy(dest + first, mem_, len - first);
+}
+
+bool record_ring::push(const uint8_t* data, size_t size) {
+    if (size == 0 || size > MAX_RECORD || !fits(size)) {
+        return false;
+    }
+
+    size_t tail = head_ + used_;
+    uint8_t header[HEADER_SIZE] = { static_cast<uint8_t>(size & 0xFF), static_cast<uint8_t>(size >> 8) };
+    write_at(tail, header, HEADER_SIZE);
+    write_at(tail + HEADER_SIZE, data, size);
+    used_ += record_bytes(size);
+    records_++;
+    return true;
+}
+
+size_t record_ring::front_size() const {
+    if (records_ == 0) {
+        return 0;
+    }
+    uint8_t header[HEADER_SIZE];
+    read_at(head_, header, HEADER_SIZE);
+    return header[0] | (static_cast<size_t>(header[1]) << 8);
+}
+
+void record_ring::copy_front(uint8_t* dest) const {
+    read_at(head_ + HEADER_SIZE, dest, front_size());
+}
+
+size_t record_ring::pop() {
+    size_t size = front_size();
+    if (records_ == 0) {
+        return 0;
+    }
+    head_ = (head_ + record_bytes(size)) % capacity_;
+    used_ -= record_bytes(size);
+    records_--;
+    if (records_ == 0) {
+        head_ = 0;
+        used_ = 0;
+    }
+    return size;
+}
+
+store_forward& store_forward::get_instance() {
+    static store_forward instance;
+    return instance;
+}
+
+store_forward::store_forward()
+    : spool_(nullptr),
+      max_record_(record_ring::MAX_RECORD),
+      head_seq_(0),
+      initialized_(false),
+      task_handle_(nullptr),
+#if CONFIG_STORE_FORWARD_DROP_NEWEST
+      policy_(overflow_policy::drop_newest),
+#else
+      policy_(overflow_policy::drop_oldest),
+#endif
+      replay_rate_(CONFIG_STORE_FORWARD_REPLAY_RATE),
+      peak_bytes_(0),
+      stored_bytes_(0),
+      replayed_bytes_(0),
+      dropped_bytes_(0) {
+}
+
+bool store_forward::init() {
+    if (initialized_) {
+        ESP_LOGW(TAG, "存储转发已经初始化");
+        return true;
+    }
+
+    if (STORE_FORWARD_RAM_SIZE == 0) {
+        ESP_LOGI(TAG, "未配置缓存，TCP断开期间的数据将被丢弃");
+        return true;
+    }
+
+    if (!ram_.init(STORE_FORWARD_RAM_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)) {
+        ESP_LOGE(TAG, "RAM缓存分配失败: %d字节", STORE_FORWARD_RAM_SIZE);
+        return false;
+    }
+
+    // PSRAM分配失败时只使用RAM缓存
+    if (STORE_FORWARD_PSRAM_SIZE > 0 &&
+        !psram_.init(STORE_FORWARD_PSRAM_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)) {
+        ESP_LOGW(TAG, "PSRAM缓存分配失败: %d字节，只使用RAM缓存", STORE_FORWARD_PSRAM_SIZE);
+    }
+
+#ifdef FLASH_SPOOL_PARTITION_LABEL
+    // 读取位置保存在NVS中，NVS由网络模块构造时初始化
+    network_module::get_instance();
+
+    // 闪存缓存不可用时只使用内存缓存
+    static flash_spool spool(FLASH_SPOOL_PARTITION_LABEL);
+    if (spool.init()) {
+        spool_ = &spool;
+        if (spool.max_record_size() < max_record_) {
+            max_record_ = spool.max_record_size();
+        }
+    } else {
+        ESP_LOGW(TAG, "闪存缓存不可用，只使用内存缓存");
+    }
+#endif
+
+    if (xTaskCreate(replay_task, "sf_replay", REPLAY_TASK_STACK_SIZE, this,
+                    REPLAY_TASK_PRIORITY, &task_handle_) != pdPASS) {
+        ESP_LOGE(TAG, "重放任务创建失败");
+        task_handle_ = nullptr;
+        return false;
+    }
+
+    // 连接建立时立即开始重放 - 由于是单例，不应该被shared_ptr删除；
+    // 事件总线只保存弱引用，由成员持有该shared_ptr，否则订阅随即失效
+    listener_ref_ = std::shared_ptr<event_listener>(this, [](event_listener*){});
+    event_bus::get_instance().subscribe(event_type::tcp_state_changed, listener_ref_);
+    event_bus::get_instance().subscribe(event_type::enter_deep_sleep, listener_ref_);
+
+    // TCP断开（包括切换服务器）时上行队列中未发送的数据交还缓存
+    network_module::get_instance().set_unsent_callback([this](const pool_buffer& buffer) {
+        return requeue(buffer);
+    });
+
+    initialized_ = true;
+    uint32_t spool_capacity = 0;
+    if (spool_ != nullptr) {
+        flash_spool_stats spool_stats = spool_->get_stats();
+        spool_capacity = spool_stats.segments * spool_stats.segment_size;
+    }
+    ESP_LOGI(TAG, "存储转发初始化完成: RAM %lu字节, PSRAM %lu字节, 闪存 %lu字节, 溢出策略: %s, 重放速率: %lu字节/秒",
+             (unsigned long)ram_.capacity(), (unsigned long)psram_.capacity(),
+             (unsigned long)spool_capacity,
+             policy_ == overflow_policy::drop_oldest ? "丢弃最早" : "丢弃最新",
+             (unsigned long)replay_rate_.load());
+    return true;
+}
+
+submit_result store_forward::submit(const pool_buffer& buffer) {
+    auto& network = network_module::get_instance();
+    bool connected = network.is_tcp_connected();
+
+    // 断开后上行队列中还有数据时，它们比新数据早，由TCP发送任务依次交还缓存（requeue()），
+    // 新数据排在其后进入队列以保持顺序；队列已满时直接缓存
+    if (connected || (initialized_ && network.get_uplink_stats().queued_bytes > 0)) {
+        if (network.enqueue_uplink(buffer)) {
+            return connected ? submit_result::live : submit_result::stored;
+        }
+        if (connected) {
+            return submit_result::dropped;
+        }
+    }
+
+    if (!initialized_) {
+        return submit_result::dropped;
+    }
+    return store_buffer(buffer) ? submit_result::stored : submit_result::dropped;
+}
+
+bool store_forward::requeue(const pool_buffer& buffer) {
+    return store_buffer(buffer);
+}
+
+bool store_forward::store_buffer(const pool_buffer& buffer) {
+    // 超过单条记录上限的数据分段缓存
+    const uint8_t* data = buffer.data();
+    size_t remaining = buffer.size();
+    bool stored = true;
+    while (remaining > 0) {
+        size_t len = remaining < max_record_ ? remaining : max_record_;
+        stored = store(data, len) && stored;
+        data += len;
+        remaining -= len;
+    }
+    // 唤醒等待中的重放任务，未连接时它会继续等待连接建立
+    if (task_handle_ != nullptr) {
+        xTaskNotifyGive(task_handle_);
+    }
+    return stored;
+}
+
+bool store_forward::store(const uint8_t* data, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    while (1) {
+        // PSRAM中有数据时新数据只能追加到PSRAM，闪存中有数据时只能追加到闪存，
+        // 保持RAM中总是最早的数据
+        bool spooling = spool_ != nullptr && !spool_->empty();
+        if (!spooling && psram_.empty() && ram_.push(data, size)) {
+            break;
+        }
+        if (!spooling && psram_.push(data, size)) {
+            break;
+        }
+
+        // 内存缓存已满，写入闪存，闪存满时由闪存缓存按策略丢弃
+        if (spool_ != nullptr) {
+            uint32_t spool_dropped = spool_->get_stats().dropped_bytes;
+            bool appended = spool_->append(data, size, policy_ == overflow_policy::drop_oldest);
+            if (spool_->get_stats().dropped_bytes != spool_dropped) {
+                // 最早的记录可能已被丢弃，使进行中的重放不再移除记录
+                head_seq_++;
+            }
+            if (!appended) {
+                ESP_LOGD(TAG, "闪存缓存已满，丢弃新数据 %zu 字节", size);
+                return false;
+            }
+            break;
+        }
+
+        // 缓存已满
+        if (policy_ == overflow_policy::drop_newest || (ram_.empty() && psram_.empty())) {
+            dropped_bytes_.fetch_add(size, std::memory_order_relaxed);
+            ESP_LOGD(TAG, "缓存已满，丢弃新数据 %zu 字节", size);
+            return false;
+        }
+        size_t dropped = pop_oldest();
+        dropped_bytes_.fetch_add(dropped, std::memory_order_relaxed);
+        ESP_LOGD(TAG, "缓存已满，丢弃最早数据 %zu 字节", dropped);
+    }
+
+    stored_bytes_.fetch_add(size, std::memory_order_relaxed);
+    update_peak();
+    return true;
+}
+
+size_t store_forward::pop_oldest() {
+    size_t size = 0;
+    if (!ram_.empty()) {
+        size = ram_.pop();
+    } else if (!psram_.empty()) {
+        size = psram_.pop();
+    } else if (spool_ != nullptr) {
+        size = spool_->pop();
+    }
+    head_seq_++;
+    rebalance();
+    return size;
+}
+
+void store_forward::rebalance() {
+    uint8_t chunk[TRANSFER_CHUNK_SIZE];
+    while (!psram_.empty() && ram_.fits(psram_.front_size())) {
+        size_t size = psram_.front_size();
+        if (size <= sizeof(chunk)) {
+            psram_.copy_front(chunk);
+            ram_.push(chunk, size);
+        } else {
+            pool_buffer temp = buffer_pool::get_instance().acquire(size);
+            if (!temp) {
+                return;
+            }
+            psram_.copy_front(temp.data());
+            ram_.push(temp.data(), size);
+        }
+        psram_.pop();
+    }
+}
+
+void store_forward::update_peak() {
+    uint32_t buffered = static_cast<uint32_t>(ram_.data_bytes() + psram_.data_bytes());
+    if (spool_ != nullptr) {
+        buffered += spool_->get_stats().pending_bytes;
+    }
+    if (buffered > peak_bytes_.load(std::memory_order_relaxed)) {
+        peak_bytes_.store(buffered, std::memory_order_relaxed);
+    }
+}
+
+bool store_forward::peek(pool_buffer& out, uint32_t& seq) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!ram_.empty() || !psram_.empty()) {
+        record_ring& ring = !ram_.empty() ? ram_ : psram_;
+        size_t size = ring.front_size();
+        out = buffer_pool::get_instance().acquire(size);
+        if (!out) {
+            return false;
+        }
+        ring.copy_front(out.data());
+        out.set_size(size);
+        seq = head_seq_;
+        return true;
+    }
+
+    // 校验失败的记录已被闪存缓存跳过，继续读取下一条
+    while (spool_ != nullptr) {
+        size_t size = spool_->front_size();
+        if (size == 0) {
+            return false;
+        }
+        out = buffer_pool::get_instance().acquire(size);
+        if (!out) {
+            return false;
+        }
+        if (spool_->read_front(out.data())) {
+            out.set_size(size);
+            seq = head_seq_;
+            return true;
+        }
+    }
+    return false;
+}
+
+void store_forward::persist() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (spool_ == nullptr) {
+        return;
+    }
+
+    // 闪存中有数据时内存中没有数据，因此按顺序追加即可保持顺序
+    uint32_t moved = 0;
+    while (!ram_.empty() || !psram_.empty()) {
+        record_ring& ring = !ram_.empty() ? ram_ : psram_;
+        size_t size = ring.front_size();
+        pool_buffer temp = buffer_pool::get_instance().acquire(size);
+        if (!temp) {
+            break;
+        }
+        ring.copy_front(temp.data());
+        if (!spool_->append(temp.data(), size, false)) {
+            break;
+        }
+        ring.pop();
+        moved += size;
+    }
+    spool_->commit_cursor();
+    if (moved > 0) {
+        ESP_LOGI(TAG, "已将内存中的%lu字节写入闪存缓存", (unsigned long)moved);
+    }
+}
+
+void store_forward::consume(uint32_t seq) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (seq == head_seq_) {
+        pop_oldest();
+    }
+}
+
+void store_forward::replay_task(void* pvParameters) {
+    store_forward* self = static_cast<store_forward*>(pvParameters);
+    auto& network = network_module::get_instance();
+    uint64_t owed_us = 0;   // 尚未通过延时偿还的发送时间
+    const uint64_t tick_us = 1000ULL * portTICK_PERIOD_MS;
+
+    ESP_LOGI(TAG, "重放任务已启动");
+
+    while (1) {
+        // 连接建立时由on_event()唤醒。该事件经event_bus::post()投递，队列满时会被丢弃，
+        // 因此有缓存数据时按间隔重新检查连接状态；没有数据时由submit()/requeue()唤醒
+        if (!network.is_tcp_connected()) {
+            owed_us = 0;
+            ulTaskNotifyTake(pdTRUE, self->get_stats().buffered_bytes > 0 ?
+                                     pdMS_TO_TICKS(REPLAY_CONNECT_CHECK_MS) : portMAX_DELAY);
+            continue;
+        }
+
+        // 上行队列有积压时让实时数据先发送
+        if (network.get_uplink_stats().queued_bytes > REPLAY_LIVE_THRESHOLD) {
+            vTaskDelay(pdMS_TO_TICKS(5));
+            continue;
+        }
+
+        pool_buffer buffer;
+        uint32_t seq = 0;
+        if (!self->peek(buffer, seq)) {
+            // 缓存为空时等待submit()缓存新数据；缓冲池暂时耗尽时稍后重试
+            if (self->get_stats().buffered_bytes > 0) {
+                vTaskDelay(pdMS_TO_TICKS(100));
+            } else {
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            }
+            continue;
+        }
+
+        // 发送失败时记录保留在缓存中，重新连接后再次发送
+        if (!network.send_data(buffer)) {
+            vTaskDelay(pdMS_TO_TICKS(100));
+            continue;
+        }
+        self->consume(seq);
+        self->replayed_bytes_.fetch_add(buffer.size(), std::memory_order_relaxed);
+
+        // 按重放速率限速
+        uint32_t rate = self->replay_rate_.load(std::memory_order_relaxed);
+        if (rate > 0) {
+            owed_us += static_cast<uint64_t>(buffer.size()) * 1000000 / rate;
+            if (owed_us >= tick_us) {
+                TickType_t ticks = static_cast<TickType_t>(owed_us / tick_us);
+                owed_us -= ticks * tick_us;
+                vTaskDelay(ticks);
+            }
+        }
+    }
+}
+
+void store_forward::set_overflow_policy(overflow_policy policy) {
+    policy_ = policy;
+    ESP_LOGI(TAG, "溢出策略: %s", policy == overflow_policy::drop_oldest ? "丢弃最早" : "丢弃最新");
+}
+
+void store_forward::set_replay_rate(uint32_t bytes_per_second) {
+    replay_rate_ = bytes_per_second;
+    ESP_LOGI(TAG, "重放速率: %lu字节/秒", (unsigned long)bytes_per_second);
+}
+
+store_forward_stats store_forward::get_stats() const {
+    store_forward_stats stats;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.ram_bytes = static_cast<uint32_t>(ram_.data_bytes());
+        stats.psram_bytes = static_cast<uint32_t>(psram_.data_bytes());
+        stats.records = static_cast<uint32_t>(ram_.records() + psram_.records());
+        stats.flash_bytes = 0;
+        stats.dropped_bytes = dropped_bytes_.load(std::memory_order_relaxed);
+        if (spool_ != nullptr) {
+            flash_spool_stats spool_stats = spool_->get_stats();
+            stats.flash_bytes = spool_stats.pending_bytes;
+            stats.dropped_bytes += spool_stats.dropped_bytes;
+        }
+    }
+    stats.buffered_bytes = stats.ram_bytes + stats.psram_bytes + stats.flash_bytes;
+    stats.peak_buffered_bytes = peak_bytes_.load(std::memory_order_relaxed);
+    stats.stored_bytes = stored_bytes_.load(std::memory_order_relaxed);
+    stats.replayed_bytes = replayed_bytes_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void store_forward::on_event(const event_data& event) {
+    switch (event.type) {
+        case event_type::tcp_state_changed:
+            if (static_cast<connection_state>(event.as_integer()) == connection_state::connected &&
+                task_handle_ != nullptr) {
+                xTaskNotifyGive(task_handle_);
+            }
+            break;
+
+        case event_type::enter_deep_sleep:
+            // 内存中的数据在深度睡眠后丢失，先写入闪存
+            persist();
+            break;
+
+        default:
+            break;
+    }
+}
+
+} // namespace esp_framework
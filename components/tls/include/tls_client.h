@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <sys/uio.h>
+#include "mbedtls/ssl.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/x509_crt.h"
+
+namespace esp_framework {
+
+/**
+ * @brief 一次握手的结果
+ */
+struct tls_handshake_result {
+    bool resumed;               // 以会话票据恢复（服务器未发送证书）
+    uint32_t elapsed_ms;        // 握手总耗时
+    uint32_t compute_ms;        // 扣除等待服务器数据后的耗时，近似本地运算时间
+    uint32_t bytes;             // 握手期间收发的字节数
+};
+
+/**
+ * @brief 基于mbedTLS的TLS客户端，运行在调用者建立的TCP套接字上
+ *
+ * 只使用TLS 1.2，会话票据（RFC 5077）在握手完成后保存在RTC内存中，
+ * 软件复位和深度睡眠后仍然有效，下次握手时出示票据以省去证书验证和密钥交换。
+ * 服务器拒绝票据时自动退回完整握手。CA证书在构建时由TLS_CA_CERT_FILE嵌入。
+ *
+ * 一个任务读、另一个任务写时由内部的锁串行化；读取在套接字可读之后才加锁，
+ * 不会因等待下行数据而阻塞发送。
+ */
+class tls_client {
+public:
+    tls_client();
+    ~tls_client();
+
+    /**
+     * @brief 初始化随机数发生器、CA证书和TLS配置
+     * @return 成功返回true
+     */
+    bool init();
+
+    /**
+     * @brief 在已连接的套接字上握手
+     * @param sock 阻塞模式的TCP套接字，由调用者关闭
+     * @param server_name 验证证书的服务器名（主机名或IP地址）
+     * @param cache_key 会话缓存的键（如"主机:端口"），与缓存的键不同时不出示票据
+     * @param timeout_ms 等待服务器数据的超时时间
+     * @param result 输出握手结果
+     * @return 成功返回true
+     */
+    bool handshake(int sock, const char* server_name, const char* cache_key, uint32_t timeout_ms,
+                   tls_handshake_result& result);
+
+    /**
+     * @brief 加密发送一组数据段，小段合并为较大的记录，全部发送完成后返回
+     * @return 成功返回true
+     */
+    bool write(const struct iovec* segments, size_t count);
+
+    /**
+     * @brief 等待并读取解密后的数据
+     * @return 读取的字节数，连接被关闭（包括本地调用close()）返回0，出错返回-1
+     */
+    int read(uint8_t* data, size_t size);
+
+    /**
+     * @brief 结束当前连接（套接字应已shutdown），保留缓存的会话
+     */
+    void close();
+
+    /**
+     * @brief 丢弃缓存的会话，下次握手为完整握手
+     */
+    void clear_session();
+
+    /**
+     * @brief 是否有可用的缓存会话
+     */
+    bool has_session() const;
+
+private:
+    static int bio_send(void* ctx, const unsigned char* buf, size_t len);
+    static int bio_recv(void* ctx, unsigned char* buf, size_t len);
+    static int verify_callback(void* ctx, mbedtls_x509_crt* crt, int depth, uint32_t* flags);
+
+    // 发送一段明文，处理部分写入（调用者持有锁）
+    bool write_all(const uint8_t* data, size_t size);
+
+    // 从RTC内存恢复会话并设置到本次握手（调用者持有锁）
+    bool load_session(uint32_t key_hash);
+
+    // 把本次握手的会话保存到RTC内存（调用者持有锁）
+    void save_session(uint32_t key_hash);
+
+    mbedtls_entropy_context entropy_;
+    mbedtls_ctr_drbg_context drbg_;
+    mbedtls_x509_crt ca_;
+    mbedtls_ssl_config conf_;
+    mbedtls_ssl_context ssl_;
+    bool initialized_;
+    bool active_;               // 握手完成且未关闭
+    int sock_;
+    bool handshaking_;          // 握手期间接收阻塞（带超时），之后为非阻塞
+    bool cert_verified_;        // 本次握手验证了证书链，即完整握手
+    uint32_t io_bytes_;         // 握手期间收发的字节数
+    int64_t wait_us_;           // 握手期间等待接收的时间
+    uint8_t* staging_;          // 合并小段的写缓冲区
+    mutable std::mutex mutex_;
+};
+
+} // namespace esp_framework
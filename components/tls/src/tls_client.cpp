@@ -0,0 +1,406 @@
+#include "tls_client.h"
+#include "sdkconfig.h"
+
+#if CONFIG_TLS_ENABLE
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include "mbedtls/net_sockets.h"
+
+static const char* TAG = "TLS";
+
+// 合并小段的写缓冲区大小，即每条TLS记录的最大明文长度
+#define TLS_WRITE_CHUNK 2048
+
+// 等待下行数据时的select()超时，超时后检查连接是否已关闭
+#define TLS_READ_POLL_MS 1000
+
+// 嵌入的CA证书（PEM，以NUL结尾）
+extern const uint8_t tls_ca_pem_start[] asm("_binary_tls_ca_pem_start");
+extern const uint8_t tls_ca_pem_end[] asm("_binary_tls_ca_pem_end");
+
+namespace esp_framework {
+
+/**
+ * @brief RTC内存中的会话缓存
+ *
+ * RTC_NOINIT_ATTR在软件复位和深度睡眠后保留，上电时内容随机，由magic和CRC判断有效性。
+ */
+struct rtc_session_cache {
+    uint32_t magic;
+    uint32_t key_hash;          // 服务器地址的哈希，地址变化后不出示旧票据
+    uint32_t size;
+    uint32_t crc;
+    uint8_t data[CONFIG_TLS_SESSION_CACHE_SIZE];
+};
+
+static constexpr uint32_t SESSION_CACHE_MAGIC = 0x544C5331;    // "TLS1"
+static RTC_NOINIT_ATTR rtc_session_cache s_session_cache;
+
+static uint32_t hash_key(const char* key) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    while (*key != '\0') {
+        hash = (hash ^ static_cast<uint8_t>(*key++)) * 16777619u;
+    }
+    return hash;
+}
+
+tls_client::tls_client()
+    : initialized_(false),
+      active_(false),
+      sock_(-1),
+      handshaking_(false),
+      cert_verified_(false),
+      io_bytes_(0),
+      wait_us_(0),
+      staging_(nullptr) {
+    mbedtls_entropy_init(&entropy_);
+    mbedtls_ctr_drbg_init(&drbg_);
+    mbedtls_x509_crt_init(&ca_);
+    mbedtls_ssl_config_init(&conf_);
+    mbedtls_ssl_init(&ssl_);
+}
+
+tls_client::~tls_client() {
+    mbedtls_ssl_free(&ssl_);
+    mbedtls_ssl_config_free(&conf_);
+    mbedtls_x509_crt_free(&ca_);
+    mbedtls_ctr_drbg_free(&drbg_);
+    mbedtls_entropy_free(&entropy_);
+    delete[] staging_;
+}
+
+bool tls_client::init() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (initialized_) {
+        return true;
+    }
+
+    int ret = mbedtls_ctr_drbg_seed(&drbg_, mbedtls_entropy_func, &entropy_, nullptr, 0);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "随机数发生器初始化失败: -0x%04x", -ret);
+        return false;
+    }
+
+    ret = mbedtls_x509_crt_parse(&ca_, tls_ca_pem_start, tls_ca_pem_end - tls_ca_pem_start);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "CA证书解析失败: -0x%04x", -ret);
+        return false;
+    }
+
+    ret = mbedtls_ssl_config_defaults(&conf_, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                      MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "TLS配置失败: -0x%04x", -ret);
+        return false;
+    }
+    // TLS 1.2的票据在握手中下发，握手完成后即可保存；TLS 1.3的票据在握手后才到达
+    mbedtls_ssl_conf_max_tls_version(&conf_, MBEDTLS_SSL_VERSION_TLS1_2);
+    mbedtls_ssl_conf_authmode(&conf_, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_ca_chain(&conf_, &ca_, nullptr);
+    mbedtls_ssl_conf_rng(&conf_, mbedtls_ctr_drbg_random, &drbg_);
+    mbedtls_ssl_conf_verify(&conf_, verify_callback, this);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&conf_, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#else
+    ESP_LOGW(TAG, "mbedTLS未启用会话票据（CONFIG_MBEDTLS_CLIENT_SSL_SESSION_TICKETS），每次都是完整握手");
+#endif
+
+    ret = mbedtls_ssl_setup(&ssl_, &conf_);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "TLS上下文创建失败: -0x%04x", -ret);
+        return false;
+    }
+    mbedtls_ssl_set_bio(&ssl_, this, bio_send, bio_recv, nullptr);
+
+    staging_ = new (std::nothrow) uint8_t[TLS_WRITE_CHUNK];
+    if (staging_ == nullptr) {
+        ESP_LOGE(TAG, "TLS写缓冲区分配失败");
+        return false;
+    }
+
+    initialized_ = true;
+    ESP_LOGI(TAG, "TLS客户端初始化完成，缓存会话: %s", has_session() ? "有" : "无");
+    return true;
+}
+
+int tls_client::bio_send(void* ctx, const unsigned char* buf, size_t len) {
+    tls_client* self = static_cast<tls_client*>(ctx);
+    int ret = send(self->sock_, buf, len, 0);
+    if (ret < 0) {
+        return errno == EINTR ? MBEDTLS_ERR_SSL_WANT_WRITE : MBEDTLS_ERR_NET_SEND_FAILED;
+    }
+    if (self->handshaking_) {
+        self->io_bytes_ += ret;
+    }
+    return ret;
+}
+
+int tls_client::bio_recv(void* ctx, unsigned char* buf, size_t len) {
+    tls_client* self = static_cast<tls_client*>(ctx);
+    int ret;
+    if (self->handshaking_) {
+        // 握手期间阻塞等待，超时由SO_RCVTIMEO控制；等待时间不计入本地运算时间
+        int64_t start = esp_timer_get_time();
+        ret = recv(self->sock_, buf, len, 0);
+        self->wait_us_ += esp_timer_get_time() - start;
+        if (ret < 0) {
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? MBEDTLS_ERR_SSL_TIMEOUT : MBEDTLS_ERR_NET_RECV_FAILED;
+        }
+        self->io_bytes_ += ret;
+        return ret;
+    }
+
+    // 连接建立后只读取已到达的数据，不完整的记录由mbedTLS保留到下次读取
+    ret = recv(self->sock_, buf, len, MSG_DONTWAIT);
+    if (ret < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_RECV_FAILED;
+    }
+    return ret;
+}
+
+int tls_client::verify_callback(void* ctx, mbedtls_x509_crt* crt, int depth, uint32_t* flags) {
+    // 只有完整握手才会收到并验证服务器证书
+    static_cast<tls_client*>(ctx)->cert_verified_ = true;
+    return 0;
+}
+
+bool tls_client::load_session(uint32_t key_hash) {
+    const rtc_session_cache& cache = s_session_cache;
+    if (cache.magic != SESSION_CACHE_MAGIC || cache.key_hash != key_hash || cache.size == 0 ||
+        cache.size > sizeof(cache.data) || esp_rom_crc32_le(0, cache.data, cache.size) != cache.crc) {
+        return false;
+    }
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    int ret = mbedtls_ssl_session_load(&session, cache.data, cache.size);
+    if (ret == 0) {
+        ret = mbedtls_ssl_set_session(&ssl_, &session);
+    }
+    mbedtls_ssl_session_free(&session);
+    if (ret != 0) {
+        ESP_LOGW(TAG, "缓存的会话无效: -0x%04x", -ret);
+        s_session_cache.magic = 0;
+        return false;
+    }
+    return true;
+}
+
+void tls_client::save_session(uint32_t key_hash) {
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    size_t size = 0;
+    int ret = mbedtls_ssl_get_session(&ssl_, &session);
+    if (ret == 0) {
+        // 先使旧缓存失效，写入过程中复位也不会留下不完整的会话
+        s_session_cache.magic = 0;
+        ret = mbedtls_ssl_session_save(&session, s_session_cache.data, sizeof(s_session_cache.data), &size);
+    }
+    mbedtls_ssl_session_free(&session);
+
+    if (ret == MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL) {
+        ESP_LOGW(TAG, "会话需要%zu字节，超过TLS_SESSION_CACHE_SIZE，不缓存", size);
+        return;
+    }
+    if (ret != 0) {
+        ESP_LOGW(TAG, "会话保存失败: -0x%04x", -ret);
+        return;
+    }
+    s_session_cache.key_hash = key_hash;
+    s_session_cache.size = static_cast<uint32_t>(size);
+    s_session_cache.crc = esp_rom_crc32_le(0, s_session_cache.data, size);
+    s_session_cache.magic = SESSION_CACHE_MAGIC;
+}
+
+bool tls_client::handshake(int sock, const char* server_name, const char* cache_key, uint32_t timeout_ms,
+                           tls_handshake_result& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!initialized_) {
+        return false;
+    }
+
+    mbedtls_ssl_session_reset(&ssl_);
+    sock_ = sock;
+    active_ = false;
+    handshaking_ = true;
+    cert_verified_ = false;
+    io_bytes_ = 0;
+    wait_us_ = 0;
+
+    int ret = mbedtls_ssl_set_hostname(&ssl_, server_name);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "设置服务器名失败: -0x%04x", -ret);
+        return false;
+    }
+
+    uint32_t key_hash = hash_key(cache_key);
+    bool offered = load_session(key_hash);
+
+    // 握手期间临时替换接收超时，完成后恢复
+    struct timeval saved_tv = {};
+    socklen_t saved_len = sizeof(saved_tv);
+    getsockopt(sock_, SOL_SOCKET, SO_RCVTIMEO, &saved_tv, &saved_len);
+    struct timeval tv;
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    setsockopt(sock_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    int64_t start = esp_timer_get_time();
+    do {
+        ret = mbedtls_ssl_handshake(&ssl_);
+    } while (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+    int64_t elapsed_us = esp_timer_get_time() - start;
+
+    setsockopt(sock_, SOL_SOCKET, SO_RCVTIMEO, &saved_tv, sizeof(saved_tv));
+    handshaking_ = false;
+
+    if (ret != 0) {
+        uint32_t flags = mbedtls_ssl_get_verify_result(&ssl_);
+        ESP_LOGE(TAG, "TLS握手失败: -0x%04x, 证书验证结果0x%lx", -ret, (unsigned long)flags);
+        // 出示票据后失败时丢弃缓存，避免每次重连都重复失败
+        if (offered) {
+            s_session_cache.magic = 0;
+        }
+        return false;
+    }
+
+    result.resumed = !cert_verified_;
+    result.elapsed_ms = static_cast<uint32_t>(elapsed_us / 1000);
+    result.compute_ms = static_cast<uint32_t>((elapsed_us - wait_us_) / 1000);
+    result.bytes = io_bytes_;
+    if (offered && !result.resumed) {
+        ESP_LOGI(TAG, "服务器未接受会话票据，已完成完整握手");
+    }
+
+    save_session(key_hash);
+    active_ = true;
+    ESP_LOGI(TAG, "TLS握手完成(%s): %lums, 本地运算%lums, %lu字节, %s",
+             result.resumed ? "会话恢复" : "完整握手", (unsigned long)result.elapsed_ms,
+             (unsigned long)result.compute_ms, (unsigned long)result.bytes, mbedtls_ssl_get_ciphersuite(&ssl_));
+    return true;
+}
+
+bool tls_client::write_all(const uint8_t* data, size_t size) {
+    while (size > 0) {
+        int ret = mbedtls_ssl_write(&ssl_, data, size);
+        if (ret == MBEDTLS_ERR_SSL_WANT_WRITE || ret == MBEDTLS_ERR_SSL_WANT_READ) {
+            continue;
+        }
+        if (ret < 0) {
+            ESP_LOGE(TAG, "TLS发送失败: -0x%04x", -ret);
+            return false;
+        }
+        data += ret;
+        size -= ret;
+    }
+    return true;
+}
+
+bool tls_client::write(const struct iovec* segments, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!active_) {
+        return false;
+    }
+
+    // 小段复制到写缓冲区合并成一条记录，大段直接加密发送，减少记录头和MAC的开销
+    size_t staged = 0;
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* data = static_cast<const uint8_t*>(segments[i].iov_base);
+        size_t size = segments[i].iov_len;
+        if (size >= TLS_WRITE_CHUNK) {
+            if ((staged > 0 && !write_all(staging_, staged)) || !write_all(data, size)) {
+                return false;
+            }
+            staged = 0;
+            continue;
+        }
+        if (staged + size > TLS_WRITE_CHUNK) {
+            if (!write_all(staging_, staged)) {
+                return false;
+            }
+            staged = 0;
+        }
+        memcpy(staging_ + staged, data, size);
+        staged += size;
+    }
+    return staged == 0 || write_all(staging_, staged);
+}
+
+int tls_client::read(uint8_t* data, size_t size) {
+    while (true) {
+        bool pending;
+        int sock;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!active_) {
+                return 0;
+            }
+            pending = mbedtls_ssl_check_pending(&ssl_) != 0;
+            sock = sock_;
+        }
+
+        // 等待套接字可读时不持有锁，发送不受影响
+        if (!pending) {
+            fd_set readable;
+            FD_ZERO(&readable);
+            FD_SET(sock, &readable);
+            struct timeval tv;
+            tv.tv_sec = TLS_READ_POLL_MS / 1000;
+            tv.tv_usec = (TLS_READ_POLL_MS % 1000) * 1000;
+            int ret = select(sock + 1, &readable, nullptr, nullptr, &tv);
+            if (ret < 0 && errno != EINTR) {
+                return -1;
+            }
+            if (ret <= 0) {
+                continue;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!active_) {
+            return 0;
+        }
+        int ret = mbedtls_ssl_read(&ssl_, data, size);
+        if (ret > 0) {
+            return ret;
+        }
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            continue;
+        }
+        if (ret == 0 || ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY || ret == MBEDTLS_ERR_SSL_CONN_EOF) {
+            return 0;
+        }
+        ESP_LOGE(TAG, "TLS接收失败: -0x%04x", -ret);
+        return -1;
+    }
+}
+
+void tls_client::close() {
+    // 套接字已经关闭，不再发送close_notify
+    std::lock_guard<std::mutex> lock(mutex_);
+    active_ = false;
+}
+
+void tls_client::clear_session() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    s_session_cache.magic = 0;
+}
+
+bool tls_client::has_session() const {
+    const rtc_session_cache& cache = s_session_cache;
+    return cache.magic == SESSION_CACHE_MAGIC && cache.size > 0 && cache.size <= sizeof(cache.data) &&
+           esp_rom_crc32_le(0, cache.data, cache.size) == cache.crc;
+}
+
+} // namespace esp_framework
+
+#endif // CONFIG_TLS_ENABLE
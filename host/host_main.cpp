@@ -0,0 +1,39 @@
+// 宿主机入口：与设备上一样在任务中运行app_main()，收到SIGINT/SIGTERM时退出
+#include <csignal>
+#include <cstdio>
+#include <pthread.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+extern "C" void app_main(void);
+
+static void main_task(void*) {
+    app_main();
+}
+
+int main() {
+    // 日志实时输出，便于测试脚本读取
+    setvbuf(stderr, nullptr, _IONBF, 0);
+
+    // esp_timer从首次调用开始计时，与设备上从上电开始计时一致
+    esp_timer_get_time();
+
+    // 在创建任务前屏蔽退出信号，由主线程统一等待
+    sigset_t exit_signals;
+    sigemptyset(&exit_signals);
+    sigaddset(&exit_signals, SIGINT);
+    sigaddset(&exit_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &exit_signals, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    xTaskCreate(main_task, "main", 8192, nullptr, 1, nullptr);
+
+    int sig = 0;
+    sigwait(&exit_signals, &sig);
+
+    // 设备上单例从不析构，任务仍在运行时不执行静态析构
+    fflush(stdout);
+    _exit(0);
+}
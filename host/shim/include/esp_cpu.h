@@ -0,0 +1,11 @@
+#pragma once
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef uint32_t esp_cpu_cycle_count_t;
+// x86上为TSC计数，其他平台按1GHz由单调时钟换算
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,10 @@
+#pragma once
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+// 进程启动以来的微秒数
+int64_t esp_timer_get_time(void);
+#ifdef __cplusplus
+}
+#endif
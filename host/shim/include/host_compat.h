@@ -0,0 +1,13 @@
+#pragma once
+// newlib提供但glibc(<2.38)缺少的函数
+#include <stddef.h>
+#include <string.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+#if !defined(__GLIBC__) || !__GLIBC_PREREQ(2, 38)
+size_t strlcpy(char* dst, const char* src, size_t size);
+#endif
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,14 @@
+#pragma once
+#include <netdb.h>
+
+// ESP_HOST_DNS_SERVER="ip:port"时向指定的DNS服务器查询A记录（测试用的本地DNS替身），
+// 未设置时使用系统解析器。结果用系统的freeaddrinfo()释放
+#ifdef __cplusplus
+extern "C" {
+#endif
+int esp_host_getaddrinfo(const char* node, const char* service,
+                         const struct addrinfo* hints, struct addrinfo** res);
+#ifdef __cplusplus
+}
+#endif
+#define getaddrinfo esp_host_getaddrinfo
@@ -0,0 +1,423 @@
+// FreeRTOS任务、队列、事件组、信号量和日志的宿主机实现（基于std::thread）
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+
+namespace {
+
+using host_clock = std::chrono::steady_clock;
+const host_clock::time_point boot_time = host_clock::now();
+
+host_clock::time_point deadline_after(TickType_t ticks) {
+    if (ticks == portMAX_DELAY) {
+        return host_clock::time_point::max();
+    }
+    return host_clock::now() + std::chrono::milliseconds(ticks * portTICK_PERIOD_MS);
+}
+
+template <typename Pred>
+bool wait_until(std::condition_variable& cv, std::unique_lock<std::mutex>& lock,
+                host_clock::time_point deadline, Pred pred) {
+    if (deadline == host_clock::time_point::max()) {
+        cv.wait(lock, pred);
+        return true;
+    }
+    return cv.wait_until(lock, deadline, pred);
+}
+
+std::recursive_mutex critical_mutex;
+
+} // namespace
+
+struct host_task {
+    std::string name;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool suspended = false;
+    bool deleted = false;
+    uint32_t notify_value = 0;
+    bool notify_pending = false;
+};
+
+static thread_local host_task* current_task = nullptr;
+
+static void wait_if_suspended(host_task* task) {
+    if (task == nullptr) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(task->mutex);
+    task->cv.wait(lock, [task] { return !task->suspended; });
+}
+
+// 宿主机无法从外部停止线程：被挂起的任务在进入或离开下一个FreeRTOS调用时停下，直到被恢复。
+// 任务的主循环都经过队列、通知或延时，效果与设备上挂起后不再运行相同
+static void suspension_point() {
+    wait_if_suspended(current_task);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t, void* arg,
+                                   UBaseType_t, TaskHandle_t* handle, BaseType_t) {
+    host_task* task = new host_task();
+    task->name = name ? name : "";
+    if (handle) {
+        *handle = task;
+    }
+    std::thread([fn, arg, task] {
+        current_task = task;
+        pthread_setname_np(pthread_self(), task->name.substr(0, 15).c_str());
+        fn(arg);
+    }).detach();
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack, void* arg,
+                       UBaseType_t prio, TaskHandle_t* handle) {
+    return xTaskCreatePinnedToCore(fn, name, stack, arg, prio, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == nullptr || task == current_task) {
+        // 结束当前线程，任务对象保留（其他任务可能仍持有句柄）
+        pthread_exit(nullptr);
+    }
+    // 宿主机上无法强制终止其他线程，标记后由其自行阻塞
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->deleted = true;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    suspension_point();
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks * portTICK_PERIOD_MS));
+    suspension_point();
+}
+
+void vTaskSuspend(TaskHandle_t task) {
+    if (task == nullptr) {
+        task = current_task;
+    }
+    if (task == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->suspended = true;
+    }
+    if (task == current_task) {
+        wait_if_suspended(task);
+    }
+}
+
+void vTaskResume(TaskHandle_t task) {
+    if (task == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->suspended = false;
+    task->cv.notify_all();
+}
+
+TickType_t xTaskGetTickCount(void) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(host_clock::now() - boot_time);
+    return static_cast<TickType_t>(elapsed.count() / portTICK_PERIOD_MS);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return current_task;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+    if (task == nullptr) {
+        return pdFAIL;
+    }
+    std::lock_guard<std::mutex> lock(task->mutex);
+    switch (action) {
+        case eSetBits: task->notify_value |= value; break;
+        case eIncrement: task->notify_value++; break;
+        case eSetValueWithOverwrite: task->notify_value = value; break;
+        default: break;
+    }
+    task->notify_pending = true;
+    task->cv.notify_all();
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    return xTaskNotify(task, 0, eIncrement);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+    host_task* task = current_task;
+    if (task == nullptr) {
+        return 0;
+    }
+    suspension_point();
+    uint32_t value = 0;
+    {
+        std::unique_lock<std::mutex> lock(task->mutex);
+        if (wait_until(task->cv, lock, deadline_after(ticks), [task] { return task->notify_value != 0; })) {
+            value = task->notify_value;
+            task->notify_value = clear ? 0 : value - 1;
+            task->notify_pending = false;
+        }
+    }
+    suspension_point();
+    return value;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_entry, uint32_t clear_exit, uint32_t* value, TickType_t ticks) {
+    host_task* task = current_task;
+    if (task == nullptr) {
+        return pdFALSE;
+    }
+    suspension_point();
+    BaseType_t result = pdFALSE;
+    {
+        std::unique_lock<std::mutex> lock(task->mutex);
+        if (!task->notify_pending) {
+            task->notify_value &= ~clear_entry;
+        }
+        if (wait_until(task->cv, lock, deadline_after(ticks), [task] { return task->notify_pending; })) {
+            if (value) {
+                *value = task->notify_value;
+            }
+            task->notify_value &= ~clear_exit;
+            task->notify_pending = false;
+            result = pdTRUE;
+        }
+    }
+    suspension_point();
+    return result;
+}
+
+void vPortEnterCritical(portMUX_TYPE*) {
+    critical_mutex.lock();
+}
+
+void vPortExitCritical(portMUX_TYPE*) {
+    critical_mutex.unlock();
+}
+
+// ---------------------------------------------------------------- 队列
+
+// 与FreeRTOS一样在创建时分配全部存储，收发不访问堆
+struct host_queue {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<uint8_t> storage;
+    UBaseType_t head;
+    UBaseType_t count;
+    UBaseType_t length;
+    UBaseType_t item_size;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    host_queue* q = new host_queue();
+    q->storage.resize(static_cast<size_t>(length) * item_size);
+    q->head = 0;
+    q->count = 0;
+    q->length = length;
+    q->item_size = item_size;
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t q) {
+    delete q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t ticks) {
+    suspension_point();
+    BaseType_t result = pdFALSE;
+    {
+        std::unique_lock<std::mutex> lock(q->mutex);
+        if (wait_until(q->cv, lock, deadline_after(ticks), [q] { return q->count < q->length; })) {
+            UBaseType_t tail = (q->head + q->count) % q->length;
+            memcpy(&q->storage[static_cast<size_t>(tail) * q->item_size], item, q->item_size);
+            q->count++;
+            q->cv.notify_all();
+            result = pdTRUE;
+        }
+    }
+    suspension_point();
+    return result;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t q, const void* item, TickType_t ticks) {
+    return xQueueSend(q, item, ticks);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t ticks) {
+    suspension_point();
+    BaseType_t result = pdFALSE;
+    {
+        std::unique_lock<std::mutex> lock(q->mutex);
+        if (wait_until(q->cv, lock, deadline_after(ticks), [q] { return q->count > 0; })) {
+            memcpy(item, &q->storage[static_cast<size_t>(q->head) * q->item_size], q->item_size);
+            q->head = (q->head + 1) % q->length;
+            q->count--;
+            q->cv.notify_all();
+            result = pdTRUE;
+        }
+    }
+    suspension_point();
+    return result;
+}
+
+BaseType_t xQueueReset(QueueHandle_t q) {
+    std::lock_guard<std::mutex> lock(q->mutex);
+    q->head = 0;
+    q->count = 0;
+    q->cv.notify_all();
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+    std::lock_guard<std::mutex> lock(q->mutex);
+    return q->count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q) {
+    std::lock_guard<std::mutex> lock(q->mutex);
+    return q->length - q->count;
+}
+
+// ---------------------------------------------------------------- 事件组
+
+struct host_event_group {
+    std::mutex mutex;
+    std::condition_variable cv;
+    EventBits_t bits = 0;
+};
+
+EventGroupHandle_t xEventGroupCreate(void) {
+    return new host_event_group();
+}
+
+void vEventGroupDelete(EventGroupHandle_t g) {
+    delete g;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t g, EventBits_t bits) {
+    std::lock_guard<std::mutex> lock(g->mutex);
+    g->bits |= bits;
+    g->cv.notify_all();
+    return g->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t g, EventBits_t bits) {
+    std::lock_guard<std::mutex> lock(g->mutex);
+    EventBits_t prev = g->bits;
+    g->bits &= ~bits;
+    return prev;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t g) {
+    std::lock_guard<std::mutex> lock(g->mutex);
+    return g->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t g, EventBits_t bits, BaseType_t clear,
+                                BaseType_t all, TickType_t ticks) {
+    suspension_point();
+    EventBits_t result;
+    {
+        std::unique_lock<std::mutex> lock(g->mutex);
+        auto ready = [g, bits, all] {
+            return all ? (g->bits & bits) == bits : (g->bits & bits) != 0;
+        };
+        wait_until(g->cv, lock, deadline_after(ticks), ready);
+        result = g->bits;
+        if (ready() && clear) {
+            g->bits &= ~bits;
+        }
+    }
+    suspension_point();
+    return result;
+}
+
+// ---------------------------------------------------------------- 信号量
+
+struct host_semaphore {
+    std::mutex mutex;
+    std::condition_variable cv;
+    uint32_t count;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    host_semaphore* s = new host_semaphore();
+    s->count = 1;
+    return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    host_semaphore* s = new host_semaphore();
+    s->count = 0;
+    return s;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t s) {
+    delete s;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks) {
+    suspension_point();
+    BaseType_t result = pdFALSE;
+    {
+        std::unique_lock<std::mutex> lock(s->mutex);
+        if (wait_until(s->cv, lock, deadline_after(ticks), [s] { return s->count > 0; })) {
+            s->count--;
+            result = pdTRUE;
+        }
+    }
+    suspension_point();
+    return result;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s) {
+    std::lock_guard<std::mutex> lock(s->mutex);
+    if (s->count > 0) {
+        return pdFALSE;
+    }
+    s->count++;
+    s->cv.notify_one();
+    return pdTRUE;
+}
+
+// ---------------------------------------------------------------- 日志
+
+static esp_log_level_t log_level = ESP_LOG_INFO;
+
+extern "C" void esp_log_level_set(const char*, esp_log_level_t level) {
+    log_level = level;
+}
+
+extern "C" void esp_log_write(esp_log_level_t level, const char*, const char* format, ...) {
+    if (level > log_level) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+extern "C" uint32_t esp_log_timestamp(void) {
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        host_clock::now() - boot_time).count());
+}
+
+extern "C" const char* esp_err_to_name(esp_err_t code) {
+    return code == ESP_OK ? "ESP_OK" : "ESP_ERR";
+}
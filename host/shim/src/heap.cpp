@@ -0,0 +1,158 @@
+// 堆内存接口的宿主机实现
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <malloc.h>
+#include <mutex>
+
+// 与ESP-IDF的CONFIG_HEAP_USE_HOOKS一样，每次分配和释放后调用堆钩子（由应用定义，未定义时不调用）。
+// 设备上所有malloc/new都经过heap_caps，宿主机替换malloc系列函数以覆盖同样的范围，
+// 包括标准库内部的分配；实际分配仍由glibc完成。
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+
+__attribute__((weak)) void esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t caps);
+__attribute__((weak)) void esp_heap_trace_free_hook(void* ptr);
+}
+
+// 模拟层自身查询堆状态时的内部分配不调用钩子
+static thread_local bool s_hooks_suspended = false;
+
+static inline void* after_alloc(void* ptr, size_t size) {
+    if (ptr != nullptr && !s_hooks_suspended && esp_heap_trace_alloc_hook != nullptr) {
+        esp_heap_trace_alloc_hook(ptr, size, MALLOC_CAP_DEFAULT);
+    }
+    return ptr;
+}
+
+static inline void before_free(void* ptr) {
+    if (ptr != nullptr && !s_hooks_suspended && esp_heap_trace_free_hook != nullptr) {
+        esp_heap_trace_free_hook(ptr);
+    }
+}
+
+#ifdef HOST_TSAN
+// ThreadSanitizer拦截malloc系列函数，不能替换，改用其分配钩子（声明见sanitizer/allocator_interface.h）
+extern "C" int __sanitizer_install_malloc_and_free_hooks(void (*malloc_hook)(const volatile void*, size_t),
+                                                         void (*free_hook)(const volatile void*));
+
+static void tsan_alloc_hook(const volatile void* ptr, size_t size) {
+    after_alloc(const_cast<void*>(ptr), size);
+}
+
+static void tsan_free_hook(const volatile void* ptr) {
+    before_free(const_cast<void*>(ptr));
+}
+
+__attribute__((constructor)) static void install_heap_hooks() {
+    __sanitizer_install_malloc_and_free_hooks(tsan_alloc_hook, tsan_free_hook);
+}
+#else
+extern "C" void* malloc(size_t size) {
+    return after_alloc(__libc_malloc(size), size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+    return after_alloc(__libc_calloc(count, size), count * size);
+}
+
+// 地址改变时计为一次分配和一次释放
+extern "C" void* realloc(void* ptr, size_t size) {
+    void* result = __libc_realloc(ptr, size);
+    if (result != ptr) {
+        if (ptr != nullptr && (result != nullptr || size == 0)) {
+            before_free(ptr);
+        }
+        after_alloc(result, size);
+    }
+    return result;
+}
+
+extern "C" void* memalign(size_t alignment, size_t size) {
+    return after_alloc(__libc_memalign(alignment, size), size);
+}
+
+extern "C" void* aligned_alloc(size_t alignment, size_t size) {
+    return memalign(alignment, size);
+}
+
+extern "C" int posix_memalign(void** out, size_t alignment, size_t size) {
+    void* ptr = memalign(alignment, size);
+    if (ptr == nullptr) {
+        return ENOMEM;
+    }
+    *out = ptr;
+    return 0;
+}
+
+extern "C" void free(void* ptr) {
+    before_free(ptr);
+    __libc_free(ptr);
+}
+#endif
+
+extern "C" void* heap_caps_malloc(size_t size, uint32_t) {
+    return malloc(size);
+}
+
+extern "C" void heap_caps_free(void* ptr) {
+    free(ptr);
+}
+
+extern "C" size_t heap_caps_get_free_size(uint32_t) {
+    struct mallinfo2 mi = mallinfo2();
+    return mi.fordblks;
+}
+
+// glibc没有直接查询最大空闲块的接口，解析malloc_info()输出的空闲块分布：
+// 每个<size from to total count>区间中最大的块不超过to，也不超过total减去其余count-1块的最小值；
+// 堆顶未划分的部分（keepcost）同样可以一次分配。结果是上界，用于观察碎片化趋势。
+extern "C" size_t heap_caps_get_largest_free_block(uint32_t) {
+    static std::mutex lock;
+    static char report[64 * 1024];
+    std::lock_guard<std::mutex> guard(lock);
+
+    s_hooks_suspended = true;
+    struct mallinfo2 mi = mallinfo2();
+    size_t largest = mi.keepcost;
+    FILE* out = fmemopen(report, sizeof(report) - 1, "w");
+    if (out != nullptr) {
+        malloc_info(0, out);
+        long length = ftell(out);
+        fclose(out);
+        report[length > 0 ? length : 0] = '\0';
+
+        for (const char* p = report; (p = strchr(p, '<')) != nullptr; p++) {
+            char tag[16];
+            size_t from, to, total, count;
+            if (sscanf(p, "<%15s from=\"%zu\" to=\"%zu\" total=\"%zu\" count=\"%zu\"",
+                       tag, &from, &to, &total, &count) != 5 || count == 0) {
+                continue;
+            }
+            size_t bound = total - (count - 1) * from;
+            size_t block = to < bound ? to : bound;
+            if (block > largest) {
+                largest = block;
+            }
+        }
+    }
+    s_hooks_suspended = false;
+    // 区间上界可能超出实际空闲总量
+    return largest < mi.fordblks ? largest : mi.fordblks;
+}
+
+// 宿主机没有固定大小的堆，返回一个与ESP32S3内部RAM相当的数值
+extern "C" uint32_t esp_get_free_heap_size(void) {
+    return 256 * 1024;
+}
+
+extern "C" uint32_t esp_get_minimum_free_heap_size(void) {
+    return 256 * 1024;
+}
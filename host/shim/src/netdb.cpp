@@ -0,0 +1,154 @@
+#include "lwip/netdb.h"
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "esp_log.h"
+
+#undef getaddrinfo
+
+static const char* TAG = "HostDNS";
+
+#define DNS_QUERY_TIMEOUT_MS 2000
+#define DNS_QUERY_TRIES 2
+#define DNS_TYPE_A 1
+#define DNS_CLASS_IN 1
+
+// 跳过报文中的域名（支持压缩指针），返回之后的偏移，出错返回0
+static size_t skip_name(const uint8_t* msg, size_t len, size_t pos) {
+    while (pos < len) {
+        uint8_t label = msg[pos];
+        if (label == 0) {
+            return pos + 1;
+        }
+        if ((label & 0xC0) == 0xC0) {
+            return pos + 2 <= len ? pos + 2 : 0;
+        }
+        pos += 1 + label;
+    }
+    return 0;
+}
+
+// 向DNS服务器查询A记录，成功时addr为网络字节序
+static bool query_a(const char* server, const char* node, uint32_t& addr) {
+    std::string spec(server);
+    size_t colon = spec.rfind(':');
+    struct sockaddr_in dest;
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(colon == std::string::npos ? 53 : atoi(spec.c_str() + colon + 1));
+    if (inet_pton(AF_INET, spec.substr(0, colon).c_str(), &dest.sin_addr) != 1) {
+        ESP_LOGE(TAG, "ESP_HOST_DNS_SERVER格式错误: %s", server);
+        return false;
+    }
+    
+    // 报文头：ID、标志（期望递归）、1个问题
+    uint8_t query[300];
+    uint16_t id = static_cast<uint16_t>(rand());
+    size_t qlen = 0;
+    const uint8_t header[12] = {uint8_t(id >> 8), uint8_t(id), 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, 0};
+    memcpy(query, header, sizeof(header));
+    qlen = sizeof(header);
+    const char* label = node;
+    while (*label) {
+        const char* dot = strchr(label, '.');
+        size_t n = dot ? static_cast<size_t>(dot - label) : strlen(label);
+        if (n == 0 || n > 63 || qlen + n + 6 > sizeof(query)) {
+            return false;
+        }
+        query[qlen++] = static_cast<uint8_t>(n);
+        memcpy(query + qlen, label, n);
+        qlen += n;
+        label += n + (dot ? 1 : 0);
+    }
+    const uint8_t tail[5] = {0, 0, DNS_TYPE_A, 0, DNS_CLASS_IN};
+    memcpy(query + qlen, tail, sizeof(tail));
+    qlen += sizeof(tail);
+    
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        return false;
+    }
+    struct timeval tv;
+    tv.tv_sec = DNS_QUERY_TIMEOUT_MS / 1000;
+    tv.tv_usec = (DNS_QUERY_TIMEOUT_MS % 1000) * 1000;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    
+    bool found = false;
+    for (int attempt = 0; attempt < DNS_QUERY_TRIES && !found; attempt++) {
+        if (sendto(sock, query, qlen, 0, (struct sockaddr*)&dest, sizeof(dest)) != (ssize_t)qlen) {
+            break;
+        }
+        uint8_t reply[512];
+        ssize_t len = recv(sock, reply, sizeof(reply), 0);
+        if (len < 12 || reply[0] != header[0] || reply[1] != header[1]) {
+            continue;
+        }
+        if ((reply[3] & 0x0F) != 0) {
+            // NXDOMAIN等错误不重试
+            break;
+        }
+        size_t pos = skip_name(reply, len, 12);
+        if (pos == 0 || pos + 4 > (size_t)len) {
+            continue;
+        }
+        pos += 4;
+        int answers = (reply[6] << 8) | reply[7];
+        for (int i = 0; i < answers && !found; i++) {
+            pos = skip_name(reply, len, pos);
+            if (pos == 0 || pos + 10 > (size_t)len) {
+                break;
+            }
+            uint16_t type = (reply[pos] << 8) | reply[pos + 1];
+            uint16_t rdlength = (reply[pos + 8] << 8) | reply[pos + 9];
+            pos += 10;
+            if (pos + rdlength > (size_t)len) {
+                break;
+            }
+            if (type == DNS_TYPE_A && rdlength == 4) {
+                memcpy(&addr, reply + pos, 4);
+                found = true;
+            }
+            pos += rdlength;
+        }
+        if (!found) {
+            break;
+        }
+    }
+    ::close(sock);
+    return found;
+}
+
+extern "C" int esp_host_getaddrinfo(const char* node, const char* service,
+                                    const struct addrinfo* hints, struct addrinfo** res) {
+    const char* server = getenv("ESP_HOST_DNS_SERVER");
+    struct in_addr literal;
+    if (server == nullptr || node == nullptr || inet_pton(AF_INET, node, &literal) == 1) {
+        return getaddrinfo(node, service, hints, res);
+    }
+    
+    uint32_t addr;
+    if (!query_a(server, node, addr)) {
+        return EAI_NONAME;
+    }
+    
+    // 与glibc相同，地址和addrinfo在同一块内存中，可以用freeaddrinfo()释放
+    struct addrinfo* ai = static_cast<struct addrinfo*>(calloc(1, sizeof(struct addrinfo) + sizeof(struct sockaddr_in)));
+    if (ai == nullptr) {
+        return EAI_MEMORY;
+    }
+    struct sockaddr_in* sin = reinterpret_cast<struct sockaddr_in*>(ai + 1);
+    sin->sin_family = AF_INET;
+    sin->sin_port = htons(service ? atoi(service) : 0);
+    sin->sin_addr.s_addr = addr;
+    ai->ai_family = AF_INET;
+    ai->ai_socktype = hints ? hints->ai_socktype : SOCK_STREAM;
+    ai->ai_protocol = ai->ai_socktype == SOCK_DGRAM ? IPPROTO_UDP : IPPROTO_TCP;
+    ai->ai_addrlen = sizeof(struct sockaddr_in);
+    ai->ai_addr = reinterpret_cast<struct sockaddr*>(sin);
+    *res = ai;
+    return 0;
+}
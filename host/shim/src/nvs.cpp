@@ -0,0 +1,202 @@
+// NVS的宿主机实现
+//
+// 数据保存在内存中；设置环境变量ESP_HOST_NVS_FILE时，nvs_commit()把全部数据写入该文件，
+// nvs_flash_init()从该文件加载，用于模拟重启后数据仍然保留。
+#include "nvs.h"
+#include "nvs_flash.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::map<std::string, std::vector<uint8_t>> nvs_namespace;
+
+std::mutex nvs_mutex;
+std::map<std::string, nvs_namespace> nvs_store;
+std::vector<std::string> nvs_handles;   // 句柄-1即下标，值为命名空间名
+std::vector<bool> nvs_writable;
+
+const char* nvs_file() {
+    return getenv("ESP_HOST_NVS_FILE");
+}
+
+// 文件格式：重复的 [命名空间长度][命名空间][键长度][键][值长度][值]，长度均为uint32_t
+void write_string(FILE* f, const void* data, uint32_t size) {
+    fwrite(&size, sizeof(size), 1, f);
+    fwrite(data, 1, size, f);
+}
+
+bool read_string(FILE* f, std::vector<uint8_t>& out) {
+    uint32_t size = 0;
+    if (fread(&size, sizeof(size), 1, f) != 1 || size > 1024 * 1024) {
+        return false;
+    }
+    out.resize(size);
+    return size == 0 || fread(out.data(), 1, size, f) == size;
+}
+
+void load_store() {
+    const char* path = nvs_file();
+    if (path == nullptr) {
+        return;
+    }
+    FILE* f = fopen(path, "rb");
+    if (f == nullptr) {
+        return;
+    }
+    std::vector<uint8_t> ns, key, value;
+    while (read_string(f, ns) && read_string(f, key) && read_string(f, value)) {
+        nvs_store[std::string(ns.begin(), ns.end())][std::string(key.begin(), key.end())] = value;
+    }
+    fclose(f);
+}
+
+esp_err_t save_store() {
+    const char* path = nvs_file();
+    if (path == nullptr) {
+        return ESP_OK;
+    }
+    FILE* f = fopen(path, "wb");
+    if (f == nullptr) {
+        return ESP_FAIL;
+    }
+    for (const auto& ns : nvs_store) {
+        for (const auto& entry : ns.second) {
+            write_string(f, ns.first.data(), static_cast<uint32_t>(ns.first.size()));
+            write_string(f, entry.first.data(), static_cast<uint32_t>(entry.first.size()));
+            write_string(f, entry.second.data(), static_cast<uint32_t>(entry.second.size()));
+        }
+    }
+    fclose(f);
+    return ESP_OK;
+}
+
+nvs_namespace* find_namespace(nvs_handle_t handle, bool write) {
+    if (handle == 0 || handle > nvs_handles.size() || nvs_handles[handle - 1].empty()) {
+        return nullptr;
+    }
+    if (write && !nvs_writable[handle - 1]) {
+        return nullptr;
+    }
+    return &nvs_store[nvs_handles[handle - 1]];
+}
+
+esp_err_t set_value(nvs_handle_t handle, const char* key, const void* value, size_t length) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    nvs_namespace* ns = find_namespace(handle, true);
+    if (ns == nullptr || key == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(value);
+    (*ns)[key].assign(bytes, bytes + length);
+    return ESP_OK;
+}
+
+esp_err_t get_value(nvs_handle_t handle, const char* key, void* out_value, size_t* length) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    nvs_namespace* ns = find_namespace(handle, false);
+    if (ns == nullptr || key == nullptr || length == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    auto it = ns->find(key);
+    if (it == ns->end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (out_value == nullptr) {
+        *length = it->second.size();
+        return ESP_OK;
+    }
+    if (*length < it->second.size()) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(out_value, it->second.data(), it->second.size());
+    *length = it->second.size();
+    return ESP_OK;
+}
+
+} // namespace
+
+extern "C" esp_err_t nvs_flash_init(void) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    nvs_store.clear();
+    load_store();
+    return ESP_OK;
+}
+
+extern "C" esp_err_t nvs_flash_erase(void) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    nvs_store.clear();
+    return save_store();
+}
+
+extern "C" esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle) {
+    if (name == nullptr || out_handle == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    if (open_mode == NVS_READONLY && nvs_store.find(name) == nvs_store.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    nvs_handles.push_back(name);
+    nvs_writable.push_back(open_mode == NVS_READWRITE);
+    *out_handle = static_cast<nvs_handle_t>(nvs_handles.size());
+    return ESP_OK;
+}
+
+extern "C" void nvs_close(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    if (handle > 0 && handle <= nvs_handles.size()) {
+        nvs_handles[handle - 1].clear();
+    }
+}
+
+extern "C" esp_err_t nvs_commit(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    if (find_namespace(handle, true) == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return save_store();
+}
+
+extern "C" esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    nvs_namespace* ns = find_namespace(handle, true);
+    if (ns == nullptr || key == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ns->erase(key) > 0 ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+extern "C" esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length) {
+    return set_value(handle, key, value, length);
+}
+
+extern "C" esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length) {
+    return get_value(handle, key, out_value, length);
+}
+
+extern "C" esp_err_t nvs_set_u32(nvs_handle_t handle, const char* key, uint32_t value) {
+    return set_value(handle, key, &value, sizeof(value));
+}
+
+extern "C" esp_err_t nvs_get_u32(nvs_handle_t handle, const char* key, uint32_t* out_value) {
+    size_t length = sizeof(uint32_t);
+    return get_value(handle, key, out_value, &length);
+}
+
+extern "C" esp_err_t nvs_set_str(nvs_handle_t handle, const char* key, const char* value) {
+    if (value == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return set_value(handle, key, value, strlen(value) + 1);
+}
+
+extern "C" esp_err_t nvs_get_str(nvs_handle_t handle, const char* key, char* out_value, size_t* length) {
+    return get_value(handle, key, out_value, length);
+}
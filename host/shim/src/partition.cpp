@@ -0,0 +1,262 @@
+// 分区和闪存接口的宿主机实现，每个分区对应一个映像文件
+//
+// 分区表读取自仓库根目录的partitions.csv（编译时由HOST_PARTITION_TABLE指定）。
+// 映像文件按NOR闪存的语义访问：擦除把数据置为0xFF，写入只能把1变为0。
+// 环境变量：
+//   ESP_HOST_PARTITION_<LABEL>       映像文件路径，默认为当前目录下的<label>.img
+//   ESP_HOST_PARTITION_<LABEL>_SIZE  覆盖分区大小（字节，可带K/M后缀），用于测试不同容量
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_log.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char* TAG = "HostFlash";
+
+#define HOST_FLASH_SECTOR_SIZE 4096
+
+namespace {
+
+struct host_partition {
+    esp_partition_t info;
+    uint8_t* image = nullptr;   // 映像文件的共享映射
+};
+
+std::mutex partition_mutex;
+std::vector<host_partition*> partitions;
+bool table_loaded = false;
+
+std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t\r\n");
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return begin == std::string::npos ? std::string() : s.substr(begin, end - begin + 1);
+}
+
+// 解析0x前缀、十进制以及K/M后缀
+uint32_t parse_size(const std::string& text) {
+    if (text.empty()) {
+        return 0;
+    }
+    char* end = nullptr;
+    unsigned long value = strtoul(text.c_str(), &end, 0);
+    if (end != nullptr && (*end == 'K' || *end == 'k')) {
+        value *= 1024;
+    } else if (end != nullptr && (*end == 'M' || *end == 'm')) {
+        value *= 1024 * 1024;
+    }
+    return static_cast<uint32_t>(value);
+}
+
+int parse_type(const std::string& text) {
+    if (text == "app") {
+        return ESP_PARTITION_TYPE_APP;
+    }
+    if (text == "data") {
+        return ESP_PARTITION_TYPE_DATA;
+    }
+    return static_cast<int>(parse_size(text));
+}
+
+int parse_subtype(const std::string& text) {
+    if (text == "factory") {
+        return ESP_PARTITION_SUBTYPE_APP_FACTORY;
+    }
+    if (text == "phy") {
+        return ESP_PARTITION_SUBTYPE_DATA_PHY;
+    }
+    if (text == "nvs") {
+        return ESP_PARTITION_SUBTYPE_DATA_NVS;
+    }
+    return static_cast<int>(parse_size(text));
+}
+
+std::string env_name(const char* label, const char* suffix) {
+    std::string name = "ESP_HOST_PARTITION_";
+    for (const char* p = label; *p != '\0'; p++) {
+        name += static_cast<char>(toupper(static_cast<unsigned char>(*p)));
+    }
+    return name + suffix;
+}
+
+void load_table() {
+    table_loaded = true;
+    std::ifstream file(HOST_PARTITION_TABLE);
+    if (!file) {
+        ESP_LOGW(TAG, "无法读取分区表: %s", HOST_PARTITION_TABLE);
+        return;
+    }
+
+    std::string line;
+    uint32_t next_offset = 0x9000;
+    while (std::getline(file, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> fields;
+        size_t start = 0;
+        while (true) {
+            size_t comma = line.find(',', start);
+            fields.push_back(trim(line.substr(start, comma - start)));
+            if (comma == std::string::npos) {
+                break;
+            }
+            start = comma + 1;
+        }
+        if (fields.size() < 5) {
+            continue;
+        }
+
+        host_partition* part = new host_partition();
+        memset(&part->info, 0, sizeof(part->info));
+        strncpy(part->info.label, fields[0].c_str(), sizeof(part->info.label) - 1);
+        part->info.type = static_cast<esp_partition_type_t>(parse_type(fields[1]));
+        part->info.subtype = static_cast<esp_partition_subtype_t>(parse_subtype(fields[2]));
+        part->info.address = fields[3].empty() ? next_offset : parse_size(fields[3]);
+        part->info.size = parse_size(fields[4]);
+        part->info.erase_size = HOST_FLASH_SECTOR_SIZE;
+
+        const char* size_override = getenv(env_name(part->info.label, "_SIZE").c_str());
+        if (size_override != nullptr && parse_size(size_override) > 0) {
+            part->info.size = parse_size(size_override) & ~(HOST_FLASH_SECTOR_SIZE - 1);
+        }
+        next_offset = part->info.address + part->info.size;
+        partitions.push_back(part);
+    }
+}
+
+// 首次访问时打开映像文件，不存在或大小不符时创建为全0xFF
+bool map_image(host_partition* part) {
+    if (part->image != nullptr) {
+        return true;
+    }
+
+    const char* path_env = getenv(env_name(part->info.label, "").c_str());
+    std::string path = path_env != nullptr ? path_env : std::string(part->info.label) + ".img";
+    int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        ESP_LOGE(TAG, "无法打开分区映像%s: errno %d", path.c_str(), errno);
+        return false;
+    }
+
+    struct stat st;
+    fstat(fd, &st);
+    bool fresh = static_cast<uint32_t>(st.st_size) != part->info.size;
+    if (fresh && ftruncate(fd, part->info.size) != 0) {
+        ESP_LOGE(TAG, "无法设置分区映像大小: errno %d", errno);
+        close(fd);
+        return false;
+    }
+
+    void* mem = mmap(nullptr, part->info.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        ESP_LOGE(TAG, "映射分区映像失败: errno %d", errno);
+        return false;
+    }
+    part->image = static_cast<uint8_t*>(mem);
+    if (fresh) {
+        memset(part->image, 0xFF, part->info.size);
+    }
+    ESP_LOGI(TAG, "分区%s -> %s (%lu字节%s)", part->info.label, path.c_str(),
+             (unsigned long)part->info.size, fresh ? "，新建" : "");
+    return true;
+}
+
+host_partition* get_partition(const esp_partition_t* partition, size_t offset, size_t size) {
+    if (partition == nullptr || offset > partition->size || size > partition->size - offset) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(partition_mutex);
+    for (host_partition* part : partitions) {
+        if (&part->info == partition) {
+            return map_image(part) ? part : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+extern "C" const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                           const char* label) {
+    std::lock_guard<std::mutex> lock(partition_mutex);
+    if (!table_loaded) {
+        load_table();
+    }
+    for (host_partition* part : partitions) {
+        if ((type == ESP_PARTITION_TYPE_ANY || part->info.type == type) &&
+            (subtype == ESP_PARTITION_SUBTYPE_ANY || part->info.subtype == subtype) &&
+            (label == nullptr || strcmp(part->info.label, label) == 0)) {
+            return &part->info;
+        }
+    }
+    return nullptr;
+}
+
+extern "C" esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size) {
+    host_partition* part = get_partition(partition, src_offset, size);
+    if (part == nullptr || dst == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(dst, part->image + src_offset, size);
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src,
+                                         size_t size) {
+    host_partition* part = get_partition(partition, dst_offset, size);
+    if (part == nullptr || src == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // NOR闪存写入只能清除位，未擦除就覆盖写入会得到两者的按位与
+    const uint8_t* data = static_cast<const uint8_t*>(src);
+    uint8_t* flash = part->image + dst_offset;
+    for (size_t i = 0; i < size; i++) {
+        flash[i] &= data[i];
+    }
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+    if (offset % HOST_FLASH_SECTOR_SIZE != 0 || size % HOST_FLASH_SECTOR_SIZE != 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    host_partition* part = get_partition(partition, offset, size);
+    if (part == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(part->image + offset, 0xFF, size);
+    return ESP_OK;
+}
+
+// 与ROM中的crc32_le相同：初值和结果按位取反，esp_rom_crc32_le(0, ...)等于zlib的crc32()
+extern "C" uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len) {
+    static uint32_t table[256];
+    static std::once_flag table_once;
+    std::call_once(table_once, [] {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int bit = 0; bit < 8; bit++) {
+                c = (c >> 1) ^ (0xEDB88320 & (0 - (c & 1)));
+            }
+            table[i] = c;
+        }
+    });
+
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc = table[(crc ^ buf[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
@@ -0,0 +1,189 @@
+// 系统、睡眠、电源管理、GPIO和ADC接口的宿主机实现
+#include "esp_system.h"
+#include "esp_random.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "esp_sleep.h"
+#include "esp_pm.h"
+#include "esp_log.h"
+#include "driver/gpio.h"
+#include "driver/adc.h"
+#include "host_compat.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+
+static const char* TAG = "HostSystem";
+
+// GPIO数量（ESP32S3）
+#define HOST_GPIO_COUNT 49
+
+static std::mutex gpio_mutex;
+static uint32_t gpio_levels[HOST_GPIO_COUNT];
+
+extern "C" uint32_t esp_random(void) {
+    static std::mutex mutex;
+    static std::mt19937 engine(std::random_device{}());
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<uint32_t>(engine());
+}
+
+extern "C" esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return static_cast<esp_cpu_cycle_count_t>(__builtin_ia32_rdtsc());
+#else
+    return static_cast<esp_cpu_cycle_count_t>(
+        std::chrono::steady_clock::now().time_since_epoch() / std::chrono::nanoseconds(1));
+#endif
+}
+
+extern "C" int64_t esp_timer_get_time(void) {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+extern "C" void esp_restart(void) {
+    ESP_LOGW(TAG, "esp_restart()，宿主机进程退出");
+    fflush(stderr);
+    exit(0);
+}
+
+extern "C" esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us) {
+    ESP_LOGI(TAG, "定时器唤醒: %llu微秒", (unsigned long long)time_in_us);
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_sleep_enable_uart_wakeup(int uart_num) {
+    ESP_LOGI(TAG, "UART%d唤醒已启用", uart_num);
+    return ESP_OK;
+}
+
+// 电源管理只记录配置和锁的计数，宿主机不调频也不睡眠
+struct esp_pm_lock {
+    esp_pm_lock_type_t type;
+    const char* name;
+    int count;
+};
+
+static std::mutex pm_mutex;
+static esp_pm_config_t pm_config = {160, 160, false};
+
+extern "C" esp_err_t esp_pm_configure(const void* config) {
+    if (config == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(pm_mutex);
+    pm_config = *static_cast<const esp_pm_config_t*>(config);
+    ESP_LOGD(TAG, "电源管理: %d~%dMHz, 自动轻度睡眠%s", pm_config.min_freq_mhz, pm_config.max_freq_mhz,
+             pm_config.light_sleep_enable ? "开启" : "关闭");
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_pm_get_configuration(void* config) {
+    if (config == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(pm_mutex);
+    *static_cast<esp_pm_config_t*>(config) = pm_config;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_pm_lock_create(esp_pm_lock_type_t lock_type, int, const char* name,
+                                        esp_pm_lock_handle_t* out_handle) {
+    if (out_handle == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out_handle = new esp_pm_lock{lock_type, name, 0};
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_pm_lock_delete(esp_pm_lock_handle_t handle) {
+    if (handle == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (handle->count != 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    delete handle;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle) {
+    if (handle == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(pm_mutex);
+    handle->count++;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle) {
+    if (handle == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(pm_mutex);
+    if (handle->count == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->count--;
+    return ESP_OK;
+}
+
+// 深度睡眠在设备上以复位结束，宿主机上直接退出进程
+extern "C" void esp_deep_sleep_start(void) {
+    ESP_LOGW(TAG, "进入深度睡眠，宿主机进程退出");
+    fflush(stderr);
+    exit(0);
+}
+
+extern "C" esp_err_t gpio_config(const gpio_config_t* cfg) {
+    if (cfg == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+extern "C" esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+    if (gpio_num < 0 || gpio_num >= HOST_GPIO_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(gpio_mutex);
+    gpio_levels[gpio_num] = level ? 1 : 0;
+    return ESP_OK;
+}
+
+extern "C" int gpio_get_level(gpio_num_t gpio_num) {
+    if (gpio_num < 0 || gpio_num >= HOST_GPIO_COUNT) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(gpio_mutex);
+    return static_cast<int>(gpio_levels[gpio_num]);
+}
+
+extern "C" esp_err_t adc1_config_width(adc_bits_width_t) {
+    return ESP_OK;
+}
+
+extern "C" esp_err_t adc1_config_channel_atten(adc1_channel_t, adc_atten_t) {
+    return ESP_OK;
+}
+
+// 12位ADC中间值
+extern "C" int adc1_get_raw(adc1_channel_t) {
+    return 2048;
+}
+
+#if !defined(__GLIBC__) || !__GLIBC_PREREQ(2, 38)
+extern "C" size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
@@ -0,0 +1,333 @@
+// UART驱动的宿主机实现，每个UART端口对应一个伪终端(pty)
+//
+// 向pty从设备写入的数据作为UART接收数据，uart_write_bytes()写出的数据从pty从设备读出。
+// 环境变量：
+//   ESP_HOST_UART<n>_LINK   为UART<n>的pty从设备创建符号链接（例如/tmp/esp_uart1）
+//   ESP_HOST_UART_LOOPBACK  设为1时TX直接回环到RX（模拟TX/RX短接），不经过pty
+//   ESP_HOST_UART_PACING    设为0时不按波特率限速，默认按波特率模拟线路传输时间
+//   ESP_HOST_UART_BAUD      覆盖uart_param_config()设置的波特率，用于不重新编译测试不同波特率
+#include "driver/uart.h"
+#include "esp_log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <pthread.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+static const char* TAG = "HostUART";
+
+// 与ESP32 UART硬件FIFO相当，每次接收事件最多携带的字节数
+#define HOST_UART_FIFO_SIZE 120
+#define HOST_UART_PORT_COUNT 3
+
+namespace {
+
+using host_clock = std::chrono::steady_clock;
+
+// 按波特率计算线路传输时间（8N1，每字节10位）
+class line_pacer {
+public:
+    void wait(size_t bytes, int baud) {
+        if (baud <= 0) {
+            return;
+        }
+        auto now = host_clock::now();
+        if (next_ < now) {
+            next_ = now;
+        }
+        next_ += std::chrono::microseconds(static_cast<int64_t>(bytes) * 10 * 1000000 / baud);
+        std::this_thread::sleep_until(next_);
+    }
+
+private:
+    host_clock::time_point next_;
+};
+
+struct host_uart {
+    bool installed = false;
+    int master = -1;
+    int slave = -1;
+    std::string link;
+    QueueHandle_t queue = nullptr;
+    std::atomic<int> baud{115200};
+    std::atomic<bool> running{false};
+    std::thread reader;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<uint8_t> rx;
+    size_t rx_capacity = 0;
+
+    line_pacer rx_pacer;   // 仅接收线程使用
+    std::mutex tx_mutex;   // 串行化多个任务的写出
+    line_pacer tx_pacer;
+    bool tx_stall_logged = false;
+};
+
+host_uart uarts[HOST_UART_PORT_COUNT];
+
+bool env_flag(const char* name, bool default_value) {
+    const char* value = getenv(name);
+    if (value == nullptr || *value == '\0') {
+        return default_value;
+    }
+    return strcmp(value, "0") != 0;
+}
+
+int pacing_baud(host_uart& uart) {
+    return env_flag("ESP_HOST_UART_PACING", true) ? uart.baud.load() : 0;
+}
+
+void post_event(host_uart& uart, uart_event_type_t type, size_t size) {
+    if (uart.queue == nullptr) {
+        return;
+    }
+    uart_event_t event = {};
+    event.type = type;
+    event.size = size;
+    xQueueSend(uart.queue, &event, 0);
+}
+
+// 数据到达RX：放入接收缓冲区并投递事件，缓冲区满时与设备驱动一样丢弃数据
+void deliver_rx(host_uart& uart, const uint8_t* data, size_t size) {
+    size_t accepted;
+    {
+        std::lock_guard<std::mutex> lock(uart.mutex);
+        size_t space = uart.rx_capacity - uart.rx.size();
+        accepted = std::min(space, size);
+        uart.rx.insert(uart.rx.end(), data, data + accepted);
+    }
+    uart.cv.notify_all();
+
+    if (accepted > 0) {
+        post_event(uart, UART_DATA, accepted);
+    }
+    if (accepted < size) {
+        post_event(uart, UART_BUFFER_FULL, 0);
+    }
+}
+
+void reader_thread(host_uart* uart) {
+    // 模拟层线程以host_开头命名，与设备任务区分（见wakeup_bench.py）
+    pthread_setname_np(pthread_self(), "host_uart_rx");
+    uint8_t buf[HOST_UART_FIFO_SIZE];
+    while (uart->running) {
+        struct pollfd pfd = {uart->master, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0 || !(pfd.revents & POLLIN)) {
+            continue;
+        }
+        ssize_t len = read(uart->master, buf, sizeof(buf));
+        if (len <= 0) {
+            continue;
+        }
+        uart->rx_pacer.wait(static_cast<size_t>(len), pacing_baud(*uart));
+        deliver_rx(*uart, buf, static_cast<size_t>(len));
+    }
+}
+
+host_uart* get_uart(uart_port_t uart_num) {
+    if (uart_num < 0 || uart_num >= HOST_UART_PORT_COUNT || !uarts[uart_num].installed) {
+        return nullptr;
+    }
+    return &uarts[uart_num];
+}
+
+} // namespace
+
+extern "C" esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size, int, int queue_size,
+                                         QueueHandle_t* uart_queue, int) {
+    if (uart_num < 0 || uart_num >= HOST_UART_PORT_COUNT || rx_buffer_size <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    host_uart& uart = uarts[uart_num];
+    if (uart.installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uart.master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (uart.master < 0 || grantpt(uart.master) != 0 || unlockpt(uart.master) != 0) {
+        ESP_LOGE(TAG, "创建伪终端失败: errno %d", errno);
+        if (uart.master >= 0) {
+            close(uart.master);
+            uart.master = -1;
+        }
+        return ESP_FAIL;
+    }
+
+    // 保持从设备打开并设为原始模式，外部程序关闭从设备时主设备读取不会出错
+    const char* slave_name = ptsname(uart.master);
+    uart.slave = open(slave_name, O_RDWR | O_NOCTTY);
+    if (uart.slave >= 0) {
+        struct termios tio;
+        tcgetattr(uart.slave, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(uart.slave, TCSANOW, &tio);
+    }
+
+    char link_env[32];
+    snprintf(link_env, sizeof(link_env), "ESP_HOST_UART%d_LINK", uart_num);
+    const char* link = getenv(link_env);
+    if (link != nullptr && *link != '\0') {
+        unlink(link);
+        if (symlink(slave_name, link) == 0) {
+            uart.link = link;
+        } else {
+            ESP_LOGW(TAG, "创建符号链接%s失败: errno %d", link, errno);
+        }
+    }
+
+    uart.rx_capacity = static_cast<size_t>(rx_buffer_size);
+    uart.rx.clear();
+    if (uart_queue != nullptr && queue_size > 0) {
+        uart.queue = xQueueCreate(queue_size, sizeof(uart_event_t));
+        *uart_queue = uart.queue;
+    }
+
+    uart.installed = true;
+    uart.running = true;
+    uart.reader = std::thread(reader_thread, &uart);
+
+    if (uart.link.empty()) {
+        ESP_LOGI(TAG, "UART%d -> %s", uart_num, slave_name);
+    } else {
+        ESP_LOGI(TAG, "UART%d -> %s (%s)", uart_num, slave_name, uart.link.c_str());
+    }
+    return ESP_OK;
+}
+
+extern "C" esp_err_t uart_driver_delete(uart_port_t uart_num) {
+    host_uart* uart = get_uart(uart_num);
+    if (uart == nullptr) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uart->running = false;
+    if (uart->reader.joinable()) {
+        uart->reader.join();
+    }
+    if (!uart->link.empty()) {
+        unlink(uart->link.c_str());
+        uart->link.clear();
+    }
+    if (uart->slave >= 0) {
+        close(uart->slave);
+        uart->slave = -1;
+    }
+    close(uart->master);
+    uart->master = -1;
+    if (uart->queue != nullptr) {
+        vQueueDelete(uart->queue);
+        uart->queue = nullptr;
+    }
+    uart->installed = false;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t uart_param_config(uart_port_t uart_num, const uart_config_t* uart_config) {
+    host_uart* uart = get_uart(uart_num);
+    if (uart == nullptr || uart_config == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const char* baud = getenv("ESP_HOST_UART_BAUD");
+    uart->baud = (baud != nullptr && atoi(baud) > 0) ? atoi(baud) : uart_config->baud_rate;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t uart_set_pin(uart_port_t uart_num, int, int, int, int) {
+    return get_uart(uart_num) != nullptr ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+extern "C" int uart_read_bytes(uart_port_t uart_num, void* buf, uint32_t length, TickType_t ticks_to_wait) {
+    host_uart* uart = get_uart(uart_num);
+    if (uart == nullptr || buf == nullptr) {
+        return -1;
+    }
+
+    std::unique_lock<std::mutex> lock(uart->mutex);
+    auto ready = [uart, length] { return uart->rx.size() >= length; };
+    if (ticks_to_wait == portMAX_DELAY) {
+        uart->cv.wait(lock, ready);
+    } else {
+        uart->cv.wait_for(lock, std::chrono::milliseconds(ticks_to_wait * portTICK_PERIOD_MS), ready);
+    }
+
+    size_t n = std::min<size_t>(length, uart->rx.size());
+    std::copy(uart->rx.begin(), uart->rx.begin() + n, static_cast<uint8_t*>(buf));
+    uart->rx.erase(uart->rx.begin(), uart->rx.begin() + n);
+    return static_cast<int>(n);
+}
+
+extern "C" int uart_write_bytes(uart_port_t uart_num, const void* src, size_t size) {
+    host_uart* uart = get_uart(uart_num);
+    if (uart == nullptr || src == nullptr) {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(uart->tx_mutex);
+    uart->tx_pacer.wait(size, pacing_baud(*uart));
+
+    const uint8_t* data = static_cast<const uint8_t*>(src);
+    if (env_flag("ESP_HOST_UART_LOOPBACK", false)) {
+        deliver_rx(*uart, data, size);
+        return static_cast<int>(size);
+    }
+
+    // 线路总会把数据发出去；pty对端长时间不读取时丢弃剩余数据，避免写任务永久阻塞
+    size_t written = 0;
+    while (written < size) {
+        struct pollfd pfd = {uart->master, POLLOUT, 0};
+        if (poll(&pfd, 1, 100) <= 0) {
+            if (!uart->tx_stall_logged) {
+                ESP_LOGW(TAG, "UART%d的pty对端未读取，丢弃TX数据", uart_num);
+                uart->tx_stall_logged = true;
+            }
+            break;
+        }
+        ssize_t n = write(uart->master, data + written, size - written);
+        if (n <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(n);
+        uart->tx_stall_logged = false;
+    }
+    return static_cast<int>(size);
+}
+
+extern "C" esp_err_t uart_flush_input(uart_port_t uart_num) {
+    host_uart* uart = get_uart(uart_num);
+    if (uart == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(uart->mutex);
+    uart->rx.clear();
+    return ESP_OK;
+}
+
+extern "C" esp_err_t uart_get_buffered_data_len(uart_port_t uart_num, size_t* size) {
+    host_uart* uart = get_uart(uart_num);
+    if (uart == nullptr || size == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(uart->mutex);
+    *size = uart->rx.size();
+    return ESP_OK;
+}
+
+extern "C" esp_err_t uart_wait_tx_done(uart_port_t uart_num, TickType_t) {
+    return get_uart(uart_num) != nullptr ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+extern "C" esp_err_t uart_set_wakeup_threshold(uart_port_t uart_num, int) {
+    return get_uart(uart_num) != nullptr ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
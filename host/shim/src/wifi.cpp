@@ -0,0 +1,391 @@
+// 默认事件循环、esp_netif和WiFi站点模式的宿主机实现
+//
+// 宿主机直接使用本机网络，WiFi连接总是成功，获取的IP为127.0.0.1。
+// 事件处理函数在独立的事件循环线程中调用，与设备上的默认事件循环一致。
+//
+// 以下环境变量模拟连接各阶段的耗时和AP（默认全部为0，立即连接）：
+//   ESP_HOST_WIFI_SCAN_MS    全信道扫描耗时，只扫描一个信道时为其1/13
+//   ESP_HOST_WIFI_ASSOC_MS   认证、关联和四次握手耗时
+//   ESP_HOST_WIFI_DHCP_MS    DHCP耗时，停止DHCP使用静态地址时没有
+//   ESP_HOST_WIFI_BSSID      AP的MAC地址，默认02:00:00:00:00:01
+//   ESP_HOST_WIFI_CHANNEL    AP的信道，默认1
+// 配置了BSSID或信道而与AP不符时，扫描该信道后以WIFI_REASON_NO_AP_FOUND断开。
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_wifi.h"
+#include "esp_log.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <pthread.h>
+
+static const char* TAG = "HostWiFi";
+
+extern "C" esp_event_base_t const WIFI_EVENT = "WIFI_EVENT";
+extern "C" esp_event_base_t const IP_EVENT = "IP_EVENT";
+
+namespace {
+
+struct handler_entry {
+    esp_event_base_t base;
+    int32_t id;
+    esp_event_handler_t handler;
+    void* arg;
+};
+
+struct pending_event {
+    esp_event_base_t base;
+    int32_t id;
+    std::vector<uint8_t> data;
+};
+
+struct event_loop {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<handler_entry> handlers;
+    std::deque<pending_event> events;
+    bool running = false;
+};
+
+event_loop loop;
+
+void event_loop_thread() {
+    pthread_setname_np(pthread_self(), "host_event");
+    while (true) {
+        pending_event event;
+        std::vector<handler_entry> handlers;
+        {
+            std::unique_lock<std::mutex> lock(loop.mutex);
+            loop.cv.wait(lock, [] { return !loop.events.empty(); });
+            event = std::move(loop.events.front());
+            loop.events.pop_front();
+            handlers = loop.handlers;
+        }
+
+        // 在锁外调用处理函数，处理函数可以继续投递事件
+        for (const handler_entry& entry : handlers) {
+            if (entry.base == event.base && (entry.id == ESP_EVENT_ANY_ID || entry.id == event.id)) {
+                entry.handler(entry.arg, event.base, event.id, event.data.empty() ? nullptr : event.data.data());
+            }
+        }
+    }
+}
+
+// WiFi状态
+std::mutex wifi_mutex;
+bool wifi_initialized = false;
+bool wifi_started = false;
+bool wifi_connected = false;
+uint32_t wifi_generation = 0;   // 每次断开加1，作废进行中的模拟连接
+wifi_config_t wifi_config = {};
+bool dhcp_running = true;
+esp_netif_ip_info_t static_ip = {};
+esp_netif_dns_info_t dns_info = {};
+
+int env_int(const char* name, int fallback) {
+    const char* value = getenv(name);
+    return value != nullptr ? atoi(value) : fallback;
+}
+
+void ap_bssid(uint8_t* bssid) {
+    unsigned int b[6] = {0x02, 0, 0, 0, 0, 0x01};
+    const char* value = getenv("ESP_HOST_WIFI_BSSID");
+    if (value != nullptr) {
+        sscanf(value, "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]);
+    }
+    for (int i = 0; i < 6; i++) {
+        bssid[i] = static_cast<uint8_t>(b[i]);
+    }
+}
+
+void sleep_ms(int ms) {
+    if (ms > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+}
+
+bool still_connecting(uint32_t generation) {
+    std::lock_guard<std::mutex> lock(wifi_mutex);
+    return wifi_started && generation == wifi_generation;
+}
+
+// 模拟扫描、关联和DHCP，在独立线程中按耗时投递事件
+void simulate_connect(uint32_t generation, wifi_sta_config_t sta) {
+    uint8_t bssid[6];
+    ap_bssid(bssid);
+    uint8_t channel = static_cast<uint8_t>(env_int("ESP_HOST_WIFI_CHANNEL", 1));
+    int scan_ms = env_int("ESP_HOST_WIFI_SCAN_MS", 0);
+
+    // 指定信道时只扫描该信道
+    sleep_ms(sta.channel != 0 ? scan_ms / 13 : scan_ms);
+    if ((sta.channel != 0 && sta.channel != channel) ||
+        (sta.bssid_set && memcmp(sta.bssid, bssid, sizeof(bssid)) != 0)) {
+        {
+            std::lock_guard<std::mutex> lock(wifi_mutex);
+            if (!wifi_started || generation != wifi_generation) {
+                return;
+            }
+            wifi_connected = false;
+        }
+        ESP_LOGI(TAG, "模拟WiFi连接: 信道%u上没有指定的AP", sta.channel);
+        wifi_event_sta_disconnected_t disconnected = {};
+        disconnected.reason = WIFI_REASON_NO_AP_FOUND;
+        esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &disconnected, sizeof(disconnected), portMAX_DELAY);
+        return;
+    }
+
+    sleep_ms(env_int("ESP_HOST_WIFI_ASSOC_MS", 0));
+    if (!still_connecting(generation)) {
+        return;
+    }
+    wifi_event_sta_connected_t connected = {};
+    size_t len = strnlen(reinterpret_cast<const char*>(sta.ssid), sizeof(connected.ssid));
+    memcpy(connected.ssid, sta.ssid, len);
+    connected.ssid_len = static_cast<uint8_t>(len);
+    memcpy(connected.bssid, bssid, sizeof(bssid));
+    connected.channel = channel;
+    connected.authmode = WIFI_AUTH_WPA2_PSK;
+    ESP_LOGI(TAG, "模拟WiFi连接: %.*s", connected.ssid_len, (const char*)connected.ssid);
+    esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, &connected, sizeof(connected), portMAX_DELAY);
+
+    bool dhcp;
+    {
+        std::lock_guard<std::mutex> lock(wifi_mutex);
+        dhcp = dhcp_running;
+    }
+    if (dhcp) {
+        sleep_ms(env_int("ESP_HOST_WIFI_DHCP_MS", 0));
+        if (!still_connecting(generation)) {
+            return;
+        }
+    }
+    ip_event_got_ip_t got_ip = {};
+    esp_netif_get_ip_info(nullptr, &got_ip.ip_info);
+    got_ip.ip_changed = true;
+    esp_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &got_ip, sizeof(got_ip), portMAX_DELAY);
+}
+
+} // namespace
+
+extern "C" esp_err_t esp_event_loop_create_default(void) {
+    std::lock_guard<std::mutex> lock(loop.mutex);
+    if (loop.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    loop.running = true;
+    std::thread(event_loop_thread).detach();
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_event_handler_register(esp_event_base_t event_base, int32_t event_id,
+                                                esp_event_handler_t event_handler, void* event_handler_arg) {
+    std::lock_guard<std::mutex> lock(loop.mutex);
+    loop.handlers.push_back({event_base, event_id, event_handler, event_handler_arg});
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_event_handler_unregister(esp_event_base_t event_base, int32_t event_id,
+                                                  esp_event_handler_t event_handler) {
+    std::lock_guard<std::mutex> lock(loop.mutex);
+    for (auto it = loop.handlers.begin(); it != loop.handlers.end(); ++it) {
+        if (it->base == event_base && it->id == event_id && it->handler == event_handler) {
+            loop.handlers.erase(it);
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+extern "C" esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id, const void* event_data,
+                                    size_t event_data_size, TickType_t) {
+    pending_event event;
+    event.base = event_base;
+    event.id = event_id;
+    if (event_data != nullptr && event_data_size > 0) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(event_data);
+        event.data.assign(bytes, bytes + event_data_size);
+    }
+
+    std::lock_guard<std::mutex> lock(loop.mutex);
+    if (!loop.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    loop.events.push_back(std::move(event));
+    loop.cv.notify_one();
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_netif_init(void) {
+    return ESP_OK;
+}
+
+extern "C" esp_netif_t* esp_netif_create_default_wifi_sta(void) {
+    static int netif;
+    return reinterpret_cast<esp_netif_t*>(&netif);
+}
+
+extern "C" esp_err_t esp_netif_dhcpc_stop(esp_netif_t*) {
+    std::lock_guard<std::mutex> lock(wifi_mutex);
+    dhcp_running = false;
+    return ESP_OK;
+}
+
+// 已连接时启动DHCP立即获得地址（宿主机地址不变）
+extern "C" esp_err_t esp_netif_dhcpc_start(esp_netif_t*) {
+    bool connected;
+    {
+        std::lock_guard<std::mutex> lock(wifi_mutex);
+        if (dhcp_running) {
+            return ESP_OK;
+        }
+        dhcp_running = true;
+        connected = wifi_connected;
+    }
+    if (connected) {
+        ip_event_got_ip_t got_ip = {};
+        esp_netif_get_ip_info(nullptr, &got_ip.ip_info);
+        esp_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &got_ip, sizeof(got_ip), portMAX_DELAY);
+    }
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_netif_set_ip_info(esp_netif_t*, const esp_netif_ip_info_t* ip_info) {
+    if (ip_info == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(wifi_mutex);
+    static_ip = *ip_info;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_netif_get_ip_info(esp_netif_t*, esp_netif_ip_info_t* ip_info) {
+    if (ip_info == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(wifi_mutex);
+    if (!dhcp_running && static_ip.ip.addr != 0) {
+        *ip_info = static_ip;
+        return ESP_OK;
+    }
+    memset(ip_info, 0, sizeof(*ip_info));
+    ip_info->ip.addr = htonl(INADDR_LOOPBACK);
+    ip_info->netmask.addr = htonl(0xFF000000);
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_netif_set_dns_info(esp_netif_t*, esp_netif_dns_type_t, esp_netif_dns_info_t* dns) {
+    if (dns == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(wifi_mutex);
+    dns_info = *dns;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_netif_get_dns_info(esp_netif_t*, esp_netif_dns_type_t, esp_netif_dns_info_t* dns) {
+    if (dns == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(wifi_mutex);
+    *dns = dns_info;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_wifi_init(const wifi_init_config_t*) {
+    std::lock_guard<std::mutex> lock(wifi_mutex);
+    wifi_initialized = true;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_wifi_deinit(void) {
+    std::lock_guard<std::mutex> lock(wifi_mutex);
+    wifi_initialized = false;
+    wifi_started = false;
+    wifi_connected = false;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_wifi_set_mode(wifi_mode_t) {
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_wifi_set_config(wifi_interface_t, wifi_config_t* conf) {
+    if (conf == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(wifi_mutex);
+    wifi_config = *conf;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_wifi_set_ps(wifi_ps_type_t) {
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_wifi_start(void) {
+    {
+        std::lock_guard<std::mutex> lock(wifi_mutex);
+        if (!wifi_initialized) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        wifi_started = true;
+    }
+    return esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_START, nullptr, 0, portMAX_DELAY);
+}
+
+extern "C" esp_err_t esp_wifi_stop(void) {
+    std::lock_guard<std::mutex> lock(wifi_mutex);
+    wifi_started = false;
+    wifi_connected = false;
+    wifi_generation++;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_wifi_connect(void) {
+    wifi_sta_config_t sta;
+    uint32_t generation;
+    {
+        std::lock_guard<std::mutex> lock(wifi_mutex);
+        if (!wifi_started) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        if (wifi_connected) {
+            return ESP_OK;
+        }
+        wifi_connected = true;
+        sta = wifi_config.sta;
+        generation = wifi_generation;
+    }
+    std::thread(simulate_connect, generation, sta).detach();
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_wifi_disconnect(void) {
+    std::lock_guard<std::mutex> lock(wifi_mutex);
+    wifi_connected = false;
+    wifi_generation++;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t* ap_info) {
+    if (ap_info == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(wifi_mutex);
+    if (!wifi_connected) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    memset(ap_info, 0, sizeof(*ap_info));
+    memcpy(ap_info->ssid, wifi_config.sta.ssid, sizeof(wifi_config.sta.ssid));
+    ap_info->primary = 1;
+    ap_info->rssi = -40;
+    return ESP_OK;
+}
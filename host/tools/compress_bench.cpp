@@ -0,0 +1,157 @@
+// 上行压缩性能测试：按不同的刷新间隔（每批字节数）和窗口大小压缩一段遥测数据，
+// 输出压缩率、每字节CPU周期数和每次刷新的耗时（即压缩增加的发送延迟），并解压校验。
+// 结果以JSON输出到标准输出。宿主机的周期数为x86 TSC计数，只用于比较不同配置和提交。
+//
+// 用法: compress_bench [--input 文件] [--bytes N] [--dump 文件]
+// 不指定--input时生成模拟的ASCII遥测数据；--dump写出窗口2^11、每批1024字节的压缩流，
+// 可用test_server/lz_codec.py解压比对。
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "esp_cpu.h"
+#include "lz_codec.h"
+
+using namespace esp_framework;
+
+// 生成模拟遥测：逗号分隔的传感器读数，数值缓慢变化
+static std::vector<uint8_t> generate_telemetry(size_t size) {
+    std::vector<uint8_t> data;
+    uint32_t seed = 1;
+    auto next = [&seed]() {
+        seed = seed * 1103515245u + 12345u;
+        return (seed >> 16) & 0x7FFF;
+    };
+    double temperature = 23.5;
+    double humidity = 45.0;
+    double voltage = 3.70;
+    uint32_t seq = 0;
+    char line[160];
+    while (data.size() < size) {
+        temperature += (static_cast<int>(next() % 5) - 2) * 0.01;
+        humidity += (static_cast<int>(next() % 3) - 1) * 0.1;
+        voltage -= (next() % 50 == 0) ? 0.01 : 0.0;
+        int n = snprintf(line, sizeof(line),
+                         "{\"seq\":%lu,\"node\":\"sensor-%02u\",\"temp\":%.2f,\"hum\":%.1f,\"vbat\":%.2f,\"status\":\"ok\"}\n",
+                         (unsigned long)seq++, static_cast<unsigned>(next() % 4), temperature, humidity, voltage);
+        data.insert(data.end(), line, line + n);
+    }
+    data.resize(size);
+    return data;
+}
+
+int main(int argc, char** argv) {
+    const char* input_path = nullptr;
+    const char* dump_path = nullptr;
+    size_t total = 256 * 1024;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--input") == 0) {
+            input_path = argv[i + 1];
+        } else if (strcmp(argv[i], "--bytes") == 0) {
+            total = strtoul(argv[i + 1], nullptr, 0);
+        } else if (strcmp(argv[i], "--dump") == 0) {
+            dump_path = argv[i + 1];
+        }
+    }
+
+    std::vector<uint8_t> input;
+    if (input_path != nullptr) {
+        FILE* f = fopen(input_path, "rb");
+        if (f == nullptr) {
+            fprintf(stderr, "无法打开%s\n", input_path);
+            return 1;
+        }
+        uint8_t chunk[4096];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+            input.insert(input.end(), chunk, chunk + n);
+        }
+        fclose(f);
+    } else {
+        input = generate_telemetry(total);
+    }
+    if (input.empty()) {
+        fprintf(stderr, "输入为空\n");
+        return 1;
+    }
+
+    // 与网络模块一致，每批最多4000字节
+    const size_t flush_sizes[] = {64, 256, 1024, 4000};
+    std::vector<uint8_t> out(lz_encoder::max_compressed_size(4000));
+    std::vector<uint8_t> decoded(input.size());
+    std::vector<uint8_t> dump;
+    bool ok = true;
+
+    printf("{\n  \"input\": \"%s\",\n  \"input_bytes\": %zu,\n  \"results\": [\n",
+           input_path != nullptr ? input_path : "telemetry", input.size());
+    bool first = true;
+    for (uint8_t bits = LZ_MIN_WINDOW_BITS; bits <= LZ_MAX_WINDOW_BITS; bits++) {
+        for (size_t flush : flush_sizes) {
+            lz_encoder encoder;
+            lz_decoder decoder;
+            if (!encoder.init(bits) || !decoder.init(bits)) {
+                return 1;
+            }
+
+            uint64_t cycles = 0;
+            double total_us = 0;
+            double max_us = 0;
+            size_t compressed = 0;
+            size_t produced = 0;
+            size_t flushes = 0;
+            for (size_t offset = 0; offset < input.size(); offset += flush) {
+                struct iovec iov;
+                iov.iov_base = input.data() + offset;
+                iov.iov_len = std::min(flush, input.size() - offset);
+
+                auto start = std::chrono::steady_clock::now();
+                esp_cpu_cycle_count_t start_cycles = esp_cpu_get_cycle_count();
+                size_t size = encoder.compress(&iov, 1, out.data());
+                cycles += static_cast<esp_cpu_cycle_count_t>(esp_cpu_get_cycle_count() - start_cycles);
+                double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+                total_us += us;
+                max_us = std::max(max_us, us);
+                compressed += size;
+                flushes++;
+
+                if (dump_path != nullptr && bits == 11 && flush == 1024) {
+                    dump.insert(dump.end(), out.begin(), out.begin() + size);
+                }
+
+                int n = decoder.decompress(out.data(), size, decoded.data() + produced, decoded.size() - produced);
+                if (n < 0) {
+                    fprintf(stderr, "解压失败: 窗口2^%u, 每批%zu字节, 偏移%zu\n", bits, flush, offset);
+                    ok = false;
+                    break;
+                }
+                produced += static_cast<size_t>(n);
+            }
+            bool match = produced == input.size() && memcmp(decoded.data(), input.data(), input.size()) == 0;
+            ok = ok && match;
+
+            printf("%s    {\"window_bits\": %u, \"flush_bytes\": %zu, \"compressed_bytes\": %zu, \"ratio\": %.4f, "
+                   "\"cycles_per_byte\": %.2f, \"ns_per_byte\": %.2f, \"flush_avg_us\": %.2f, \"flush_max_us\": %.2f, "
+                   "\"encoder_ram_bytes\": %zu, \"verified\": %s}",
+                   first ? "" : ",\n", bits, flush, compressed, (double)compressed / input.size(),
+                   (double)cycles / input.size(), total_us * 1000.0 / input.size(), total_us / flushes, max_us,
+                   (static_cast<size_t>(2) << bits) + (static_cast<size_t>(1) << bits),
+                   match ? "true" : "false");
+            first = false;
+        }
+    }
+    printf("\n  ]\n}\n");
+
+    if (dump_path != nullptr) {
+        FILE* f = fopen(dump_path, "wb");
+        if (f == nullptr || fwrite(dump.data(), 1, dump.size(), f) != dump.size()) {
+            fprintf(stderr, "无法写入%s\n", dump_path);
+            ok = false;
+        }
+        if (f != nullptr) {
+            fclose(f);
+        }
+    }
+    return ok ? 0 : 1;
+}
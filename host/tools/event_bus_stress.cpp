@@ -0,0 +1,248 @@
+// 事件总线并发压力测试：多个发布线程持续publish()/post()，同时多个线程反复订阅和取消订阅监听器，
+// 覆盖基于纪元的快照回收（active_publishers_、retired_）和已销毁监听器的清理（stale_mask_）。
+// 用ThreadSanitizer构建（-DHOST_TSAN=ON）运行时可发现数据竞争和释放后使用。
+//
+// 用法: event_bus_stress [--publishers N] [--churners N] [--seconds N]
+// 订阅线程每轮随机执行一种操作：
+//   订阅新监听器，短暂等待后取消订阅并立即销毁（取消订阅返回后不应再被调用）
+//   订阅一次性监听器，它在on_event()中取消自己的订阅（发布路径内取消订阅不等待）
+//   订阅新监听器后释放其引用而不取消订阅，监听器随即销毁（可能正被发布者调用），留下过期条目由stale_mask_标记后清理
+// 结束后输出各操作次数，检查已销毁监听器被调用的次数和回收后剩余的旧快照数，均应为0，否则返回1。
+// outstanding_heap_blocks为测试期间未释放的堆块数，只供参考：retired_等容器扩容后保留容量，可能为1~2。
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "buffer_pool.h"
+#include "esp_log.h"
+#include "event_system.h"
+#include "heap_monitor.h"
+
+using namespace esp_framework;
+
+// 参与测试的事件类型
+static const event_type STRESS_TYPES[] = {
+    event_type::data_received,
+    event_type::device_error,
+    event_type::uplink_high_watermark,
+};
+static constexpr size_t STRESS_TYPE_COUNT = sizeof(STRESS_TYPES) / sizeof(STRESS_TYPES[0]);
+
+static std::atomic<bool> s_start(false);
+static std::atomic<bool> s_stop(false);
+static std::atomic<uint32_t> s_running(0);
+static std::atomic<uint32_t> s_finished(0);
+static std::atomic<uint64_t> s_publishes(0);
+static std::atomic<uint64_t> s_posts(0);
+static std::atomic<uint64_t> s_calls(0);
+static std::atomic<uint64_t> s_bad_calls(0);
+static std::atomic<uint64_t> s_subscribes(0);
+static std::atomic<uint64_t> s_self_unsubscribes(0);
+static std::atomic<uint64_t> s_expired(0);
+
+// 销毁时清除标记，被已销毁的对象调用时计数（ThreadSanitizer同时报告释放后使用）
+class stress_listener : public event_listener {
+public:
+    static constexpr uint32_t ALIVE = 0x4C495645;
+    static constexpr uint32_t DEAD = 0xDEADDEAD;
+
+    ~stress_listener() override {
+        magic_.store(DEAD);
+    }
+
+    void on_event(const event_data& event) override {
+        if (magic_.load(std::memory_order_relaxed) != ALIVE) {
+            s_bad_calls.fetch_add(1);
+            return;
+        }
+        // 读取数据，使缓冲池缓冲区的引用计数和内容也参与竞争检测
+        const uint8_t* data = event.payload();
+        if (data != nullptr && event.data_size > 0 && data[event.data_size - 1] != static_cast<uint8_t>(event.data_size)) {
+            s_bad_calls.fetch_add(1);
+        }
+        s_calls.fetch_add(1, std::memory_order_relaxed);
+        handled(event);
+    }
+
+protected:
+    virtual void handled(const event_data&) {}
+
+private:
+    std::atomic<uint32_t> magic_{ALIVE};
+};
+
+// 第一次收到事件时取消自己的订阅
+class one_shot_listener : public stress_listener {
+public:
+    explicit one_shot_listener(event_type type) : type_(type), fired_(false) {}
+
+    std::weak_ptr<event_listener> self;
+
+protected:
+    void handled(const event_data&) override {
+        if (fired_.exchange(true)) {
+            return;
+        }
+        std::shared_ptr<event_listener> ref = self.lock();
+        if (ref) {
+            event_bus::get_instance().unsubscribe(type_, ref);
+            s_self_unsubscribes.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    event_type type_;
+    std::atomic<bool> fired_;
+};
+
+// 所有线程就绪后同时开始，测试结束后线程保持存活直到统计完成，堆统计不包含线程的创建和退出
+static void wait_start() {
+    s_running.fetch_add(1);
+    while (!s_start.load()) {
+        std::this_thread::yield();
+    }
+}
+
+static void finish() {
+    s_finished.fetch_add(1);
+    while (s_stop.load() && s_finished.load() != 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+static uint32_t next_random(uint32_t& seed) {
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+static void publisher(uint32_t id) {
+    auto& bus = event_bus::get_instance();
+    uint32_t seed = id + 1;
+    uint8_t data[200];
+    uint64_t count = 0;
+    wait_start();
+    while (!s_stop.load(std::memory_order_relaxed)) {
+        event_type type = STRESS_TYPES[next_random(seed) % STRESS_TYPE_COUNT];
+        // 数据末字节为长度，监听器据此检查内容；较大的数据使用缓冲池
+        size_t size = (next_random(seed) % 8 == 0) ? sizeof(data) : 4;
+        memset(data, static_cast<int>(id), size);
+        data[size - 1] = static_cast<uint8_t>(size);
+        event_data event(type, event_data_type::binary, data, size);
+        if (count++ % 16 == 0) {
+            bus.post(event);
+            s_posts.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            bus.publish(event);
+            s_publishes.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    finish();
+}
+
+static void churner(uint32_t id) {
+    auto& bus = event_bus::get_instance();
+    uint32_t seed = 1000 + id;
+    wait_start();
+    while (!s_stop.load(std::memory_order_relaxed)) {
+        event_type type = STRESS_TYPES[next_random(seed) % STRESS_TYPE_COUNT];
+        uint32_t op = next_random(seed) % 4;
+        if (op <= 1) {
+            auto listener = std::make_shared<stress_listener>();
+            bus.subscribe(type, listener);
+            std::this_thread::sleep_for(std::chrono::microseconds(next_random(seed) % 200));
+            bus.unsubscribe(type, listener);
+        } else if (op == 2) {
+            auto listener = std::make_shared<one_shot_listener>(type);
+            listener->self = listener;
+            bus.subscribe(type, listener);
+            std::this_thread::sleep_for(std::chrono::microseconds(next_random(seed) % 200));
+            bus.unsubscribe(type, listener);
+        } else {
+            // 不取消订阅，最后一个外部引用释放后监听器即被销毁
+            auto listener = std::make_shared<stress_listener>();
+            bus.subscribe(type, listener);
+            std::this_thread::sleep_for(std::chrono::microseconds(next_random(seed) % 200));
+            listener.reset();
+            s_expired.fetch_add(1, std::memory_order_relaxed);
+        }
+        s_subscribes.fetch_add(1, std::memory_order_relaxed);
+    }
+    finish();
+}
+
+int main(int argc, char** argv) {
+    uint32_t publishers = 4;
+    uint32_t churners = 2;
+    uint32_t seconds = 5;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        uint32_t value = strtoul(argv[i + 1], nullptr, 0);
+        if (strcmp(argv[i], "--publishers") == 0) {
+            publishers = value;
+        } else if (strcmp(argv[i], "--churners") == 0) {
+            churners = value;
+        } else if (strcmp(argv[i], "--seconds") == 0) {
+            seconds = value;
+        }
+    }
+
+    // 订阅变更和队列满丢弃的日志会淹没输出
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    buffer_pool::get_instance().init();
+    auto& bus = event_bus::get_instance();
+    uint32_t total = publishers + churners;
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < publishers; i++) {
+        threads.emplace_back(publisher, i);
+    }
+    for (uint32_t i = 0; i < churners; i++) {
+        threads.emplace_back(churner, i);
+    }
+    while (s_running.load() != total) {
+        std::this_thread::yield();
+    }
+    heap_call_stats before = heap_monitor::get_stats();
+    s_start.store(true);
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    s_stop.store(true);
+    while (s_finished.load() != total) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // 等待分发任务处理完队列；过期条目只在发布时被标记，每种类型再发布一次后清理并回收全部旧快照
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    for (event_type type : STRESS_TYPES) {
+        bus.publish(event_data(type));
+    }
+    bus.reap_expired();
+    bus.reap_expired();
+    size_t retired = bus.get_retired_count();
+    heap_call_stats after = heap_monitor::get_stats();
+    int64_t outstanding = static_cast<int64_t>(after.allocs - before.allocs) - (after.frees - before.frees);
+    s_finished.store(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    bool ok = s_bad_calls.load() == 0 && retired == 0;
+    printf("{\n  \"seconds\": %lu,\n  \"publishers\": %lu,\n  \"churners\": %lu,\n",
+           (unsigned long)seconds, (unsigned long)publishers, (unsigned long)churners);
+    printf("  \"publishes\": %llu,\n  \"posts\": %llu,\n  \"posts_dropped\": %lu,\n  \"listener_calls\": %llu,\n",
+           (unsigned long long)s_publishes.load(), (unsigned long long)s_posts.load(),
+           (unsigned long)bus.get_dropped_count(), (unsigned long long)s_calls.load());
+    printf("  \"subscribes\": %llu,\n  \"self_unsubscribes\": %llu,\n  \"expired_listeners\": %llu,\n",
+           (unsigned long long)s_subscribes.load(), (unsigned long long)s_self_unsubscribes.load(),
+           (unsigned long long)s_expired.load());
+    printf("  \"calls_after_destroy\": %llu,\n  \"retired_lists\": %zu,\n  \"outstanding_heap_blocks\": %lld,\n"
+           "  \"ok\": %s\n}\n",
+           (unsigned long long)s_bad_calls.load(), retired, static_cast<long long>(outstanding), ok ? "true" : "false");
+
+    // 分发任务仍在运行，不执行静态析构
+    fflush(stdout);
+    _exit(ok ? 0 : 1);
+}
@@ -0,0 +1,183 @@
+// 事件数据堆测试：按固定速率（默认1kHz）post()内联数据和缓冲池数据的事件，由一个监听器接收，
+// 分别输出每个阶段的堆调用次数（heap_monitor）、数据存储方式（event_data::get_alloc_stats）、
+// 缓冲池回退到堆分配的次数、丢弃的事件数，以及周期采样的空闲堆、最大空闲块和碎片率（1 - 最大空闲块/空闲堆）。
+// 事件数据不应访问堆，即各阶段堆调用次数和回退次数为0、碎片率不随时间增长。
+// 宿主机的最大空闲块由glibc的空闲块分布估算，只反映趋势；设备上为heap_caps的实际值。
+//
+// 用法: event_payload_bench [--seconds N] [--rate N] [--inline-bytes N] [--pool-bytes N]
+// --seconds为每个阶段的时长，--rate为每秒投递的事件数；
+// --inline-bytes不应超过EVENT_INLINE_PAYLOAD_SIZE，--pool-bytes应超过它。
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "buffer_pool.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "event_system.h"
+#include "heap_monitor.h"
+#include "sdkconfig.h"
+
+using namespace esp_framework;
+
+// 堆采样间隔
+static constexpr uint32_t SAMPLE_INTERVAL_MS = 100;
+
+// 读取数据并检查内容的监听器
+class payload_listener : public event_listener {
+public:
+    void on_event(const event_data& event) override {
+        const uint8_t* data = event.payload();
+        if (data == nullptr || event.data_size == 0 || data[event.data_size - 1] != static_cast<uint8_t>(event.data_size)) {
+            corrupt.fetch_add(1, std::memory_order_relaxed);
+        }
+        handled.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint32_t> handled{0};
+    std::atomic<uint32_t> corrupt{0};
+};
+
+struct heap_sample {
+    size_t free_bytes;
+    size_t largest_block;
+};
+
+static heap_sample sample_heap() {
+    heap_sample sample;
+    sample.free_bytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    sample.largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    return sample;
+}
+
+static double fragmentation(const heap_sample& sample) {
+    return sample.free_bytes > 0 ? 1.0 - static_cast<double>(sample.largest_block) / sample.free_bytes : 0.0;
+}
+
+static bool run_phase(const char* name, size_t payload, uint32_t seconds, uint32_t rate, bool last) {
+    auto& bus = event_bus::get_instance();
+    const event_type type = event_type::data_received;
+    auto listener = std::make_shared<payload_listener>();
+    bus.subscribe(type, listener);
+
+    // 数据末字节为长度，监听器据此检查内容
+    std::vector<uint8_t> data(payload, 0xA5);
+    data[payload - 1] = static_cast<uint8_t>(payload);
+
+    uint32_t events = seconds * rate;
+    uint32_t sample_every = rate * SAMPLE_INTERVAL_MS / 1000;
+    if (sample_every == 0) {
+        sample_every = 1;
+    }
+
+    heap_sample first = sample_heap();
+    heap_sample last_sample = first;
+    double max_frag = fragmentation(first);
+    size_t min_largest = first.largest_block;
+    uint32_t samples = 1;
+
+    heap_call_stats heap_before = heap_monitor::get_stats();
+    buffer_pool_stats pool_before = buffer_pool::get_instance().get_stats();
+    event_alloc_stats data_before = event_data::get_alloc_stats();
+    uint32_t dropped_before = bus.get_dropped_count();
+    uint32_t accepted = 0;
+
+    auto interval = std::chrono::nanoseconds(1000000000ull / rate);
+    auto next = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < events; i++) {
+        event_data event(type, event_data_type::binary, data.data(), data.size());
+        accepted += bus.post(event) ? 1 : 0;
+        if ((i + 1) % sample_every == 0) {
+            last_sample = sample_heap();
+            double frag = fragmentation(last_sample);
+            max_frag = frag > max_frag ? frag : max_frag;
+            min_largest = last_sample.largest_block < min_largest ? last_sample.largest_block : min_largest;
+            samples++;
+        }
+        next += interval;
+        std::this_thread::sleep_until(next);
+    }
+
+    // 等待分发任务处理完已入队的事件
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (listener->handled.load() < accepted && std::chrono::steady_clock::now() < deadline) {
+        usleep(1000);
+    }
+
+    heap_call_stats heap_after = heap_monitor::get_stats();
+    buffer_pool_stats pool_after = buffer_pool::get_instance().get_stats();
+    event_alloc_stats data_after = event_data::get_alloc_stats();
+    uint32_t dropped = bus.get_dropped_count() - dropped_before;
+    bus.unsubscribe(type, listener);
+
+    uint32_t heap_allocs = heap_after.allocs - heap_before.allocs;
+    uint32_t heap_frees = heap_after.frees - heap_before.frees;
+    uint32_t fallbacks = pool_after.fallback_allocs - pool_before.fallback_allocs;
+    uint32_t corrupt = listener->corrupt.load();
+
+    printf("    {\"phase\": \"%s\", \"payload_bytes\": %zu, \"events\": %lu, \"dropped\": %lu, \"delivered\": %lu, "
+           "\"corrupt\": %lu,\n",
+           name, payload, (unsigned long)events, (unsigned long)dropped,
+           (unsigned long)listener->handled.load(), (unsigned long)corrupt);
+    printf("     \"inline_payloads\": %lu, \"buffer_payloads\": %lu, \"pool_acquired\": %lu, \"pool_fallback_allocs\": %lu, "
+           "\"pool_failures\": %lu,\n",
+           (unsigned long)(data_after.inline_payloads - data_before.inline_payloads),
+           (unsigned long)(data_after.buffer_payloads - data_before.buffer_payloads),
+           (unsigned long)(pool_after.acquired - pool_before.acquired), (unsigned long)fallbacks,
+           (unsigned long)(pool_after.failures - pool_before.failures));
+    printf("     \"heap_allocs\": %lu, \"heap_frees\": %lu, \"heap_samples\": %lu,\n",
+           (unsigned long)heap_allocs, (unsigned long)heap_frees, (unsigned long)samples);
+    printf("     \"free_bytes\": [%zu, %zu], \"largest_free_block\": [%zu, %zu], \"min_largest_free_block\": %zu,\n",
+           first.free_bytes, last_sample.free_bytes, first.largest_block, last_sample.largest_block, min_largest);
+    printf("     \"fragmentation\": [%.3f, %.3f], \"max_fragmentation\": %.3f}%s\n",
+           fragmentation(first), fragmentation(last_sample), max_frag, last ? "" : ",");
+
+    return heap_allocs == 0 && fallbacks == 0 && corrupt == 0;
+}
+
+int main(int argc, char** argv) {
+    uint32_t seconds = 5;
+    uint32_t rate = 1000;
+    uint32_t inline_bytes = 16;
+    uint32_t pool_bytes = 200;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        uint32_t value = strtoul(argv[i + 1], nullptr, 0);
+        if (strcmp(argv[i], "--seconds") == 0) {
+            seconds = value;
+        } else if (strcmp(argv[i], "--rate") == 0) {
+            rate = value;
+        } else if (strcmp(argv[i], "--inline-bytes") == 0) {
+            inline_bytes = value;
+        } else if (strcmp(argv[i], "--pool-bytes") == 0) {
+            pool_bytes = value;
+        }
+    }
+    if (rate == 0 || inline_bytes == 0 || pool_bytes == 0) {
+        fprintf(stderr, "--rate、--inline-bytes和--pool-bytes必须大于0\n");
+        return 2;
+    }
+
+    // 订阅变更和队列满丢弃的日志会淹没输出
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    buffer_pool::get_instance().init();
+    // 分发任务首次运行时的分配不计入第一个阶段
+    event_bus::get_instance().post(event_data(event_type::data_received));
+    usleep(10000);
+
+    printf("{\n  \"seconds\": %lu,\n  \"rate_hz\": %lu,\n  \"inline_limit\": %d,\n  \"heap_monitor\": %s,\n",
+           (unsigned long)seconds, (unsigned long)rate, CONFIG_EVENT_INLINE_PAYLOAD_SIZE,
+           heap_monitor::enabled() ? "true" : "false");
+    printf("  \"results\": [\n");
+    bool ok = run_phase("inline", inline_bytes, seconds, rate, false);
+    ok = run_phase("pool", pool_bytes, seconds, rate, true) && ok;
+    printf("  ],\n  \"allocation_free\": %s\n}\n", heap_monitor::enabled() && ok ? "true" : "false");
+
+    // 分发任务仍在运行，不执行静态析构
+    fflush(stdout);
+    _exit(ok ? 0 : 1);
+}
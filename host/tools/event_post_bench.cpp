@@ -0,0 +1,134 @@
+// 事件投递延迟测试：订阅1、4、16个慢监听器（每个事件阻塞--listener-ms毫秒），按固定间隔post()事件，
+// 测量发布者一侧每次post()的耗时（入队和队列满丢弃分别统计）和丢弃的事件数，并与同步publish()的耗时比较。
+// 结果以JSON输出到标准输出。宿主机的耗时反映软件开销，用于比较不同实现和提交。
+//
+// 用法: event_post_bench [--events N] [--interval-us N] [--listener-ms N]
+// post()不应随监听器数量和监听器耗时变慢；慢监听器跟不上投递速率时事件在队列满后被丢弃。
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "event_system.h"
+#include "sdkconfig.h"
+
+using namespace esp_framework;
+
+// 模拟阻塞在I/O上的监听器
+class slow_listener : public event_listener {
+public:
+    slow_listener(std::atomic<uint32_t>& handled, uint32_t delay_ms) : handled_(handled), delay_ms_(delay_ms) {}
+
+    void on_event(const event_data&) override {
+        if (delay_ms_ > 0) {
+            vTaskDelay(pdMS_TO_TICKS(delay_ms_));
+        }
+        handled_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint32_t>& handled_;
+    uint32_t delay_ms_;
+};
+
+static void print_latency(const char* key, std::vector<double>& samples) {
+    std::sort(samples.begin(), samples.end());
+    auto at = [&samples](double q) {
+        return samples.empty() ? 0.0 : samples[static_cast<size_t>(q * (samples.size() - 1))];
+    };
+    printf("\"%s\": {\"calls\": %zu, \"p50_ns\": %.0f, \"p99_ns\": %.0f, \"max_ns\": %.0f}",
+           key, samples.size(), at(0.5), at(0.99), samples.empty() ? 0.0 : samples.back());
+}
+
+int main(int argc, char** argv) {
+    uint32_t events = 2000;
+    uint32_t interval_us = 1000;
+    uint32_t listener_ms = 2;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        uint32_t value = strtoul(argv[i + 1], nullptr, 0);
+        if (strcmp(argv[i], "--events") == 0) {
+            events = value;
+        } else if (strcmp(argv[i], "--interval-us") == 0) {
+            interval_us = value;
+        } else if (strcmp(argv[i], "--listener-ms") == 0) {
+            listener_ms = value;
+        }
+    }
+
+    auto& bus = event_bus::get_instance();
+    const event_type type = event_type::data_received;
+    const size_t counts[] = {1, 4, 16};
+
+    printf("{\n  \"events\": %lu,\n  \"interval_us\": %lu,\n  \"listener_ms\": %lu,\n  \"queue_length\": %d,\n",
+           (unsigned long)events, (unsigned long)interval_us, (unsigned long)listener_ms,
+           CONFIG_EVENT_BUS_QUEUE_LENGTH);
+    printf("  \"results\": [\n");
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        size_t n = counts[c];
+        std::atomic<uint32_t> handled(0);
+        std::vector<std::shared_ptr<event_listener>> listeners;
+        for (size_t i = 0; i < n; i++) {
+            listeners.push_back(std::make_shared<slow_listener>(handled, listener_ms));
+            bus.subscribe(type, listeners.back());
+        }
+
+        // 异步投递：按固定间隔post()，只计入发布者一侧的耗时
+        std::vector<double> post_ns;
+        std::vector<double> dropped_ns;
+        post_ns.reserve(events);
+        dropped_ns.reserve(events);
+        uint32_t dropped_before = bus.get_dropped_count();
+        uint32_t accepted = 0;
+        auto next = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < events; i++) {
+            event_data event = event_data::from_integer(type, static_cast<int32_t>(i));
+            auto start = std::chrono::steady_clock::now();
+            bool ok = bus.post(event);
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            (ok ? post_ns : dropped_ns).push_back(ns);
+            accepted += ok ? 1 : 0;
+            next += std::chrono::microseconds(interval_us);
+            std::this_thread::sleep_until(next);
+        }
+        uint32_t dropped = bus.get_dropped_count() - dropped_before;
+
+        // 等待分发任务处理完已入队的事件
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+        while (handled.load() < accepted * n && std::chrono::steady_clock::now() < deadline) {
+            usleep(1000);
+        }
+        uint32_t delivered = handled.load() / static_cast<uint32_t>(n);
+
+        // 同步发布：发布者依次执行所有监听器，次数较少以限制运行时间
+        std::vector<double> publish_ns;
+        uint32_t publish_events = std::min<uint32_t>(events, 50);
+        for (uint32_t i = 0; i < publish_events; i++) {
+            event_data event = event_data::from_integer(type, static_cast<int32_t>(i));
+            auto start = std::chrono::steady_clock::now();
+            bus.publish(event);
+            publish_ns.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        for (auto& listener : listeners) {
+            bus.unsubscribe(type, listener);
+        }
+
+        printf("%s    {\"listeners\": %zu, ", c == 0 ? "" : ",\n", n);
+        print_latency("post", post_ns);
+        printf(", ");
+        print_latency("post_dropped", dropped_ns);
+        printf(", \"dropped\": %lu, \"delivered\": %lu, ", (unsigned long)dropped, (unsigned long)delivered);
+        print_latency("publish", publish_ns);
+        printf("}");
+    }
+    printf("\n  ]\n}\n");
+
+    // 分发任务仍在运行，不执行静态析构
+    fflush(stdout);
+    _exit(0);
+}
@@ -0,0 +1,111 @@
+// 事件发布性能测试：按订阅者数量（0~--max-listeners，按2的幂递增）同步publish()事件，
+// 输出每次发布的平均耗时和发布期间的堆调用次数，并按最小二乘拟合每个监听器的耗时。
+// 发布路径应为O(监听器数)且不访问堆，即耗时随监听器数线性增长、堆调用次数为0。
+// 结果以JSON输出到标准输出。宿主机的耗时反映软件开销，用于比较不同实现和提交。
+//
+// 用法: event_publish_bench [--events N] [--max-listeners N] [--payload N]
+// --payload为事件数据字节数，不超过EVENT_INLINE_PAYLOAD_SIZE时内联存储，否则使用缓冲池。
+// 堆调用次数需要CONFIG_HEAP_CALL_COUNTER（宿主机默认启用）。
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <unistd.h>
+#include <vector>
+#include "buffer_pool.h"
+#include "event_system.h"
+#include "heap_monitor.h"
+#include "sdkconfig.h"
+
+using namespace esp_framework;
+
+// 只读取数据的监听器，耗时接近监听器调用本身的开销
+class counting_listener : public event_listener {
+public:
+    explicit counting_listener(std::atomic<uint32_t>& sum) : sum_(sum) {}
+
+    void on_event(const event_data& event) override {
+        sum_.fetch_add(event.payload() != nullptr ? event.payload()[0] : 1, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint32_t>& sum_;
+};
+
+int main(int argc, char** argv) {
+    uint32_t events = 100000;
+    uint32_t max_listeners = 64;
+    uint32_t payload = sizeof(int32_t);
+    for (int i = 1; i + 1 < argc; i += 2) {
+        uint32_t value = strtoul(argv[i + 1], nullptr, 0);
+        if (strcmp(argv[i], "--events") == 0) {
+            events = value;
+        } else if (strcmp(argv[i], "--max-listeners") == 0) {
+            max_listeners = value;
+        } else if (strcmp(argv[i], "--payload") == 0) {
+            payload = value;
+        }
+    }
+
+    buffer_pool::get_instance().init();
+    auto& bus = event_bus::get_instance();
+    const event_type type = event_type::data_received;
+    std::vector<uint8_t> data(payload, 0x5A);
+    event_data event(type, event_data_type::binary, data.data(), data.size());
+
+    std::atomic<uint32_t> sum(0);
+    std::vector<std::shared_ptr<event_listener>> listeners;
+    listeners.reserve(max_listeners);
+
+    printf("{\n  \"events\": %lu,\n  \"payload_bytes\": %lu,\n  \"inline\": %s,\n  \"heap_monitor\": %s,\n",
+           (unsigned long)events, (unsigned long)payload, event.buffer ? "false" : "true",
+           heap_monitor::enabled() ? "true" : "false");
+    printf("  \"results\": [\n");
+
+    // 拟合 耗时 = a + b * 监听器数
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    int points = 0;
+    uint32_t total_allocs = 0;
+    for (uint32_t n = 0; n <= max_listeners; n = n == 0 ? 1 : n * 2) {
+        while (listeners.size() < n) {
+            listeners.push_back(std::make_shared<counting_listener>(sum));
+            bus.subscribe(type, listeners.back());
+        }
+
+        // 预热一轮，再统计计时轮的堆调用
+        for (uint32_t i = 0; i < events / 10; i++) {
+            bus.publish(event);
+        }
+        heap_call_stats before = heap_monitor::get_stats();
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < events; i++) {
+            bus.publish(event);
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / events;
+        heap_call_stats after = heap_monitor::get_stats();
+        uint32_t allocs = after.allocs - before.allocs;
+        uint32_t frees = after.frees - before.frees;
+        total_allocs += allocs;
+
+        sx += n;
+        sy += ns;
+        sxx += static_cast<double>(n) * n;
+        sxy += n * ns;
+        points++;
+        printf("%s    {\"listeners\": %lu, \"ns_per_publish\": %.1f, \"ns_per_listener\": %.2f, "
+               "\"heap_allocs\": %lu, \"heap_frees\": %lu}",
+               n == 0 ? "" : ",\n", (unsigned long)n, ns, n > 0 ? ns / n : 0.0,
+               (unsigned long)allocs, (unsigned long)frees);
+    }
+
+    double slope = points > 1 ? (points * sxy - sx * sy) / (points * sxx - sx * sx) : 0.0;
+    double intercept = points > 0 ? (sy - slope * sx) / points : 0.0;
+    printf("\n  ],\n  \"fit\": {\"base_ns\": %.1f, \"ns_per_listener\": %.2f},\n  \"allocation_free\": %s\n}\n",
+           intercept, slope, heap_monitor::enabled() && total_allocs == 0 ? "true" : "false");
+
+    // 分发任务仍在运行，不执行静态析构
+    fflush(stdout);
+    _exit(0);
+}
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+根据Kconfig默认值生成宿主机构建使用的sdkconfig.h
+
+依次读取:
+  1. main/Kconfig.projbuild 中各配置项的默认值
+  2. 若干sdkconfig格式的覆盖文件（CONFIG_X=值），后面的文件优先
+"""
+
+import argparse
+import re
+import sys
+
+
+def parse_kconfig(path):
+    """解析Kconfig，返回 [(名称, 类型, 默认值)]，只取每项的第一个default"""
+    options = []
+    name = None
+    kind = None
+    default = None
+
+    def flush():
+        if name is not None and kind is not None:
+            options.append((name, kind, default))
+
+    with open(path, encoding='utf-8') as f:
+        for raw in f:
+            line = raw.strip()
+            m = re.match(r'^(?:menu)?config\s+(\w+)$', line)
+            if m:
+                flush()
+                name, kind, default = m.group(1), None, None
+                continue
+            m = re.match(r'^(bool|int|hex|string)\b', line)
+            if m and name is not None and kind is None:
+                kind = m.group(1)
+                continue
+            m = re.match(r'^default\s+(.+?)(?:\s+if\s+.*)?$', line)
+            if m and name is not None and default is None:
+                default = m.group(1)
+    flush()
+    return options
+
+
+def parse_overrides(path):
+    """解析sdkconfig格式文件，返回 {名称: 值}"""
+    values = {}
+    with open(path, encoding='utf-8') as f:
+        for raw in f:
+            line = raw.strip()
+            m = re.match(r'^CONFIG_(\w+)=(.*)$', line)
+            if m:
+                values[m.group(1)] = m.group(2)
+                continue
+            m = re.match(r'^#\s*CONFIG_(\w+) is not set$', line)
+            if m:
+                values[m.group(1)] = 'n'
+    return values
+
+
+def render(name, kind, value):
+    """生成一行#define，bool为n时不定义"""
+    if kind == 'bool':
+        return f'#define CONFIG_{name} 1' if value == 'y' else None
+    if kind == 'string':
+        if not value.startswith('"'):
+            value = '"' + value + '"'
+        return f'#define CONFIG_{name} {value}'
+    return f'#define CONFIG_{name} {value}'
+
+
+def guess_kind(value):
+    if value in ('y', 'n'):
+        return 'bool'
+    if value.startswith('"'):
+        return 'string'
+    return 'int'
+
+
+def main():
+    parser = argparse.ArgumentParser(description='生成宿主机sdkconfig.h')
+    parser.add_argument('--kconfig', required=True, help='Kconfig.projbuild路径')
+    parser.add_argument('--override', action='append', default=[], help='sdkconfig格式的覆盖文件')
+    parser.add_argument('--output', required=True, help='输出的sdkconfig.h路径')
+    args = parser.parse_args()
+
+    options = parse_kconfig(args.kconfig)
+    values = {name: default for name, _, default in options}
+    kinds = {name: kind for name, kind, _ in options}
+    for path in args.override:
+        for name, value in parse_overrides(path).items():
+            values[name] = value
+            kinds.setdefault(name, guess_kind(value))
+
+    lines = ['/* 由host/tools/gen_sdkconfig.py生成，请勿手动修改 */', '#pragma once', '']
+    for name in values:
+        value = values[name]
+        if value is None:
+            if kinds[name] == 'bool':
+                continue
+            sys.exit(f'配置项 CONFIG_{name} 没有默认值')
+        line = render(name, kinds[name], value)
+        if line:
+            lines.append(line)
+
+    content = '\n'.join(lines) + '\n'
+    try:
+        with open(args.output, encoding='utf-8') as f:
+            if f.read() == content:
+                return
+    except FileNotFoundError:
+        pass
+    with open(args.output, 'w', encoding='utf-8') as f:
+        f.write(content)
+
+
+if __name__ == '__main__':
+    main()
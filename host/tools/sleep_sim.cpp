@@ -0,0 +1,191 @@
+// 省电档位策略仿真：按流量记录回放数据事件，用与设备相同的sleep_policy选择档位，
+// 输出各档位的时间、占空比、UART唤醒次数和平均电流估算，并与固定档位比较。
+// 结果以JSON输出到标准输出。电流为sleep_policy中的模型估算值，用于比较策略参数和流量形态。
+//
+// 用法: sleep_sim [--trace 文件] [--active-gap ms] [--light-gap ms] [--dwell ms]
+//                 [--hold ms] [--listen-interval n] [--tick ms] [--duration s]
+// 记录文件每行一个数据事件："时间(秒) [字节数]"，按时间排序，#开头为注释，
+// 可由test_server/traffic_trace.py录制或生成。不指定--trace时使用生成的混合流量：
+// 密集突发、周期性遥测和长时间静默交替。--tick为0（默认）时与设备上的pmu一样按
+// next_update_us()安排更新，大于0时按固定周期轮询，用于比较两者的档位时间和更新次数。
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "sdkconfig.h"
+#include "sleep_policy.h"
+
+using namespace esp_framework;
+
+// 生成混合流量：每轮依次为5ms间隔的突发、200ms间隔的遥测、5s间隔的心跳和静默
+static std::vector<int64_t> generate_trace() {
+    std::vector<int64_t> events;
+    uint32_t seed = 1;
+    auto jitter = [&seed](int64_t range_us) {
+        seed = seed * 1103515245u + 12345u;
+        return static_cast<int64_t>((seed >> 8) % static_cast<uint32_t>(range_us));
+    };
+    int64_t t = 1000000;
+    for (int round = 0; round < 5; round++) {
+        for (int i = 0; i < 2000; i++) {
+            events.push_back(t);
+            t += 5000 + jitter(1000);
+        }
+        for (int i = 0; i < 150; i++) {
+            events.push_back(t);
+            t += 200000 + jitter(20000);
+        }
+        for (int i = 0; i < 12; i++) {
+            events.push_back(t);
+            t += 5000000 + jitter(100000);
+        }
+        t += 60000000;
+    }
+    return events;
+}
+
+static bool load_trace(const char* path, std::vector<int64_t>& events) {
+    FILE* f = fopen(path, "r");
+    if (f == nullptr) {
+        fprintf(stderr, "无法打开%s\n", path);
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f) != nullptr) {
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        char* end = nullptr;
+        double seconds = strtod(line, &end);
+        if (end == line) {
+            continue;
+        }
+        events.push_back(static_cast<int64_t>(seconds * 1e6));
+    }
+    fclose(f);
+    std::sort(events.begin(), events.end());
+    return true;
+}
+
+// 回放一次，按pmu的方式交替调用on_event()和周期性的update()
+static void run(const char* name, const sleep_policy_config& config, const std::vector<int64_t>& events,
+                int64_t tick_us, int64_t end_us, bool first) {
+    sleep_policy policy(config);
+    policy.reset(0);
+    uint32_t switches = 0;
+    uint32_t updates = 0;
+    // 按定时器回放：到期时更新并重新安排，事件只会提前下一次更新
+    auto after = [&policy, tick_us](int64_t now) { return tick_us > 0 ? now + tick_us : policy.next_update_us(now); };
+    int64_t next = tick_us > 0 ? 0 : policy.next_update_us(0);
+    for (int64_t t : events) {
+        while (next <= t) {
+            switches += policy.update(next) ? 1 : 0;
+            updates++;
+            next = after(next);
+        }
+        switches += policy.on_event(t) ? 1 : 0;
+        if (tick_us == 0) {
+            next = std::min(next, policy.next_update_us(t));
+        }
+    }
+    while (next <= end_us) {
+        switches += policy.update(next) ? 1 : 0;
+        updates++;
+        next = after(next);
+    }
+
+    power_tier_stats stats[POWER_TIER_COUNT];
+    policy.get_stats(end_us, stats);
+    double total_s = 0.0;
+    double charge = 0.0;
+    double awake_s = 0.0;
+    printf("%s    {\"policy\": \"%s\", \"tiers\": [", first ? "" : ",\n", name);
+    for (size_t i = 0; i < POWER_TIER_COUNT; i++) {
+        power_tier tier = static_cast<power_tier>(i);
+        double seconds = stats[i].time_us / 1e6;
+        float ma = sleep_policy::estimate_ma(tier, stats[i]);
+        total_s += seconds;
+        charge += ma * seconds;
+        awake_s += stats[i].awake_us / 1e6;
+        static const char* keys[POWER_TIER_COUNT] = {"active", "modem_sleep", "light_sleep"};
+        printf("%s\n      {\"tier\": \"%s\", \"time_s\": %.3f, \"duty_cycle\": %.4f, \"current_ma\": %.3f, "
+               "\"events\": %lu, \"wakeups\": %lu, \"entries\": %lu}",
+               i == 0 ? "" : ",", keys[i], seconds, sleep_policy::duty_cycle(stats[i]), ma,
+               (unsigned long)stats[i].events, (unsigned long)stats[i].wakeups, (unsigned long)stats[i].entries);
+    }
+    printf("\n    ], \"switches\": %lu, \"updates_per_hour\": %.0f, \"duty_cycle\": %.4f, \"avg_current_ma\": %.3f, "
+           "\"uart_wakeups\": %lu}",
+           (unsigned long)switches, total_s > 0 ? updates * 3600.0 / total_s : 0.0,
+           total_s > 0 ? awake_s / total_s : 0.0, total_s > 0 ? charge / total_s : 0.0,
+           (unsigned long)stats[static_cast<size_t>(power_tier::light_sleep)].wakeups);
+}
+
+int main(int argc, char** argv) {
+    const char* trace_path = nullptr;
+    sleep_policy_config config;
+    config.active_gap_ms = CONFIG_POWER_ACTIVE_GAP_MS;
+    config.light_gap_ms = CONFIG_POWER_LIGHT_GAP_MS;
+    config.dwell_ms = CONFIG_POWER_TIER_DWELL_MS;
+    config.hold_ms = CONFIG_POWER_LIGHT_SLEEP_HOLD_MS;
+    config.listen_interval = CONFIG_POWER_WIFI_LISTEN_INTERVAL;
+    int64_t tick_ms = 0;
+    double duration_s = 0.0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        uint32_t value = strtoul(argv[i + 1], nullptr, 0);
+        if (strcmp(argv[i], "--trace") == 0) {
+            trace_path = argv[i + 1];
+        } else if (strcmp(argv[i], "--active-gap") == 0) {
+            config.active_gap_ms = value;
+        } else if (strcmp(argv[i], "--light-gap") == 0) {
+            config.light_gap_ms = value;
+        } else if (strcmp(argv[i], "--dwell") == 0) {
+            config.dwell_ms = value;
+        } else if (strcmp(argv[i], "--hold") == 0) {
+            config.hold_ms = value;
+        } else if (strcmp(argv[i], "--listen-interval") == 0) {
+            config.listen_interval = value;
+        } else if (strcmp(argv[i], "--tick") == 0) {
+            tick_ms = value;
+        } else if (strcmp(argv[i], "--duration") == 0) {
+            duration_s = strtod(argv[i + 1], nullptr);
+        }
+    }
+
+    std::vector<int64_t> events;
+    if (trace_path != nullptr) {
+        if (!load_trace(trace_path, events)) {
+            return 1;
+        }
+    } else {
+        events = generate_trace();
+    }
+    if (events.empty()) {
+        fprintf(stderr, "记录为空\n");
+        return 1;
+    }
+    int64_t end_us = std::max(events.back() + static_cast<int64_t>(config.hold_ms) * 1000,
+                              static_cast<int64_t>(duration_s * 1e6));
+
+    printf("{\n  \"trace\": \"%s\",\n  \"events\": %zu,\n  \"duration_s\": %.3f,\n", trace_path != nullptr ? trace_path : "mixed",
+           events.size(), end_us / 1e6);
+    printf("  \"config\": {\"active_gap_ms\": %lu, \"light_gap_ms\": %lu, \"dwell_ms\": %lu, \"hold_ms\": %lu, "
+           "\"listen_interval\": %lu, \"tick_ms\": %lld},\n",
+           (unsigned long)config.active_gap_ms, (unsigned long)config.light_gap_ms, (unsigned long)config.dwell_ms,
+           (unsigned long)config.hold_ms, (unsigned long)config.listen_interval, (long long)tick_ms);
+    printf("  \"results\": [\n");
+
+    // 自适应策略与三个固定档位：阈值取极值使目标档位恒定，驻留时间为0使其立即生效
+    run("adaptive", config, events, tick_ms * 1000, end_us, true);
+    sleep_policy_config fixed = config;
+    fixed.dwell_ms = 0;
+    fixed.active_gap_ms = UINT32_MAX;
+    fixed.light_gap_ms = UINT32_MAX;
+    run("fixed_active", fixed, events, tick_ms * 1000, end_us, false);
+    fixed.active_gap_ms = 0;
+    run("fixed_modem_sleep", fixed, events, tick_ms * 1000, end_us, false);
+    fixed.light_gap_ms = 0;
+    run("fixed_light_sleep", fixed, events, tick_ms * 1000, end_us, false);
+    printf("\n  ]\n}\n");
+    return 0;
+}
@@ -0,0 +1,123 @@
+// 闪存缓存性能测试：在宿主机的分区映像上测量追加速率、满分区的启动恢复时间和读出速率，
+// 并多次写满分区检查各段擦除次数是否均衡。结果以JSON输出到标准输出。
+// 宿主机映像位于内存映射文件中，数值反映软件开销，不代表真实闪存的写入和擦除耗时。
+//
+// 用法: spool_bench [--record-size N] [--passes N]
+// 分区映像默认为spool_bench.img，可用ESP_HOST_PARTITION_SPOOL指定，运行前会被删除。
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+#include "flash_spool.h"
+#include "nvs_flash.h"
+#include "sdkconfig.h"
+
+using namespace esp_framework;
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void fill_record(std::vector<uint8_t>& record, uint32_t index) {
+    for (size_t i = 0; i < record.size(); i++) {
+        record[i] = static_cast<uint8_t>(index * 31 + i);
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t record_size = 256;
+    int passes = 3;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--record-size") == 0) {
+            record_size = strtoul(argv[i + 1], nullptr, 0);
+        } else if (strcmp(argv[i], "--passes") == 0) {
+            passes = atoi(argv[i + 1]);
+        }
+    }
+
+    const char* label = CONFIG_FLASH_SPOOL_PARTITION_LABEL;
+    setenv("ESP_HOST_PARTITION_SPOOL", "spool_bench.img", 0);
+    unlink(getenv("ESP_HOST_PARTITION_SPOOL"));
+    unsetenv("ESP_HOST_NVS_FILE");
+    nvs_flash_init();
+
+    flash_spool writer(label);
+    if (!writer.init()) {
+        fprintf(stderr, "分区%s不可用\n", label);
+        return 1;
+    }
+    if (record_size == 0 || record_size > writer.max_record_size()) {
+        fprintf(stderr, "记录长度必须在1~%zu之间\n", writer.max_record_size());
+        return 1;
+    }
+
+    // 追加直到写满分区
+    std::vector<uint8_t> record(record_size);
+    uint32_t appended = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (true) {
+        fill_record(record, appended);
+        if (!writer.append(record.data(), record.size(), false)) {
+            break;
+        }
+        appended++;
+    }
+    double append_ms = elapsed_ms(start);
+    writer.commit_cursor();
+    flash_spool_stats full = writer.get_stats();
+
+    // 用新实例模拟重启，测量满分区的恢复时间
+    flash_spool reader(label);
+    start = std::chrono::steady_clock::now();
+    reader.init();
+    double recovery_ms = elapsed_ms(start);
+    flash_spool_stats recovered = reader.get_stats();
+
+    // 读出并校验全部记录
+    std::vector<uint8_t> expected(record_size);
+    std::vector<uint8_t> buffer(reader.max_record_size());
+    uint32_t read = 0;
+    uint32_t mismatched = 0;
+    start = std::chrono::steady_clock::now();
+    while (size_t size = reader.front_size()) {
+        if (reader.read_front(buffer.data())) {
+            fill_record(expected, read);
+            if (size != record_size || memcmp(buffer.data(), expected.data(), size) != 0) {
+                mismatched++;
+            }
+            read++;
+            reader.pop();
+        }
+    }
+    double read_ms = elapsed_ms(start);
+
+    // 按丢弃最早策略反复写满，检查擦除次数
+    uint64_t wear_bytes = static_cast<uint64_t>(passes) * recovered.segments * recovered.segment_size;
+    for (uint64_t written = 0; written < wear_bytes; written += record_size) {
+        reader.append(record.data(), record.size(), true);
+    }
+    flash_spool wear(label);
+    wear.init();
+    flash_spool_stats worn = wear.get_stats();
+
+    double bytes = static_cast<double>(appended) * record_size;
+    printf("{\n");
+    printf("  \"partition_bytes\": %lu,\n", (unsigned long)full.segments * full.segment_size);
+    printf("  \"segment_size\": %lu,\n", (unsigned long)full.segment_size);
+    printf("  \"record_size\": %zu,\n", record_size);
+    printf("  \"records\": %lu,\n", (unsigned long)appended);
+    printf("  \"payload_bytes\": %.0f,\n", bytes);
+    printf("  \"append_mb_s\": %.2f,\n", bytes / 1e6 / (append_ms / 1000));
+    printf("  \"recovery_ms\": %.3f,\n", recovery_ms);
+    printf("  \"recovered_pending_bytes\": %lu,\n", (unsigned long)recovered.pending_bytes);
+    printf("  \"read_mb_s\": %.2f,\n", read / 1e6 * record_size / (read_ms / 1000));
+    printf("  \"read_records\": %lu,\n", (unsigned long)read);
+    printf("  \"mismatched_records\": %lu,\n", (unsigned long)mismatched);
+    printf("  \"wear_passes\": %d,\n", passes);
+    printf("  \"min_erase_count\": %lu,\n", (unsigned long)worn.min_erase_count);
+    printf("  \"max_erase_count\": %lu\n", (unsigned long)worn.max_erase_count);
+    printf("}\n");
+    return read == appended && mismatched == 0 ? 0 : 1;
+}
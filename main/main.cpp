@@ -9,15 +9,27 @@
 #include "device.h"
 #include "device_manager.h"
 #include "network_module.h"
+#include "dns_cache.h"
+#include "store_forward.h"
 #include "battery_manager.h"
 #include "pmu.h"
 #include "uart_device.h"
+#include "buffer_pool.h"
+#include "heap_monitor.h"
+#include "timer_service.h"
 
 // 使用命名空间
 using namespace esp_framework;
 
 static const char* TAG = "Main";
 
+#if CONFIG_UART_LOOPBACK_TEST
+// 回环测试的发送间隔
+#define UART_LOOPBACK_INTERVAL_MS 1000
+
+static timer_id uart_echo_timer = TIMER_INVALID;
+#endif
+
 // 系统状态监听器
 class system_listener : public event_listener {
 public:
@@ -32,9 +44,9 @@ public:
                 break;
                 
             case event_type::data_received:
-                if (event.data_type == event_data_type::string && event.data) {
-                    // ESP_LOGI(TAG, "接收到数据: %s", (const char*)event.data.get());
-                } else if (event.data_type == event_data_type::binary && event.data) {
+                if (event.data_type == event_data_type::string && event.payload()) {
+                    // ESP_LOGI(TAG, "接收到数据: %.*s", (int)event.data_size, (const char*)event.payload());
+                } else if (event.data_type == event_data_type::binary && event.payload()) {
                     // ESP_LOGI(TAG, "接收到二进制数据: %zu字节", event.data_size);
                 }
                 break;
@@ -63,6 +75,44 @@ public:
                 ESP_LOGI(TAG, "系统准备进入深度睡眠");
                 break;
                 
+            case event_type::uplink_high_watermark:
+                ESP_LOGW(TAG, "上行队列积压: %ld字节", (long)event.as_integer());
+                break;
+                
+            case event_type::uplink_low_watermark:
+                ESP_LOGI(TAG, "上行队列积压解除: %ld字节", (long)event.as_integer());
+                break;
+                
+            case event_type::tcp_state_changed:
+                on_tcp_state(static_cast<connection_state>(event.as_integer()));
+                break;
+                
+            default:
+                break;
+        }
+    }
+    
+private:
+    void on_tcp_state(connection_state state) {
+        switch (state) {
+            case connection_state::connected: {
+                ESP_LOGI(TAG, "已连接到TCP服务器");
+                
+                // 每次连接后发送测试数据
+                const char* test_msg = "Hello from ESP32S3!";
+                std::vector<uint8_t> data(test_msg, test_msg + strlen(test_msg));
+                if (network_module::get_instance().send_data(data)) {
+                    ESP_LOGI(TAG, "测试数据发送成功");
+                } else {
+                    ESP_LOGE(TAG, "测试数据发送失败");
+                }
+                break;
+            }
+            
+            case connection_state::waiting_wifi:
+                ESP_LOGW(TAG, "等待WiFi连接");
+                break;
+                
             default:
                 break;
         }
@@ -115,10 +165,12 @@ void main_task(void* pvParameter) {
     event_bus::get_instance().subscribe(event_type::battery_temp_high, sys_listener);
     event_bus::get_instance().subscribe(event_type::battery_temp_normal, sys_listener);
     event_bus::get_instance().subscribe(event_type::enter_deep_sleep, sys_listener);
+    event_bus::get_instance().subscribe(event_type::uplink_high_watermark, sys_listener);
+    event_bus::get_instance().subscribe(event_type::uplink_low_watermark, sys_listener);
+    event_bus::get_instance().subscribe(event_type::tcp_state_changed, sys_listener);
     
-    // 获取网络模块和电池管理器实例
+    // 获取网络模块实例
     auto& net_module = network_module::get_instance();
-    auto& batt_mgr = battery_manager::get_instance();
     //从dev_mgr中获取uart_device
     auto uart_dev = std::dynamic_pointer_cast<uart_device>(dev_mgr->get_device_by_name("uart_device"));
     if (!uart_dev) {
@@ -137,54 +189,28 @@ void main_task(void* pvParameter) {
     } else {
         ESP_LOGI(TAG, "WiFi配置正确，准备连接WiFi: SSID=%s, 密码长度=%d", ssid, strlen(password));
         
-        bool wifi_connected = net_module.connect_wifi(ssid, password);
-        if (!wifi_connected) {
-            ESP_LOGE(TAG, "WiFi连接失败，无法继续网络操作");
+        // WiFi首次连接失败时由连接管理任务继续重连
+        if (net_module.connect_wifi(ssid, password)) {
+            ESP_LOGI(TAG, "WiFi连接成功");
         } else {
-            ESP_LOGI(TAG, "WiFi连接成功，准备连接TCP服务器");
-            
-            // 连接TCP服务器
-            const char* server_ip = CONFIG_TCP_SERVER_IP;
-            uint16_t server_port = CONFIG_TCP_SERVER_PORT;
-            
-            if (server_ip == NULL) {
-                ESP_LOGE(TAG, "TCP服务器IP配置错误");
-            } else {
-                ESP_LOGI(TAG, "正在连接TCP服务器: %s:%u", server_ip, server_port);
-                
-                // 尝试连接多次
-                bool tcp_connected = false;
-                for (int retry = 0; retry < 3; retry++) {
-                    ESP_LOGI(TAG, "尝试TCP连接，第%d次", retry + 1);
-                    tcp_connected = net_module.connect_tcp(server_ip, server_port);
-                    if (tcp_connected) {
-                        ESP_LOGI(TAG, "已连接到TCP服务器");
-                        
-                        // 发送测试数据
-                        const char* test_msg = "Hello from ESP32S3!";
-                        std::vector<uint8_t>* data = new std::vector<uint8_t>(test_msg, test_msg + strlen(test_msg));
-                        if (net_module.send_data(*data)) {
-                            ESP_LOGI(TAG, "测试数据发送成功");
-                        } else {
-                            ESP_LOGE(TAG, "测试数据发送失败");
-                        }
-                        delete data;
-                        break;
-                    } else {
-                        ESP_LOGW(TAG, "TCP服务器连接失败，重试 %d/3", retry + 1);
-                        vTaskDelay(1000 / portTICK_PERIOD_MS);
-                    }
-                }
-                
-                if (!tcp_connected) {
-                    ESP_LOGE(TAG, "多次连接TCP服务器失败");
-                }
-            }
+            ESP_LOGW(TAG, "WiFi首次连接失败，将在后台重连");
+        }
+        
+        // 启动TCP连接管理，连接和断线重连在网络模块的任务中进行，不阻塞主任务
+        std::vector<server_endpoint> servers;
+        servers.push_back({CONFIG_TCP_SERVER_IP, CONFIG_TCP_SERVER_PORT});
+        if (!endpoint_list::parse(CONFIG_TCP_SERVER_FALLBACKS, CONFIG_TCP_SERVER_PORT, servers)) {
+            ESP_LOGE(TAG, "备用服务器配置错误，只使用主服务器");
+            servers.resize(1);
+        }
+        for (const auto& server : servers) {
+            ESP_LOGI(TAG, "TCP服务器: %s:%u", server.host.c_str(), server.port);
         }
+        net_module.start_connection(servers);
     }
     
-    // 创建PMU并获取锁
-    power_mgr = new pmu(*dev_mgr, CONFIG_POWER_SAVE_TIMEOUT);
+    // 创建PMU，数据和网络事件视为活动，各模块按需持有唤醒锁
+    power_mgr = new pmu(*dev_mgr, CONFIG_POWER_SAVE_TIMEOUT, CONFIG_POWER_ACTIVITY_GRACE_S);
     if (!power_mgr) {
         ESP_LOGE(TAG, "电源管理器创建失败");
         // 释放传入的设备管理器资源
@@ -194,23 +220,135 @@ void main_task(void* pvParameter) {
         vTaskDelete(NULL);
         return;
     }
-    power_mgr->lock(); // 初始时锁定，防止系统立即进入低功耗
+    
+    // 电池采样和电源管理由各自的定时器驱动，主任务只在统计定时器到期时被唤醒
+    auto& timers = timer_service::get_instance();
+    TaskHandle_t main_handle = xTaskGetCurrentTaskHandle();
+    timer_id stats_timer = timers.add("stats", [main_handle] { xTaskNotifyGive(main_handle); });
+    timers.schedule_in(stats_timer, CONFIG_STATS_LOG_INTERVAL_S * 1000);
+    
+#if CONFIG_UART_LOOPBACK_TEST
+    // uart1 echo，tx rx 短接了
+    uart_echo_timer = timers.add("uart_echo", [uart_dev] {
+        uart_dev->send_data("Hello from uart1!");
+        timer_service::get_instance().schedule_in(uart_echo_timer, UART_LOOPBACK_INTERVAL_MS);
+    });
+    timers.schedule_in(uart_echo_timer, UART_LOOPBACK_INTERVAL_MS);
+#endif
+    
+    // 上次统计时的堆调用次数
+    heap_call_stats last_heap_stats = heap_monitor::get_stats();
     
     // 主循环
     while (1) {
-        // 处理网络事件
-        net_module.loop();
+        // 无限期等待统计定时器
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        timers.schedule_in(stats_timer, CONFIG_STATS_LOG_INTERVAL_S * 1000);
         
-        // 处理电池管理
-        batt_mgr.loop();
+        // 定期输出转发统计，以及回环测试期间的堆调用次数和缓冲池使用情况
+        uart_forward_stats fwd = uart_dev->get_forward_stats();
+        ESP_LOGI(TAG, "UART转发: 接收%lu字节, 转发%lu字节, 每字节复制%.2f次",
+                 (unsigned long)fwd.rx_bytes, (unsigned long)fwd.forwarded_bytes,
+                 fwd.forwarded_bytes > 0 ? (double)fwd.copied_bytes / fwd.forwarded_bytes : 0.0);
+        ESP_LOGI(TAG, "UART下行: 写出%lu字节, 丢弃%lu字节",
+                 (unsigned long)fwd.tx_bytes, (unsigned long)fwd.tx_dropped_bytes);
         
-        // 处理电源管理
-        power_mgr->loop();
+        uplink_stats up = network_module::get_instance().get_uplink_stats();
+        ESP_LOGI(TAG, "上行队列: 当前%lu字节, 峰值%lu字节, 已发送%lu字节, 丢弃%lu字节, 未连接交还缓存%lu字节, 未连接丢弃%lu字节",
+                 (unsigned long)up.queued_bytes, (unsigned long)up.peak_queued_bytes,
+                 (unsigned long)up.sent_bytes, (unsigned long)up.dropped_bytes,
+                 (unsigned long)up.requeued_bytes, (unsigned long)up.unsent_bytes);
+        ESP_LOGI(TAG, "上行合并: %lu个数据块, %lu次发送(阈值%lu, 超时%lu, 分隔符%lu)",
+                 (unsigned long)up.chunks, (unsigned long)up.send_calls,
+                 (unsigned long)up.flush_by_size, (unsigned long)up.flush_by_timeout,
+                 (unsigned long)up.flush_by_delimiter);
         
-        // uart1 echo，tx rx 短接了
-        uart_dev->send_data("Hello from uart1!");
-        // 每秒执行一次
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
+        connection_stats conn = net_module.get_connection_stats();
+        ESP_LOGI(TAG, "TCP连接: 状态%ld, 尝试%lu次, 失败%lu次, 重连%lu次(最近%lums, 最长%lums), WiFi重连%lu次, 切换服务器%lu次",
+                 (long)conn.state, (unsigned long)conn.attempts, (unsigned long)conn.failures,
+                 (unsigned long)conn.reconnects, (unsigned long)conn.last_reconnect_ms,
+                 (unsigned long)conn.max_reconnect_ms, (unsigned long)conn.wifi_retries,
+                 (unsigned long)conn.failovers);
+        for (const auto& ep : net_module.get_endpoint_stats()) {
+            ESP_LOGI(TAG, "服务器%s:%u%s: 健康分%u, 参与%lu次, 成功%lu次, 失败%lu次",
+                     ep.host.c_str(), ep.port, ep.pinned ? "(当前)" : "", ep.score,
+                     (unsigned long)ep.attempts, (unsigned long)ep.wins, (unsigned long)ep.failures);
+        }
+        boot_timing boot = net_module.get_boot_timing();
+        ESP_LOGI(TAG, "启动耗时: %s%s, 关联%lums, 获得IP %lums, 连接服务器%lums, 首次发送%lums, 退回全信道扫描%lu次",
+                 boot.cached_ap ? "按记录连接AP" : "全信道扫描",
+                 boot.reused_lease ? ", 使用记录的地址" : ", DHCP",
+                 (unsigned long)boot.assoc_ms, (unsigned long)boot.ip_ms, (unsigned long)boot.tcp_ms,
+                 (unsigned long)boot.first_byte_ms, (unsigned long)boot.fallbacks);
+        
+        store_forward_stats sf = store_forward::get_instance().get_stats();
+        ESP_LOGI(TAG, "存储转发: 缓存%lu字节(RAM %lu, PSRAM %lu, 闪存 %lu, 峰值%lu), 累计缓存%lu字节, 重放%lu字节, 丢弃%lu字节",
+                 (unsigned long)sf.buffered_bytes, (unsigned long)sf.ram_bytes,
+                 (unsigned long)sf.psram_bytes, (unsigned long)sf.flash_bytes,
+                 (unsigned long)sf.peak_buffered_bytes,
+                 (unsigned long)sf.stored_bytes, (unsigned long)sf.replayed_bytes,
+                 (unsigned long)sf.dropped_bytes);
+        
+#if CONFIG_UPLINK_COMPRESS
+        compress_stats comp = network_module::get_instance().get_compress_stats();
+        ESP_LOGI(TAG, "上行压缩: %lu -> %lu字节(%.1f%%), 刷新%lu次, 每字节%.1f周期, 每次平均%luus/最长%luus",
+                 (unsigned long)comp.input_bytes, (unsigned long)comp.output_bytes,
+                 comp.input_bytes > 0 ? 100.0 * comp.output_bytes / comp.input_bytes : 0.0,
+                 (unsigned long)comp.flushes,
+                 comp.input_bytes > 0 ? (double)comp.cycles / comp.input_bytes : 0.0,
+                 (unsigned long)comp.avg_time_us, (unsigned long)comp.max_time_us);
+#endif
+        
+        if (net_module.get_transport() == transport_type::udp) {
+            udp_transport_stats udp = net_module.get_udp_stats();
+            ESP_LOGI(TAG, "UDP: 发送%lu个数据报(丢弃%lu), 接收%lu个(丢失%lu, 乱序%lu)",
+                     (unsigned long)udp.tx_datagrams, (unsigned long)udp.tx_dropped,
+                     (unsigned long)udp.rx_datagrams, (unsigned long)udp.rx_lost,
+                     (unsigned long)udp.rx_reordered);
+        }
+        
+        dns_cache_stats dns = dns_cache::get_instance().get_stats();
+        ESP_LOGI(TAG, "DNS缓存: 命中%lu次, 过期使用%lu次, 同步解析%lu次, 后台解析%lu次, 失败%lu次, 解析耗时最近%lums/最长%lums",
+                 (unsigned long)dns.fresh_hits, (unsigned long)dns.stale_hits,
+                 (unsigned long)dns.lookups, (unsigned long)dns.refreshes, (unsigned long)dns.failures,
+                 (unsigned long)dns.last_lookup_ms, (unsigned long)dns.max_lookup_ms);
+        
+#if CONFIG_TLS_ENABLE
+        tls_stats tls = network_module::get_instance().get_tls_stats();
+        ESP_LOGI(TAG, "TLS: 完整握手%lu次(平均%lums, 运算%lums, %lu字节), 会话恢复%lu次(平均%lums, 运算%lums, %lu字节), 失败%lu次, 最近一次%s %lums",
+                 (unsigned long)tls.full_handshakes, (unsigned long)tls.avg_full_ms,
+                 (unsigned long)tls.avg_full_compute_ms, (unsigned long)tls.avg_full_bytes,
+                 (unsigned long)tls.resumed_handshakes, (unsigned long)tls.avg_resumed_ms,
+                 (unsigned long)tls.avg_resumed_compute_ms, (unsigned long)tls.avg_resumed_bytes,
+                 (unsigned long)tls.failed_handshakes, tls.last_resumed ? "恢复" : "完整",
+                 (unsigned long)tls.last_handshake_ms);
+#endif
+        
+#if CONFIG_PROTOCOL_FRAMING
+        frame_protocol_stats proto = network_module::get_instance().get_protocol_stats();
+        ESP_LOGI(TAG, "帧协议: 已发送%lu帧, 已确认%lu帧, 未确认%lu帧(%lu字节), 重传%lu帧, 确认延迟平均%lums/最长%lums, 窗口满%lu次, 下行%lu帧(校验错误%lu, 帧号不连续%lu)",
+                 (unsigned long)proto.sent_frames, (unsigned long)proto.acked_frames,
+                 (unsigned long)proto.in_flight_frames, (unsigned long)proto.in_flight_bytes,
+                 (unsigned long)proto.retransmitted_frames, (unsigned long)proto.ack_latency_avg_ms,
+                 (unsigned long)proto.ack_latency_max_ms, (unsigned long)proto.window_full_waits,
+                 (unsigned long)proto.rx_frames, (unsigned long)proto.rx_crc_errors,
+                 (unsigned long)proto.rx_seq_gaps);
+#endif
+        
+        power_mgr->dump();
+        timers.dump(TAG);
+        
+        if (heap_monitor::enabled()) {
+            heap_call_stats heap_stats = heap_monitor::get_stats();
+            buffer_pool_stats pool_stats = buffer_pool::get_instance().get_stats();
+            ESP_LOGI(TAG, "堆调用: malloc +%lu, free +%lu; 缓冲池: 分配%lu, 堆回退%lu, 失败%lu",
+                     (unsigned long)(heap_stats.allocs - last_heap_stats.allocs),
+                     (unsigned long)(heap_stats.frees - last_heap_stats.frees),
+                     (unsigned long)pool_stats.acquired,
+                     (unsigned long)pool_stats.fallback_allocs,
+                     (unsigned long)pool_stats.failures);
+            last_heap_stats = heap_stats;
+        }
     }
     
     // 此处实际上不会执行到，但为了代码完整性添加释放资源代码
@@ -235,6 +373,21 @@ extern "C" void app_main(void)
     
     ESP_LOGI(TAG, "空闲堆内存: %lu字节", esp_get_free_heap_size());
     
+    // 预分配数据缓冲池，数据路径上不再调用malloc
+    if (!buffer_pool::get_instance().init()) {
+        ESP_LOGE(TAG, "缓冲池初始化失败，数据路径将回退到堆分配");
+    }
+    
+    // TCP断开期间缓存UART数据，重新连接后重放
+    if (!store_forward::get_instance().init()) {
+        ESP_LOGE(TAG, "存储转发初始化失败，TCP断开期间的数据将被丢弃");
+    }
+    
+    // 电池采样、电源管理和统计日志的定时器在此任务中触发
+    if (!timer_service::get_instance().init()) {
+        ESP_LOGE(TAG, "定时器服务启动失败，电池采样和自动低功耗将不可用");
+    }
+    
     // 创建并初始化设备管理器
     device_manager* dev_mgr = new device_manager();
     
@@ -0,0 +1,417 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+UART→TCP桥接端到端基准测试
+
+按配置的数据模式向ESP32 UART注入数据，同时作为本地TCP服务器接收转发结果，
+记录每个字节的注入时间和到达时间，统计吞吐量、延迟分位数和丢失字节数，输出JSON结果。
+
+两种运行方式：
+  宿主机：--host-binary 指定 esp32_bridge_host，每个波特率启动一次，通过伪终端注入
+  设备：  --serial 指定连接ESP32 UART RX引脚的串口（需要pyserial），设备须配置为连接本机
+"""
+
+import argparse
+import json
+import logging
+import os
+import random
+import socket
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+from lz_codec import LzDecoder
+
+# 配置日志
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s - %(levelname)s - %(message)s'
+)
+logger = logging.getLogger(__name__)
+
+PATTERNS = ('burst', 'random', 'lines', 'telemetry', 'stream')
+
+
+class TcpSink:
+    def __init__(self, host, port, window_bits=None):
+        """本地TCP接收端，记录每次接收的时间和字节范围
+
+        Args:
+            host: 监听地址
+            port: 监听端口
+            window_bits: 设备启用了上行压缩时为压缩窗口大小对数，记录解压后的数据
+        """
+        self.server_socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.server_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.server_socket.bind((host, port))
+        self.server_socket.listen(1)
+        self.client_socket = None
+        self.lock = threading.Lock()
+        self.data = bytearray()
+        self.arrivals = []      # (时间, 起始偏移, 结束偏移)
+        self.wire_bytes = 0
+        self.decoder = LzDecoder(window_bits) if window_bits else None
+        self.closed = False
+
+    def accept(self, timeout):
+        """等待设备连接"""
+        self.server_socket.settimeout(timeout)
+        self.client_socket, addr = self.server_socket.accept()
+        logger.info(f"设备已连接: {addr[0]}:{addr[1]}")
+        thread = threading.Thread(target=self._receive)
+        thread.daemon = True
+        thread.start()
+
+    def _receive(self):
+        while True:
+            try:
+                data = self.client_socket.recv(65536)
+            except OSError:
+                data = b''
+            now = time.monotonic()
+            if not data:
+                self.closed = True
+                return
+            with self.lock:
+                self.wire_bytes += len(data)
+                if self.decoder:
+                    data = self.decoder.feed(data)
+                    if not data:
+                        continue
+                start = len(self.data)
+                self.data += data
+                self.arrivals.append((now, start, start + len(data)))
+
+    def reset(self):
+        """丢弃已接收的数据（连接时的问候数据、上一轮的残留数据）"""
+        with self.lock:
+            self.data = bytearray()
+            self.arrivals = []
+            self.wire_bytes = 0
+
+    def received(self):
+        with self.lock:
+            return len(self.data)
+
+    def snapshot(self):
+        with self.lock:
+            return bytes(self.data), list(self.arrivals)
+
+    def close(self):
+        for s in (self.client_socket, self.server_socket):
+            if s:
+                try:
+                    s.close()
+                except OSError:
+                    pass
+
+
+class PtyPort:
+    def __init__(self, path):
+        """宿主机伪终端端口，读取端持续丢弃设备的UART输出"""
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        thread = threading.Thread(target=self._drain)
+        thread.daemon = True
+        thread.start()
+
+    def _drain(self):
+        while True:
+            try:
+                if not os.read(self.fd, 4096):
+                    return
+            except OSError:
+                return
+
+    def write(self, data):
+        view = memoryview(data)
+        while view:
+            n = os.write(self.fd, view)
+            view = view[n:]
+
+    def close(self):
+        os.close(self.fd)
+
+
+class SerialPort:
+    def __init__(self, path, baud):
+        """真实串口（需要pyserial）"""
+        import serial
+        self.serial = serial.Serial(path, baud, timeout=0.1)
+
+    def write(self, data):
+        self.serial.write(data)
+        self.serial.flush()
+
+    def close(self):
+        self.serial.close()
+
+
+def generate(pattern, baud, args, rng):
+    """生成 [(发送前等待秒数, 数据块)]，总线传输速率按8N1估算为 baud/10 字节/秒"""
+    line_rate = baud / 10.0
+    chunks = []
+    total = 0
+    if pattern == 'burst':
+        # 固定大小的突发，突发之间留出足够的线路时间，保持约50%线路占用
+        gap = args.burst_size / line_rate * 2
+        while total < args.bytes:
+            chunks.append((gap, bytes(rng.getrandbits(8) for _ in range(args.burst_size))))
+            total += args.burst_size
+    elif pattern == 'random':
+        # 随机大小、随机间隔，平均约50%线路占用
+        while total < args.bytes:
+            size = rng.randint(1, args.max_random_size)
+            gap = rng.uniform(0, 2 * size / line_rate * 2)
+            chunks.append((gap, bytes(rng.getrandbits(8) for _ in range(size))))
+            total += size
+    elif pattern == 'lines':
+        # 以\n结尾的文本行，按行写入，约50%线路占用
+        seq = 0
+        while total < args.bytes:
+            filler = ''.join(rng.choice('abcdefghijklmnopqrstuvwxyz0123456789 ')
+                             for _ in range(rng.randint(10, 100)))
+            line = f"{seq:08d},{filler}\n".encode('ascii')
+            chunks.append((len(line) / line_rate * 2, line))
+            total += len(line)
+            seq += 1
+    elif pattern == 'telemetry':
+        # 重复字段的JSON遥测记录，数值缓慢变化，用于测试上行压缩
+        seq = 0
+        temperature = 23.5
+        while total < args.bytes:
+            temperature += rng.choice((-0.01, 0, 0.01))
+            line = (f'{{"seq":{seq},"node":"sensor-{rng.randint(0, 3):02d}","temp":{temperature:.2f},'
+                    f'"hum":{rng.randint(400, 500) / 10:.1f},"status":"ok"}}\n').encode('ascii')
+            chunks.append((len(line) / line_rate * 2, line))
+            total += len(line)
+            seq += 1
+    elif pattern == 'stream':
+        # 不间断的最大速率数据流
+        while total < args.bytes:
+            chunks.append((0, bytes(rng.getrandbits(8) for _ in range(4096))))
+            total += 4096
+    return chunks
+
+
+def weighted_percentiles(samples, points):
+    """samples为[(延迟, 字节数)]，返回各分位点的延迟"""
+    if not samples:
+        return {p: None for p in points}
+    samples.sort()
+    total = sum(count for _, count in samples)
+    result = {}
+    for p in points:
+        target = total * p
+        acc = 0
+        for latency, count in samples:
+            acc += count
+            if acc >= target:
+                result[p] = latency
+                break
+    return result
+
+
+def analyze(sent, injections, received, arrivals):
+    """逐字节匹配注入时间和到达时间
+
+    Returns:
+        (延迟样本[(秒, 字节数)], 第一个内容不一致的偏移或None)
+    """
+    corrupt_offset = None
+    limit = min(len(sent), len(received))
+    if received[:limit] != sent[:limit]:
+        corrupt_offset = next(i for i in range(limit) if received[i] != sent[i])
+        limit = corrupt_offset
+
+    samples = []
+    i = 0
+    for arrive_time, start, end in arrivals:
+        end = min(end, limit)
+        while start < end and i < len(injections):
+            inject_time, inj_start, inj_end = injections[i]
+            if inj_end <= start:
+                i += 1
+                continue
+            overlap = min(end, inj_end) - max(start, inj_start)
+            if overlap > 0:
+                samples.append((arrive_time - inject_time, overlap))
+            start = min(end, inj_end)
+            if inj_end <= end:
+                i += 1
+    return samples, corrupt_offset
+
+
+def run_pattern(port, sink, pattern, baud, args, rng):
+    """执行一个数据模式，返回结果字典"""
+    chunks = generate(pattern, baud, args, rng)
+    sink.reset()
+
+    sent = bytearray()
+    injections = []     # (时间, 起始偏移, 结束偏移)
+    start_time = time.monotonic()
+    next_time = start_time
+    for gap, data in chunks:
+        next_time += gap
+        delay = next_time - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+        port.write(data)
+        # 写入返回时数据已交给串口/伪终端，以此作为注入时间
+        now = time.monotonic()
+        injections.append((now, len(sent), len(sent) + len(data)))
+        sent += data
+    inject_done = time.monotonic()
+
+    # 等待数据全部到达或空闲超时
+    last_count = -1
+    last_change = time.monotonic()
+    while sink.received() < len(sent) and not sink.closed:
+        count = sink.received()
+        if count != last_count:
+            last_count = count
+            last_change = time.monotonic()
+        elif time.monotonic() - last_change > args.settle:
+            break
+        time.sleep(0.05)
+
+    received, arrivals = sink.snapshot()
+    wire_bytes = sink.wire_bytes
+    samples, corrupt_offset = analyze(bytes(sent), injections, received, arrivals)
+    end_time = arrivals[-1][0] if arrivals else inject_done
+    duration = max(end_time - start_time, 1e-9)
+    percentiles = weighted_percentiles(samples, (0.5, 0.99, 0.999, 1.0))
+
+    def ms(value):
+        return None if value is None else round(value * 1000, 3)
+
+    result = {
+        'pattern': pattern,
+        'baud': baud,
+        'bytes_sent': len(sent),
+        'bytes_received': len(received),
+        'loss_bytes': max(len(sent) - len(received), 0),
+        'loss_ratio': round(max(len(sent) - len(received), 0) / len(sent), 6) if sent else 0,
+        'corrupt_offset': corrupt_offset,
+        'duration_s': round(duration, 3),
+        'throughput_bps': round(len(received) / duration, 1),
+        'line_utilization': round(len(received) / duration / (baud / 10.0), 3),
+        'wire_bytes': wire_bytes,
+        'compression_ratio': round(wire_bytes / len(received), 4) if received else None,
+        'latency_ms': {
+            'p50': ms(percentiles[0.5]),
+            'p99': ms(percentiles[0.99]),
+            'p999': ms(percentiles[0.999]),
+            'max': ms(percentiles[1.0]),
+        },
+    }
+    logger.info(f"[{pattern} @ {baud}] 发送 {result['bytes_sent']} 接收 {result['bytes_received']} "
+                f"吞吐量 {result['throughput_bps']:.0f} B/s "
+                f"延迟 p50={result['latency_ms']['p50']}ms p99={result['latency_ms']['p99']}ms "
+                f"p999={result['latency_ms']['p999']}ms 丢失 {result['loss_bytes']}")
+    return result
+
+
+def git_commit():
+    try:
+        root = os.path.dirname(os.path.abspath(__file__))
+        return subprocess.check_output(['git', 'rev-parse', 'HEAD'], cwd=root,
+                                       stderr=subprocess.DEVNULL).decode().strip()
+    except (OSError, subprocess.CalledProcessError):
+        return None
+
+
+def run_baud(baud, args, rng):
+    """启动一个波特率下的全部数据模式"""
+    sink = TcpSink(args.listen, args.port, args.decompress)
+    process = None
+    port = None
+    results = []
+    try:
+        if args.host_binary:
+            link = os.path.join(tempfile.gettempdir(), f"esp_bench_uart{args.uart_port}_{os.getpid()}")
+            env = dict(os.environ)
+            env[f'ESP_HOST_UART{args.uart_port}_LINK'] = link
+            env['ESP_HOST_UART_BAUD'] = str(baud)
+            log = open(args.host_log, 'ab') if args.host_log else subprocess.DEVNULL
+            process = subprocess.Popen([args.host_binary], env=env, stdout=log, stderr=log)
+            sink.accept(args.connect_timeout)
+            port = PtyPort(link)
+        else:
+            port = SerialPort(args.serial, baud)
+            logger.info(f"请确认设备UART波特率为 {baud}，等待设备连接...")
+            sink.accept(args.connect_timeout)
+
+        # 丢弃连接时发送的问候数据
+        time.sleep(1.0)
+        for pattern in args.patterns:
+            results.append(run_pattern(port, sink, pattern, baud, args, rng))
+    finally:
+        if port:
+            port.close()
+        sink.close()
+        if process:
+            process.terminate()
+            try:
+                process.wait(timeout=5)
+            except subprocess.TimeoutExpired:
+                process.kill()
+    return results
+
+
+def main():
+    """主函数"""
+    parser = argparse.ArgumentParser(description='UART→TCP桥接端到端基准测试')
+    target = parser.add_mutually_exclusive_group(required=True)
+    target.add_argument('--host-binary', help='宿主机构建的esp32_bridge_host路径')
+    target.add_argument('--serial', help='连接ESP32 UART RX的串口设备（如/dev/ttyUSB0）')
+    parser.add_argument('--uart-port', type=int, default=1, help='被测UART端口号（宿主机模式）')
+    parser.add_argument('--listen', default='0.0.0.0', help='TCP接收端监听地址')
+    parser.add_argument('--port', type=int, default=8080, help='TCP接收端监听端口，须与TCP_SERVER_PORT一致')
+    parser.add_argument('--baud', type=int, nargs='+', default=[115200, 460800, 921600], help='测试的波特率')
+    parser.add_argument('--patterns', nargs='+', choices=PATTERNS, default=list(PATTERNS), help='数据模式')
+    parser.add_argument('--bytes', type=int, default=64 * 1024, help='每个模式注入的字节数')
+    parser.add_argument('--burst-size', type=int, default=256, help='burst模式的突发大小')
+    parser.add_argument('--max-random-size', type=int, default=1024, help='random模式的最大块大小')
+    parser.add_argument('--settle', type=float, default=2.0, help='注入结束后等待数据到达的空闲超时（秒）')
+    parser.add_argument('--connect-timeout', type=float, default=30.0, help='等待设备连接的超时（秒）')
+    parser.add_argument('--seed', type=int, default=1, help='随机种子，固定种子使结果可比较')
+    parser.add_argument('--host-log', help='宿主机进程日志文件')
+    parser.add_argument('--decompress', type=int, nargs='?', const=11, metavar='WINDOW_BITS',
+                        help='设备启用了上行压缩，参数为UPLINK_COMPRESS_WINDOW_BITS（默认11）')
+    parser.add_argument('--output', default='bridge_bench.json', help='JSON结果文件')
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    report = {
+        'commit': git_commit(),
+        'timestamp': time.strftime('%Y-%m-%dT%H:%M:%S%z'),
+        'target': 'host' if args.host_binary else 'device',
+        'config': {
+            'bytes_per_pattern': args.bytes,
+            'burst_size': args.burst_size,
+            'max_random_size': args.max_random_size,
+            'seed': args.seed,
+            'decompress_window_bits': args.decompress,
+        },
+        'results': [],
+    }
+
+    try:
+        for baud in args.baud:
+            report['results'].extend(run_baud(baud, args, rng))
+    except KeyboardInterrupt:
+        logger.info("测试被中断")
+    except socket.timeout:
+        logger.error("等待设备连接超时")
+        sys.exit(1)
+
+    with open(args.output, 'w', encoding='utf-8') as f:
+        json.dump(report, f, indent=2, ensure_ascii=False)
+    logger.info(f"结果已写入 {args.output}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+DNS缓存冷启动与热启动的连接耗时对比
+
+在本机启动DNS替身（dns_standin.py）和TCP接收端，反复启动按主机名连接的宿主机构建
+（host/sdkconfig.dns），每次启动相当于设备从深度睡眠唤醒：NVS文件（ESP_HOST_NVS_FILE）
+保留上次的解析结果，系统时钟继续计时。
+    cold   删除NVS文件，没有缓存，连接前同步查询DNS
+    warm   缓存未过期，连接不查询DNS
+    stale  等待缓存过期（TTL+1秒）后启动，先用旧地址连接，同时在后台查询
+每轮记录从启动进程到服务器accept的耗时、设备日志中的解析耗时和地址来源，以及
+连接前和连接后DNS替身收到的查询数。
+
+示例：
+    python dns_bench.py --binary ../host/build-dns/esp32_bridge_host --delay-ms 80 --output dns.json
+"""
+
+import argparse
+import json
+import logging
+import os
+import re
+import socket
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+from bridge_bench import git_commit
+from dns_standin import DnsStandin
+
+# 配置日志
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s - %(levelname)s - %(message)s'
+)
+logger = logging.getLogger(__name__)
+
+CONNECT_LOG_RE = re.compile(r'开始连接服务器\(\w+\): \S+ \(([\d.]+), ([^,]+), 解析(\d+)ms\)')
+
+
+def run_once(phase, args, dns, nvs_file):
+    """启动一次宿主机构建，等待连接后保持一段时间再结束"""
+    server_socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server_socket.bind((args.listen, args.port))
+    server_socket.listen(1)
+    server_socket.settimeout(args.connect_timeout)
+
+    env = dict(os.environ)
+    env['ESP_HOST_DNS_SERVER'] = f"127.0.0.1:{args.dns_port}"
+    env['ESP_HOST_NVS_FILE'] = nvs_file
+    log_path = os.path.join(tempfile.gettempdir(), f"esp_dns_bench_{os.getpid()}.log")
+    dns.reset()
+    with open(log_path, 'wb') as log:
+        start = time.monotonic()
+        process = subprocess.Popen([args.binary], env=env, stdout=log, stderr=log)
+        try:
+            client, _ = server_socket.accept()
+            connect_ms = (time.monotonic() - start) * 1000.0
+            queries_before = dns.query_count()
+            # 等待后台解析完成
+            time.sleep(args.hold)
+            queries_after = dns.query_count() - queries_before
+            client.close()
+        finally:
+            server_socket.close()
+            process.terminate()
+            try:
+                process.wait(timeout=5)
+            except subprocess.TimeoutExpired:
+                process.kill()
+
+    with open(log_path, encoding='utf-8', errors='replace') as f:
+        match = CONNECT_LOG_RE.search(f.read())
+    os.unlink(log_path)
+    result = {
+        'phase': phase,
+        'connect_ms': round(connect_ms, 1),
+        'resolve_ms': int(match.group(3)) if match else None,
+        'source': match.group(2) if match else None,
+        'address': match.group(1) if match else None,
+        'dns_queries_before_connect': queries_before,
+        'dns_queries_after_connect': queries_after,
+    }
+    logger.info(f"[{phase}] 连接{result['connect_ms']}ms, 解析{result['resolve_ms']}ms({result['source']}), "
+                f"DNS查询 连接前{queries_before}次/连接后{queries_after}次")
+    return result
+
+
+def summarize(results, phase):
+    values = [r['connect_ms'] for r in results if r['phase'] == phase]
+    resolve = [r['resolve_ms'] for r in results if r['phase'] == phase and r['resolve_ms'] is not None]
+    if not values:
+        return None
+    return {
+        'runs': len(values),
+        'median_connect_ms': round(statistics.median(values), 1),
+        'median_resolve_ms': statistics.median(resolve) if resolve else None,
+        'dns_queries_before_connect': sum(r['dns_queries_before_connect'] for r in results if r['phase'] == phase),
+    }
+
+
+def main():
+    """主函数"""
+    parser = argparse.ArgumentParser(description='DNS缓存冷启动与热启动的连接耗时对比')
+    parser.add_argument('--binary', required=True, help='按主机名连接的esp32_bridge_host路径（host/sdkconfig.dns）')
+    parser.add_argument('--hostname', default='bridge.test', help='设备配置的服务器主机名（CONFIG_TCP_SERVER_IP）')
+    parser.add_argument('--ttl', type=float, default=10.0, help='设备配置的CONFIG_DNS_CACHE_TTL_S（秒）')
+    parser.add_argument('--dns-port', type=int, default=5353, help='DNS替身端口')
+    parser.add_argument('--delay-ms', type=float, default=80.0, help='DNS替身模拟的往返时间（毫秒）')
+    parser.add_argument('--listen', default='127.0.0.1', help='接收端监听地址')
+    parser.add_argument('--port', type=int, default=8080, help='接收端监听端口，须与TCP_SERVER_PORT一致')
+    parser.add_argument('--rounds', type=int, default=5, help='冷启动和热启动各自的轮数')
+    parser.add_argument('--hold', type=float, default=1.0, help='连接后保持的时间（秒），等待后台解析')
+    parser.add_argument('--connect-timeout', type=float, default=30.0, help='等待设备连接的超时（秒）')
+    parser.add_argument('--output', default='dns_bench.json', help='JSON结果文件')
+    args = parser.parse_args()
+
+    dns = DnsStandin('127.0.0.1', args.dns_port, {args.hostname: args.listen}, args.delay_ms)
+    dns.start()
+    nvs_file = os.path.join(tempfile.gettempdir(), f"esp_dns_bench_nvs_{os.getpid()}.bin")
+    results = []
+    try:
+        for _ in range(args.rounds):
+            if os.path.exists(nvs_file):
+                os.unlink(nvs_file)
+            results.append(run_once('cold', args, dns, nvs_file))
+            results.append(run_once('warm', args, dns, nvs_file))
+        # 冷启动轮数相同时最后一次热启动之后缓存仍有效，等待过期
+        time.sleep(args.ttl + 1.0)
+        results.append(run_once('stale', args, dns, nvs_file))
+    except socket.timeout:
+        logger.error("等待设备连接超时")
+        sys.exit(1)
+    except KeyboardInterrupt:
+        logger.info("测试被中断")
+    finally:
+        dns.stop()
+        if os.path.exists(nvs_file):
+            os.unlink(nvs_file)
+
+    report = {
+        'commit': git_commit(),
+        'timestamp': time.strftime('%Y-%m-%dT%H:%M:%S%z'),
+        'config': {'dns_delay_ms': args.delay_ms, 'ttl_s': args.ttl, 'rounds': args.rounds},
+        'summary': {phase: summarize(results, phase) for phase in ('cold', 'warm', 'stale')},
+        'results': results,
+    }
+    cold, warm = report['summary']['cold'], report['summary']['warm']
+    if cold and warm:
+        report['summary']['warm_saving_ms'] = round(cold['median_connect_ms'] - warm['median_connect_ms'], 1)
+    with open(args.output, 'w', encoding='utf-8') as f:
+        json.dump(report, f, indent=2, ensure_ascii=False)
+    logger.info(f"结果已写入 {args.output}")
+
+
+if __name__ == "__main__":
+    main()
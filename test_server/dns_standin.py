@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+本地DNS替身：只回答A记录查询，用于测试设备的DNS缓存
+
+宿主机构建设置 ESP_HOST_DNS_SERVER=127.0.0.1:5353 后向这里查询。--delay-ms 模拟真实网络中
+DNS服务器的往返时间，未配置的名称回答NXDOMAIN。
+
+示例：
+    python dns_standin.py --record bridge.test=127.0.0.1 --delay-ms 80
+"""
+
+import argparse
+import logging
+import socket
+import struct
+import threading
+import time
+
+# 配置日志
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s - %(levelname)s - %(message)s'
+)
+logger = logging.getLogger(__name__)
+
+TYPE_A = 1
+CLASS_IN = 1
+
+
+def parse_question(packet):
+    """解析第一个问题，返回 (名称, 类型, 问题结束偏移)，格式错误返回None"""
+    labels = []
+    pos = 12
+    while pos < len(packet):
+        length = packet[pos]
+        if length == 0:
+            pos += 1
+            break
+        if length & 0xC0:
+            return None
+        labels.append(packet[pos + 1:pos + 1 + length].decode('ascii', 'replace'))
+        pos += 1 + length
+    if pos + 4 > len(packet):
+        return None
+    qtype, _ = struct.unpack_from('>HH', packet, pos)
+    return '.'.join(labels).lower(), qtype, pos + 4
+
+
+class DnsStandin:
+    def __init__(self, host='127.0.0.1', port=5353, records=None, delay_ms=0.0, ttl=300):
+        """初始化DNS替身
+
+        Args:
+            host: 监听地址
+            port: 监听端口
+            records: {名称: IPv4地址}
+            delay_ms: 每次回答前的延迟（毫秒）
+            ttl: 回答中的TTL（秒）
+        """
+        self.records = {name.lower(): addr for name, addr in (records or {}).items()}
+        self.delay_ms = delay_ms
+        self.ttl = ttl
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.sock.bind((host, port))
+        self.lock = threading.Lock()
+        self.queries = []       # (时间, 名称)
+        self.running = False
+
+    def start(self):
+        """在后台线程中回答查询"""
+        self.running = True
+        thread = threading.Thread(target=self.serve)
+        thread.daemon = True
+        thread.start()
+
+    def stop(self):
+        self.running = False
+        self.sock.close()
+
+    def query_count(self, name=None):
+        with self.lock:
+            return sum(1 for _, n in self.queries if name is None or n == name.lower())
+
+    def reset(self):
+        with self.lock:
+            self.queries = []
+
+    def serve(self):
+        while self.running:
+            try:
+                packet, peer = self.sock.recvfrom(512)
+            except OSError:
+                break
+            question = parse_question(packet) if len(packet) >= 12 else None
+            if question is None:
+                continue
+            name, qtype, end = question
+            with self.lock:
+                self.queries.append((time.monotonic(), name))
+            # 每个查询单独延迟，不阻塞其他查询
+            threading.Thread(target=self._answer, args=(packet, end, name, qtype, peer), daemon=True).start()
+
+    def _answer(self, packet, end, name, qtype, peer):
+        if self.delay_ms > 0:
+            time.sleep(self.delay_ms / 1000.0)
+        addr = self.records.get(name)
+        flags = 0x8180 if addr else 0x8183     # 回答、期望递归、可递归；未知名称为NXDOMAIN
+        answer = b''
+        if addr and qtype == TYPE_A:
+            # 名称用指向问题的压缩指针
+            answer = struct.pack('>HHHIH', 0xC00C, TYPE_A, CLASS_IN, self.ttl, 4) + socket.inet_aton(addr)
+        header = packet[:2] + struct.pack('>HHHHH', flags, 1, 1 if answer else 0, 0, 0)
+        logger.info(f"{peer} 查询 {name} 类型{qtype} -> {addr if answer else '无记录'}")
+        try:
+            self.sock.sendto(header + packet[12:end] + answer, peer)
+        except OSError:
+            pass
+
+
+def main():
+    """主函数"""
+    parser = argparse.ArgumentParser(description='本地DNS替身')
+    parser.add_argument('--host', default='127.0.0.1', help='监听地址')
+    parser.add_argument('--port', type=int, default=5353, help='监听端口')
+    parser.add_argument('--record', action='append', default=[], help='A记录，如 bridge.test=127.0.0.1，可重复')
+    parser.add_argument('--delay-ms', type=float, default=0.0, help='模拟的DNS往返时间（毫秒）')
+    parser.add_argument('--ttl', type=int, default=300, help='回答中的TTL（秒）')
+    args = parser.parse_args()
+
+    records = dict(item.split('=', 1) for item in args.record)
+    server = DnsStandin(args.host, args.port, records, args.delay_ms, args.ttl)
+    server.start()
+    logger.info(f"DNS替身启动，监听 {args.host}:{args.port}，记录: {records}")
+    try:
+        while True:
+            time.sleep(1)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        server.stop()
+        logger.info(f"共回答 {server.query_count()} 次查询")
+
+
+if __name__ == "__main__":
+    main()
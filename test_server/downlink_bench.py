@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+ESP32下行吞吐量测试工具
+作为TCP服务器向ESP32连续推送数据，测量TCP发送速率；
+可选通过串口读取ESP32 UART输出，测量实际到达UART的持续吞吐量并校验数据
+"""
+
+import socket
+import time
+import argparse
+import threading
+import logging
+import sys
+
+# 配置日志
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s - %(levelname)s - %(message)s'
+)
+logger = logging.getLogger(__name__)
+
+CHUNK_SIZE = 4096
+
+
+def pattern_chunk(offset, size):
+    """生成从offset开始的测试数据（字节值为偏移量对251取模，便于发现丢失和错位）"""
+    return bytes((offset + i) % 251 for i in range(size))
+
+
+class SerialSink:
+    def __init__(self, port, baud, total):
+        """初始化串口接收端
+
+        Args:
+            port: 串口设备，连接ESP32的UART TX引脚
+            baud: 波特率，需与ESP32的UART_BAUD_RATE一致
+            total: 期望接收的总字节数
+        """
+        import serial  # 需要pyserial，仅在使用串口测量时导入
+        self.serial = serial.Serial(port, baud, timeout=1)
+        self.total = total
+        self.received = 0
+        self.errors = 0
+        self.first_time = None
+        self.last_time = None
+
+    def run(self, idle_timeout):
+        """读取串口直到收齐数据或空闲超时"""
+        idle_since = time.time()
+        while self.received < self.total:
+            data = self.serial.read(CHUNK_SIZE)
+            now = time.time()
+            if not data:
+                if now - idle_since > idle_timeout:
+                    logger.warning(f"串口空闲超过 {idle_timeout} 秒，停止接收")
+                    break
+                continue
+
+            idle_since = now
+            if self.first_time is None:
+                self.first_time = now
+            self.last_time = now
+
+            expected = pattern_chunk(self.received, len(data))
+            if data != expected:
+                self.errors += sum(1 for a, b in zip(data, expected) if a != b)
+            self.received += len(data)
+
+        self.serial.close()
+
+    def report(self):
+        """打印UART端统计"""
+        if self.first_time is None or self.last_time <= self.first_time:
+            logger.error("串口未接收到足够的数据")
+            return
+        elapsed = self.last_time - self.first_time
+        logger.info(f"UART接收: {self.received}/{self.total} 字节, 用时 {elapsed:.2f} 秒, "
+                    f"持续吞吐量 {self.received / elapsed:.0f} 字节/秒, 错误字节 {self.errors}")
+
+
+def push_data(client_socket, total, rate):
+    """向客户端推送total字节测试数据
+
+    Returns:
+        (发送字节数, 用时)
+    """
+    sent = 0
+    start = time.time()
+    last_report = start
+    while sent < total:
+        chunk = pattern_chunk(sent, min(CHUNK_SIZE, total - sent))
+        client_socket.sendall(chunk)
+        sent += len(chunk)
+
+        # 可选限速，避免超过UART波特率太多导致长时间阻塞
+        if rate > 0:
+            expected = sent / rate
+            elapsed = time.time() - start
+            if expected > elapsed:
+                time.sleep(expected - elapsed)
+
+        now = time.time()
+        if now - last_report >= 1.0:
+            logger.info(f"已发送 {sent}/{total} 字节, 平均 {sent / (now - start):.0f} 字节/秒")
+            last_report = now
+
+    return sent, time.time() - start
+
+
+def main():
+    """主函数"""
+    parser = argparse.ArgumentParser(description='ESP32下行吞吐量测试工具')
+    parser.add_argument('--host', default='0.0.0.0', help='服务器监听地址')
+    parser.add_argument('--port', type=int, default=8080, help='服务器监听端口')
+    parser.add_argument('--size', type=float, default=1.0, help='推送数据量（MB）')
+    parser.add_argument('--rate', type=int, default=0, help='发送限速（字节/秒），0表示不限速')
+    parser.add_argument('--serial', help='串口设备（如/dev/ttyUSB0），用于测量到达UART的吞吐量')
+    parser.add_argument('--baud', type=int, default=115200, help='串口波特率')
+    parser.add_argument('--idle-timeout', type=float, default=5.0, help='串口空闲超时（秒）')
+    args = parser.parse_args()
+
+    total = int(args.size * 1024 * 1024)
+
+    sink = None
+    sink_thread = None
+    if args.serial:
+        try:
+            sink = SerialSink(args.serial, args.baud, total)
+        except ImportError:
+            logger.error("串口测量需要pyserial: pip install pyserial")
+            sys.exit(1)
+
+    server_socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server_socket.bind((args.host, args.port))
+    server_socket.listen(1)
+    logger.info(f"等待ESP32连接 {args.host}:{args.port} ...")
+
+    client_socket, addr = server_socket.accept()
+    logger.info(f"接受来自 {addr[0]}:{addr[1]} 的连接，开始推送 {total} 字节")
+
+    if sink:
+        sink_thread = threading.Thread(target=sink.run, args=(args.idle_timeout,))
+        sink_thread.daemon = True
+        sink_thread.start()
+
+    try:
+        sent, elapsed = push_data(client_socket, total, args.rate)
+        logger.info(f"TCP发送完成: {sent} 字节, 用时 {elapsed:.2f} 秒, 平均 {sent / elapsed:.0f} 字节/秒")
+
+        if sink_thread:
+            sink_thread.join()
+            sink.report()
+    except KeyboardInterrupt:
+        logger.info("测试被中断")
+    except Exception as e:
+        logger.error(f"测试出错: {e}")
+    finally:
+        client_socket.close()
+        server_socket.close()
+
+
+if __name__ == "__main__":
+    main()
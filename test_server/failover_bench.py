@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+多服务器故障切换测试
+
+在本机启动主服务器和备用服务器两个接收端，运行配置了备用服务器的宿主机构建
+（host/sdkconfig.failover），按固定速率向UART写入带序号的记录：
+    1. 设备连接主服务器后关闭主服务器，--backup-delay秒后才启动备用服务器，测量从启动到
+       设备连接备用服务器的时间，并按序号统计两个服务器共收到的记录，检查切换期间的数据是否丢失。
+       sdkconfig.failover使上行批次保留200ms，关闭时发送任务中总有未发送的数据，
+       断开时间超过该时长，这些数据须交给存储转发缓存并在备用服务器上重放
+    2. 恢复主服务器后重启设备进程（NVS文件保留），检查设备是否先连接上次成功的备用服务器
+
+没有启用帧协议时，关闭瞬间已交给协议栈但主服务器未读取的数据无法恢复，
+上行队列中未发送的数据和断开期间从UART读取的数据由存储转发缓存，连接备用服务器后重放。
+丢失的记录超过--max-lost条时以退出码1结束。
+
+示例：
+    python failover_bench.py --binary ../host/build-failover/esp32_bridge_host --output failover.json
+"""
+
+import argparse
+import json
+import logging
+import os
+import select
+import socket
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+from bridge_bench import PtyPort, TcpSink, git_commit
+from transport_bench import make_record, parse_records
+
+# 配置日志
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s - %(levelname)s - %(message)s'
+)
+logger = logging.getLogger(__name__)
+
+
+class RecordWriter:
+    def __init__(self, port, rate, size):
+        """在后台线程中按固定速率写入记录"""
+        self.port = port
+        self.interval = 1.0 / rate
+        self.size = size
+        self.count = 0
+        self.running = True
+        self.thread = threading.Thread(target=self._run)
+        self.thread.daemon = True
+        self.thread.start()
+
+    def _run(self):
+        next_time = time.monotonic()
+        while self.running:
+            delay = next_time - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+            self.port.write(make_record(self.count, self.size))
+            self.count += 1
+            next_time += self.interval
+
+    def stop(self):
+        self.running = False
+        self.thread.join()
+        return self.count
+
+
+def start_process(args, nvs_file, link):
+    env = dict(os.environ)
+    env['ESP_HOST_NVS_FILE'] = nvs_file
+    env[f'ESP_HOST_UART{args.uart_port}_LINK'] = link
+    log = open(args.host_log, 'ab') if args.host_log else subprocess.DEVNULL
+    return subprocess.Popen([args.binary], env=env, stdout=log, stderr=log)
+
+
+def stop_process(process):
+    process.terminate()
+    try:
+        process.wait(timeout=5)
+    except subprocess.TimeoutExpired:
+        process.kill()
+
+
+def wait_first(sinks, timeout):
+    """等待任一接收端被连接，返回其序号，其余接收端仍在监听"""
+    ready, _, _ = select.select([sink.server_socket for sink in sinks], [], [], timeout)
+    if not ready:
+        raise socket.timeout()
+    index = [sink.server_socket for sink in sinks].index(ready[0])
+    sinks[index].accept(timeout)
+    return index
+
+
+def run_failover(args, nvs_file, link):
+    """第1阶段：关闭主服务器，测量切换时间和数据丢失"""
+    primary = TcpSink(args.listen, args.primary_port)
+    backup = None
+    process = start_process(args, nvs_file, link)
+    port = None
+    writer = None
+    try:
+        primary.accept(args.connect_timeout)
+        port = PtyPort(link)
+        time.sleep(1.0)
+        primary.reset()
+        writer = RecordWriter(port, args.rate, args.record_size)
+        time.sleep(args.before)
+
+        # 关闭主服务器（连接和监听套接字），之后连接主服务器被拒绝；
+        # 备用服务器稍后启动，使断开时间超过上行批次的保留时间
+        kill_time = time.monotonic()
+        primary.close()
+        time.sleep(args.backup_delay)
+        backup_time = time.monotonic()
+        backup = TcpSink(args.listen, args.backup_port)
+        backup.accept(args.connect_timeout)
+        outage_ms = (time.monotonic() - kill_time) * 1000.0
+        switch_ms = (time.monotonic() - backup_time) * 1000.0
+        logger.info(f"设备已切换到备用服务器，断开{outage_ms:.1f}ms，备用服务器启动后{switch_ms:.1f}ms")
+
+        time.sleep(args.after)
+        written = writer.stop()
+        writer = None
+        time.sleep(args.settle)
+
+        # 两个服务器收到的记录按序号合并
+        records = {}
+        duplicates = 0
+        for sink in (primary, backup):
+            data, arrivals = sink.snapshot()
+            received, dup = parse_records(arrivals, data)
+            duplicates += dup + len(set(received) & set(records))
+            records.update(received)
+        lost = [i for i in range(written) if i not in records]
+        return {
+            'outage_ms': round(outage_ms, 1),
+            'switch_ms': round(switch_ms, 1),
+            'records_written': written,
+            'records_received': len(records),
+            'records_lost': len(lost),
+            'first_lost': lost[:10],
+            'duplicates': duplicates,
+        }
+    finally:
+        if writer:
+            writer.stop()
+        if port:
+            port.close()
+        primary.close()
+        if backup:
+            backup.close()
+        stop_process(process)
+
+
+def run_reboot(args, nvs_file, link):
+    """第2阶段：两个服务器都可用，重启后检查先连接哪个"""
+    sinks = [TcpSink(args.listen, args.primary_port), TcpSink(args.listen, args.backup_port)]
+    start = time.monotonic()
+    process = start_process(args, nvs_file, link)
+    try:
+        first = wait_first(sinks, args.connect_timeout)
+        connect_ms = (time.monotonic() - start) * 1000.0
+        name = 'backup' if first == 1 else 'primary'
+        logger.info(f"重启后连接{'备用' if first == 1 else '主'}服务器，耗时{connect_ms:.1f}ms")
+        return {'endpoint': name, 'connect_ms': round(connect_ms, 1)}
+    finally:
+        for sink in sinks:
+            sink.close()
+        stop_process(process)
+
+
+def main():
+    """主函数"""
+    parser = argparse.ArgumentParser(description='多服务器故障切换测试')
+    parser.add_argument('--binary', required=True, help='配置了备用服务器的esp32_bridge_host路径（host/sdkconfig.failover）')
+    parser.add_argument('--listen', default='127.0.0.1', help='接收端监听地址')
+    parser.add_argument('--primary-port', type=int, default=8080, help='主服务器端口，须与TCP_SERVER_PORT一致')
+    parser.add_argument('--backup-port', type=int, default=8081, help='备用服务器端口，须与TCP_SERVER_FALLBACKS一致')
+    parser.add_argument('--uart-port', type=int, default=1, help='写入记录的UART端口号')
+    parser.add_argument('--rate', type=float, default=200.0, help='每秒写入的记录数')
+    parser.add_argument('--record-size', type=int, default=64, help='每条记录的字节数（至少32）')
+    parser.add_argument('--before', type=float, default=2.0, help='关闭主服务器前写入的时间（秒）')
+    parser.add_argument('--backup-delay', type=float, default=1.0, help='关闭主服务器后启动备用服务器的延迟（秒），应超过上行批次的保留时间')
+    parser.add_argument('--after', type=float, default=3.0, help='切换后继续写入的时间（秒）')
+    parser.add_argument('--settle', type=float, default=3.0, help='停止写入后等待数据到达的时间（秒）')
+    parser.add_argument('--connect-timeout', type=float, default=30.0, help='等待设备连接的超时（秒）')
+    parser.add_argument('--max-lost', type=int, default=2, help='允许丢失的记录数（关闭瞬间已交给协议栈的数据）')
+    parser.add_argument('--host-log', help='宿主机进程日志文件')
+    parser.add_argument('--output', default='failover_bench.json', help='JSON结果文件')
+    args = parser.parse_args()
+
+    nvs_file = os.path.join(tempfile.gettempdir(), f"esp_failover_nvs_{os.getpid()}.bin")
+    link = os.path.join(tempfile.gettempdir(), f"esp_failover_uart{args.uart_port}_{os.getpid()}")
+    report = {
+        'commit': git_commit(),
+        'timestamp': time.strftime('%Y-%m-%dT%H:%M:%S%z'),
+        'config': {'rate': args.rate, 'record_size': args.record_size, 'backup_delay_s': args.backup_delay},
+    }
+    try:
+        report['failover'] = run_failover(args, nvs_file, link)
+        report['reboot'] = run_reboot(args, nvs_file, link)
+    except RuntimeError as e:
+        logger.error(str(e))
+        sys.exit(1)
+    except socket.timeout:
+        logger.error("等待设备连接超时")
+        sys.exit(1)
+    finally:
+        if os.path.exists(nvs_file):
+            os.unlink(nvs_file)
+
+    with open(args.output, 'w', encoding='utf-8') as f:
+        json.dump(report, f, indent=2, ensure_ascii=False)
+    logger.info(f"结果已写入 {args.output}")
+    print(json.dumps(report, indent=2, ensure_ascii=False))
+
+    lost = report['failover']['records_lost']
+    if lost > args.max_lost:
+        logger.error(f"切换期间丢失{lost}条记录，超过{args.max_lost}条")
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
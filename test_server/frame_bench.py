@@ -0,0 +1,402 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+帧协议端到端基准测试
+
+作为帧协议服务器接收设备上行的数据帧并发送累计确认，按bridge_bench.py的数据模式
+向UART注入数据，统计有效吞吐量（负载字节/秒）、线路开销、逐字节延迟、重复帧和丢失帧。
+设备端的确认延迟（发送到收到确认）取自宿主机进程日志中的帧协议统计。
+
+--reconnect 在每个模式中途停止确认并断开连接，验证重连后未确认帧的重传和去重。
+
+宿主机构建须启用帧协议：
+    cmake -S host -B host/build-framing -DSDKCONFIG_HOST_EXTRA=$PWD/host/sdkconfig.framing
+"""
+
+import argparse
+import json
+import logging
+import os
+import random
+import re
+import socket
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+from bridge_bench import PATTERNS, PtyPort, SerialPort, analyze, generate, git_commit, weighted_percentiles
+from frame_protocol import FRAME_DATA, FRAME_HELLO, FrameParser, FrameSession
+from lz_codec import DEFAULT_WINDOW_BITS
+
+# 配置日志
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s - %(levelname)s - %(message)s'
+)
+logger = logging.getLogger(__name__)
+
+PROTOCOL_STATS_RE = re.compile(
+    r'帧协议: 已发送(\d+)帧, 已确认(\d+)帧, 未确认(\d+)帧\((\d+)字节\), 重传(\d+)帧, '
+    r'确认延迟平均(\d+)ms/最长(\d+)ms, 窗口满(\d+)次')
+
+
+class FramedSink:
+    def __init__(self, host, port, window_bits):
+        """帧协议接收端，记录去重（和解压）后负载的到达时间，可暂停确认
+
+        Args:
+            host: 监听地址
+            port: 监听端口
+            window_bits: 压缩通道的窗口大小对数
+        """
+        self.server_socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.server_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.server_socket.bind((host, port))
+        self.server_socket.listen(1)
+        self.client_socket = None
+        self.lock = threading.Lock()
+        self.session = FrameSession(window_bits)
+        self.acking = True
+        self.data = bytearray()
+        self.arrivals = []      # (时间, 起始偏移, 结束偏移)
+        self.wire_bytes = 0
+        self.frames = 0
+        self.acks = 0
+        self.crc_errors = 0
+        self.connected = threading.Event()
+        self.closed = False
+
+    def accept(self, timeout):
+        """等待设备连接"""
+        self.server_socket.settimeout(timeout)
+        self.client_socket, addr = self.server_socket.accept()
+        self.closed = False
+        logger.info(f"设备已连接: {addr[0]}:{addr[1]}")
+        thread = threading.Thread(target=self._receive, args=(self.client_socket,))
+        thread.daemon = True
+        thread.start()
+
+    def _receive(self, client_socket):
+        parser = FrameParser()
+        while True:
+            try:
+                data = client_socket.recv(65536)
+            except OSError:
+                data = b''
+            now = time.monotonic()
+            if not data:
+                self.closed = True
+                return
+            with self.lock:
+                self.wire_bytes += len(data)
+                ack_needed = False
+                for frame in parser.feed(data):
+                    if frame.type == FRAME_HELLO:
+                        self._send(client_socket, self.session.on_hello(frame))
+                        self.connected.set()
+                    elif frame.type == FRAME_DATA:
+                        self.frames += 1
+                        ack_needed = True
+                        payload = self.session.on_data(frame)
+                        if payload:
+                            start = len(self.data)
+                            self.data += payload
+                            self.arrivals.append((now, start, start + len(payload)))
+                self.crc_errors = parser.crc_errors
+                if ack_needed and self.acking:
+                    self._send(client_socket, self.session.ack_frame())
+
+    def _send(self, client_socket, frame):
+        try:
+            client_socket.sendall(frame)
+            self.acks += 1
+        except OSError:
+            pass
+
+    def set_acking(self, enabled):
+        with self.lock:
+            self.acking = enabled
+            if enabled and self.client_socket and not self.closed:
+                self._send(self.client_socket, self.session.ack_frame())
+
+    def drop_connection(self):
+        """断开当前连接，模拟链路中断"""
+        self.connected.clear()
+        self.client_socket.shutdown(socket.SHUT_RDWR)
+        self.client_socket.close()
+
+    def reset(self):
+        """丢弃已接收的负载（连接时的问候数据、上一轮的残留数据）"""
+        with self.lock:
+            self.data = bytearray()
+            self.arrivals = []
+            self.wire_bytes = 0
+            self.frames = 0
+
+    def truncate(self, size):
+        """只保留前size字节负载"""
+        with self.lock:
+            del self.data[size:]
+            self.arrivals = [a for a in self.arrivals if a[1] < size]
+            if self.arrivals and self.arrivals[-1][2] > size:
+                now, start, _ = self.arrivals[-1]
+                self.arrivals[-1] = (now, start, size)
+
+    def received(self):
+        with self.lock:
+            return len(self.data)
+
+    def snapshot(self):
+        with self.lock:
+            return bytes(self.data), list(self.arrivals)
+
+    def close(self):
+        for s in (self.client_socket, self.server_socket):
+            if s:
+                try:
+                    s.close()
+                except OSError:
+                    pass
+
+
+def wait_for(sink, target, settle):
+    """等待接收到target字节或空闲超时"""
+    last_count = -1
+    last_change = time.monotonic()
+    while sink.received() < target:
+        count = sink.received()
+        if count != last_count:
+            last_count = count
+            last_change = time.monotonic()
+        elif time.monotonic() - last_change > settle:
+            break
+        time.sleep(0.05)
+
+
+def inject(port, chunks, sent, injections):
+    next_time = time.monotonic()
+    for gap, data in chunks:
+        next_time += gap
+        delay = next_time - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+        port.write(data)
+        injections.append((time.monotonic(), len(sent), len(sent) + len(data)))
+        sent += data
+
+
+def run_pattern(port, sink, pattern, baud, args, rng):
+    """执行一个数据模式，返回结果字典"""
+    chunks = generate(pattern, baud, args, rng)
+    sink.reset()
+    duplicates_before = sink.session.duplicates
+    lost_before = sink.session.lost_frames
+
+    sent = bytearray()
+    injections = []
+    start_time = time.monotonic()
+    if args.reconnect:
+        # 前一段不确认，全部到达后断开；重连后设备重传这些帧，服务器去重。
+        # 这一段须能放进设备的发送窗口，否则窗口满后超出部分会被丢弃
+        half = 0
+        phase_bytes = 0
+        while half < len(chunks) and phase_bytes < args.reconnect_bytes:
+            phase_bytes += len(chunks[half][1])
+            half += 1
+        sink.set_acking(False)
+        inject(port, chunks[:half], sent, injections)
+        wait_for(sink, len(sent), args.settle)
+        sink.drop_connection()
+        sink.accept(args.connect_timeout)
+        sink.connected.wait(args.connect_timeout)
+        # 丢弃重连后设备发送的问候数据
+        time.sleep(1.0)
+        sink.truncate(len(sent))
+        sink.set_acking(True)
+        inject(port, chunks[half:], sent, injections)
+    else:
+        inject(port, chunks, sent, injections)
+    inject_done = time.monotonic()
+    wait_for(sink, len(sent), args.settle)
+
+    received, arrivals = sink.snapshot()
+    samples, corrupt_offset = analyze(bytes(sent), injections, received, arrivals)
+    end_time = arrivals[-1][0] if arrivals else inject_done
+    duration = max(end_time - start_time, 1e-9)
+    percentiles = weighted_percentiles(samples, (0.5, 0.99, 0.999, 1.0))
+
+    def ms(value):
+        return None if value is None else round(value * 1000, 3)
+
+    with sink.lock:
+        wire_bytes = sink.wire_bytes
+        frames = sink.frames
+    result = {
+        'pattern': pattern,
+        'baud': baud,
+        'reconnect': args.reconnect,
+        'bytes_sent': len(sent),
+        'bytes_received': len(received),
+        'loss_bytes': max(len(sent) - len(received), 0),
+        'corrupt_offset': corrupt_offset,
+        'duration_s': round(duration, 3),
+        'goodput_bps': round(len(received) / duration, 1),
+        'wire_bytes': wire_bytes,
+        'overhead_ratio': round(wire_bytes / len(received) - 1, 4) if received else None,
+        'frames': frames,
+        'avg_payload_per_frame': round(len(received) / frames, 1) if frames else None,
+        'duplicate_frames': sink.session.duplicates - duplicates_before,
+        'lost_frames': sink.session.lost_frames - lost_before,
+        'crc_errors': sink.crc_errors,
+        'latency_ms': {
+            'p50': ms(percentiles[0.5]),
+            'p99': ms(percentiles[0.99]),
+            'p999': ms(percentiles[0.999]),
+            'max': ms(percentiles[1.0]),
+        },
+    }
+    logger.info(f"[{pattern} @ {baud}] 发送 {result['bytes_sent']} 接收 {result['bytes_received']} "
+                f"有效吞吐量 {result['goodput_bps']:.0f} B/s 开销 {result['overhead_ratio']} "
+                f"延迟 p50={result['latency_ms']['p50']}ms p99={result['latency_ms']['p99']}ms "
+                f"重复帧 {result['duplicate_frames']} 丢失帧 {result['lost_frames']}")
+    return result
+
+
+def device_protocol_stats(log_path, timeout):
+    """等待宿主机日志输出新的帧协议统计（每10秒一次），返回最后一条"""
+    def last_match():
+        try:
+            with open(log_path, 'r', encoding='utf-8', errors='replace') as f:
+                matches = PROTOCOL_STATS_RE.findall(f.read())
+        except OSError:
+            return 0, None
+        return len(matches), matches[-1] if matches else None
+
+    count, match = last_match()
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        time.sleep(0.5)
+        new_count, new_match = last_match()
+        if new_count > count:
+            match = new_match
+            break
+    if match is None:
+        return None
+    keys = ('sent_frames', 'acked_frames', 'in_flight_frames', 'in_flight_bytes', 'retransmitted_frames',
+            'ack_latency_avg_ms', 'ack_latency_max_ms', 'window_full_waits')
+    return dict(zip(keys, (int(v) for v in match)))
+
+
+def run_baud(baud, args, rng):
+    """启动一个波特率下的全部数据模式"""
+    sink = FramedSink(args.listen, args.port, args.window_bits)
+    process = None
+    port = None
+    results = []
+    log_path = None
+    try:
+        if args.host_binary:
+            link = os.path.join(tempfile.gettempdir(), f"esp_frame_bench_uart{args.uart_port}_{os.getpid()}")
+            log_path = args.host_log or os.path.join(tempfile.gettempdir(), f"esp_frame_bench_{os.getpid()}.log")
+            env = dict(os.environ)
+            env[f'ESP_HOST_UART{args.uart_port}_LINK'] = link
+            env['ESP_HOST_UART_BAUD'] = str(baud)
+            log = open(log_path, 'ab')
+            process = subprocess.Popen([args.host_binary], env=env, stdout=log, stderr=log)
+            sink.accept(args.connect_timeout)
+            port = PtyPort(link)
+        else:
+            port = SerialPort(args.serial, baud)
+            logger.info(f"请确认设备UART波特率为 {baud}，等待设备连接...")
+            sink.accept(args.connect_timeout)
+            log_path = args.host_log
+
+        if not sink.connected.wait(5.0):
+            logger.error("未收到hello帧，设备是否启用了帧协议（CONFIG_PROTOCOL_FRAMING）？")
+            return results
+
+        # 丢弃连接时发送的问候数据
+        time.sleep(1.0)
+        for pattern in args.patterns:
+            results.append(run_pattern(port, sink, pattern, baud, args, rng))
+
+        if log_path and results:
+            stats = device_protocol_stats(log_path, args.stats_timeout)
+            if stats:
+                logger.info(f"[{baud}] 设备确认延迟 平均{stats['ack_latency_avg_ms']}ms "
+                            f"最长{stats['ack_latency_max_ms']}ms 重传{stats['retransmitted_frames']}帧")
+                for result in results:
+                    result['device_protocol'] = stats
+    finally:
+        if port:
+            port.close()
+        sink.close()
+        if process:
+            process.terminate()
+            try:
+                process.wait(timeout=5)
+            except subprocess.TimeoutExpired:
+                process.kill()
+    return results
+
+
+def main():
+    """主函数"""
+    parser = argparse.ArgumentParser(description='帧协议端到端基准测试')
+    target = parser.add_mutually_exclusive_group(required=True)
+    target.add_argument('--host-binary', help='启用帧协议的esp32_bridge_host路径')
+    target.add_argument('--serial', help='连接ESP32 UART RX的串口设备（如/dev/ttyUSB0）')
+    parser.add_argument('--uart-port', type=int, default=1, help='被测UART端口号（宿主机模式）')
+    parser.add_argument('--listen', default='0.0.0.0', help='监听地址')
+    parser.add_argument('--port', type=int, default=8080, help='监听端口，须与TCP_SERVER_PORT一致')
+    parser.add_argument('--baud', type=int, nargs='+', default=[115200, 921600], help='测试的波特率')
+    parser.add_argument('--patterns', nargs='+', choices=PATTERNS, default=['burst', 'stream'], help='数据模式')
+    parser.add_argument('--bytes', type=int, default=64 * 1024, help='每个模式注入的字节数')
+    parser.add_argument('--burst-size', type=int, default=256, help='burst模式的突发大小')
+    parser.add_argument('--max-random-size', type=int, default=1024, help='random模式的最大块大小')
+    parser.add_argument('--reconnect', action='store_true', help='中途断开连接，测试重传和去重')
+    parser.add_argument('--window-bits', type=int, default=DEFAULT_WINDOW_BITS,
+                        help='压缩通道的窗口大小对数，须与UPLINK_COMPRESS_WINDOW_BITS一致')
+    parser.add_argument('--reconnect-bytes', type=int, default=4096, help='断开前不确认的注入字节数')
+    parser.add_argument('--settle', type=float, default=2.0, help='等待数据到达的空闲超时（秒）')
+    parser.add_argument('--connect-timeout', type=float, default=30.0, help='等待设备连接的超时（秒）')
+    parser.add_argument('--stats-timeout', type=float, default=12.0, help='等待设备输出帧协议统计的时间（秒）')
+    parser.add_argument('--seed', type=int, default=1, help='随机种子，固定种子使结果可比较')
+    parser.add_argument('--host-log', help='宿主机进程日志文件（设备模式下为设备日志文件）')
+    parser.add_argument('--output', default='frame_bench.json', help='JSON结果文件')
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    report = {
+        'commit': git_commit(),
+        'timestamp': time.strftime('%Y-%m-%dT%H:%M:%S%z'),
+        'target': 'host' if args.host_binary else 'device',
+        'config': {
+            'bytes_per_pattern': args.bytes,
+            'burst_size': args.burst_size,
+            'max_random_size': args.max_random_size,
+            'reconnect': args.reconnect,
+            'reconnect_bytes': args.reconnect_bytes,
+            'seed': args.seed,
+        },
+        'results': [],
+    }
+
+    try:
+        for baud in args.baud:
+            report['results'].extend(run_baud(baud, args, rng))
+    except KeyboardInterrupt:
+        logger.info("测试被中断")
+    except socket.timeout:
+        logger.error("等待设备连接超时")
+        sys.exit(1)
+
+    with open(args.output, 'w', encoding='utf-8') as f:
+        json.dump(report, f, indent=2, ensure_ascii=False)
+    logger.info(f"结果已写入 {args.output}")
+
+
+if __name__ == "__main__":
+    main()
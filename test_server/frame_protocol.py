@@ -0,0 +1,278 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+桥接帧协议的Python实现（与components/protocol一致）
+
+帧格式（变长整数为无符号LEB128，CRC32为小端，覆盖类型到负载末尾）：
+    0xA5 | 类型 | 负载长度 | 通道 | 帧号 | 负载 | CRC32
+
+类型：
+    DATA  数据帧，帧号从1开始连续递增
+    ACK   累计确认，帧号为期望的下一帧号
+    HELLO 每次连接后设备首先发送，帧号为最早未确认的帧号，负载为4字节会话ID
+
+通道：
+    0     原始数据
+    1     压缩数据（UPLINK_COMPRESS，格式见lz_codec.py），解压窗口跨越重连保留，设备重启时重置
+
+直接运行时作为帧协议服务器：解析设备上行的数据帧，去除重传造成的重复帧，
+收到数据后发送累计确认，打印数据内容或吞吐统计。
+"""
+
+import argparse
+import logging
+import socket
+import struct
+import time
+import zlib
+
+from lz_codec import DEFAULT_WINDOW_BITS, LzDecoder
+
+# 配置日志
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s - %(levelname)s - %(message)s'
+)
+logger = logging.getLogger(__name__)
+
+FRAME_SYNC = 0xA5
+FRAME_DATA = 0
+FRAME_ACK = 1
+FRAME_HELLO = 2
+FRAME_CRC_SIZE = 4
+CHANNEL_DATA = 0
+CHANNEL_COMPRESSED = 1
+
+
+def encode_varint(value):
+    """编码无符号LEB128"""
+    out = bytearray()
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+    return bytes(out)
+
+
+def encode_frame(frame_type, channel, seq, payload=b''):
+    """编码一帧"""
+    body = bytes([frame_type]) + encode_varint(len(payload)) + encode_varint(channel) + \
+        encode_varint(seq) + payload
+    return bytes([FRAME_SYNC]) + body + struct.pack('<I', zlib.crc32(body))
+
+
+class Frame:
+    __slots__ = ('type', 'channel', 'seq', 'payload', 'wire_size')
+
+    def __init__(self, frame_type, channel, seq, payload, wire_size):
+        self.type = frame_type
+        self.channel = channel
+        self.seq = seq
+        self.payload = payload
+        self.wire_size = wire_size
+
+
+def _read_varint(buf, pos):
+    """从pos读取varint，数据不足返回(None, pos)，格式错误返回(-1, pos)"""
+    value = 0
+    shift = 0
+    while pos < len(buf):
+        byte = buf[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, pos
+        shift += 7
+        if shift > 28:
+            return -1, pos
+    return None, pos
+
+
+class FrameParser:
+    def __init__(self, max_payload=1 << 20):
+        """增量帧解析器，输入任意切分的字节流，输出完整的帧
+
+        Args:
+            max_payload: 接受的最大负载长度
+        """
+        self.max_payload = max_payload
+        self.buffer = bytearray()
+        self.frames = 0
+        self.crc_errors = 0
+        self.sync_errors = 0
+
+    def feed(self, data):
+        """输入数据，返回解析出的帧列表"""
+        self.buffer += data
+        frames = []
+        buf = self.buffer
+        pos = 0
+        while True:
+            start = buf.find(FRAME_SYNC, pos)
+            if start < 0:
+                self.sync_errors += len(buf) - pos
+                pos = len(buf)
+                break
+            self.sync_errors += start - pos
+            pos = start
+
+            if pos + 2 > len(buf):
+                break
+            frame_type = buf[pos + 1]
+            length, p = _read_varint(buf, pos + 2)
+            channel, p = _read_varint(buf, p) if length is not None and length >= 0 else (length, p)
+            seq, p = _read_varint(buf, p) if channel is not None and channel >= 0 else (channel, p)
+            if seq is None:
+                break       # 帧头不完整，等待更多数据
+            if seq < 0 or length < 0 or channel < 0 or frame_type > FRAME_HELLO or length > self.max_payload:
+                pos += 1    # 不是有效帧头，从下一个字节继续寻找同步字节
+                self.sync_errors += 1
+                continue
+
+            end = p + length + FRAME_CRC_SIZE
+            if end > len(buf):
+                break
+            crc = struct.unpack_from('<I', buf, p + length)[0]
+            if zlib.crc32(buf[pos + 1:p + length]) != crc:
+                self.crc_errors += 1
+                pos += 1
+                continue
+
+            frames.append(Frame(frame_type, channel, seq, bytes(buf[p:p + length]), end - pos))
+            self.frames += 1
+            pos = end
+
+        del buf[:pos]
+        return frames
+
+
+class FrameSession:
+    def __init__(self, window_bits=DEFAULT_WINDOW_BITS):
+        """接收方会话状态，跨越重新连接保留，用于去除重传造成的重复帧
+
+        Args:
+            window_bits: 压缩通道的解压窗口大小对数
+        """
+        self.window_bits = window_bits
+        self.decoder = LzDecoder(window_bits)
+        self.compressed_bytes = 0   # 压缩通道收到的负载字节数
+        self.session_id = None
+        self.expected = 1       # 期望的下一帧号
+        self.duplicates = 0     # 重复帧数（重连后重传的已收到帧）
+        self.gaps = 0           # 帧号跳跃次数（有帧丢失）
+        self.lost_frames = 0
+        self.restarts = 0       # 设备重启次数（会话ID变化）
+
+    def on_hello(self, frame):
+        """处理hello帧，返回应答的确认帧"""
+        session_id = struct.unpack('<I', frame.payload[:4])[0] if len(frame.payload) >= 4 else None
+        if session_id != self.session_id:
+            # 设备重启，帧号重新计数
+            if self.session_id is not None:
+                self.restarts += 1
+            self.session_id = session_id
+            self.expected = frame.seq
+            self.decoder.reset()
+        elif frame.seq > self.expected:
+            # 设备认为已确认但本端未收到的帧不会再重传
+            self.gaps += 1
+            self.lost_frames += frame.seq - self.expected
+            self.expected = frame.seq
+        return self.ack_frame()
+
+    def on_data(self, frame):
+        """处理数据帧，返回应交付的负载，重复帧返回None"""
+        if frame.seq < self.expected:
+            self.duplicates += 1
+            return None
+        if frame.seq > self.expected:
+            self.gaps += 1
+            self.lost_frames += frame.seq - self.expected
+        self.expected = frame.seq + 1
+        if frame.channel == CHANNEL_COMPRESSED:
+            self.compressed_bytes += len(frame.payload)
+            return self.decoder.feed(frame.payload)
+        return frame.payload
+
+    def ack_frame(self):
+        return encode_frame(FRAME_ACK, 0, self.expected)
+
+
+def serve(args):
+    """帧协议服务器"""
+    server_socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server_socket.bind((args.host, args.port))
+    server_socket.listen(1)
+    logger.info(f"帧协议服务器启动，监听 {args.host}:{args.port}")
+
+    session = FrameSession(args.window_bits)
+    downlink_seq = 1
+    while True:
+        client_socket, addr = server_socket.accept()
+        logger.info(f"接受来自 {addr[0]}:{addr[1]} 的连接")
+        parser = FrameParser()
+        total = 0
+        window_bytes = 0
+        window_start = time.time()
+        try:
+            while True:
+                data = client_socket.recv(65536)
+                if not data:
+                    break
+                ack_needed = False
+                for frame in parser.feed(data):
+                    if frame.type == FRAME_HELLO:
+                        client_socket.sendall(session.on_hello(frame))
+                        logger.info(f"会话 {session.session_id:08x}，从帧号 {frame.seq} 继续")
+                        continue
+                    if frame.type != FRAME_DATA:
+                        continue
+                    payload = session.on_data(frame)
+                    ack_needed = True
+                    if payload is None:
+                        continue
+                    total += len(payload)
+                    window_bytes += len(payload)
+                    if not args.quiet:
+                        logger.info(f"帧 {frame.seq} 通道 {frame.channel}: {payload!r}")
+                    if args.echo:
+                        client_socket.sendall(encode_frame(FRAME_DATA, frame.channel, downlink_seq, payload))
+                        downlink_seq += 1
+
+                # 每次接收后发送一次累计确认
+                if ack_needed:
+                    client_socket.sendall(session.ack_frame())
+
+                now = time.time()
+                if now - window_start >= 1.0:
+                    logger.info(f"吞吐量: {window_bytes / (now - window_start):.0f} 字节/秒, 累计 {total} 字节, "
+                                f"重复帧 {session.duplicates}, 丢失帧 {session.lost_frames}, "
+                                f"校验错误 {parser.crc_errors}")
+                    window_bytes = 0
+                    window_start = now
+        except OSError as e:
+            logger.error(f"连接出错: {e}")
+        finally:
+            client_socket.close()
+        logger.info(f"连接断开，本次接收 {total} 字节，下一帧号 {session.expected}")
+
+
+def main():
+    """主函数"""
+    parser = argparse.ArgumentParser(description='桥接帧协议服务器')
+    parser.add_argument('--host', default='0.0.0.0', help='服务器监听地址')
+    parser.add_argument('--port', type=int, default=8080, help='服务器监听端口')
+    parser.add_argument('--quiet', action='store_true', help='不打印每帧数据，只打印吞吐统计')
+    parser.add_argument('--echo', action='store_true', help='把收到的负载作为下行数据帧发回')
+    parser.add_argument('--window-bits', type=int, default=DEFAULT_WINDOW_BITS,
+                        help='压缩通道的窗口大小对数，须与UPLINK_COMPRESS_WINDOW_BITS一致')
+    args = parser.parse_args()
+    try:
+        serve(args)
+    except KeyboardInterrupt:
+        logger.info("服务器已退出")
+
+
+if __name__ == "__main__":
+    main()
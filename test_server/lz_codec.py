@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+上行压缩格式的解压器（与components/compress一致）
+
+压缩数据由若干字节对齐的序列组成：
+    标记 | [字面量长度扩展] | 字面量 | [距离(2字节小端) | [匹配长度扩展]]
+标记高4位为字面量字节数，低4位为0表示没有匹配，否则匹配长度为该值+2；
+值为15时后跟扩展字节逐个累加，字节为255时继续。
+
+直接运行时解压文件：python lz_codec.py 输入文件 输出文件
+"""
+
+import argparse
+import sys
+
+DEFAULT_WINDOW_BITS = 11
+
+
+class LzError(Exception):
+    pass
+
+
+class LzDecoder:
+    def __init__(self, window_bits=DEFAULT_WINDOW_BITS):
+        """流式解压器，输入可在任意位置切分
+
+        Args:
+            window_bits: 与设备UPLINK_COMPRESS_WINDOW_BITS相同的窗口大小对数
+        """
+        self.window = 1 << window_bits
+        self.history = bytearray()
+        self.pending = bytearray()
+
+    def reset(self):
+        self.history = bytearray()
+        self.pending = bytearray()
+
+    @staticmethod
+    def _extension(buf, pos, value):
+        """读取扩展长度，数据不足返回(None, pos)"""
+        while True:
+            if pos >= len(buf):
+                return None, pos
+            byte = buf[pos]
+            pos += 1
+            value += byte
+            if byte != 255:
+                return value, pos
+
+    def feed(self, data):
+        """输入压缩数据，返回解出的数据；不完整的序列留到下次输入"""
+        buf = self.pending + data
+        out = bytearray()
+        history = self.history
+        pos = 0
+        while pos < len(buf):
+            start = pos
+            token = buf[pos]
+            pos += 1
+            literals = token >> 4
+            match = token & 0x0F
+            if literals == 15:
+                literals, pos = self._extension(buf, pos, literals)
+                if literals is None:
+                    pos = start
+                    break
+            if pos + literals > len(buf):
+                pos = start
+                break
+            if match == 0:
+                chunk = buf[pos:pos + literals]
+                pos += literals
+                out += chunk
+                history += chunk
+                continue
+
+            literal_pos = pos
+            pos += literals
+            if pos + 2 > len(buf):
+                pos = start
+                break
+            distance = buf[pos] | (buf[pos + 1] << 8)
+            pos += 2
+            if match == 15:
+                match, pos = self._extension(buf, pos, match)
+                if match is None:
+                    pos = start
+                    break
+            length = match + 2
+
+            chunk = buf[literal_pos:literal_pos + literals]
+            out += chunk
+            history += chunk
+            if distance == 0 or distance > min(len(history), self.window):
+                raise LzError(f"无效的匹配距离 {distance}")
+            # 距离小于长度时匹配与输出重叠，逐段复制
+            src = len(history) - distance
+            for i in range(length):
+                history.append(history[src + i])
+            out += history[-length:]
+
+        self.pending = bytearray(buf[pos:])
+        # 只保留一个窗口的历史
+        if len(history) > self.window * 4:
+            del history[:len(history) - self.window]
+        return bytes(out)
+
+
+def decompress(data, window_bits=DEFAULT_WINDOW_BITS):
+    """解压一段完整的压缩数据"""
+    decoder = LzDecoder(window_bits)
+    out = decoder.feed(data)
+    if decoder.pending:
+        raise LzError(f"数据不完整，剩余 {len(decoder.pending)} 字节")
+    return out
+
+
+def main():
+    """主函数"""
+    parser = argparse.ArgumentParser(description='解压上行压缩数据')
+    parser.add_argument('input', help='压缩数据文件')
+    parser.add_argument('output', nargs='?', help='输出文件，默认为标准输出')
+    parser.add_argument('--window-bits', type=int, default=DEFAULT_WINDOW_BITS, help='窗口大小对数')
+    args = parser.parse_args()
+
+    with open(args.input, 'rb') as f:
+        data = decompress(f.read(), args.window_bits)
+    if args.output:
+        with open(args.output, 'wb') as f:
+            f.write(data)
+    else:
+        sys.stdout.buffer.write(data)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+TCP重连时间测试
+
+模拟服务器重启：设备连接后关闭连接和监听套接字，停机一段时间后重新监听，
+测量从服务器恢复监听到设备重新连接的时间。多轮测试后输出分位数统计和JSON结果。
+"""
+
+import argparse
+import json
+import logging
+import socket
+import sys
+import time
+
+# 配置日志
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s - %(levelname)s - %(message)s'
+)
+logger = logging.getLogger(__name__)
+
+
+def listen(host, port):
+    """创建监听套接字"""
+    server_socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server_socket.bind((host, port))
+    server_socket.listen(1)
+    return server_socket
+
+
+def percentile(values, p):
+    """最近秩法分位数"""
+    if not values:
+        return None
+    ordered = sorted(values)
+    index = min(len(ordered) - 1, max(0, int(round(p * len(ordered) + 0.5)) - 1))
+    return ordered[index]
+
+
+def main():
+    """主函数"""
+    parser = argparse.ArgumentParser(description='TCP重连时间测试')
+    parser.add_argument('--host', default='0.0.0.0', help='监听地址')
+    parser.add_argument('--port', type=int, default=8080, help='监听端口')
+    parser.add_argument('--rounds', type=int, default=10, help='重启次数')
+    parser.add_argument('--downtime', type=float, nargs='+', default=[0.5, 2.0, 5.0],
+                        help='服务器停机时间（秒），多个值时轮流使用')
+    parser.add_argument('--hold', type=float, default=1.0, help='每次连接保持的时间（秒）')
+    parser.add_argument('--timeout', type=float, default=60.0, help='等待重新连接的超时（秒）')
+    parser.add_argument('--target', type=float, default=500.0, help='重连时间目标（毫秒）')
+    parser.add_argument('--output', help='JSON结果文件')
+    args = parser.parse_args()
+
+    server_socket = listen(args.host, args.port)
+    server_socket.settimeout(args.timeout)
+    logger.info(f"等待设备首次连接 {args.host}:{args.port}...")
+    try:
+        client_socket, addr = server_socket.accept()
+    except socket.timeout:
+        logger.error("等待设备连接超时")
+        sys.exit(1)
+    logger.info(f"设备已连接: {addr[0]}:{addr[1]}")
+
+    trials = []
+    try:
+        for round_index in range(args.rounds):
+            time.sleep(args.hold)
+
+            # 模拟服务器进程退出：关闭连接和监听套接字
+            downtime = args.downtime[round_index % len(args.downtime)]
+            client_socket.close()
+            server_socket.close()
+            time.sleep(downtime)
+
+            server_socket = listen(args.host, args.port)
+            server_socket.settimeout(args.timeout)
+            restart_time = time.monotonic()
+            try:
+                client_socket, addr = server_socket.accept()
+            except socket.timeout:
+                logger.error(f"第{round_index + 1}轮: 设备未在{args.timeout}秒内重新连接")
+                trials.append({'downtime_s': downtime, 'reconnect_ms': None})
+                break
+            elapsed_ms = (time.monotonic() - restart_time) * 1000
+            trials.append({'downtime_s': downtime, 'reconnect_ms': round(elapsed_ms, 1)})
+            logger.info(f"第{round_index + 1}轮: 停机{downtime:.1f}秒, 恢复后{elapsed_ms:.1f}ms重新连接")
+    except KeyboardInterrupt:
+        logger.info("测试被中断")
+    finally:
+        client_socket.close()
+        server_socket.close()
+
+    # 按停机时间分组统计
+    summary = {}
+    for downtime in sorted(set(t['downtime_s'] for t in trials)):
+        values = [t['reconnect_ms'] for t in trials if t['downtime_s'] == downtime and t['reconnect_ms'] is not None]
+        summary[str(downtime)] = {
+            'count': len(values),
+            'p50_ms': percentile(values, 0.5),
+            'max_ms': max(values) if values else None,
+            'within_target': sum(1 for v in values if v <= args.target),
+        }
+        if values:
+            logger.info(f"停机{downtime:.1f}秒: p50={summary[str(downtime)]['p50_ms']}ms "
+                        f"最长={summary[str(downtime)]['max_ms']}ms, "
+                        f"{summary[str(downtime)]['within_target']}/{len(values)}次在{args.target:.0f}ms内")
+
+    if args.output:
+        with open(args.output, 'w', encoding='utf-8') as f:
+            json.dump({'target_ms': args.target, 'trials': trials, 'summary': summary}, f, indent=2)
+        logger.info(f"结果已写入 {args.output}")
+
+
+if __name__ == "__main__":
+    main()
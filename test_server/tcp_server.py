@@ -13,6 +13,8 @@ import logging
 import sys
 import signal
 
+from lz_codec import LzDecoder
+
 # 配置日志
 logging.basicConfig(
     level=logging.INFO,
@@ -24,15 +26,21 @@ logger = logging.getLogger(__name__)
 running = True
 
 class TcpServer:
-    def __init__(self, host='0.0.0.0', port=8080):
+    def __init__(self, host='0.0.0.0', port=8080, rate=0, quiet=False, window_bits=None):
         """初始化TCP服务器
         
         Args:
             host: 服务器监听地址，默认所有地址
             port: 服务器监听端口
+            rate: 接收限速（字节/秒），0表示不限速，用于模拟慢速链路
+            quiet: 不打印每包数据，只打印吞吐统计
+            window_bits: 设备启用了上行压缩时为压缩窗口大小对数，接收的数据先解压
         """
         self.host = host
         self.port = port
+        self.rate = rate
+        self.quiet = quiet
+        self.window_bits = window_bits
         self.server_socket = None
         self.clients = []
         self.running = False
@@ -116,25 +124,65 @@ class TcpServer:
             client_socket: 客户端socket
             addr: 客户端地址
         """
+        total_bytes = 0
+        wire_bytes = 0
+        window_bytes = 0
+        window_reads = 0
+        start_time = time.time()
+        window_start = start_time
+        # 设备每个连接从空窗口开始压缩
+        decoder = LzDecoder(self.window_bits) if self.window_bits else None
+        
         try:
             while self.running:
-                # 接收数据
-                data = client_socket.recv(1024)
+                # 接收数据，限速时每次只读取少量数据
+                data = client_socket.recv(256 if self.rate > 0 else 1024)
                 
                 if not data:
-                    logger.info(f"客户端 {addr[0]}:{addr[1]} 断开连接")
+                    elapsed = time.time() - start_time
+                    logger.info(f"客户端 {addr[0]}:{addr[1]} 断开连接，共接收 {total_bytes} 字节，"
+                                f"平均 {total_bytes / elapsed if elapsed > 0 else 0:.0f} 字节/秒")
                     break
                 
+                wire_bytes += len(data)
+                if decoder:
+                    data = decoder.feed(data)
+                total_bytes += len(data)
+                window_bytes += len(data)
+                window_reads += 1
+                if not data:
+                    continue
+                
                 # 打印接收到的数据
-                try:
-                    decoded = data.decode('utf-8')
-                    logger.info(f"从 {addr[0]}:{addr[1]} 接收: {decoded}")
-                except UnicodeDecodeError:
-                    logger.info(f"从 {addr[0]}:{addr[1]} 接收二进制数据: {data.hex()}")
+                if not self.quiet:
+                    try:
+                        decoded = data.decode('utf-8')
+                        logger.info(f"从 {addr[0]}:{addr[1]} 接收: {decoded}")
+                    except UnicodeDecodeError:
+                        logger.info(f"从 {addr[0]}:{addr[1]} 接收二进制数据: {data.hex()}")
+                
+                    # 回复客户端
+                    reply = f"服务器已接收 {len(data)} 字节"
+                    client_socket.send(reply.encode('utf-8'))
+                
+                # 限速：按目标速率推迟下一次接收，TCP窗口填满后设备端发送被阻塞
+                if self.rate > 0:
+                    expected = total_bytes / self.rate
+                    elapsed = time.time() - start_time
+                    if expected > elapsed:
+                        time.sleep(expected - elapsed)
                 
-                # 回复客户端
-                reply = f"服务器已接收 {len(data)} 字节"
-                client_socket.send(reply.encode('utf-8'))
+                # 每秒打印一次吞吐量和读取次数（未限速时近似等于到达的TCP段数）
+                now = time.time()
+                if now - window_start >= 1.0:
+                    interval = now - window_start
+                    logger.info(f"{addr[0]}:{addr[1]} 吞吐量: {window_bytes / interval:.0f} 字节/秒, "
+                                f"读取 {window_reads / interval:.0f} 次/秒, "
+                                f"平均 {window_bytes / window_reads:.0f} 字节/次, 累计 {total_bytes} 字节"
+                                + (f", 压缩后 {wire_bytes} 字节" if decoder else ""))
+                    window_bytes = 0
+                    window_reads = 0
+                    window_start = now
                 
         except Exception as e:
             logger.error(f"处理客户端 {addr[0]}:{addr[1]} 时出错: {e}")
@@ -162,13 +210,17 @@ def main():
     parser = argparse.ArgumentParser(description='TCP服务器测试工具')
     parser.add_argument('--host', default='0.0.0.0', help='服务器监听地址')
     parser.add_argument('--port', type=int, default=8080, help='服务器监听端口')
+    parser.add_argument('--rate', type=int, default=0, help='接收限速（字节/秒），0表示不限速')
+    parser.add_argument('--quiet', action='store_true', help='不打印每包数据，只打印吞吐统计')
+    parser.add_argument('--decompress', type=int, nargs='?', const=11, metavar='WINDOW_BITS',
+                        help='解压设备的上行压缩数据，参数为UPLINK_COMPRESS_WINDOW_BITS（默认11）')
     args = parser.parse_args()
     
     # 处理中断信号
     signal.signal(signal.SIGINT, signal_handler)
     
     # 创建并启动服务器
-    server = TcpServer(args.host, args.port)
+    server = TcpServer(args.host, args.port, args.rate, args.quiet, args.decompress)
     if not server.start():
         sys.exit(1)
     
@@ -0,0 +1,222 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+TLS完整握手与会话恢复对比测试
+
+设备模式：设备连接后保持一段时间再关闭连接，迫使设备重连，多轮后比较完整握手和
+以会话票据恢复的握手耗时（服务器端从accept到握手完成）。第一轮为完整握手，之后
+设备出示RTC内存中的票据。--device-log指定设备串口日志时同时统计设备端的耗时、本地
+运算时间和收发字节数（"TLS握手完成"日志行），并按电流参数估算每次握手的能耗：
+    能耗 = 电压 × (射频电流 × 握手耗时 + CPU电流 × 本地运算时间)
+
+自检模式（--self-test）：在本机启动服务器，用Python客户端交替进行完整握手和会话恢复，
+验证服务器配置并给出宿主机上的参考耗时，不需要设备。
+"""
+
+import argparse
+import json
+import logging
+import re
+import socket
+import ssl
+import statistics
+import sys
+import threading
+import time
+
+from tls_server import CERTS_DIR, accept_tls, generate_certs, server_context
+
+# 配置日志
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s - %(levelname)s - %(message)s'
+)
+logger = logging.getLogger(__name__)
+
+DEVICE_LOG_RE = re.compile(r'TLS握手完成\((会话恢复|完整握手)\): (\d+)ms, 本地运算(\d+)ms, (\d+)字节')
+
+
+def summarize(values):
+    """耗时统计（毫秒）"""
+    if not values:
+        return None
+    return {
+        'count': len(values),
+        'min_ms': round(min(values), 2),
+        'median_ms': round(statistics.median(values), 2),
+        'max_ms': round(max(values), 2),
+    }
+
+
+def listen(host, port):
+    """创建监听套接字"""
+    server_socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server_socket.bind((host, port))
+    server_socket.listen(5)
+    return server_socket
+
+
+def parse_device_log(path, args):
+    """统计设备日志中的握手记录并估算能耗"""
+    records = {'full': [], 'resumed': []}
+    with open(path, encoding='utf-8', errors='replace') as f:
+        for line in f:
+            match = DEVICE_LOG_RE.search(line)
+            if match:
+                kind = 'resumed' if match.group(1) == '会话恢复' else 'full'
+                records[kind].append(tuple(int(v) for v in match.groups()[1:]))
+
+    result = {}
+    for kind, items in records.items():
+        if not items:
+            continue
+        elapsed = statistics.median(r[0] for r in items)
+        compute = statistics.median(r[1] for r in items)
+        energy_mj = args.voltage * (args.radio_ma * elapsed + args.cpu_ma * compute) / 1000.0
+        result[kind] = {
+            'count': len(items),
+            'median_ms': elapsed,
+            'median_compute_ms': compute,
+            'median_bytes': statistics.median(r[2] for r in items),
+            'energy_mj': round(energy_mj, 3),
+        }
+    return result
+
+
+def run_device(args):
+    """等待设备多轮重连，记录服务器端的握手耗时"""
+    context = server_context(args.certs)
+    server_socket = listen(args.host, args.port)
+    server_socket.settimeout(args.timeout)
+    full, resumed = [], []
+    logger.info(f"等待设备连接 {args.host}:{args.port}，共{args.rounds}轮...")
+    try:
+        for i in range(args.rounds):
+            try:
+                tls, addr, elapsed_ms, reused = accept_tls(server_socket, context)
+            except socket.timeout:
+                logger.error("等待设备连接超时")
+                break
+            if tls is None:
+                continue
+            (resumed if reused else full).append(elapsed_ms)
+            logger.info(f"第{i + 1}轮 {addr}: {'会话恢复' if reused else '完整握手'} {elapsed_ms:.1f}ms")
+            # 保持连接并丢弃收到的数据，然后关闭迫使设备重连
+            deadline = time.time() + args.hold
+            tls.settimeout(0.1)
+            while time.time() < deadline:
+                try:
+                    if not tls.recv(4096):
+                        break
+                except socket.timeout:
+                    continue
+                except (ssl.SSLError, OSError):
+                    break
+            tls.close()
+    finally:
+        server_socket.close()
+    return full, resumed
+
+
+def run_self_test(args):
+    """本机服务器和Python客户端的对比测试"""
+    context = server_context(args.certs)
+    server_socket = listen('127.0.0.1', 0)
+    port = server_socket.getsockname()[1]
+    stop = threading.Event()
+
+    def serve():
+        while not stop.is_set():
+            try:
+                tls, _, _, _ = accept_tls(server_socket, context)
+            except OSError:
+                break
+            if tls is not None:
+                try:
+                    tls.recv(1)
+                except (ssl.SSLError, OSError):
+                    pass
+                tls.close()
+
+    thread = threading.Thread(target=serve)
+    thread.daemon = True
+    thread.start()
+
+    client_context = ssl.create_default_context(cafile=f"{args.certs}/ca.pem")
+    client_context.maximum_version = ssl.TLSVersion.TLSv1_2
+    full, resumed = [], []
+    session = None
+    try:
+        for _ in range(args.rounds):
+            # 每轮一次完整握手、一次出示上次票据的握手
+            for offer in (False, True):
+                sock = socket.create_connection(('127.0.0.1', port))
+                start = time.perf_counter()
+                tls = client_context.wrap_socket(sock, server_hostname='localhost',
+                                                 session=session if offer else None)
+                elapsed_ms = (time.perf_counter() - start) * 1000.0
+                if offer and not tls.session_reused:
+                    logger.error("服务器未接受会话票据")
+                    return None, None
+                (resumed if tls.session_reused else full).append(elapsed_ms)
+                session = tls.session
+                tls.close()
+    finally:
+        stop.set()
+        server_socket.close()
+    return full, resumed
+
+
+def main():
+    """主函数"""
+    parser = argparse.ArgumentParser(description='TLS完整握手与会话恢复对比测试')
+    parser.add_argument('--host', default='0.0.0.0', help='监听地址')
+    parser.add_argument('--port', type=int, default=8080, help='监听端口')
+    parser.add_argument('--certs', default=CERTS_DIR, help='证书目录，不存在时自动生成')
+    parser.add_argument('--rounds', type=int, default=10, help='测试轮数')
+    parser.add_argument('--hold', type=float, default=1.0, help='每次连接保持的时间（秒）')
+    parser.add_argument('--timeout', type=float, default=60.0, help='等待设备重新连接的超时（秒）')
+    parser.add_argument('--device-log', help='设备串口日志文件，统计设备端的握手耗时和能耗')
+    parser.add_argument('--voltage', type=float, default=3.3, help='估算能耗用的供电电压（V）')
+    parser.add_argument('--radio-ma', type=float, default=100.0, help='握手期间WiFi射频保持工作的电流（mA）')
+    parser.add_argument('--cpu-ma', type=float, default=40.0, help='CPU满负荷运算额外增加的电流（mA）')
+    parser.add_argument('--self-test', action='store_true', help='只在本机测试，不需要设备')
+    parser.add_argument('--output', help='JSON结果文件')
+    args = parser.parse_args()
+
+    try:
+        open(f"{args.certs}/server.pem").close()
+    except OSError:
+        generate_certs(args.certs)
+
+    if args.self_test:
+        full, resumed = run_self_test(args)
+        if full is None:
+            sys.exit(1)
+    else:
+        full, resumed = run_device(args)
+
+    result = {
+        'mode': 'self_test' if args.self_test else 'device',
+        'measured_at': 'client' if args.self_test else 'server',
+        'full': summarize(full),
+        'resumed': summarize(resumed),
+    }
+    if full and resumed:
+        result['resumed_speedup'] = round(statistics.median(full) / statistics.median(resumed), 2)
+    if args.device_log:
+        result['device'] = parse_device_log(args.device_log, args)
+        device = result['device']
+        if 'full' in device and 'resumed' in device and device['resumed']['energy_mj'] > 0:
+            result['energy_saving'] = round(1.0 - device['resumed']['energy_mj'] / device['full']['energy_mj'], 3)
+
+    text = json.dumps(result, ensure_ascii=False, indent=2)
+    print(text)
+    if args.output:
+        with open(args.output, 'w', encoding='utf-8') as f:
+            f.write(text + '\n')
+
+
+if __name__ == "__main__":
+    main()
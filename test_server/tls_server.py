@@ -0,0 +1,221 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+TLS测试服务器（设备启用CONFIG_TLS_ENABLE时使用）
+
+只接受TLS 1.2并启用会话票据，记录每个连接的握手耗时和是否为会话恢复，之后接收数据。
+票据密钥只在本进程内有效，服务器重启后设备的第一次握手为完整握手。
+
+首次使用先生成证书，设备构建时嵌入certs/ca.pem（TLS_CA_CERT_FILE）：
+    python tls_server.py --generate-certs --san IP:192.168.1.100
+"""
+
+import argparse
+import logging
+import os
+import socket
+import ssl
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+# 配置日志
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s - %(levelname)s - %(message)s'
+)
+logger = logging.getLogger(__name__)
+
+CERTS_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'certs')
+
+
+def generate_certs(certs_dir=CERTS_DIR, common_name='esp32-bridge-server', sans=None, days=3650):
+    """用openssl命令行生成CA和服务器证书（ECDSA P-256，设备端验签较快）
+
+    Args:
+        certs_dir: 输出目录，生成ca.pem、ca.key、server.pem、server.key
+        common_name: 服务器证书的CN
+        sans: 额外的subjectAltName，如["IP:192.168.1.100", "DNS:bridge.local"]
+        days: 有效期（天）
+    """
+    os.makedirs(certs_dir, exist_ok=True)
+    ca_key = os.path.join(certs_dir, 'ca.key')
+    ca_pem = os.path.join(certs_dir, 'ca.pem')
+    server_key = os.path.join(certs_dir, 'server.key')
+    server_csr = os.path.join(certs_dir, 'server.csr')
+    server_pem = os.path.join(certs_dir, 'server.pem')
+    names = ['DNS:localhost', 'IP:127.0.0.1', f'DNS:{common_name}'] + list(sans or [])
+
+    def run(*args):
+        subprocess.run(['openssl', *args], check=True, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+
+    ec_args = ['-newkey', 'ec', '-pkeyopt', 'ec_paramgen_curve:prime256v1', '-nodes']
+    run('req', '-x509', *ec_args, '-keyout', ca_key, '-out', ca_pem, '-days', str(days),
+        '-subj', '/CN=esp32-bridge-test-ca')
+    run('req', '-new', *ec_args, '-keyout', server_key, '-out', server_csr, '-subj', f'/CN={common_name}')
+    with tempfile.NamedTemporaryFile('w', suffix='.cnf', delete=False) as ext:
+        ext.write(f"subjectAltName={','.join(names)}\n")
+        ext_path = ext.name
+    try:
+        run('x509', '-req', '-in', server_csr, '-CA', ca_pem, '-CAkey', ca_key, '-CAcreateserial',
+            '-out', server_pem, '-days', str(days), '-sha256', '-extfile', ext_path)
+    finally:
+        os.unlink(ext_path)
+        os.unlink(server_csr)
+    logger.info(f"证书已生成: {certs_dir}，subjectAltName: {', '.join(names)}")
+
+
+def server_context(certs_dir=CERTS_DIR):
+    """创建只使用TLS 1.2、启用会话票据的服务器上下文"""
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    context.minimum_version = ssl.TLSVersion.TLSv1_2
+    context.maximum_version = ssl.TLSVersion.TLSv1_2
+    context.load_cert_chain(os.path.join(certs_dir, 'server.pem'), os.path.join(certs_dir, 'server.key'))
+    context.options &= ~ssl.OP_NO_TICKET
+    return context
+
+
+def accept_tls(server_socket, context, timeout=10.0):
+    """接受一个连接并完成握手
+
+    Returns:
+        (TLS套接字, 地址, 握手耗时毫秒, 是否会话恢复)，握手失败时套接字为None
+    """
+    client, addr = server_socket.accept()
+    client.settimeout(timeout)
+    start = time.perf_counter()
+    try:
+        tls = context.wrap_socket(client, server_side=True, do_handshake_on_connect=False)
+        tls.do_handshake()
+    except (ssl.SSLError, OSError) as e:
+        logger.warning(f"{addr} 握手失败: {e}")
+        client.close()
+        return None, addr, None, False
+    elapsed_ms = (time.perf_counter() - start) * 1000.0
+    return tls, addr, elapsed_ms, tls.session_reused
+
+
+class TlsServer:
+    def __init__(self, host='0.0.0.0', port=8080, certs_dir=CERTS_DIR, quiet=False, drop_after=0.0):
+        """初始化TLS服务器
+
+        Args:
+            host: 监听地址
+            port: 监听端口
+            certs_dir: 证书目录
+            quiet: 不打印每包数据，只打印吞吐统计
+            drop_after: 握手后保持连接的秒数，之后主动关闭以测试重连，0表示不关闭
+        """
+        self.host = host
+        self.port = port
+        self.context = server_context(certs_dir)
+        self.quiet = quiet
+        self.drop_after = drop_after
+        self.server_socket = None
+        self.running = False
+        self.full = []
+        self.resumed = []
+
+    def start(self):
+        """启动服务器"""
+        self.server_socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.server_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.server_socket.bind((self.host, self.port))
+        self.server_socket.listen(5)
+        self.running = True
+        logger.info(f"TLS服务器启动，监听 {self.host}:{self.port}")
+        thread = threading.Thread(target=self._accept_connections)
+        thread.daemon = True
+        thread.start()
+
+    def stop(self):
+        """停止服务器"""
+        self.running = False
+        if self.server_socket:
+            self.server_socket.close()
+
+    def _accept_connections(self):
+        while self.running:
+            try:
+                tls, addr, elapsed_ms, reused = accept_tls(self.server_socket, self.context)
+            except OSError:
+                break
+            if tls is None:
+                continue
+            (self.resumed if reused else self.full).append(elapsed_ms)
+            logger.info(f"{addr} 握手完成({'会话恢复' if reused else '完整握手'}): {elapsed_ms:.1f}ms, "
+                        f"{tls.version()} {tls.cipher()[0]}")
+            thread = threading.Thread(target=self._handle_client, args=(tls, addr))
+            thread.daemon = True
+            thread.start()
+
+    def _handle_client(self, tls, addr):
+        start = time.time()
+        total = 0
+        last_report = start
+        tls.settimeout(0.5)
+        try:
+            while self.running:
+                if self.drop_after > 0 and time.time() - start >= self.drop_after:
+                    logger.info(f"{addr} 主动关闭连接")
+                    break
+                try:
+                    data = tls.recv(4096)
+                except socket.timeout:
+                    continue
+                if not data:
+                    logger.info(f"{addr} 连接关闭")
+                    break
+                total += len(data)
+                if not self.quiet:
+                    logger.info(f"{addr} 收到 {len(data)} 字节: {data[:64]!r}")
+                now = time.time()
+                if self.quiet and now - last_report >= 5.0:
+                    logger.info(f"{addr} 已接收 {total} 字节，{total / (now - start):.0f} 字节/秒")
+                    last_report = now
+        except (ssl.SSLError, OSError) as e:
+            logger.info(f"{addr} 连接错误: {e}")
+        finally:
+            try:
+                tls.close()
+            except OSError:
+                pass
+
+
+def main():
+    """主函数"""
+    parser = argparse.ArgumentParser(description='TLS测试服务器')
+    parser.add_argument('--host', default='0.0.0.0', help='监听地址')
+    parser.add_argument('--port', type=int, default=8080, help='监听端口')
+    parser.add_argument('--certs', default=CERTS_DIR, help='证书目录')
+    parser.add_argument('--generate-certs', action='store_true', help='生成CA和服务器证书后退出')
+    parser.add_argument('--cn', default='esp32-bridge-server', help='生成的服务器证书CN（也加入subjectAltName）')
+    parser.add_argument('--san', action='append', default=[],
+                        help='生成证书时额外的subjectAltName，如IP:192.168.1.100，可重复')
+    parser.add_argument('--quiet', action='store_true', help='不打印每包数据，只打印吞吐统计')
+    parser.add_argument('--drop-after', type=float, default=0.0, help='握手后保持连接的秒数，0表示不主动关闭')
+    args = parser.parse_args()
+
+    if args.generate_certs:
+        generate_certs(args.certs, args.cn, args.san)
+        return
+    if not os.path.exists(os.path.join(args.certs, 'server.pem')):
+        logger.error(f"{args.certs}中没有证书，请先运行 --generate-certs")
+        sys.exit(1)
+
+    server = TlsServer(args.host, args.port, args.certs, args.quiet, args.drop_after)
+    server.start()
+    try:
+        while True:
+            time.sleep(1)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        server.stop()
+        logger.info(f"完整握手{len(server.full)}次，会话恢复{len(server.resumed)}次")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+流量记录：为省电档位仿真（host/tools/sleep_sim）录制或生成数据到达时间
+
+输出文件每行一个数据事件："时间(秒) 字节数"，时间从第一个事件起算，#开头为注释。
+    record:   作为本地TCP服务器接收设备转发的数据，记录每次接收的时间和字节数。
+              设备按数据块转发UART数据，到达间隔近似于设备上的数据事件间隔
+    generate: 按流量模式生成记录，用于比较不同流量形态下的档位选择
+              interactive - 人工输入：每次几个字节，间隔0.2~3秒，偶尔停顿一分钟
+              telemetry   - 周期遥测：每10秒一帧，每帧分几块到达
+              bursty      - 突发传输：每分钟一次持续2秒的连续数据，其余时间静默
+
+示例：
+    python traffic_trace.py record --port 8080 --duration 600 --output field.trace
+    python traffic_trace.py generate --profile telemetry --duration 3600 --output telemetry.trace
+    ../host/build/sleep_sim --trace telemetry.trace
+"""
+
+import argparse
+import logging
+import random
+import sys
+import time
+
+from bridge_bench import TcpSink
+
+# 配置日志
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s - %(levelname)s - %(message)s'
+)
+logger = logging.getLogger(__name__)
+
+PROFILES = ('interactive', 'telemetry', 'bursty')
+
+
+def record(args):
+    """接收设备数据，返回(时间, 字节数)列表"""
+    sink = TcpSink(args.listen, args.port)
+    try:
+        logger.info(f"等待设备连接 {args.listen}:{args.port}")
+        sink.accept(args.connect_timeout)
+        deadline = time.monotonic() + args.duration
+        while time.monotonic() < deadline and not sink.closed:
+            time.sleep(0.1)
+        if sink.closed:
+            logger.warning("设备断开连接，提前结束记录")
+        _, arrivals = sink.snapshot()
+    finally:
+        sink.close()
+    return [(t, end - start) for t, start, end in arrivals]
+
+
+def generate(args):
+    """按流量模式生成(时间, 字节数)列表"""
+    rng = random.Random(args.seed)
+    events = []
+    t = 0.0
+    while t < args.duration:
+        if args.profile == 'interactive':
+            events.append((t, rng.randint(1, 8)))
+            t += 60.0 if rng.random() < 0.02 else rng.uniform(0.2, 3.0)
+        elif args.profile == 'telemetry':
+            for i in range(4):
+                events.append((t + i * 0.002, 64))
+            t += 10.0
+        else:
+            end = t + 2.0
+            while t < end:
+                events.append((t, 1024))
+                t += rng.uniform(0.004, 0.006)
+            t = end + 58.0
+    return events
+
+
+def main():
+    parser = argparse.ArgumentParser(description='为省电档位仿真录制或生成流量记录')
+    sub = parser.add_subparsers(dest='mode', required=True)
+
+    rec = sub.add_parser('record', help='接收设备转发的数据并记录到达时间')
+    rec.add_argument('--listen', default='0.0.0.0', help='监听地址')
+    rec.add_argument('--port', type=int, default=8080, help='监听端口')
+    rec.add_argument('--duration', type=float, default=300.0, help='记录时长（秒）')
+    rec.add_argument('--connect-timeout', type=float, default=60.0, help='等待设备连接的超时（秒）')
+    rec.add_argument('--output', required=True, help='输出文件')
+
+    gen = sub.add_parser('generate', help='按流量模式生成记录')
+    gen.add_argument('--profile', choices=PROFILES, default='interactive', help='流量模式')
+    gen.add_argument('--duration', type=float, default=3600.0, help='时长（秒）')
+    gen.add_argument('--seed', type=int, default=1, help='随机种子')
+    gen.add_argument('--output', required=True, help='输出文件')
+
+    args = parser.parse_args()
+    try:
+        events = record(args) if args.mode == 'record' else generate(args)
+    except OSError as e:
+        logger.error(f"记录失败: {e}")
+        return 1
+    if not events:
+        logger.error("没有记录到数据")
+        return 1
+
+    origin = events[0][0]
+    with open(args.output, 'w') as f:
+        source = f"record {args.port}" if args.mode == 'record' else f"generate {args.profile} seed={args.seed}"
+        f.write(f"# {source}, {len(events)}个事件\n")
+        f.write("# 时间(秒) 字节数\n")
+        for t, size in events:
+            f.write(f"{t - origin:.6f} {size}\n")
+    logger.info(f"已写入{len(events)}个事件到{args.output}，时长{events[-1][0] - origin:.1f}秒")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
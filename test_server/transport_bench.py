@@ -0,0 +1,246 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+TCP与UDP传输的延迟对比测试
+
+分别启动TCP和UDP传输的宿主机构建（host/sdkconfig.udp），按固定速率向UART写入定长记录，
+模拟周期性的传感器帧，统计每条记录从写入UART到服务器收到的延迟分位数和丢失的记录数。
+记录格式为 "R序号:校验:填充\\n"，按换行切分并校验，数据报丢失只影响其中的记录。
+
+--netem 指定的每个配置用 tc netem 施加在回环接口上（需要root权限和sch_netem内核模块），
+例如 "delay 20ms loss 1%"；空字符串表示不施加。回环接口上每个方向的包都经过一次netem，
+TCP的往返时间为单向延迟的两倍，丢包时TCP重传造成的队头阻塞会推迟其后所有记录的到达。
+
+示例：
+    python transport_bench.py --tcp-binary ../host/build/esp32_bridge_host \\
+        --udp-binary ../host/build-udp/esp32_bridge_host \\
+        --netem "" "delay 20ms" "delay 20ms loss 2%" --output transport.json
+"""
+
+import argparse
+import json
+import logging
+import os
+import re
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+from bridge_bench import PtyPort, TcpSink, git_commit
+from udp_server import UdpSink
+
+# 配置日志
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s - %(levelname)s - %(message)s'
+)
+logger = logging.getLogger(__name__)
+
+RECORD_RE = re.compile(rb'^R(\d{8}):(\d{8}):x*$')
+
+
+def make_record(index, size):
+    """生成一条定长记录，校验字段由序号推出"""
+    head = f"R{index:08d}:{index * 2654435761 % 100000000:08d}:".encode('ascii')
+    return head + b'x' * (size - len(head) - 1) + b'\n'
+
+
+def parse_records(arrivals, data):
+    """按换行切分接收的数据，返回 {序号: 到达时间}（重复的只保留第一次）和重复数"""
+    records = {}
+    duplicates = 0
+    line = bytearray()
+    for arrive_time, start, end in arrivals:
+        chunk = data[start:end]
+        pos = 0
+        while True:
+            newline = chunk.find(b'\n', pos)
+            if newline < 0:
+                line += chunk[pos:]
+                break
+            line += chunk[pos:newline]
+            pos = newline + 1
+            match = RECORD_RE.match(bytes(line))
+            line = bytearray()
+            if not match:
+                continue
+            index = int(match.group(1))
+            if int(match.group(2)) != index * 2654435761 % 100000000:
+                continue
+            if index in records:
+                duplicates += 1
+            else:
+                records[index] = arrive_time
+    return records, duplicates
+
+
+def percentile(values, p):
+    """最近秩法分位数"""
+    if not values:
+        return None
+    ordered = sorted(values)
+    index = min(len(ordered) - 1, max(0, int(round(p * len(ordered) + 0.5)) - 1))
+    return ordered[index]
+
+
+def apply_netem(dev, profile):
+    """在网卡上设置netem，profile为空时清除"""
+    subprocess.run(['tc', 'qdisc', 'del', 'dev', dev, 'root'],
+                   stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    if not profile:
+        return
+    result = subprocess.run(['tc', 'qdisc', 'add', 'dev', dev, 'root', 'netem', *profile.split()],
+                            capture_output=True, text=True)
+    if result.returncode != 0:
+        raise RuntimeError(f"设置netem失败（需要root权限和sch_netem内核模块）: {result.stderr.strip()}")
+
+
+def run_transport(transport, binary, profile, args):
+    """启动一个宿主机构建并测量一轮"""
+    sink = TcpSink(args.listen, args.port) if transport == 'tcp' else UdpSink(args.listen, args.port)
+    link = os.path.join(tempfile.gettempdir(), f"esp_transport_uart{args.uart_port}_{os.getpid()}")
+    env = dict(os.environ)
+    env[f'ESP_HOST_UART{args.uart_port}_LINK'] = link
+    env['ESP_HOST_UART_BAUD'] = str(args.baud)
+    log = open(args.host_log, 'ab') if args.host_log else subprocess.DEVNULL
+    process = subprocess.Popen([binary], env=env, stdout=log, stderr=log)
+    port = None
+    try:
+        sink.accept(args.connect_timeout)
+        port = PtyPort(link)
+        # 丢弃连接时发送的问候数据
+        time.sleep(1.0)
+        sink.reset()
+
+        injections = []
+        interval = 1.0 / args.rate
+        next_time = time.monotonic()
+        for index in range(args.records):
+            delay = next_time - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+            port.write(make_record(index, args.record_size))
+            injections.append(time.monotonic())
+            next_time += interval
+
+        # 等待记录全部到达或空闲超时
+        last_count = -1
+        last_change = time.monotonic()
+        while sink.received() < args.records * args.record_size and not sink.closed:
+            count = sink.received()
+            if count != last_count:
+                last_count = count
+                last_change = time.monotonic()
+            elif time.monotonic() - last_change > args.settle:
+                break
+            time.sleep(0.05)
+
+        data, arrivals = sink.snapshot()
+        records, duplicates = parse_records(arrivals, data)
+        latencies = [records[i] - injections[i] for i in records if i < len(injections)]
+        # 到达顺序中序号变小的次数，TCP总为0
+        order = [i for i, _ in sorted(records.items(), key=lambda item: item[1])]
+        out_of_order = sum(1 for a, b in zip(order, order[1:]) if b < a)
+
+        def ms(value):
+            return None if value is None else round(value * 1000, 3)
+
+        result = {
+            'transport': transport,
+            'netem': profile,
+            'records_sent': args.records,
+            'records_received': len(records),
+            'records_lost': args.records - len(records),
+            'loss_ratio': round((args.records - len(records)) / args.records, 6),
+            'duplicates': duplicates,
+            'out_of_order': out_of_order,
+            'wire_bytes': sink.wire_bytes,
+            'latency_ms': {
+                'p50': ms(percentile(latencies, 0.5)),
+                'p99': ms(percentile(latencies, 0.99)),
+                'p999': ms(percentile(latencies, 0.999)),
+                'max': ms(max(latencies) if latencies else None),
+            },
+        }
+        if transport == 'udp':
+            result['datagrams'] = sink.tracker.stats()
+        logger.info(f"[{transport} netem='{profile}'] 收到 {len(records)}/{args.records} 条记录 "
+                    f"延迟 p50={result['latency_ms']['p50']}ms p99={result['latency_ms']['p99']}ms "
+                    f"max={result['latency_ms']['max']}ms")
+        return result
+    finally:
+        if port:
+            port.close()
+        sink.close()
+        process.terminate()
+        try:
+            process.wait(timeout=5)
+        except subprocess.TimeoutExpired:
+            process.kill()
+
+
+def main():
+    """主函数"""
+    parser = argparse.ArgumentParser(description='TCP与UDP传输的延迟对比测试')
+    parser.add_argument('--tcp-binary', help='TCP传输的esp32_bridge_host路径')
+    parser.add_argument('--udp-binary', help='UDP传输的esp32_bridge_host路径（host/sdkconfig.udp）')
+    parser.add_argument('--netem', nargs='+', default=[''], help='tc netem参数，每项一轮，空字符串表示不施加')
+    parser.add_argument('--netem-dev', default='lo', help='施加netem的网卡')
+    parser.add_argument('--uart-port', type=int, default=1, help='被测UART端口号')
+    parser.add_argument('--baud', type=int, default=921600, help='UART波特率')
+    parser.add_argument('--listen', default='127.0.0.1', help='接收端监听地址')
+    parser.add_argument('--port', type=int, default=8080, help='接收端监听端口，须与TCP_SERVER_PORT一致')
+    parser.add_argument('--records', type=int, default=2000, help='每轮写入的记录数')
+    parser.add_argument('--record-size', type=int, default=64, help='每条记录的字节数（至少32）')
+    parser.add_argument('--rate', type=float, default=200.0, help='每秒写入的记录数')
+    parser.add_argument('--settle', type=float, default=3.0, help='写入结束后等待数据到达的空闲超时（秒）')
+    parser.add_argument('--connect-timeout', type=float, default=30.0, help='等待设备连接的超时（秒）')
+    parser.add_argument('--host-log', help='宿主机进程日志文件')
+    parser.add_argument('--output', default='transport_bench.json', help='JSON结果文件')
+    args = parser.parse_args()
+
+    binaries = [(name, path) for name, path in (('tcp', args.tcp_binary), ('udp', args.udp_binary)) if path]
+    if not binaries:
+        parser.error('至少指定 --tcp-binary 或 --udp-binary')
+    if args.record_size < 32:
+        parser.error('--record-size 至少为32')
+
+    report = {
+        'commit': git_commit(),
+        'timestamp': time.strftime('%Y-%m-%dT%H:%M:%S%z'),
+        'config': {
+            'records': args.records,
+            'record_size': args.record_size,
+            'rate': args.rate,
+            'baud': args.baud,
+            'netem_dev': args.netem_dev,
+        },
+        'results': [],
+    }
+    try:
+        for profile in args.netem:
+            apply_netem(args.netem_dev, profile)
+            try:
+                for name, path in binaries:
+                    report['results'].append(run_transport(name, path, profile, args))
+            finally:
+                if profile:
+                    apply_netem(args.netem_dev, '')
+    except RuntimeError as e:
+        logger.error(str(e))
+        sys.exit(1)
+    except socket.timeout:
+        logger.error("等待设备连接超时")
+        sys.exit(1)
+    except KeyboardInterrupt:
+        logger.info("测试被中断")
+
+    with open(args.output, 'w', encoding='utf-8') as f:
+        json.dump(report, f, indent=2, ensure_ascii=False)
+    logger.info(f"结果已写入 {args.output}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+UDP测试服务器（设备启用NETWORK_TRANSPORT_UDP时使用）
+
+每个数据报为4字节小端帧号加负载，帧号每个数据报加1，据此统计丢失和乱序；
+帧号0表示设备重新启动。只有帧头的数据报是设备连接后的问候，不含数据。
+--echo 把收到的负载以服务器自己的帧号发回设备（下行）。
+"""
+
+import argparse
+import logging
+import socket
+import struct
+import threading
+import time
+
+# 配置日志
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s - %(levelname)s - %(message)s'
+)
+logger = logging.getLogger(__name__)
+
+HEADER = struct.Struct('<I')
+
+
+class SeqTracker:
+    def __init__(self):
+        """按帧号统计丢失和乱序的数据报"""
+        self.expected = None
+        self.datagrams = 0
+        self.lost = 0
+        self.reordered = 0
+        self.restarts = 0
+
+    def update(self, seq):
+        """返回False表示乱序或重复"""
+        self.datagrams += 1
+        if self.expected is None or seq == 0:
+            if self.expected is not None:
+                self.restarts += 1
+            self.expected = seq + 1
+            return True
+        gap = (seq - self.expected) & 0xFFFFFFFF
+        if gap >= 0x80000000:
+            self.reordered += 1
+            return False
+        self.lost += gap
+        self.expected = seq + 1
+        return True
+
+    def stats(self):
+        return {
+            'datagrams': self.datagrams,
+            'lost': self.lost,
+            'reordered': self.reordered,
+            'restarts': self.restarts,
+            'loss_ratio': round(self.lost / (self.datagrams + self.lost), 6) if self.datagrams else 0,
+        }
+
+
+class UdpSink:
+    def __init__(self, host, port):
+        """UDP接收端，接口与bridge_bench.TcpSink相同，记录每个数据报的到达时间和负载
+
+        Args:
+            host: 监听地址
+            port: 监听端口
+        """
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4 * 1024 * 1024)
+        self.sock.bind((host, port))
+        self.lock = threading.Lock()
+        self.peer = None
+        self.tracker = SeqTracker()
+        self.data = bytearray()
+        self.arrivals = []      # (时间, 起始偏移, 结束偏移)，每个数据报一项
+        self.wire_bytes = 0
+        self.closed = False
+        self.tx_seq = 0
+
+    def accept(self, timeout):
+        """等待设备的第一个数据报"""
+        self.sock.settimeout(timeout)
+        packet, self.peer = self.sock.recvfrom(65536)
+        logger.info(f"设备已连接: {self.peer[0]}:{self.peer[1]}")
+        self._handle(packet, time.monotonic())
+        self.sock.settimeout(None)
+        thread = threading.Thread(target=self._receive)
+        thread.daemon = True
+        thread.start()
+
+    def _handle(self, packet, now):
+        if len(packet) < HEADER.size:
+            return None
+        (seq,) = HEADER.unpack_from(packet)
+        payload = packet[HEADER.size:]
+        with self.lock:
+            self.tracker.update(seq)
+            self.wire_bytes += len(packet)
+            if payload:
+                start = len(self.data)
+                self.data += payload
+                self.arrivals.append((now, start, start + len(payload)))
+        return payload
+
+    def _receive(self):
+        while True:
+            try:
+                packet, peer = self.sock.recvfrom(65536)
+            except OSError:
+                self.closed = True
+                return
+            self.peer = peer
+            self._handle(packet, time.monotonic())
+
+    def send(self, payload):
+        """向设备发送一个下行数据报"""
+        if self.peer is None:
+            return
+        self.sock.sendto(HEADER.pack(self.tx_seq & 0xFFFFFFFF) + payload, self.peer)
+        self.tx_seq += 1
+
+    def reset(self):
+        """丢弃已接收的数据"""
+        with self.lock:
+            self.data = bytearray()
+            self.arrivals = []
+            self.wire_bytes = 0
+            self.tracker = SeqTracker()
+
+    def received(self):
+        with self.lock:
+            return len(self.data)
+
+    def snapshot(self):
+        with self.lock:
+            return bytes(self.data), list(self.arrivals)
+
+    def close(self):
+        try:
+            self.sock.close()
+        except OSError:
+            pass
+
+
+def main():
+    """主函数"""
+    parser = argparse.ArgumentParser(description='UDP测试服务器')
+    parser.add_argument('--host', default='0.0.0.0', help='监听地址')
+    parser.add_argument('--port', type=int, default=8080, help='监听端口')
+    parser.add_argument('--quiet', action='store_true', help='不打印每个数据报，只打印统计')
+    parser.add_argument('--echo', action='store_true', help='把收到的负载发回设备')
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind((args.host, args.port))
+    sock.settimeout(5.0)
+    logger.info(f"UDP服务器启动，监听 {args.host}:{args.port}")
+
+    tracker = SeqTracker()
+    tx_seq = 0
+    total = 0
+    start = time.time()
+    try:
+        while True:
+            try:
+                packet, peer = sock.recvfrom(65536)
+            except socket.timeout:
+                if tracker.datagrams:
+                    logger.info(f"已接收 {total} 字节，{tracker.stats()}")
+                continue
+            if len(packet) < HEADER.size:
+                logger.warning(f"{peer} 忽略{len(packet)}字节的无效数据报")
+                continue
+            (seq,) = HEADER.unpack_from(packet)
+            payload = packet[HEADER.size:]
+            if seq == 0:
+                logger.info(f"{peer} 设备启动")
+            in_order = tracker.update(seq)
+            total += len(payload)
+            if not args.quiet:
+                note = '' if in_order else ' (乱序)'
+                logger.info(f"{peer} #{seq} {len(payload)} 字节{note}: {payload[:64]!r}")
+            if args.echo and payload:
+                sock.sendto(HEADER.pack(tx_seq & 0xFFFFFFFF) + payload, peer)
+                tx_seq += 1
+    except KeyboardInterrupt:
+        pass
+    finally:
+        sock.close()
+        elapsed = max(time.time() - start, 1e-9)
+        logger.info(f"共接收 {total} 字节（{total / elapsed:.0f} 字节/秒），{tracker.stats()}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+唤醒次数测试：宿主机构建在空闲连接下各任务每小时的唤醒次数
+
+启动设备进程并作为本地TCP服务器保持连接，不注入UART数据，预热后在测量时间内统计
+进程中每个线程的主动上下文切换次数（/proc/<pid>/task/<tid>/status中的
+voluntary_ctxt_switches），每次阻塞后被唤醒计一次，按线程名（FreeRTOS任务名）汇总并折算为每小时。
+模拟层自身的线程（名称以host_开头，如模拟UART硬件的pty读取线程）单独列出，不计入总数。
+指定多个--binary时依次测量，用于比较不同提交（例如改为定时器驱动前后）。只支持Linux。
+
+示例：
+    python wakeup_bench.py --binary /tmp/before/esp32_bridge_host ../host/build/esp32_bridge_host \\
+        --duration 120 --output wakeup.json
+"""
+
+import argparse
+import json
+import logging
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+from bridge_bench import TcpSink, git_commit
+
+# 配置日志
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s - %(levelname)s - %(message)s'
+)
+logger = logging.getLogger(__name__)
+
+
+def sample_threads(pid):
+    """读取进程中每个线程的名称和主动上下文切换次数"""
+    threads = {}
+    task_dir = f'/proc/{pid}/task'
+    for tid in os.listdir(task_dir):
+        try:
+            with open(f'{task_dir}/{tid}/comm') as f:
+                name = f.read().strip()
+            with open(f'{task_dir}/{tid}/status') as f:
+                for line in f:
+                    if line.startswith('voluntary_ctxt_switches:'):
+                        threads[tid] = (name, int(line.split()[1]))
+                        break
+        except OSError:
+            continue    # 线程已退出
+    return threads
+
+
+def measure(binary, args):
+    """启动一次设备进程，返回按线程名汇总的每小时唤醒次数"""
+    sink = TcpSink(args.listen, args.port)
+    env = dict(os.environ)
+    env['ESP_HOST_NVS_FILE'] = os.path.join(tempfile.gettempdir(), f"esp_wakeup_nvs_{os.getpid()}.bin")
+    log = tempfile.TemporaryFile()
+    process = subprocess.Popen([binary], env=env, stdout=log, stderr=log)
+    try:
+        sink.accept(args.connect_timeout)
+        time.sleep(args.warmup)
+        before = sample_threads(process.pid)
+        start = time.monotonic()
+        time.sleep(args.duration)
+        after = sample_threads(process.pid)
+        elapsed = time.monotonic() - start
+    finally:
+        sink.close()
+        process.terminate()
+        try:
+            process.wait(timeout=5)
+        except subprocess.TimeoutExpired:
+            process.kill()
+        log.close()
+
+    per_name = {}
+    for tid, (name, count) in after.items():
+        if tid in before:
+            count -= before[tid][1]
+        per_name[name] = per_name.get(name, 0) + count
+    hours = elapsed / 3600.0
+    tasks = {name: round(count / hours) for name, count in sorted(per_name.items())
+             if not name.startswith('host_')}
+    shim = {name: round(count / hours) for name, count in sorted(per_name.items())
+            if name.startswith('host_')}
+    total = sum(tasks.values())
+    logger.info(f"[{binary}] 每小时唤醒{total}次（不含模拟层）")
+    for name, rate in sorted(tasks.items(), key=lambda item: -item[1]):
+        logger.info(f"  {name:<16} {rate:>8}次/小时")
+    for name, rate in shim.items():
+        logger.info(f"  {name:<16} {rate:>8}次/小时（模拟层）")
+    return {'binary': binary, 'duration_s': round(elapsed, 1), 'wakeups_per_hour': total,
+            'tasks': tasks, 'shim_threads': shim}
+
+
+def main():
+    """主函数"""
+    parser = argparse.ArgumentParser(description='宿主机构建空闲时的唤醒次数测试')
+    parser.add_argument('--binary', nargs='+', required=True, help='esp32_bridge_host路径，可指定多个依次测量')
+    parser.add_argument('--listen', default='127.0.0.1', help='接收端监听地址')
+    parser.add_argument('--port', type=int, default=8080, help='接收端监听端口，须与TCP_SERVER_PORT一致')
+    parser.add_argument('--warmup', type=float, default=15.0, help='连接后到开始测量的时间（秒）')
+    parser.add_argument('--duration', type=float, default=120.0, help='测量时间（秒）')
+    parser.add_argument('--connect-timeout', type=float, default=30.0, help='等待设备连接的超时（秒）')
+    parser.add_argument('--output', default='wakeup_bench.json', help='JSON结果文件')
+    args = parser.parse_args()
+
+    if not os.path.isdir('/proc/self/task'):
+        logger.error("需要Linux的/proc文件系统")
+        return 1
+
+    report = {
+        'commit': git_commit(),
+        'timestamp': time.strftime('%Y-%m-%dT%H:%M:%S%z'),
+        'config': {'warmup_s': args.warmup, 'duration_s': args.duration},
+        'results': [],
+    }
+    try:
+        for binary in args.binary:
+            report['results'].append(measure(binary, args))
+    except (OSError, TimeoutError) as e:
+        logger.error(f"测试失败: {e}")
+        return 1
+
+    with open(args.output, 'w') as f:
+        json.dump(report, f, indent=2, ensure_ascii=False)
+    logger.info(f"结果已写入{args.output}")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+WiFi快速重连测试：冷启动与按记录重连的启动耗时对比
+
+宿主机构建通过环境变量模拟扫描、关联和DHCP的耗时（见host/README.md），
+每轮启动一次设备进程，测量从进程启动到接收端收到第一个字节的时间，
+同时从设备日志中读取"启动到首次发送"一行给出的各阶段耗时：
+    1. 冷启动：NVS文件为空，全信道扫描并等待DHCP
+    2. 按记录重连：保留NVS文件，直接连接记录的BSSID和信道，使用记录的IP地址
+    3. AP已更换：模拟的BSSID与记录不符，按记录连接失败后退回全信道扫描
+
+示例：
+    python wifi_bench.py --binary ../host/build/esp32_bridge_host --rounds 5 --output wifi.json
+"""
+
+import argparse
+import json
+import logging
+import os
+import re
+import socket
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+from bridge_bench import TcpSink, git_commit
+
+# 配置日志
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s - %(levelname)s - %(message)s'
+)
+logger = logging.getLogger(__name__)
+
+DEVICE_LOG_RE = re.compile(r'启动到首次发送(\d+)ms\((按记录连接AP|全信道扫描), (使用记录的地址|DHCP)\): '
+                           r'关联(\d+)ms, 获得IP (\d+)ms, 连接服务器(\d+)ms')
+
+
+def run_boot(args, nvs_file, bssid):
+    """启动一次设备进程，返回本轮的耗时"""
+    sink = TcpSink(args.listen, args.port)
+    env = dict(os.environ)
+    env['ESP_HOST_NVS_FILE'] = nvs_file
+    env['ESP_HOST_WIFI_SCAN_MS'] = str(args.scan_ms)
+    env['ESP_HOST_WIFI_ASSOC_MS'] = str(args.assoc_ms)
+    env['ESP_HOST_WIFI_DHCP_MS'] = str(args.dhcp_ms)
+    env['ESP_HOST_WIFI_BSSID'] = bssid
+    log = tempfile.TemporaryFile()
+    start = time.monotonic()
+    process = subprocess.Popen([args.binary], env=env, stdout=log, stderr=log)
+    try:
+        sink.accept(args.connect_timeout)
+        deadline = time.monotonic() + args.connect_timeout
+        while not sink.received() and time.monotonic() < deadline:
+            time.sleep(0.001)
+        _, arrivals = sink.snapshot()
+        if not arrivals:
+            raise socket.timeout()
+        first_byte_ms = (arrivals[0][0] - start) * 1000.0
+        # 等待设备写出日志
+        time.sleep(0.2)
+    finally:
+        sink.close()
+        process.terminate()
+        try:
+            process.wait(timeout=5)
+        except subprocess.TimeoutExpired:
+            process.kill()
+
+    log.seek(0)
+    text = log.read().decode('utf-8', errors='replace')
+    log.close()
+    if args.host_log:
+        with open(args.host_log, 'a', encoding='utf-8') as f:
+            f.write(text)
+    result = {'first_byte_ms': round(first_byte_ms, 1)}
+    match = DEVICE_LOG_RE.search(text)
+    if match:
+        result.update({
+            'device_first_byte_ms': int(match.group(1)),
+            'cached_ap': match.group(2) == '按记录连接AP',
+            'reused_lease': match.group(3) == '使用记录的地址',
+            'assoc_ms': int(match.group(4)),
+            'ip_ms': int(match.group(5)),
+            'tcp_ms': int(match.group(6)),
+        })
+    result['fallback'] = '按记录的AP连接失败' in text
+    return result
+
+
+def summarize(name, runs):
+    """汇总一组启动的耗时"""
+    values = [run['first_byte_ms'] for run in runs]
+    summary = {
+        'runs': runs,
+        'median_first_byte_ms': round(statistics.median(values), 1),
+        'min_first_byte_ms': min(values),
+        'max_first_byte_ms': max(values),
+    }
+    logger.info(f"[{name}] 启动到首字节 中位数{summary['median_first_byte_ms']}ms "
+                f"(最小{summary['min_first_byte_ms']}ms, 最大{summary['max_first_byte_ms']}ms)")
+    return summary
+
+
+def main():
+    """主函数"""
+    parser = argparse.ArgumentParser(description='WiFi快速重连测试')
+    parser.add_argument('--binary', required=True, help='esp32_bridge_host路径')
+    parser.add_argument('--listen', default='127.0.0.1', help='接收端监听地址')
+    parser.add_argument('--port', type=int, default=8080, help='接收端监听端口，须与TCP_SERVER_PORT一致')
+    parser.add_argument('--rounds', type=int, default=5, help='每种情况的启动次数')
+    parser.add_argument('--scan-ms', type=int, default=2000, help='模拟的全信道扫描耗时')
+    parser.add_argument('--assoc-ms', type=int, default=100, help='模拟的认证和关联耗时')
+    parser.add_argument('--dhcp-ms', type=int, default=1500, help='模拟的DHCP耗时')
+    parser.add_argument('--bssid', default='02:00:00:00:00:01', help='模拟AP的BSSID')
+    parser.add_argument('--moved-bssid', default='02:00:00:00:00:02', help='AP已更换时模拟的BSSID')
+    parser.add_argument('--connect-timeout', type=float, default=30.0, help='等待设备连接的超时（秒）')
+    parser.add_argument('--host-log', help='宿主机进程日志文件')
+    parser.add_argument('--output', default='wifi_bench.json', help='JSON结果文件')
+    args = parser.parse_args()
+
+    nvs_file = os.path.join(tempfile.gettempdir(), f"esp_wifi_nvs_{os.getpid()}.bin")
+    report = {
+        'commit': git_commit(),
+        'timestamp': time.strftime('%Y-%m-%dT%H:%M:%S%z'),
+        'config': {'scan_ms': args.scan_ms, 'assoc_ms': args.assoc_ms, 'dhcp_ms': args.dhcp_ms},
+    }
+    cold, cached, moved = [], [], []
+    try:
+        for _ in range(args.rounds):
+            # 冷启动后紧接一次按记录重连
+            if os.path.exists(nvs_file):
+                os.unlink(nvs_file)
+            cold.append(run_boot(args, nvs_file, args.bssid))
+            cached.append(run_boot(args, nvs_file, args.bssid))
+        for _ in range(args.rounds):
+            # 先以原AP建立记录，再更换AP
+            if os.path.exists(nvs_file):
+                os.unlink(nvs_file)
+            run_boot(args, nvs_file, args.bssid)
+            moved.append(run_boot(args, nvs_file, args.moved_bssid))
+    except socket.timeout:
+        logger.error("等待设备连接超时")
+        sys.exit(1)
+    except KeyboardInterrupt:
+        logger.info("测试被中断")
+        sys.exit(1)
+    finally:
+        if os.path.exists(nvs_file):
+            os.unlink(nvs_file)
+
+    report['cold'] = summarize('冷启动', cold)
+    report['cached'] = summarize('按记录重连', cached)
+    report['moved_ap'] = summarize('AP已更换', moved)
+    report['cached_speedup'] = round(report['cold']['median_first_byte_ms'] /
+                                     max(report['cached']['median_first_byte_ms'], 0.1), 2)
+
+    with open(args.output, 'w', encoding='utf-8') as f:
+        json.dump(report, f, indent=2, ensure_ascii=False)
+    logger.info(f"结果已写入 {args.output}")
+
+
+if __name__ == "__main__":
+    main()